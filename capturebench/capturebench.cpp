@@ -0,0 +1,175 @@
+/**
+ * @file capturebench.cpp
+ * @brief Headless continuous frame capture benchmark, synthetic frames at 60 Hz.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/string.h>
+
+#include <o3d/image/image.h>
+
+#include <o3dsamples/framerecorder.h>
+#include <o3dsamples/imagecodec.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Record synthetic frames, of the size of the window of the samples, produced at
+ * 60 Hz like a rendering loop, into a raw YUV stream and into numbered JPEG files with
+ * one then several encoders. For each sink the dropped frames, the copy time on the
+ * producer and the sustained throughput of the encoders are reported. The saves of
+ * several JPEG encoders are serialized (see ImageCodecLock), their gain is limited to
+ * the conversions around the codec.
+ * @date 2026-10-19
+ */
+class CaptureBench
+{
+public:
+
+    static Int32 main()
+    {
+        // a few frames of moving gradients, built through the Image API
+        std::vector<Image> frames(NUM_SOURCES);
+        for (UInt32 i = 0; i < NUM_SOURCES; ++i) {
+            std::vector<UInt8> texels(size_t(WIDTH) * HEIGHT * 4);
+
+            for (UInt32 y = 0; y < HEIGHT; ++y) {
+                for (UInt32 x = 0; x < WIDTH; ++x) {
+                    UInt8 *texel = &texels[(size_t(y) * WIDTH + x) * 4];
+                    texel[0] = UInt8(x + i * 8);
+                    texel[1] = UInt8(y + i * 4);
+                    texel[2] = UInt8((x ^ y) + i * 16);
+                    texel[3] = 255;
+                }
+            }
+
+            frames[i].loadBuffer(WIDTH, HEIGHT, UInt32(texels.size()), PF_RGBA_8, texels.data());
+        }
+
+        // a single stream, the frames being written in order
+        {
+            YuvStreamWriter writer;
+            if (!writer.open("capturebench.yuv")) {
+                Application::message("Unable to create capturebench.yuv", "Error");
+                return -1;
+            }
+
+            FrameRecorder recorder([&writer] (const CaptureFrame &frame, UInt32) {
+                return writer.write(frame);
+            }, 1);
+
+            report("yuv stream, 1 encoder", record(recorder, frames), recorder.getNumEncoders());
+        }
+
+        // numbered files, one file per encoder here to keep the disk clean
+        const UInt32 numWorkers = std::max<UInt32>(std::thread::hardware_concurrency(), 2) - 1;
+        const UInt32 numEncoders[2] = { 1, numWorkers };
+
+        for (UInt32 n = 0; n < 2; ++n) {
+            if ((n == 1) && (numWorkers == 1)) {
+                break;
+            }
+
+            FrameRecorder recorder([] (const CaptureFrame &frame, UInt32 encoder) {
+                Image image;
+                image.loadBuffer(frame.width, frame.height, UInt32(frame.data.size()),
+                                 PixelFormat(frame.format), frame.data.data());
+
+                ImageCodecLock lock;
+                return image.save(String::print("capturebench_%u.jpg", encoder), Image::JPEG);
+            }, numEncoders[n]);
+
+            report(String::print("jpeg files, %u encoder(s)", numEncoders[n]), record(recorder, frames),
+                   recorder.getNumEncoders());
+        }
+
+        return 0;
+    }
+
+private:
+
+    static const UInt32 WIDTH = 800;
+    static const UInt32 HEIGHT = 600;
+    static const UInt32 NUM_SOURCES = 4;
+    static const UInt32 NUM_FRAMES = 180;   //!< 3 seconds at 60 Hz.
+
+    struct Result
+    {
+        FrameRecorder::Stats stats;
+        Float time;               //!< Milliseconds from the first frame to the last encoding.
+    };
+
+    //! Push the frames at 60 Hz, then wait for the encoders.
+    static Result record(FrameRecorder &recorder, std::vector<Image> &frames)
+    {
+        const Int64 start = System::getTime();
+        const auto period = std::chrono::microseconds(16667);
+        auto next = std::chrono::steady_clock::now();
+
+        for (UInt32 i = 0; i < NUM_FRAMES; ++i) {
+            Image &frame = frames[i % frames.size()];
+
+            if (recorder.isFrameDue()) {
+                recorder.push(frame.getData(), frame.getWidth(), frame.getHeight(), 4, PF_RGBA_8, False);
+            }
+
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+
+        recorder.stop();
+
+        Result result;
+        result.stats = recorder.getStats();
+        result.time = (Float)(System::getTime() - start) * 1000.f / (Float)System::getTimeFrequency();
+
+        return result;
+    }
+
+    static void report(const String &name, const Result &result, UInt32 numEncoders)
+    {
+        const FrameRecorder::Stats &stats = result.stats;
+        const Float seconds = result.time / 1000.f;
+
+        // frames per second the encoders could sustain, busy all the time
+        const Float capacity = stats.encodeTime > 0.0f ?
+                                   stats.numEncoded * numEncoders * 1000.f / stats.encodeTime : 0.0f;
+
+        Application::message(String::print("%s: %u frames, %u encoded, %u dropped (%.1f%%), %u failed, "
+                                           "%.1f frames/s, %.1f MB/s, encode %.2f ms/frame (capacity %.1f frames/s), "
+                                           "copy %.3f ms/frame (max %.3f ms)",
+                                           name.toUtf8().getData(), stats.numFrames, stats.numEncoded,
+                                           stats.numDropped, stats.numFrames ? 100.f * stats.numDropped / stats.numFrames : 0.0f,
+                                           stats.numFailed,
+                                           stats.numEncoded / seconds,
+                                           stats.encodedBytes / (1024.f*1024.f) / seconds,
+                                           stats.numEncoded ? stats.encodeTime / stats.numEncoded : 0.0f, capacity,
+                                           stats.numQueued ? stats.pushTime / stats.numQueued : 0.0f,
+                                           stats.maxPushTime), "Bench");
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(CaptureBench, MyAppSettings)
@@ -0,0 +1,257 @@
+/**
+ * @file clusterbench.cpp
+ * @brief Headless clustered light assignment benchmark, 1k to 10k point and spot lights.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/string.h>
+
+#include <o3dsamples/lightclusters.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Assign 1k, 4k and 10k lights, half point and half spot lights, to the clusters
+ * of the 800x600 view of the ms3d deferred sample (32 pixels tiles, 24 slices). Each
+ * available path is run one after the other and on a pool, and must give the same lists.
+ * The lists are checked to be conservative at random points of the view: every light
+ * lighting a point must be in the list of its cluster. The best of a few runs is kept.
+ * @date 2026-10-19
+ */
+class ClusterBench
+{
+public:
+
+    static Int32 main()
+    {
+        LightClusters clusters;
+        clusters.setup(WIDTH, HEIGHT, TILE_SIZE, NUM_SLICES, FOV_Y, NEAR_PLANE, FAR_PLANE);
+
+        Application::message(String::print("%ux%u view, %ux%u tiles of %u pixels, %u slices, %u clusters",
+                                           WIDTH, HEIGHT, clusters.getTilesX(), clusters.getTilesY(), TILE_SIZE,
+                                           NUM_SLICES, clusters.getNumClusters()), "Bench");
+
+        WorkerPool pool;
+
+        static const UInt32 lightCounts[] = { 1000, 4000, 10000 };
+        static const LightClusters::Path paths[] = {
+            LightClusters::PATH_SCALAR, LightClusters::PATH_SSE2, LightClusters::PATH_AVX };
+        static const char *pathNames[] = { "scalar", "SSE2", "AVX" };
+
+        for (UInt32 numLights : lightCounts) {
+            std::vector<ClusterLight> lights;
+            buildLights(lights, numLights);
+
+            std::vector<UInt32> refRanges;
+            std::vector<UInt16> refIndices;
+
+            for (UInt32 p = 0; p < 3; ++p) {
+                if (!LightClusters::hasPath(paths[p])) {
+                    continue;
+                }
+
+                clusters.setPath(paths[p]);
+
+                Float serialTime = 0.0f, parallelTime = 0.0f;
+
+                for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+                    Int64 timer = System::getTime();
+                    clusters.build(lights.data(), numLights);
+                    serialTime = best(r, serialTime, elapsed(timer));
+
+                    if (refRanges.empty()) {
+                        refRanges = clusters.getRanges();
+                        refIndices = clusters.getIndices();
+                    } else if (!sameLists(clusters, refRanges, refIndices)) {
+                        Application::message(String::print("%s lists differ", pathNames[p]), "Error");
+                        return -1;
+                    }
+
+                    timer = System::getTime();
+                    clusters.build(lights.data(), numLights, &pool);
+                    parallelTime = best(r, parallelTime, elapsed(timer));
+
+                    if (!sameLists(clusters, refRanges, refIndices)) {
+                        Application::message(String::print("%s lists on the pool differ", pathNames[p]), "Error");
+                        return -1;
+                    }
+                }
+
+                Application::message(String::print("%u lights, %s: %.2f ms one by one, %.2f ms on %u workers",
+                                                   numLights, pathNames[p], serialTime, parallelTime,
+                                                   pool.getNumWorkers() + 1), "Bench");
+            }
+
+            const UInt32 numMissed = checkConservative(clusters, lights);
+            if (numMissed) {
+                Application::message(String::print("%u lit points miss their light", numMissed), "Error");
+                return -1;
+            }
+
+            const LightClusters::Stats &stats = clusters.getStats();
+            Application::message(String::print("  %u visible, %u light-tile candidates, %u indices (%.1f per cluster, "
+                                               "max %u, %u empty), upload %.1f KB",
+                                               stats.numVisible, stats.numCandidates, stats.numIndices,
+                                               Float(stats.numIndices) / Float(clusters.getNumClusters()),
+                                               stats.maxPerCluster, stats.numEmpty,
+                                               clusters.getUploadBytes() / 1024.f), "Bench");
+            Application::message(String::print("  %u light-cluster tests without binning, %.1f%% kept",
+                                               stats.numVisible * clusters.getNumClusters(),
+                                               100.f * Float(stats.numIndices) / Float(stats.numVisible * clusters.getNumClusters())), "Bench");
+        }
+
+        return 0;
+    }
+
+private:
+
+    static const UInt32 WIDTH = 800;
+    static const UInt32 HEIGHT = 600;
+    static const UInt32 TILE_SIZE = 32;
+    static const UInt32 NUM_SLICES = 24;
+    static const UInt32 NUM_SAMPLES = 200000;
+    static const UInt32 NUM_RUNS = 5;
+
+    static constexpr Float FOV_Y = 60.0f;
+    static constexpr Float NEAR_PLANE = 1.0f;
+    static constexpr Float FAR_PLANE = 1000.0f;
+
+    static UInt32 random(UInt32 &seed)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    }
+
+    static Float uniform(UInt32 &seed)
+    {
+        return Float(random(seed) & 0xffff) / 65535.f;
+    }
+
+    //! Lights around the view frustum, spots pointing down and forward.
+    static void buildLights(std::vector<ClusterLight> &lights, UInt32 count)
+    {
+        UInt32 seed = 15;
+        const Float tanY = std::tan(FOV_Y * 0.5f * 3.14159265f / 180.0f);
+        const Float tanX = tanY * Float(WIDTH) / Float(HEIGHT);
+
+        lights.resize(count);
+
+        for (UInt32 i = 0; i < count; ++i) {
+            ClusterLight &light = lights[i];
+
+            const Float depth = NEAR_PLANE + std::pow(uniform(seed), 2.0f) * 500.0f;
+            light.position[0] = (uniform(seed) * 2.4f - 1.2f) * tanX * depth;
+            light.position[1] = (uniform(seed) * 2.4f - 1.2f) * tanY * depth;
+            light.position[2] = -depth;
+            light.range = 2.0f + uniform(seed) * 18.0f;
+
+            if (i & 1) {
+                Float dir[3] = { uniform(seed) - 0.5f, -1.0f, uniform(seed) - 0.5f };
+                const Float invLen = 1.0f / std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+
+                light.type = ClusterLight::SPOT_LIGHT;
+                light.direction[0] = dir[0] * invLen;
+                light.direction[1] = dir[1] * invLen;
+                light.direction[2] = dir[2] * invLen;
+                light.cutOff = 15.0f + uniform(seed) * 45.0f;
+            } else {
+                light.type = ClusterLight::POINT_LIGHT;
+                light.direction[0] = light.direction[1] = 0.0f;
+                light.direction[2] = -1.0f;
+                light.cutOff = 180.0f;
+            }
+        }
+    }
+
+    static Bool sameLists(const LightClusters &clusters, const std::vector<UInt32> &ranges, const std::vector<UInt16> &indices)
+    {
+        return (clusters.getRanges() == ranges) && (clusters.getIndices() == indices);
+    }
+
+    static Bool isLit(const ClusterLight &light, const Float p[3])
+    {
+        const Float v[3] = { p[0] - light.position[0], p[1] - light.position[1], p[2] - light.position[2] };
+        const Float lenSq = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+
+        if (lenSq > light.range * light.range) {
+            return False;
+        }
+
+        if (light.type == ClusterLight::POINT_LIGHT) {
+            return True;
+        }
+
+        const Float along = v[0] * light.direction[0] + v[1] * light.direction[1] + v[2] * light.direction[2];
+        return along >= std::cos(light.cutOff * 3.14159265f / 180.0f) * std::sqrt(lenSq);
+    }
+
+    //! Number of points lit by a light missing from the list of their cluster.
+    static UInt32 checkConservative(const LightClusters &clusters, const std::vector<ClusterLight> &lights)
+    {
+        UInt32 seed = 7;
+        UInt32 numMissed = 0;
+
+        const Float tanY = std::tan(FOV_Y * 0.5f * 3.14159265f / 180.0f);
+        const Float tanX = tanY * Float(WIDTH) / Float(HEIGHT);
+
+        const std::vector<UInt32> &ranges = clusters.getRanges();
+        const std::vector<UInt16> &indices = clusters.getIndices();
+
+        for (UInt32 s = 0; s < NUM_SAMPLES; ++s) {
+            // a pixel center, at a depth in the first half of the range where the lights are
+            const UInt32 px = random(seed) % WIDTH;
+            const UInt32 py = random(seed) % HEIGHT;
+            const Float depth = NEAR_PLANE + std::pow(uniform(seed), 2.0f) * 520.0f;
+
+            const Float ndcX = (Float(px) + 0.5f) / Float(WIDTH) * 2.0f - 1.0f;
+            const Float ndcY = (Float(py) + 0.5f) / Float(HEIGHT) * 2.0f - 1.0f;
+            const Float p[3] = { ndcX * tanX * depth, ndcY * tanY * depth, -depth };
+
+            const UInt32 cluster = clusters.getCluster(px / TILE_SIZE, py / TILE_SIZE, clusters.getSlice(depth));
+            const UInt16 *first = &indices[0] + ranges[cluster * 2];
+            const UInt16 *last = first + ranges[cluster * 2 + 1];
+
+            for (UInt32 l = 0; l < UInt32(lights.size()); ++l) {
+                if (isLit(lights[l], p) && !std::binary_search(first, last, UInt16(l))) {
+                    ++numMissed;
+                }
+            }
+        }
+
+        return numMissed;
+    }
+
+    static Float elapsed(Int64 timer)
+    {
+        return (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+    }
+
+    static Float best(UInt32 run, Float current, Float time)
+    {
+        return (run == 0) || (time < current) ? time : current;
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(ClusterBench, MyAppSettings)
@@ -0,0 +1,286 @@
+/**
+ * @file debugdrawbench.cpp
+ * @brief Headless debug draw benchmark, symbols of 10k objects per frame.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/string.h>
+
+#include <o3dsamples/debugdraw.h>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief The symbols of a scene of 10k objects, as drawn with the DRAW_BONES,
+ * DRAW_BOUNDING_VOLUME, DRAW_LOCAL_AXIS, DRAW_SPOT_LIGHT and DRAW_SND_SOURCE_OMNI flags:
+ * a bounding box and a local axis per object, a skeleton per skinned mesh, a sphere or
+ * a cone per light and a sphere per sound source.
+ * They are drawn with a buffer and a draw per symbol, as each object draws its own,
+ * then collected by DebugDraw one after the other and on a pool, which must give the
+ * same stream. The bones have a budget below their count, the last ones are dropped.
+ * The best of a few runs is kept.
+ * @date 2026-10-19
+ */
+class DebugDrawBench
+{
+public:
+
+    static Int32 main()
+    {
+        std::vector<Object> objects;
+        buildScene(objects);
+
+        const DebugDraw::CollectFunc collect = [&objects] (UInt32 begin, UInt32 end, DebugStream &stream) {
+            for (UInt32 i = begin; i < end; ++i) {
+                drawSymbols(objects[i], stream);
+            }
+        };
+
+        // a symbol at a time, its own buffer and draw
+        Float perSymbolTime = 0.0f;
+        UInt32 numSymbols = 0;
+        std::vector<std::vector<PrimitiveVertex>> uploads;
+
+        for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+            DebugStream symbol;
+            numSymbols = 0;
+
+            const Int64 timer = System::getTime();
+            for (const Object &object : objects) {
+                for (UInt32 s = 0; s < NUM_SYMBOL_KINDS; ++s) {
+                    symbol.clear();
+                    if (drawSymbol(object, s, symbol)) {
+                        for (UInt32 c = 0; c < DEBUG_NUM_CATEGORIES; ++c) {
+                            const std::vector<PrimitiveVertex> &lines = symbol.getLines(DebugCategory(c));
+                            if (!lines.empty()) {
+                                uploads.emplace_back(lines.begin(), lines.end());
+                            }
+                        }
+
+                        ++numSymbols;
+                        if (uploads.size() > 64) {
+                            uploads.clear();
+                        }
+                    }
+                }
+            }
+            perSymbolTime = best(r, perSymbolTime, elapsed(timer));
+        }
+
+        WorkerPool pool;
+        DebugDraw serial, parallel;
+
+        for (DebugDraw *debugDraw : { &serial, &parallel }) {
+            debugDraw->setBudget(DEBUG_BONES, BONES_BUDGET);
+            debugDraw->setBudget(DEBUG_BOUNDING_VOLUMES, NUM_OBJECTS * 12);
+            debugDraw->setState(DEBUG_BONES, STATE_ON_TOP);
+        }
+
+        Float serialTime = 0.0f, parallelTime = 0.0f;
+        std::vector<PrimitiveVertex> staging;
+
+        auto submit = [&staging] (const PrimitiveSubmit &submit, const PrimitiveVertex *vertices) {
+            staging.insert(staging.end(), vertices + submit.first, vertices + submit.first + submit.count);
+        };
+
+        for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+            Int64 timer = System::getTime();
+            serial.collect(NUM_OBJECTS, collect);
+            staging.clear();
+            serial.flush(submit);
+            serialTime = best(r, serialTime, elapsed(timer));
+
+            timer = System::getTime();
+            parallel.collect(NUM_OBJECTS, collect, &pool);
+            staging.clear();
+            parallel.flush(submit);
+            parallelTime = best(r, parallelTime, elapsed(timer));
+        }
+
+        const std::vector<PrimitiveVertex> &a = serial.getVertices();
+        const std::vector<PrimitiveVertex> &b = parallel.getVertices();
+
+        if ((a.size() != b.size()) || memcmp(a.data(), b.data(), a.size() * sizeof(PrimitiveVertex))) {
+            Application::message("The parallel stream differs from the serial one", "Error");
+            return -1;
+        }
+
+        const DebugDraw::Stats &stats = parallel.getStats();
+
+        Application::message(String::print("%u objects, %u symbols", NUM_OBJECTS, numSymbols), "Bench");
+        Application::message(String::print("a draw per symbol: %u draws, %.2f ms", numSymbols, perSymbolTime), "Bench");
+        Application::message(String::print("collected: %u draws, %u lines (%.1f KB), %.2f ms one by one, %.2f ms on %u workers",
+                                           stats.numSubmits, stats.getNumLines(),
+                                           stats.getNumLines() * 2 * sizeof(PrimitiveVertex) / 1024.f,
+                                           serialTime, parallelTime, pool.getNumWorkers() + 1), "Bench");
+
+        static const char *names[DEBUG_NUM_CATEGORIES] = { "bones", "bounding volumes", "lights", "sounds", "local axis" };
+        for (UInt32 c = 0; c < DEBUG_NUM_CATEGORIES; ++c) {
+            Application::message(String::print("  %s: %u lines, %u over the budget",
+                                               names[c], stats.numLines[c], stats.numDropped[c]), "Bench");
+        }
+
+        return 0;
+    }
+
+private:
+
+    static const UInt32 NUM_OBJECTS = 10000;
+    static const UInt32 NUM_BONES = 24;
+    static const UInt32 BONES_BUDGET = 32768;
+    static const UInt32 NUM_SYMBOL_KINDS = 4;
+    static const UInt32 NUM_RUNS = 5;
+
+    enum State
+    {
+        STATE_DEPTH_TESTED = 0,
+        STATE_ON_TOP = 1
+    };
+
+    enum Kind
+    {
+        KIND_MESH = 0,
+        KIND_SKINNED,
+        KIND_POINT_LIGHT,
+        KIND_SPOT_LIGHT,
+        KIND_SOUND
+    };
+
+    struct Object
+    {
+        Float x, y, z;
+        Float size;
+        Float angle;
+        Kind kind;
+    };
+
+    static void buildScene(std::vector<Object> &objects)
+    {
+        UInt32 seed = 15;
+        auto random = [&seed] () {
+            seed = seed * 1664525u + 1013904223u;
+            return seed >> 8;
+        };
+
+        objects.resize(NUM_OBJECTS);
+
+        for (Object &object : objects) {
+            object.x = Float(random() % 100000) / 100.0f - 500.0f;
+            object.y = Float(random() % 2000) / 100.0f;
+            object.z = Float(random() % 100000) / 100.0f - 500.0f;
+            object.size = 0.5f + Float(random() % 400) / 100.0f;
+            object.angle = Float(random() % 6283) / 1000.0f;
+
+            // a quarter of skinned meshes, a few lights and sound sources
+            const UInt32 k = random() % 100;
+            object.kind = k < 25 ? KIND_SKINNED : (k < 28 ? KIND_POINT_LIGHT : (k < 31 ? KIND_SPOT_LIGHT : (k < 33 ? KIND_SOUND : KIND_MESH)));
+        }
+    }
+
+    //! A symbol of an object, false if it has none of this kind.
+    static Bool drawSymbol(const Object &object, UInt32 symbol, DebugStream &stream)
+    {
+        const Float center[3] = { object.x, object.y, object.z };
+
+        switch (symbol) {
+            case 0:
+            {
+                const Float min[3] = { object.x - object.size, object.y - object.size, object.z - object.size };
+                const Float max[3] = { object.x + object.size, object.y + object.size, object.z + object.size };
+
+                stream.setColor(1.0f, 1.0f, 0.0f);
+                stream.box(DEBUG_BOUNDING_VOLUMES, min, max);
+                return True;
+            }
+
+            case 1:
+            {
+                const Float x[3] = { std::cos(object.angle), 0.0f, -std::sin(object.angle) };
+                const Float y[3] = { 0.0f, 1.0f, 0.0f };
+                const Float z[3] = { std::sin(object.angle), 0.0f, std::cos(object.angle) };
+
+                stream.axis(DEBUG_LOCAL_AXIS, center, x, y, z, object.size);
+                return True;
+            }
+
+            case 2:
+                if (object.kind != KIND_SKINNED) {
+                    return False;
+                }
+
+                // a spine and two arms
+                stream.setColor(0.0f, 1.0f, 1.0f);
+                for (UInt32 b = 0; b < NUM_BONES; ++b) {
+                    const Float h = object.size / NUM_BONES;
+                    const Float side = b < NUM_BONES / 2 ? 0.0f : (b % 2 ? 1.0f : -1.0f) * h * Float(b - NUM_BONES / 2);
+                    const Float from[3] = { object.x + side, object.y + h * b, object.z };
+                    const Float to[3] = { object.x + side * 1.1f, object.y + h * (b + 1), object.z };
+
+                    stream.line(DEBUG_BONES, from, to);
+                }
+                return True;
+
+            case 3:
+                if (object.kind == KIND_POINT_LIGHT) {
+                    stream.setColor(1.0f, 0.5f, 0.0f);
+                    stream.sphere(DEBUG_LIGHTS, center, object.size);
+                } else if (object.kind == KIND_SPOT_LIGHT) {
+                    const Float dir[3] = { 0.0f, -1.0f, 0.0f };
+
+                    stream.setColor(1.0f, 0.0f, 0.0f);
+                    stream.cone(DEBUG_LIGHTS, center, dir, object.size * 4.0f, object.size * 2.0f);
+                } else if (object.kind == KIND_SOUND) {
+                    stream.setColor(0.0f, 0.0f, 1.0f);
+                    stream.sphere(DEBUG_SOUNDS, center, object.size);
+                } else {
+                    return False;
+                }
+                return True;
+
+            default:
+                return False;
+        }
+    }
+
+    static void drawSymbols(const Object &object, DebugStream &stream)
+    {
+        for (UInt32 s = 0; s < NUM_SYMBOL_KINDS; ++s) {
+            drawSymbol(object, s, stream);
+        }
+    }
+
+    static Float elapsed(Int64 timer)
+    {
+        return (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+    }
+
+    static Float best(UInt32 run, Float current, Float time)
+    {
+        return (run == 0) || (time < current) ? time : current;
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(DebugDrawBench, MyAppSettings)
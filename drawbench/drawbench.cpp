@@ -0,0 +1,256 @@
+/**
+ * @file drawbench.cpp
+ * @brief Headless draw command recording, sorting and state change benchmark.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/string.h>
+
+#include <o3dsamples/drawcommands.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Record the draw commands of a synthetic scene, objects spread over visibility
+ * cells drawn by an ambient pass, three light passes and a translucent pass, one after
+ * the other and then in parallel per cell. Sort them with the radix sort of DrawCommands
+ * and with std::stable_sort, which must give the same order, then count the state
+ * changes of the replay in the visibility order and in the sorted order.
+ * Each step is run a few times, the best run is kept.
+ * @date 2026-10-19
+ */
+class DrawBench
+{
+public:
+
+    static Int32 main()
+    {
+        SyntheticScene scene;
+        buildScene(scene);
+
+        WorkerPool pool;
+        DrawCommands commands;
+
+        const RecordFunc record = [&scene] (UInt32 bucket, std::vector<DrawItem> &items) {
+            recordBucket(scene, bucket, items);
+        };
+
+        // recording
+        Float serialTime = 0.0f, parallelTime = 0.0f;
+
+        for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+            Int64 timer = System::getTime();
+            commands.record(NUM_BUCKETS, record);
+            serialTime = best(r, serialTime, elapsed(timer));
+
+            timer = System::getTime();
+            commands.record(NUM_BUCKETS, record, &pool);
+            parallelTime = best(r, parallelTime, elapsed(timer));
+        }
+
+        // visibility order
+        commands.merge();
+        const UInt32 numItems = commands.getNumItems();
+        const DrawCommands::Stats unsorted = commands.countStateChanges();
+
+        // reference order
+        std::vector<DrawItem> reference;
+        Float stableSortTime = 0.0f;
+
+        for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+            reference.clear();
+            for (UInt32 i = 0; i < numItems; ++i) {
+                reference.push_back(commands.getItem(i));
+            }
+
+            const Int64 timer = System::getTime();
+            std::stable_sort(reference.begin(), reference.end(), [] (const DrawItem &a, const DrawItem &b) {
+                return a.key < b.key;
+            });
+            stableSortTime = best(r, stableSortTime, elapsed(timer));
+        }
+
+        Float radixTime = 0.0f;
+
+        for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+            const Int64 timer = System::getTime();
+            commands.sort();
+            radixTime = best(r, radixTime, elapsed(timer));
+        }
+
+        for (UInt32 i = 0; i < numItems; ++i) {
+            if ((commands.getItem(i).key != reference[i].key) || (commands.getItem(i).object != reference[i].object)) {
+                Application::message(String::print("Radix order differs from std::stable_sort at %u", i), "Error");
+                return -1;
+            }
+        }
+
+        Float replayTime = 0.0f;
+        DrawCommands::Stats sorted;
+
+        for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+            const Int64 timer = System::getTime();
+            sorted = commands.countStateChanges();
+            replayTime = best(r, replayTime, elapsed(timer));
+        }
+
+        if (sorted.numOverflows) {
+            Application::message(String::print("%u draw commands overflow their key fields", sorted.numOverflows), "Error");
+            return -1;
+        }
+
+        Application::message(String::print("%u objects in %u cells, %u draw commands", NUM_OBJECTS, NUM_BUCKETS, numItems), "Bench");
+        Application::message(String::print("record: %.2f ms one by one, %.2f ms on %u workers (x%.1f)",
+                                           serialTime, parallelTime, pool.getNumWorkers() + 1,
+                                           serialTime / parallelTime), "Bench");
+        Application::message(String::print("sort: radix %.2f ms (merge included), std::stable_sort %.2f ms (x%.1f), same order",
+                                           radixTime, stableSortTime, stableSortTime / radixTime), "Bench");
+
+        report("visibility order", unsorted);
+        report(String::print("sorted order (replay %.2f ms)", replayTime), sorted);
+
+        return 0;
+    }
+
+private:
+
+    typedef DrawCommands::RecordFunc RecordFunc;
+
+    static const UInt32 NUM_OBJECTS = 20480;   //!< 320 per cell.
+    static const UInt32 NUM_BUCKETS = 64;
+    static const UInt32 NUM_MATERIALS = 64;
+    static const UInt32 NUM_TEXTURES_PER_MATERIAL = 4;
+    static const UInt32 NUM_MESHES = 128;
+    static const UInt32 NUM_LIGHTS = 3;
+    static const UInt32 NUM_RUNS = 5;
+
+    enum Pass
+    {
+        PASS_AMBIENT = 0,
+        PASS_LIGHT = 1,           //!< One per light, PASS_LIGHT + light.
+        PASS_TRANSLUCENT = PASS_LIGHT + NUM_LIGHTS
+    };
+
+    struct Object
+    {
+        Float x, y, z;
+        UInt32 material;
+        UInt32 texture;
+        UInt32 mesh;
+        Bool translucent;
+    };
+
+    struct SyntheticScene
+    {
+        std::vector<Object> objects;  //!< By visibility cell, NUM_OBJECTS / NUM_BUCKETS each.
+        Float maxDistance;
+    };
+
+    static void buildScene(SyntheticScene &scene)
+    {
+        UInt32 seed = 15;
+        auto random = [&seed] () {
+            seed = seed * 1664525u + 1013904223u;
+            return seed >> 8;
+        };
+
+        scene.objects.resize(NUM_OBJECTS);
+        scene.maxDistance = 0.0f;
+
+        for (UInt32 i = 0; i < NUM_OBJECTS; ++i) {
+            Object &object = scene.objects[i];
+
+            // cells of a 8x8 grid, 100 units wide, the camera at the center
+            const UInt32 cell = i / (NUM_OBJECTS / NUM_BUCKETS);
+            object.x = (Float(cell % 8) - 4.0f) * 100.0f + Float(random() % 10000) / 100.0f;
+            object.y = Float(random() % 2000) / 100.0f;
+            object.z = (Float(cell / 8) - 4.0f) * 100.0f + Float(random() % 10000) / 100.0f;
+
+            object.material = random() % NUM_MATERIALS;
+            object.texture = object.material * NUM_TEXTURES_PER_MATERIAL + random() % NUM_TEXTURES_PER_MATERIAL;
+            object.mesh = random() % NUM_MESHES;
+            object.translucent = (random() % 10) == 0;
+
+            scene.maxDistance = std::max(scene.maxDistance, distance(object));
+        }
+    }
+
+    static Float distance(const Object &object)
+    {
+        return std::sqrt(object.x * object.x + object.y * object.y + object.z * object.z);
+    }
+
+    //! Commands of the objects of a cell, for every pass.
+    static void recordBucket(const SyntheticScene &scene, UInt32 bucket, std::vector<DrawItem> &items)
+    {
+        const UInt32 perBucket = NUM_OBJECTS / NUM_BUCKETS;
+        const Float invDistance = 1.0f / scene.maxDistance;
+
+        for (UInt32 i = bucket * perBucket; i < (bucket + 1) * perBucket; ++i) {
+            const Object &object = scene.objects[i];
+            const Float depth = distance(object) * invDistance;
+
+            DrawItem item;
+            item.material = object.material;
+            item.texture = object.texture;
+            item.mesh = object.mesh;
+            item.object = i;
+
+            if (object.translucent) {
+                item.pass = PASS_TRANSLUCENT;
+                item.key = DrawKey::translucent(item.pass, item.material, item.texture, item.mesh, depth);
+                items.push_back(item);
+                continue;
+            }
+
+            for (UInt32 pass = PASS_AMBIENT; pass < PASS_TRANSLUCENT; ++pass) {
+                item.pass = pass;
+                item.key = DrawKey::opaque(pass, item.material, item.texture, item.mesh, depth);
+                items.push_back(item);
+            }
+        }
+    }
+
+    static Float elapsed(Int64 timer)
+    {
+        return (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+    }
+
+    static Float best(UInt32 run, Float current, Float time)
+    {
+        return (run == 0) || (time < current) ? time : current;
+    }
+
+    static void report(const String &name, const DrawCommands::Stats &stats)
+    {
+        Application::message(String::print("%s: %u draws, %u state changes (pass %u, material %u, texture %u, mesh %u)",
+                                           name.toUtf8().getData(), stats.numDraws, stats.getNumStateChanges(),
+                                           stats.numPassChanges, stats.numMaterialChanges,
+                                           stats.numTextureChanges, stats.numMeshChanges), "Bench");
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(DrawBench, MyAppSettings)
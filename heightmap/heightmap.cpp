@@ -30,12 +30,27 @@
 
 #include <o3d/engine/landscape/heightmap/heightmapsplatting.h>
 
+#include <o3dsamples/chunklod.h>
+#include <o3dsamples/heightmapprep.h>
+#include <o3dsamples/imageloader.h>
+#include <o3dsamples/processmemory.h>
+#include <o3dsamples/tiledimage.h>
+
+#include <algorithm>
+#include <vector>
+
 #ifdef _MSC_VER
 #pragma comment(lib,"opengl32.lib")
 #endif
 
 //#define BEPO
 
+// load the whole images instead of streaming the tiles baked by heightmaptiler
+//#define MONOLITHIC
+
+// use the L3DT normal map instead of the normals derived from the heights
+//#define L3DT_NORMALMAP
+
 #ifdef BEPO
 #define LEFT KEY_U
 #define RIGHT KEY_E
@@ -57,6 +72,7 @@
 #endif
 
 using namespace o3d;
+using namespace o3dsamples;
 
 /**
  * @brief The HeightmapSample class
@@ -71,10 +87,53 @@ private:
     Renderer* m_glRenderer;
     Scene *m_scene;
     Gui *m_gui;
+    TrueTypeFont *m_font;
+
+    //! A tiled image file, and the reader of its window.
+    struct TiledMap
+    {
+        TiledImage image;
+        TileStreamer streamer;
+
+        TiledMap() : streamer(image) {}
+    };
+
+    enum Maps
+    {
+        MAP_HEIGHT = 0,
+        MAP_NORMAL,
+        MAP_COLOR,
+        NUM_MAPS
+    };
+
+    TiledMap m_maps[NUM_MAPS];
+    Bool m_tiled;
+    Int32 m_windowX;    //!< Level 0 texel of the origin of the window given to the terrain.
+    Int32 m_windowY;
+
+    //! Chunked LOD of the heights given to the terrain, selected for the camera.
+    std::vector<Float> m_heights;
+    ChunkLod m_chunkLod;
+
+    Float m_prepTime;   //!< Milliseconds of the heightmap preprocessing.
+
+    Int64 m_startTime;
+    Float m_firstFrameTime;
+    UInt64 m_firstFramePeak;
+
+    static const UInt32 WINDOW_SIZE = 2048;               //!< Heightmap texels of the tiled mode window.
 
 public:
 
-    HeightmapSample(Dir &basePath)
+    HeightmapSample(Dir &basePath) :
+        m_font(nullptr),
+        m_tiled(False),
+        m_windowX(0),
+        m_windowY(0),
+        m_prepTime(0.0f),
+        m_startTime(System::getTime()),
+        m_firstFrameTime(-1.0f),
+        m_firstFramePeak(0)
 	{
         m_appWindow = new AppWindow;
 
@@ -111,9 +170,9 @@ public:
         // Window initialisation
         getScene()->getContext()->setBackgroundColor(0.633f,0.792f,.914f,0.0f);
 
-        TrueTypeFont * lpFont = getGui()->getFontManager()->addTrueTypeFont(basePath.makeFullFileName("gui/arial.ttf"));
-        lpFont->setTextHeight(12);
-        lpFont->setColor(Color(0.0f, 0.0f, 0.0f));
+        m_font = getGui()->getFontManager()->addTrueTypeFont(basePath.makeFullFileName("gui/arial.ttf"));
+        m_font->setTextHeight(12);
+        m_font->setColor(Color(0.0f, 0.0f, 0.0f));
 
         // Camera initialisation
         Camera *lpFPSCamera = new Camera(getScene());
@@ -135,15 +194,53 @@ public:
         lnode->addTransform(ftransform);
 
         // Terrain loading
-        Image lHeightmap(basePath.makeFullFileName("terrain/heightmap/L3DT_Heightmap.jpg"));
-        Image lNormalmap(basePath.makeFullFileName("terrain/heightmap/L3DT_Normal.jpg"));
-        Image lColormap(basePath.makeFullFileName("terrain/heightmap/L3DT_Colormap.jpg"));
-        Image lLightmap(basePath.makeFullFileName("terrain/heightmap/L3DT_Lightmap.jpg"));
-        Image lNoise(basePath.makeFullFileName("terrain/heightmap/Noise.jpg"));
+        Image lHeightmap, lNormalmap, lColormap, lNoise;
+
+        // the preparation of the heights runs on a pool, the decoding stays on this thread
+        WorkerPool lPool;
+        ImageLoader lLoader;
+        lLoader.add(basePath.makeFullFileName("terrain/heightmap/Noise.jpg"), lNoise);
+
+#ifndef MONOLITHIC
+        m_tiled = openTiles(basePath);
+#endif
+
+        if (m_tiled) {
+            // the terrain takes whole images, it is given once the window around the center
+            // of the tiled images, only the tiles of the window are read. The streaming of
+            // the tiles around a moving camera is measured by heightmapbench
+            const TiledImageHeader &lHeader = m_maps[MAP_HEIGHT].image.getHeader();
+            const UInt32 lWindowSize = WINDOW_SIZE;
+
+            m_windowX = (Int32(lHeader.width) - Int32(std::min(lHeader.width, lWindowSize))) / 2;
+            m_windowY = (Int32(lHeader.height) - Int32(std::min(lHeader.height, lWindowSize))) / 2;
 
-        // Flip those two images so that they will appear as they are shown in your OS
-        Bool lRet = lHeightmap.hFlip();
-        lRet = lColormap.hFlip();
+            composeWindow(m_maps[MAP_HEIGHT], lHeightmap);
+            composeWindow(m_maps[MAP_COLOR], lColormap);
+        } else {
+            lLoader.add(basePath.makeFullFileName("terrain/heightmap/L3DT_Heightmap.jpg"), lHeightmap);
+            lLoader.add(basePath.makeFullFileName("terrain/heightmap/L3DT_Colormap.jpg"), lColormap);
+        }
+
+        if (!lLoader.load()) {
+            System::print(String::print("%u images could not be decoded", lLoader.getStats().numFailed), "Heightmap");
+        }
+
+        System::print(String::print("%u images decoded in %.2f ms",
+                                    lLoader.getStats().numImages, lLoader.getStats().time), "Heightmap");
+
+        prepareHeightmap(lHeightmap, lNormalmap, lColormap, lPool);
+
+        // the L3DT normal map when the normals are not derived from the heights
+        if (!lNormalmap.isValid()) {
+            if (m_tiled) {
+                composeWindow(m_maps[MAP_NORMAL], lNormalmap);
+            } else {
+                lNormalmap.load(basePath.makeFullFileName("terrain/heightmap/L3DT_Normal.jpg"));
+            }
+        }
+
+        buildChunkLod(lHeightmap.getWidth(), lHeightmap.getHeight(), lpFPSCamera);
 
         HeightmapSplatting * lpHeightmap = new HeightmapSplatting(getScene(), lpFPSCamera, HeightmapSplatting::OPT_NOISE);
         lpHeightmap->setUnits(Vector3(1.0f, 0.1f, 1.0f));
@@ -152,7 +249,7 @@ public:
         lpHeightmap->setNormalmap(lNormalmap);
 
         lpHeightmap->setColormap(lColormap);
-    //	lpHeightmap->setLightmap(lLightmap);
+    //	lpHeightmap->setLightmap(Image(basePath.makeFullFileName("terrain/heightmap/L3DT_Lightmap.jpg")));
         lpHeightmap->setNoise(lNoise);
 
         getScene()->getLandscape()->getTerrainManager().addTerrain(lpHeightmap);
@@ -204,12 +301,189 @@ public:
 
 		SceneObject *lpCamera = getScene()->getSceneObjectManager()->searchName("CameraFPS");
 		lpCamera->getNode()->getTransform()->translate(Vector3(cam_t_x,cam_t_y,cam_t_z));
+
+        const Vector3 lCameraPos = lpCamera->getNode()->getTransform()->getPosition();
+
+        // the camera looks toward -Z
+        const Vector3 lView = -lpCamera->getAbsoluteMatrix().getZ();
+        const Vector3 lUp = lpCamera->getAbsoluteMatrix().getY();
+
+        const Float lEye[3] = { lCameraPos[X], lCameraPos[Y], lCameraPos[Z] };
+        const Float lForward[3] = { lView[X], lView[Y], lView[Z] };
+        const Float lUpDir[3] = { lUp[X], lUp[Y], lUp[Z] };
+
+        m_chunkLod.select(lEye, lForward, lUpDir);
 	}
 
 	void onSceneDraw()
 	{
+        if (m_firstFrameTime < 0.0f) {
+            m_firstFrameTime = (Float)(System::getTime() - m_startTime) / (Float)System::getTimeFrequency();
+            m_firstFramePeak = ProcessMemory::getPeakResidentBytes();
+
+            System::print(String::print("%s: first frame in %.2f s, peak resident memory %.1f MB",
+                                        m_tiled ? "Tiled" : "Monolithic",
+                                        m_firstFrameTime, m_firstFramePeak / (1024.f*1024.f)), "Heightmap");
+        }
+
+		Int32 lViewPort[4];
+		getScene()->getContext()->getViewPort(lViewPort);
+
+		Matrix4 l2DProjection, lProjection;
+		l2DProjection.buildOrtho(0.0f, Float(lViewPort[2] - 1), Float(lViewPort[3] - 1), 0.0f, -1.0f, 1.0f);
+
+		lProjection = getScene()->getContext()->projection().get();
+		getScene()->getContext()->projection().set(l2DProjection);
+		getScene()->getContext()->modelView().push();
+		getScene()->getContext()->modelView().identity();
+
+		String lText = String::print("%s    Prep = %.1f ms    First frame = %.2f s    Peak memory = %.1f MB (now %.1f MB)",
+									 m_tiled ? "Tiled" : "Monolithic",
+									 m_prepTime,
+									 m_firstFrameTime,
+									 m_firstFramePeak / (1024.f*1024.f),
+									 ProcessMemory::getPeakResidentBytes() / (1024.f*1024.f));
+		m_font->write(Vector2i(10, 22), lText);
+
+		const ChunkLod::Stats &lLodStats = m_chunkLod.getStats();
+		lText = String::print("Chunk LOD: Chunks = %u (level <= %u)    Triangles = %u (grid %llu)    Selection = %.2f us",
+							  lLodStats.numSelected, lLodStats.maxLevel, lLodStats.numTriangles,
+							  (unsigned long long)m_chunkLod.getGridTriangles(), lLodStats.selectTime);
+		m_font->write(Vector2i(10, 42), lText);
+
+		getScene()->getContext()->modelView().pop();
+		getScene()->getContext()->projection().set(lProjection);
 	}
 
+    /**
+     * @brief Flip the height and color images so that they appear as they are shown in
+     * your OS, derive the heights in the units of the terrain and the normals, in a
+     * single tiled pass over the heightmap. The flipped height and color texels written
+     * by the pass replace the images, the colormap keeping its own size. The tiles are
+     * baked flipped, only the heights and the normals are derived from them. The normal
+     * map is left empty if the normals cannot be derived.
+     */
+    void prepareHeightmap(Image &heightmap, Image &normalmap, Image &colormap, WorkerPool &pool)
+    {
+        HeightmapPrepParams lParams;
+        lParams.flip = !m_tiled;
+        lParams.unitX = 1.0f;
+        lParams.unitY = 0.1f;
+        lParams.unitZ = 1.0f;
+        lParams.texels = lParams.flip;
+#ifdef L3DT_NORMALMAP
+        lParams.normals = False;
+#endif
+
+        const UInt32 lWidth = heightmap.getWidth();
+        const UInt32 lHeight = heightmap.getHeight();
+
+        const HeightmapPrep::Source lHeights(heightmap.getData(), lWidth, lHeight, heightmap.getBpp() / 8);
+        const HeightmapPrep::Source lColors(colormap.getData(), colormap.getWidth(), colormap.getHeight(), colormap.getBpp() / 8);
+
+        const Bool lFlipColors = lParams.flip && colormap.isValid();
+
+        HeightmapPrep lPrep;
+
+        if (lPrep.run(lHeights, lFlipColors ? &lColors : nullptr, nullptr, lParams, &pool)) {
+            m_prepTime = lPrep.getTime();
+            m_heights.assign(lPrep.getHeights(), lPrep.getHeights() + size_t(lWidth) * lHeight);
+
+            if (lParams.normals) {
+                normalmap.loadBuffer(lWidth, lHeight, UInt32(lPrep.getNormalBytes()), PF_RGB_8, lPrep.getNormals());
+            }
+
+            if (lParams.texels) {
+                heightmap.loadBuffer(lWidth, lHeight, UInt32(lPrep.getHeightTexelBytes()),
+                                     heightmap.getPixelFormat(), lPrep.getHeightTexels());
+            }
+
+            if (lFlipColors) {
+                colormap.loadBuffer(lPrep.getColorWidth(), lPrep.getColorHeight(), UInt32(lPrep.getColorBytes()),
+                                    colormap.getPixelFormat(), lPrep.getColors());
+            }
+
+            System::print(String::print("Heightmap prepared in %.2f ms on %u threads",
+                                        m_prepTime, pool.getNumWorkers() + 1), "Heightmap");
+        } else {
+            System::print("Unable to prepare the heightmap", "Heightmap");
+        }
+
+        // heights of the chunk LOD from the first channel of the texels if the prep failed
+        if (m_heights.empty() && heightmap.isValid()) {
+            const UInt32 lTexelSize = heightmap.getBpp() / 8;
+            const UInt8 *lData = heightmap.getData();
+
+            m_heights.resize(size_t(lWidth) * lHeight);
+            for (size_t i = 0; i < m_heights.size(); ++i) {
+                m_heights[i] = lData[i * lTexelSize] * lParams.unitY;
+            }
+        }
+    }
+
+    //! Chunks of the heights given to the terrain, with the units of the terrain.
+    void buildChunkLod(UInt32 width, UInt32 height, Camera *camera)
+    {
+        ChunkLodParams lParams;
+        lParams.fov = camera->getFov();
+        lParams.znear = camera->getZnear();
+        lParams.zfar = camera->getZfar();
+        lParams.aspect = Float(getWindow()->getWidth()) / getWindow()->getHeight();
+        lParams.viewportHeight = getWindow()->getHeight();
+
+        const Int64 lTimer = System::getTime();
+        m_chunkLod.build(m_heights.data(), width, height, 1.0f, 1.0f, lParams);
+
+        System::print(String::print("Chunk LOD: %u chunks on %u levels built in %.2f ms",
+                                    m_chunkLod.getNumNodes(), m_chunkLod.getNumLevels(),
+                                    (Float)(System::getTime() - lTimer) * 1000.f / (Float)System::getTimeFrequency()), "Heightmap");
+    }
+
+    //! Open the tiled images baked by heightmaptiler.
+    Bool openTiles(Dir &basePath)
+    {
+        static const char *lNames[NUM_MAPS] = { "L3DT_Heightmap", "L3DT_Normal", "L3DT_Colormap" };
+
+        for (UInt32 i = 0; i < NUM_MAPS; ++i) {
+            String lFile = basePath.makeFullFileName(String("terrain/heightmap/") + lNames[i] + ".tiles");
+
+            if (!m_maps[i].image.open(lFile.toUtf8().getData())) {
+                System::print(String("Missing ") + lFile + ", run heightmaptiler, loading the whole images", "Heightmap");
+                return False;
+            }
+        }
+
+        return True;
+    }
+
+    //! Texels of a map per heightmap texel.
+    void getMapScale(const TiledMap &map, Float &scaleX, Float &scaleY) const
+    {
+        const TiledImageHeader &lHeights = m_maps[MAP_HEIGHT].image.getHeader();
+        const TiledImageHeader &lHeader = map.image.getHeader();
+
+        scaleX = Float(lHeader.width) / Float(lHeights.width);
+        scaleY = Float(lHeader.height) / Float(lHeights.height);
+    }
+
+    //! Image of the window of a tiled map, at the full resolution of the map.
+    void composeWindow(const TiledMap &map, Image &image)
+    {
+        const TiledImageHeader &lHeader = map.image.getHeader();
+
+        Float lScaleX, lScaleY;
+        getMapScale(map, lScaleX, lScaleY);
+
+        const UInt32 lWindowSize = WINDOW_SIZE;
+        const UInt32 lWidth = std::min(lHeader.getLevelWidth(0), UInt32(lWindowSize * lScaleX));
+        const UInt32 lHeight = std::min(lHeader.getLevelHeight(0), UInt32(lWindowSize * lScaleY));
+
+        std::vector<UInt8> lData(size_t(lWidth) * lHeight * lHeader.texelSize);
+        map.streamer.compose(0, Int32(m_windowX * lScaleX), Int32(m_windowY * lScaleY), lWidth, lHeight, lData.data());
+
+        image.loadBuffer(lWidth, lHeight, UInt32(lData.size()), PixelFormat(lHeader.format), lData.data());
+    }
+
     void onMouseMotion(Mouse* mouse)
 	{
 		Float elapsed = getScene()->getFrameManager()->getFrameDuration();
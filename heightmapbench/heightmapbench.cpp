@@ -0,0 +1,608 @@
+/**
+ * @file heightmapbench.cpp
+ * @brief Headless chunk LOD selection and preprocessing benchmark of the heightmap terrain.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/dir.h>
+#include <o3d/core/string.h>
+
+#include <o3d/image/image.h>
+
+#include <o3dsamples/chunklod.h>
+#include <o3dsamples/heightmapprep.h>
+#include <o3dsamples/perlinnoise.h>
+#include <o3dsamples/tiledimage.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Replay a camera path over the heightmap of the heightmap sample, then over
+ * generated heightmaps of 1025 to 8193 vertices a side, through the chunk LOD. The
+ * camera has the sample values (fov 60, zfar 500, 800x600). The selected triangles
+ * must stay bounded whatever the size of the heightmap, while the single grid grows
+ * with it.
+ * Then time the preprocessing of the heightmaps of 1024 to 8192 texels a side, as
+ * separate full image passes (flips, scale, noise, normals) and as the fused tiled
+ * pass of HeightmapPrep, on one thread and on the pool. The outputs must be identical.
+ * The heightmap sample runs the prep once without noise, the flipped height texels and
+ * colors it writes being copied into the images given to the terrain, this case is
+ * timed against the separate passes too.
+ * Then the colors of another size than the heights, as the 128 heightmap and the
+ * 1024 colormap of the media, must be flipped at their own size.
+ * Finally a tiled image of 8192 texels a side is streamed along the fly path, with
+ * the tile settings of the heightmap sample: time of an update, tiles read, resident
+ * memory against the cap, and the texels sampled under the camera once settled.
+ * @date 2026-10-19
+ */
+class HeightmapBench
+{
+public:
+
+    static Int32 main()
+    {
+        Dir basePath("media");
+        if (!basePath.exists()) {
+            basePath = Dir("../media");
+            if (!basePath.exists()) {
+                Application::message("Missing media content", "Error");
+                return -1;
+            }
+        }
+
+        WorkerPool pool;
+
+        // the heightmap of the sample, with its units of 1, 0.1, 1
+        Image image(basePath.makeFullFileName("terrain/heightmap/L3DT_Heightmap.jpg"));
+        if (!image.isValid()) {
+            Application::message("Unable to load the heightmap", "Error");
+            return -1;
+        }
+
+        HeightmapPrepParams prepParams;
+        prepParams.normals = False;
+
+        HeightmapPrep prep;
+        prep.run(HeightmapPrep::Source(image.getData(), image.getWidth(), image.getHeight(), image.getBpp() / 8),
+                 nullptr, nullptr, prepParams, &pool);
+
+        std::vector<Float> heights(prep.getHeights(), prep.getHeights() + size_t(image.getWidth()) * image.getHeight());
+
+        runPath("L3DT", heights, image.getWidth(), image.getHeight(), pool);
+
+        // generated heightmaps, the same relief at every size
+        for (UInt32 size = 1024; size <= 8192; size *= 2) {
+            PerlinNoise noise;
+            noise.setAmplitudes(PerlinNoise::geometricSequence(8, 0.5f, 1.0f));
+            noise.setFrequencies(PerlinNoise::geometricSequence(8, 2, Float(size / 256)));
+            noise.setSize(size + 1);
+            noise.setRandomSeed(7);
+
+            heights.resize(size_t(size + 1) * (size + 1));
+            noise.generate(heights.data(), &pool);
+
+            for (Float &h : heights) {
+                h *= 25.0f;
+            }
+
+            runPath(String::print("noise %u", size + 1), heights, size + 1, size + 1, pool);
+        }
+
+        for (UInt32 size = 1024; size <= 8192; size *= 2) {
+            benchPrep(size, pool);
+        }
+
+        if (!checkMedia(basePath, pool) || !checkSizes(512, 4096, pool)) {
+            return -1;
+        }
+
+        if (!benchTiles(8192)) {
+            return -1;
+        }
+
+        return 0;
+    }
+
+private:
+
+    //! Accumulated values of a path segment.
+    struct Summary
+    {
+        UInt32 numFrames;
+        UInt64 triangles;
+        UInt32 maxTriangles;
+        UInt64 chunks;
+        UInt32 maxChunks;
+        Float selectTime;
+        Float maxSelectTime;
+    };
+
+    enum Segments
+    {
+        SEGMENT_FLY = 0,
+        SEGMENT_LOOK_AROUND,
+        SEGMENT_HIGH,
+        NUM_SEGMENTS
+    };
+
+    static const UInt32 FRAMES_PER_SEGMENT = 600;
+
+    static const UInt32 TILE_SIZE = 256;
+    static const UInt64 TILE_CAP = 32 * 1024 * 1024;   //!< Resident tiles bytes of a map.
+
+    //! Texel of the generated tiled image.
+    static UInt8 tileTexel(UInt32 x, UInt32 y) { return UInt8((x * 7 + y * 13) & 0xff); }
+
+    /**
+     * @brief Write a tiled image of size texels a side, then stream it along the fly
+     * path with a radius of 2 tiles, 4 reads per update at most and a 32 MB cap.
+     * @return False if the cap is passed, or if the texels under the camera are not the
+     * level 0 ones once no tile is pending.
+     */
+    static Bool benchTiles(UInt32 size)
+    {
+        const char *fileName = "heightmapbench.tiles";
+
+        Int64 timer = System::getTime();
+
+        TiledImageWriter writer;
+        std::vector<UInt8> row(size);
+        Bool ok = writer.open(fileName, size, size, 1, 0, TILE_SIZE);
+
+        for (UInt32 y = 0; ok && (y < size); ++y) {
+            for (UInt32 x = 0; x < size; ++x) {
+                row[x] = tileTexel(x, y);
+            }
+            ok = writer.writeRows(row.data(), 1);
+        }
+
+        ok = writer.close() && ok;
+
+        if (!ok) {
+            Application::message(String("Unable to write ") + fileName, "Error");
+            remove(fileName);
+            return False;
+        }
+
+        const Float writeTime = (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+
+        TiledImage image;
+        if (!image.open(fileName)) {
+            Application::message(String("Unable to open ") + fileName, "Error");
+            remove(fileName);
+            return False;
+        }
+
+        TileStreamer streamer(image);
+        streamer.setMemoryCap(TILE_CAP);
+        streamer.setRadius(2);
+        streamer.setMaxLoadsPerUpdate(4);
+
+        Float updateTime = 0.0f, maxUpdateTime = 0.0f;
+        UInt32 maxPending = 0;
+        Float x = 0.0f, y = 0.0f;
+
+        for (UInt32 f = 0; f < FRAMES_PER_SEGMENT; ++f) {
+            const Float t = Float(f) / FRAMES_PER_SEGMENT;
+            x = size * (0.1f + 0.8f * t);
+            y = size * (0.1f + 0.8f * t);
+
+            streamer.update(x, y);
+
+            const TileStreamer::Stats &stats = streamer.getStats();
+            updateTime += stats.lastUpdateTime;
+            maxUpdateTime = std::max(maxUpdateTime, stats.lastUpdateTime);
+            maxPending = std::max(maxPending, stats.numPending);
+        }
+
+        // settle at the last position, then the texels around it must be the level 0 ones
+        UInt32 numSettle = 0;
+        do {
+            streamer.update(x, y);
+            ++numSettle;
+        } while (streamer.getStats().numPending && (numSettle < 100));
+
+        UInt32 numWrong = 0;
+
+        for (UInt32 dy = 0; dy < TILE_SIZE; dy += 7) {
+            for (UInt32 dx = 0; dx < TILE_SIZE; dx += 7) {
+                const UInt32 sx = std::min(UInt32(x) + dx, size - 1);
+                const UInt32 sy = std::min(UInt32(y) + dy, size - 1);
+
+                UInt8 texel = 0;
+                if ((streamer.sample(sx, sy, &texel) != 0) || (texel != tileTexel(sx, sy))) {
+                    ++numWrong;
+                }
+            }
+        }
+
+        image.close();
+        remove(fileName);
+
+        const TileStreamer::Stats &stats = streamer.getStats();
+
+        Application::message(String::print("tiles %u: written in %.1f ms, %u levels // update avg %.3f ms max %.3f ms // "
+                                           "%u read, %u evicted, %u pending max // resident peak %.1f MB of %.1f MB",
+                                           size, writeTime, image.getHeader().numLevels,
+                                           updateTime / FRAMES_PER_SEGMENT, maxUpdateTime,
+                                           stats.numLoaded, stats.numEvicted, maxPending,
+                                           stats.peakResidentBytes / (1024.f*1024.f), TILE_CAP / (1024.f*1024.f)), "Bench");
+
+        if (stats.peakResidentBytes > TILE_CAP) {
+            Application::message("Resident tiles past the cap", "Error");
+            return False;
+        }
+
+        if (numWrong) {
+            Application::message(String::print("%u texels under the camera are not the level 0 ones after %u updates",
+                                               numWrong, numSettle), "Error");
+            return False;
+        }
+
+        return True;
+    }
+
+    /**
+     * @brief Separate passes over the whole images, as the sample and the terrain do:
+     * flip of the heights and of the colors, heights in world units with the noise, the
+     * noise back in the texels, then the normals.
+     */
+    static void referencePasses(std::vector<UInt8> &heightTexels, std::vector<UInt8> &colors,
+                                const HeightmapPrep::Source &noise, UInt32 size, const HeightmapPrepParams &params,
+                                std::vector<Float> &heights, std::vector<UInt8> &normals)
+    {
+        flipRows(heightTexels, size, size, 3);
+        flipRows(colors, size, size, 3);
+
+        heights.resize(size_t(size) * size);
+        for (UInt32 y = 0; y < size; ++y) {
+            for (UInt32 x = 0; x < size; ++x) {
+                heights[size_t(y) * size + x] = heightTexels[(size_t(y) * size + x) * 3] * params.unitY;
+            }
+        }
+
+        if (params.noiseAmplitude != 0.0f) {
+            addNoise(heightTexels, noise, size, params, heights);
+        }
+
+        computeNormals(heights, size, params, normals);
+    }
+
+    //! Noise added to the heights, then into the first channel of the texels.
+    static void addNoise(std::vector<UInt8> &heightTexels, const HeightmapPrep::Source &noise, UInt32 size,
+                         const HeightmapPrepParams &params, std::vector<Float> &heights)
+    {
+        const Float invNoiseScale = 1.0f / params.noiseScale;
+
+        for (UInt32 y = 0; y < size; ++y) {
+            for (UInt32 x = 0; x < size; ++x) {
+                const UInt32 nx = UInt32(x * invNoiseScale) % noise.width;
+                const UInt32 ny = UInt32(y * invNoiseScale) % noise.height;
+                const Float n = noise.data[(size_t(ny) * noise.width + nx) * noise.texelSize] / 255.0f - 0.5f;
+
+                heights[size_t(y) * size + x] += n * 2.0f * params.noiseAmplitude;
+            }
+        }
+
+        // the texels given to the terrain take the noise
+        const Float invY = 1.0f / params.unitY;
+
+        for (size_t i = 0; i < heights.size(); ++i) {
+            heightTexels[i * 3] = UInt8(std::min(std::max(heights[i] * invY + 0.5f, 0.0f), 255.0f));
+        }
+    }
+
+    static void computeNormals(const std::vector<Float> &heights, UInt32 size, const HeightmapPrepParams &params,
+                               std::vector<UInt8> &normals)
+    {
+        normals.resize(size_t(size) * size * 3);
+
+        auto h = [&heights, size] (Int32 x, Int32 y) {
+            x = std::min(std::max(x, 0), Int32(size) - 1);
+            y = std::min(std::max(y, 0), Int32(size) - 1);
+            return heights[size_t(y) * size + x];
+        };
+
+        const Float invX = 1.0f / (8.0f * params.unitX);
+        const Float invZ = 1.0f / (8.0f * params.unitZ);
+
+        for (Int32 y = 0; y < Int32(size); ++y) {
+            for (Int32 x = 0; x < Int32(size); ++x) {
+                const Float dx = ((h(x+1, y-1) + 2.0f * h(x+1, y) + h(x+1, y+1)) -
+                                  (h(x-1, y-1) + 2.0f * h(x-1, y) + h(x-1, y+1))) * invX;
+                const Float dz = ((h(x-1, y+1) + 2.0f * h(x, y+1) + h(x+1, y+1)) -
+                                  (h(x-1, y-1) + 2.0f * h(x, y-1) + h(x+1, y-1))) * invZ;
+
+                const Float inv = 1.0f / std::sqrt(dx*dx + dz*dz + 1.0f);
+
+                UInt8 *normal = &normals[(size_t(y) * size + x) * 3];
+                normal[0] = HeightmapPrep::encode(-dx * inv);
+                normal[1] = HeightmapPrep::encode(-dz * inv);
+                normal[2] = HeightmapPrep::encode(inv);
+            }
+        }
+    }
+
+    static void flipRows(std::vector<UInt8> &data, UInt32 width, UInt32 height, UInt32 texelSize)
+    {
+        const size_t pitch = size_t(width) * texelSize;
+        std::vector<UInt8> row(pitch);
+
+        for (UInt32 y = 0; y < height / 2; ++y) {
+            UInt8 *a = &data[y * pitch];
+            UInt8 *b = &data[(height - 1 - y) * pitch];
+
+            memcpy(row.data(), a, pitch);
+            memcpy(a, b, pitch);
+            memcpy(b, row.data(), pitch);
+        }
+    }
+
+    static void benchPrep(UInt32 size, WorkerPool &pool)
+    {
+        // RGB heights and colors, like the L3DT exports, and the detail noise
+        PerlinNoise relief;
+        relief.setAmplitudes(PerlinNoise::geometricSequence(8, 0.5f, 0.5f));
+        relief.setFrequencies(PerlinNoise::geometricSequence(8, 2, 4));
+        relief.setPositive(True);
+        relief.setSize(size);
+        relief.setRandomSeed(7);
+
+        std::vector<Float> values(size_t(size) * size);
+        relief.generate(values.data(), &pool);
+
+        std::vector<UInt8> heightTexels(values.size() * 3);
+        std::vector<UInt8> colors(values.size() * 3);
+
+        for (size_t i = 0; i < values.size(); ++i) {
+            const UInt8 v = UInt8(std::min(std::max(values[i] * 255.0f, 0.0f), 255.0f));
+            heightTexels[i * 3] = heightTexels[i * 3 + 1] = heightTexels[i * 3 + 2] = v;
+            colors[i * 3] = v;
+            colors[i * 3 + 1] = UInt8(255 - v);
+            colors[i * 3 + 2] = UInt8(i);
+        }
+
+        std::vector<UInt8> noiseTexels(256 * 256);
+        for (size_t i = 0; i < noiseTexels.size(); ++i) {
+            noiseTexels[i] = UInt8((i * 2654435761u) >> 24);
+        }
+
+        const HeightmapPrep::Source noise(noiseTexels.data(), 256, 256, 1);
+
+        HeightmapPrepParams params;
+        params.noiseAmplitude = 0.05f;
+
+        // fused passes first, the reference flips the images in place
+        const HeightmapPrep::Source colorSource(colors.data(), size, size, 3);
+
+        const HeightmapPrep::Source heightSource(heightTexels.data(), size, size, 3);
+
+        // the first run also maps the pages of the outputs, the second reuses them
+        HeightmapPrep single, parallel;
+
+        single.run(heightSource, &colorSource, &noise, params);
+        const Float coldTime = single.getTime();
+        single.run(heightSource, &colorSource, &noise, params);
+
+        parallel.run(heightSource, &colorSource, &noise, params, &pool);
+        parallel.run(heightSource, &colorSource, &noise, params, &pool);
+
+        // as the sample, no noise, the flipped texels and colors written by the prep then
+        // copied into the images given to the terrain
+        HeightmapPrepParams sampleParams;
+
+        std::vector<UInt8> sampleHeightTexels(heightTexels), sampleColors(colors);
+        std::vector<Float> sampleHeights;
+        std::vector<UInt8> sampleNormals;
+
+        Int64 timer = System::getTime();
+        referencePasses(sampleHeightTexels, sampleColors, noise, size, sampleParams, sampleHeights, sampleNormals);
+        const Float sampleReferenceTime = (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+
+        std::vector<UInt8> imageTexels(heightTexels.size()), imageColors(colors.size());
+
+        HeightmapPrep sample;
+
+        timer = System::getTime();
+        sample.run(heightSource, &colorSource, nullptr, sampleParams, &pool);
+        memcpy(imageTexels.data(), sample.getHeightTexels(), sample.getHeightTexelBytes());
+        memcpy(imageColors.data(), sample.getColors(), sample.getColorBytes());
+        const Float sampleTime = (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+
+        const Bool sampleSame = (memcmp(sampleHeights.data(), sample.getHeights(), sampleHeights.size() * sizeof(Float)) == 0) &&
+                                (memcmp(sampleNormals.data(), sample.getNormals(), sampleNormals.size()) == 0) &&
+                                (imageTexels == sampleHeightTexels) && (imageColors == sampleColors);
+
+        std::vector<Float> heights;
+        std::vector<UInt8> normals;
+
+        timer = System::getTime();
+        referencePasses(heightTexels, colors, noise, size, params, heights, normals);
+        const Float referenceTime = (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+
+        const size_t heightBytes = heights.size() * sizeof(Float);
+
+        const Bool same = (memcmp(heights.data(), single.getHeights(), heightBytes) == 0) &&
+                          (memcmp(normals.data(), single.getNormals(), normals.size()) == 0) &&
+                          (memcmp(colors.data(), single.getColors(), colors.size()) == 0) &&
+                          (memcmp(heightTexels.data(), single.getHeightTexels(), heightTexels.size()) == 0) &&
+                          (memcmp(single.getHeights(), parallel.getHeights(), heightBytes) == 0) &&
+                          (memcmp(single.getNormals(), parallel.getNormals(), normals.size()) == 0);
+
+        Application::message(String::print("prep %u: separate passes %.2fms // fused %.2fms (x%.1f), reused %.2fms (x%.1f) // "
+                                           "fused on %u workers %.2fms (x%.1f) %s",
+                                           size, referenceTime,
+                                           coldTime, referenceTime / coldTime,
+                                           single.getTime(), referenceTime / single.getTime(),
+                                           pool.getNumWorkers() + 1, parallel.getTime(), referenceTime / parallel.getTime(),
+                                           same ? "identical" : "DIFFERENT"), "Bench");
+
+        Application::message(String::print("prep %u as the sample: separate passes %.2fms // prep writing the flipped "
+                                           "texels and colors, and their copies %.2fms (x%.1f) %s",
+                                           size, sampleReferenceTime, sampleTime, sampleReferenceTime / sampleTime,
+                                           sampleSame ? "identical" : "DIFFERENT"), "Bench");
+    }
+
+    //! Heights and colors of different sizes: the colors must be flipped at their own size.
+    static Bool checkColors(const String &name, const HeightmapPrep::Source &heights, const HeightmapPrep::Source &colors,
+                            WorkerPool &pool)
+    {
+        HeightmapPrepParams params;
+
+        std::vector<UInt8> flipped(colors.data, colors.data + size_t(colors.width) * colors.height * colors.texelSize);
+        flipRows(flipped, colors.width, colors.height, colors.texelSize);
+
+        HeightmapPrep single, parallel;
+
+        const Bool done = single.run(heights, &colors, nullptr, params) &&
+                          parallel.run(heights, &colors, nullptr, params, &pool);
+
+        const Bool same = done &&
+                          (single.getColorWidth() == colors.width) && (single.getColorHeight() == colors.height) &&
+                          (single.getColorBytes() == flipped.size()) &&
+                          (memcmp(single.getColors(), flipped.data(), flipped.size()) == 0) &&
+                          (memcmp(parallel.getColors(), flipped.data(), flipped.size()) == 0);
+
+        Application::message(String::print("%s: heights %ux%u, colors %ux%u, prep %.2fms, on %u workers %.2fms, colors %s",
+                                           name.toUtf8().getData(), heights.width, heights.height, colors.width, colors.height,
+                                           single.getTime(), pool.getNumWorkers() + 1, parallel.getTime(),
+                                           same ? "flipped at their size" : "DIFFERENT"), done && same ? "Bench" : "Error");
+
+        return done && same;
+    }
+
+    //! The heightmap and the colormap of the heightmap sample.
+    static Bool checkMedia(Dir &basePath, WorkerPool &pool)
+    {
+        Image heightmap(basePath.makeFullFileName("terrain/heightmap/L3DT_Heightmap.jpg"));
+        Image colormap(basePath.makeFullFileName("terrain/heightmap/L3DT_Colormap.jpg"));
+
+        if (!heightmap.isValid() || !colormap.isValid()) {
+            Application::message("Unable to load the heightmap and the colormap", "Error");
+            return False;
+        }
+
+        return checkColors("L3DT",
+                           HeightmapPrep::Source(heightmap.getData(), heightmap.getWidth(), heightmap.getHeight(), heightmap.getBpp() / 8),
+                           HeightmapPrep::Source(colormap.getData(), colormap.getWidth(), colormap.getHeight(), colormap.getBpp() / 8),
+                           pool);
+    }
+
+    static Bool checkSizes(UInt32 heightSize, UInt32 colorSize, WorkerPool &pool)
+    {
+        std::vector<UInt8> heightTexels(size_t(heightSize) * heightSize);
+        std::vector<UInt8> colors(size_t(colorSize) * colorSize * 3);
+
+        for (size_t i = 0; i < heightTexels.size(); ++i) {
+            heightTexels[i] = UInt8((i * 2654435761u) >> 24);
+        }
+        for (size_t i = 0; i < colors.size(); ++i) {
+            colors[i] = UInt8(i * 7 + (i >> 12));
+        }
+
+        return checkColors(String::print("sizes %u/%u", heightSize, colorSize),
+                           HeightmapPrep::Source(heightTexels.data(), heightSize, heightSize, 1),
+                           HeightmapPrep::Source(colors.data(), colorSize, colorSize, 3),
+                           pool);
+    }
+
+    static void runPath(const String &name, const std::vector<Float> &heights, UInt32 width, UInt32 height, WorkerPool &pool)
+    {
+        static const char *segments[NUM_SEGMENTS] = { "fly", "look around", "high" };
+
+        ChunkLodParams params;
+
+        Int64 timer = System::getTime();
+
+        ChunkLod lod;
+        if (!lod.build(heights.data(), width, height, 1.0f, 1.0f, params, &pool)) {
+            Application::message(String("Unable to build ") + name, "Error");
+            return;
+        }
+
+        const Float buildTime = (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+
+        Application::message(String::print("%s: %ux%u, %u chunks on %u levels built in %.2f ms, single grid %llu triangles",
+                                           name.toUtf8().getData(), width, height, lod.getNumNodes(), lod.getNumLevels(),
+                                           buildTime, (unsigned long long)lod.getGridTriangles()), "Bench");
+
+        const Float sizeX = Float(width - 1), sizeZ = Float(height - 1);
+
+        for (UInt32 s = 0; s < NUM_SEGMENTS; ++s) {
+            Summary summary = {};
+
+            for (UInt32 f = 0; f < FRAMES_PER_SEGMENT; ++f) {
+                const Float t = Float(f) / FRAMES_PER_SEGMENT;
+
+                Float eye[3], yaw, pitch;
+
+                if (s == SEGMENT_FLY) {
+                    // along the diagonal, looking ahead
+                    eye[0] = sizeX * (0.1f + 0.8f * t);
+                    eye[2] = sizeZ * (0.1f + 0.8f * t);
+                    yaw = 0.785f;
+                    pitch = -0.15f;
+                } else {
+                    // turning at the center, near the ground then high above
+                    eye[0] = sizeX * 0.5f;
+                    eye[2] = sizeZ * 0.5f;
+                    yaw = t * 6.2832f;
+                    pitch = s == SEGMENT_HIGH ? -0.6f : -0.1f;
+                }
+
+                const UInt32 vx = std::min(UInt32(eye[0]), width - 1);
+                const UInt32 vz = std::min(UInt32(eye[2]), height - 1);
+                eye[1] = lod.getHeight(vx, vz) + (s == SEGMENT_HIGH ? 200.0f : 2.0f);
+
+                const Float forward[3] = { std::cos(pitch) * std::cos(yaw), std::sin(pitch), std::cos(pitch) * std::sin(yaw) };
+                const Float up[3] = { -std::sin(pitch) * std::cos(yaw), std::cos(pitch), -std::sin(pitch) * std::sin(yaw) };
+
+                lod.select(eye, forward, up);
+
+                const ChunkLod::Stats &stats = lod.getStats();
+
+                ++summary.numFrames;
+                summary.triangles += stats.numTriangles;
+                summary.maxTriangles = std::max(summary.maxTriangles, stats.numTriangles);
+                summary.chunks += stats.numSelected;
+                summary.maxChunks = std::max(summary.maxChunks, stats.numSelected);
+                summary.selectTime += stats.selectTime;
+                summary.maxSelectTime = std::max(summary.maxSelectTime, stats.selectTime);
+            }
+
+            Application::message(String::print("%s, %s: chunks avg %u max %u // triangles avg %u max %u // "
+                                               "selection avg %.2fus max %.2fus",
+                                               name.toUtf8().getData(), segments[s],
+                                               UInt32(summary.chunks / summary.numFrames), summary.maxChunks,
+                                               UInt32(summary.triangles / summary.numFrames), summary.maxTriangles,
+                                               summary.selectTime / summary.numFrames, summary.maxSelectTime), "Bench");
+        }
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(HeightmapBench, MyAppSettings)
@@ -0,0 +1,126 @@
+/**
+ * @file heightmaptiler.cpp
+ * @brief Conversion of the heightmap sample images into tiled mip pyramid files.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/dir.h>
+#include <o3d/core/file.h>
+#include <o3d/core/string.h>
+
+#include <o3d/image/image.h>
+
+#include <o3dsamples/processmemory.h>
+#include <o3dsamples/tiledimage.h>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Bake the L3DT exports of the heightmap sample into .tiles files, next to the
+ * images. The heightmap sample streams them in its tiled mode. The images are flipped
+ * like the sample does before giving them to HeightmapSplatting.
+ * The source image is decoded whole by the engine, then given to the writer strip by
+ * strip, so the writer itself only keeps a strip per level.
+ * @date 2026-10-19
+ */
+class HeightmapTiler
+{
+public:
+
+    static Int32 main()
+    {
+        Dir basePath("media");
+        if (!basePath.exists()) {
+            basePath = Dir("../media");
+            if (!basePath.exists()) {
+                Application::message("Missing media content", "Error");
+                return -1;
+            }
+        }
+
+        static const char *names[4] = { "L3DT_Heightmap", "L3DT_Normal", "L3DT_Colormap", "L3DT_Lightmap" };
+        static const Bool flips[4] = { True, False, True, False };
+
+        for (UInt32 i = 0; i < 4; ++i) {
+            String source = basePath.makeFullFileName(String("terrain/heightmap/") + names[i] + ".jpg");
+            String target = basePath.makeFullFileName(String("terrain/heightmap/") + names[i] + ".tiles");
+
+            if (!convert(source, target, flips[i])) {
+                Application::message(String("Unable to convert ") + source, "Error");
+                return -1;
+            }
+        }
+
+        Application::message(String::print("Peak resident memory %.1f MB",
+                                           ProcessMemory::getPeakResidentBytes() / (1024.f*1024.f)), "Tiler");
+
+        return 0;
+    }
+
+private:
+
+    static const UInt32 TILE_SIZE = 256;
+
+    static Bool convert(const String &source, const String &target, Bool flip)
+    {
+        Int64 timer = System::getTime();
+
+        Image image(source);
+        if (!image.isValid()) {
+            return False;
+        }
+
+        if (flip) {
+            image.hFlip();
+        }
+
+        const UInt32 width = image.getWidth();
+        const UInt32 height = image.getHeight();
+        const UInt32 texelSize = image.getBpp() / 8;
+        const UInt8 *data = image.getData();
+
+        TiledImageWriter writer;
+        if (!writer.open(target.toUtf8().getData(), width, height, texelSize, UInt32(image.getPixelFormat()), TILE_SIZE)) {
+            return False;
+        }
+
+        // a strip of rows at a time, as a decoder of rows would give them
+        for (UInt32 y = 0; y < height; y += TILE_SIZE) {
+            const UInt32 count = height - y < TILE_SIZE ? height - y : TILE_SIZE;
+            writer.writeRows(data + size_t(y) * width * texelSize, count);
+        }
+
+        if (!writer.close()) {
+            return False;
+        }
+
+        const Float time = (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+
+        Application::message(String::print("%ux%u, %u bytes per texel, %u levels of %u tiles, in %.2f ms",
+                                           width, height, texelSize, writer.getHeader().numLevels, TILE_SIZE, time), "Tiler");
+        Application::message(String("  ") + target, "Tiler");
+
+        return True;
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(HeightmapTiler, MyAppSettings)
@@ -0,0 +1,141 @@
+/**
+ * @file imagebench.cpp
+ * @brief Headless image decoding throughput benchmark over the media of the samples.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/dir.h>
+#include <o3d/core/string.h>
+
+#include <o3d/image/image.h>
+
+#include <o3dsamples/imageloader.h>
+
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Decode the images of media/textures and media/terrain, the ones loaded at the
+ * startup of the samples, one after the other. Each set is decoded a few times and the
+ * best run is kept, the files being in the system cache after the first one.
+ * The decoders are the ones of the engine, this measures them, it does not change them.
+ * @date 2026-10-19
+ */
+class ImageBench
+{
+public:
+
+    static Int32 main()
+    {
+        Dir basePath("media");
+        if (!basePath.exists()) {
+            basePath = Dir("../media");
+            if (!basePath.exists()) {
+                Application::message("Missing media content", "Error");
+                return -1;
+            }
+        }
+
+        static const char *files[] = {
+            "textures/sky01_xp.jpg", "textures/sky01_xn.jpg", "textures/sky01_yp.jpg",
+            "textures/sky01_zp.jpg", "textures/sky01_zn.jpg",
+            "textures/earth.jpg", "textures/axe.jpg", "textures/dwarf.jpg", "textures/dwarf2.jpg",
+            "textures/monster.jpg",
+            "textures/Flare1.bmp", "textures/Flare2.bmp", "textures/Flare3.bmp",
+            "textures/Flare4.bmp", "textures/Flare5.bmp", "textures/Flare6.bmp",
+            "textures/Shine0.bmp", "textures/Shine1.bmp", "textures/Shine2.bmp", "textures/Shine3.bmp",
+            "textures/Shine4.bmp", "textures/Shine5.bmp", "textures/Shine6.bmp", "textures/Shine7.bmp",
+            "textures/Shine8.bmp", "textures/Shine9.bmp",
+            "terrain/hemispherical_2048.png", "terrain/moon256.png", "terrain/sun.png", "terrain/noise.jpg",
+            "terrain/heightmap/L3DT_Heightmap.jpg", "terrain/heightmap/L3DT_Normal.jpg",
+            "terrain/heightmap/L3DT_Colormap.jpg", "terrain/heightmap/L3DT_Lightmap.jpg",
+            "terrain/heightmap/Noise.jpg"
+        };
+
+        const UInt32 numFiles = UInt32(sizeof(files) / sizeof(files[0]));
+
+        std::vector<String> fileNames;
+        for (UInt32 i = 0; i < numFiles; ++i) {
+            fileNames.push_back(basePath.makeFullFileName(files[i]));
+        }
+
+        const ImageLoader::Stats all = run(fileNames);
+        report("startup images", all);
+
+        if (all.numFailed) {
+            Application::message(String::print("%u images could not be decoded", all.numFailed), "Error");
+            return -1;
+        }
+
+        // the startup set of the heightmap sample alone
+        std::vector<String> heightmapNames;
+        for (UInt32 i = numFiles - 5; i < numFiles; ++i) {
+            heightmapNames.push_back(fileNames[i]);
+        }
+
+        report("heightmap images", run(heightmapNames));
+
+        return 0;
+    }
+
+private:
+
+    static const UInt32 NUM_RUNS = 3;
+
+    //! Best of a few loads of every file.
+    static ImageLoader::Stats run(const std::vector<String> &fileNames)
+    {
+        ImageLoader::Stats best;
+
+        for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+            std::vector<Image> images(fileNames.size());
+            ImageLoader loader;
+
+            for (size_t i = 0; i < fileNames.size(); ++i) {
+                loader.add(fileNames[i], images[i]);
+            }
+
+            loader.load();
+
+            if ((r == 0) || (loader.getStats().time < best.time)) {
+                best = loader.getStats();
+            }
+        }
+
+        return best;
+    }
+
+    static void report(const String &name, const ImageLoader::Stats &stats)
+    {
+        const Float seconds = stats.time / 1000.f;
+
+        Application::message(String::print("%s: %u images in %.2fms, %.1f images/s, "
+                                           "files %.1f MB/s, texels %.1f MB/s",
+                                           name.toUtf8().getData(), stats.numImages, stats.time,
+                                           stats.numImages / seconds,
+                                           stats.fileBytes / (1024.f*1024.f) / seconds,
+                                           stats.texelBytes / (1024.f*1024.f) / seconds), "Bench");
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(ImageBench, MyAppSettings)
@@ -0,0 +1,574 @@
+/**
+ * @file bakedtexture.h
+ * @brief Texture file with its pre-generated mip chain, raw or BC1 compressed.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_BAKEDTEXTURE_H
+#define _O3DSAMPLES_BAKEDTEXTURE_H
+
+#include "contenthash.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief Layout of a baked texture file.
+ * The header, then the levels from the full resolution down to 1x1, each one at the
+ * offset given by the header. Each level halves the size, rounded up. A level maps to
+ * a single upload call: its size, its bytes and the format of the file.
+ * The hash and size of the source file are kept, a file baked from another content of
+ * its source is stale. The raw levels keep the channel order of the source, FLAG_BGR
+ * being set for a blue first source. The BC1 blocks are always red first.
+ */
+struct BakedTextureHeader
+{
+    enum Format
+    {
+        FORMAT_RGB8 = 0,     //!< 3 bytes per texel.
+        FORMAT_RGBA8,        //!< 4 bytes per texel.
+        FORMAT_BC1           //!< 8 bytes per block of 4x4 texels, opaque, RGB565 endpoints.
+    };
+
+    enum Flags
+    {
+        FLAG_BGR = 1         //!< Raw levels in blue, green, red order.
+    };
+
+    static const UInt32 MAX_LEVELS = 16;
+
+    char magic[8];
+    UInt32 version;
+    UInt32 format;
+    UInt32 width;
+    UInt32 height;
+    UInt32 numLevels;
+    UInt32 sourceFormat;              //!< Opaque pixel format of the source image.
+    UInt32 flags;
+    UInt64 sourceHash;                //!< Content hash of the source file, see ContentHash.
+    UInt64 sourceSize;                //!< Bytes of the source file.
+    UInt64 offsets[MAX_LEVELS];       //!< From the start of the file.
+    UInt64 sizes[MAX_LEVELS];
+
+    static const char* getMagic() { return "O3DBAKED"; }
+    static UInt32 getVersion() { return 2; }
+
+    UInt32 getLevelWidth(UInt32 level) const { return std::max<UInt32>(((width - 1) >> level) + 1, 1); }
+    UInt32 getLevelHeight(UInt32 level) const { return std::max<UInt32>(((height - 1) >> level) + 1, 1); }
+
+    //! Bytes of a level of a size in a format.
+    static UInt64 computeLevelSize(UInt32 width, UInt32 height, UInt32 format)
+    {
+        if (format == FORMAT_BC1) {
+            return UInt64((width + 3) / 4) * ((height + 3) / 4) * 8;
+        }
+
+        return UInt64(width) * height * (format == FORMAT_RGBA8 ? 4 : 3);
+    }
+
+    //! Number of levels down to 1x1.
+    static UInt32 computeNumLevels(UInt32 width, UInt32 height)
+    {
+        UInt32 numLevels = 1;
+        while ((width > 1) || (height > 1)) {
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+            ++numLevels;
+        }
+
+        return numLevels;
+    }
+};
+
+/**
+ * @brief A baked texture in memory, built from texels or loaded from a file.
+ * The mip chain uses a 2x2 box filter, the odd last row or column of a level being
+ * repeated. The BC1 encoder fits the endpoints on the bounding box of the block, along
+ * its main diagonal, then takes the nearest of the four colors for each texel. The
+ * blocks are independent and split across a WorkerPool. A blue first source is read
+ * as such by the encoder, the 565 endpoints being red first.
+ */
+class BakedTexture
+{
+public:
+
+    BakedTexture()
+    {
+        memset(&m_header, 0, sizeof(BakedTextureHeader));
+    }
+
+    /**
+     * @brief Build the mip chain of an image.
+     * @param texels Rows of the image, top to bottom.
+     * @param width Width of the image.
+     * @param height Height of the image.
+     * @param texelSize 3 for RGB or 4 for RGBA.
+     * @param sourceFormat Opaque pixel format stored in the header.
+     * @param compress Encode in BC1, only if every texel is opaque.
+     * @param pool Optional pool of workers for the encoding.
+     * @param bgr True if the texels are in blue, green, red order.
+     */
+    Bool build(const UInt8 *texels, UInt32 width, UInt32 height, UInt32 texelSize, UInt32 sourceFormat,
+               Bool compress, WorkerPool *pool = nullptr, Bool bgr = False)
+    {
+        if (!texels || !width || !height || ((texelSize != 3) && (texelSize != 4))) {
+            return False;
+        }
+
+        const UInt32 numLevels = BakedTextureHeader::computeNumLevels(width, height);
+        if (numLevels > BakedTextureHeader::MAX_LEVELS) {
+            return False;
+        }
+
+        if (compress && (texelSize == 4)) {
+            const size_t count = size_t(width) * height;
+            for (size_t i = 0; i < count; ++i) {
+                if (texels[i * 4 + 3] != 255) {
+                    compress = False;
+                    break;
+                }
+            }
+        }
+
+        memset(&m_header, 0, sizeof(BakedTextureHeader));
+        memcpy(m_header.magic, BakedTextureHeader::getMagic(), 8);
+        m_header.version = BakedTextureHeader::getVersion();
+        m_header.format = compress ? BakedTextureHeader::FORMAT_BC1 :
+                          (texelSize == 4 ? BakedTextureHeader::FORMAT_RGBA8 : BakedTextureHeader::FORMAT_RGB8);
+        m_header.width = width;
+        m_header.height = height;
+        m_header.numLevels = numLevels;
+        m_header.sourceFormat = sourceFormat;
+        m_header.flags = bgr ? BakedTextureHeader::FLAG_BGR : 0;
+
+        UInt64 offset = sizeof(BakedTextureHeader);
+        for (UInt32 l = 0; l < numLevels; ++l) {
+            m_header.offsets[l] = offset;
+            m_header.sizes[l] = BakedTextureHeader::computeLevelSize(
+                                    m_header.getLevelWidth(l), m_header.getLevelHeight(l), m_header.format);
+            offset += m_header.sizes[l];
+        }
+
+        m_data.assign(size_t(offset), 0);
+        memcpy(m_data.data(), &m_header, sizeof(BakedTextureHeader));
+
+        // raw levels, with the texel size of the source
+        std::vector<UInt8> level(texels, texels + size_t(width) * height * texelSize);
+        std::vector<UInt8> next;
+
+        for (UInt32 l = 0; l < numLevels; ++l) {
+            const UInt32 w = m_header.getLevelWidth(l);
+            const UInt32 h = m_header.getLevelHeight(l);
+
+            if (compress) {
+                encodeBC1(level.data(), w, h, texelSize, bgr, &m_data[size_t(m_header.offsets[l])], pool);
+            } else {
+                memcpy(&m_data[size_t(m_header.offsets[l])], level.data(), level.size());
+            }
+
+            if (l + 1 < numLevels) {
+                halve(level, w, h, texelSize, next);
+                level.swap(next);
+            }
+        }
+
+        return True;
+    }
+
+    /**
+     * @brief Content hash and size of a source file, the key of its baked file.
+     * @return False if the file cannot be read.
+     */
+    static Bool hashSource(const char *path, UInt64 &hash, UInt64 &size)
+    {
+        ContentHash content;
+        if (!content.updateFile(path)) {
+            return False;
+        }
+
+        FILE *file = fopen(path, "rb");
+        if (!file) {
+            return False;
+        }
+
+        fseek(file, 0, SEEK_END);
+        const long bytes = ftell(file);
+        fclose(file);
+
+        hash = content.get();
+        size = bytes > 0 ? UInt64(bytes) : 0;
+
+        return True;
+    }
+
+    //! Set the key of the source, see hashSource, once built.
+    void setSource(UInt64 hash, UInt64 size)
+    {
+        m_header.sourceHash = hash;
+        m_header.sourceSize = size;
+
+        if (m_data.size() >= sizeof(BakedTextureHeader)) {
+            memcpy(m_data.data(), &m_header, sizeof(BakedTextureHeader));
+        }
+    }
+
+    //! True if it was baked from this content of its source, see hashSource.
+    Bool isBakedFrom(UInt64 hash, UInt64 size) const
+    {
+        return !m_data.empty() && (m_header.sourceHash == hash) && (m_header.sourceSize == size);
+    }
+
+    //! Write the file.
+    Bool save(const char *path) const
+    {
+        if (m_data.empty()) {
+            return False;
+        }
+
+        FILE *file = fopen(path, "wb");
+        if (!file) {
+            return False;
+        }
+
+        const Bool ok = fwrite(m_data.data(), 1, m_data.size(), file) == m_data.size();
+        return (fclose(file) == 0) && ok;
+    }
+
+    //! Read a whole file, in a single read.
+    Bool load(const char *path)
+    {
+        m_data.clear();
+
+        FILE *file = fopen(path, "rb");
+        if (!file) {
+            return False;
+        }
+
+        fseek(file, 0, SEEK_END);
+        const long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        if (size < long(sizeof(BakedTextureHeader))) {
+            fclose(file);
+            return False;
+        }
+
+        m_data.resize(size_t(size));
+        const Bool read = fread(m_data.data(), 1, m_data.size(), file) == m_data.size();
+        fclose(file);
+
+        memcpy(&m_header, m_data.data(), sizeof(BakedTextureHeader));
+
+        if (!read || memcmp(m_header.magic, BakedTextureHeader::getMagic(), 8) ||
+            (m_header.version != BakedTextureHeader::getVersion()) ||
+            !m_header.numLevels || (m_header.numLevels > BakedTextureHeader::MAX_LEVELS) ||
+            (m_header.format > BakedTextureHeader::FORMAT_BC1)) {
+            m_data.clear();
+            return False;
+        }
+
+        for (UInt32 l = 0; l < m_header.numLevels; ++l) {
+            if (m_header.offsets[l] + m_header.sizes[l] > m_data.size()) {
+                m_data.clear();
+                return False;
+            }
+        }
+
+        return True;
+    }
+
+    Bool isValid() const { return !m_data.empty(); }
+
+    //! Baked file of a source image, its extension replaced by .baked.
+    static std::string getFileName(const std::string &source)
+    {
+        std::string name(source);
+
+        const size_t dot = name.find_last_of('.');
+        const size_t slash = name.find_last_of("/\\");
+
+        if ((dot != std::string::npos) && ((slash == std::string::npos) || (dot > slash))) {
+            name.resize(dot);
+        }
+
+        return name + ".baked";
+    }
+
+    const BakedTextureHeader& getHeader() const { return m_header; }
+
+    const UInt8* getLevelData(UInt32 level) const { return &m_data[size_t(m_header.offsets[level])]; }
+    UInt64 getLevelSize(UInt32 level) const { return m_header.sizes[level]; }
+
+    //! Bytes of the file.
+    UInt64 getBytes() const { return m_data.size(); }
+
+    //! Bytes of the levels.
+    UInt64 getLevelsBytes() const { return m_data.empty() ? 0 : m_data.size() - sizeof(BakedTextureHeader); }
+
+    /**
+     * @brief Decode a level to RGBA8, red first, to check an encoding.
+     * @param level Level to decode.
+     * @param out Receives getLevelWidth * getLevelHeight texels.
+     */
+    void decodeLevel(UInt32 level, std::vector<UInt8> &out) const
+    {
+        const UInt32 w = m_header.getLevelWidth(level);
+        const UInt32 h = m_header.getLevelHeight(level);
+        const UInt8 *data = getLevelData(level);
+
+        out.resize(size_t(w) * h * 4);
+
+        if (m_header.format != BakedTextureHeader::FORMAT_BC1) {
+            const UInt32 texelSize = m_header.format == BakedTextureHeader::FORMAT_RGBA8 ? 4 : 3;
+            const UInt32 red = (m_header.flags & BakedTextureHeader::FLAG_BGR) ? 2 : 0;
+
+            for (size_t i = 0; i < size_t(w) * h; ++i) {
+                out[i * 4] = data[i * texelSize + red];
+                out[i * 4 + 1] = data[i * texelSize + 1];
+                out[i * 4 + 2] = data[i * texelSize + 2 - red];
+                out[i * 4 + 3] = texelSize == 4 ? data[i * texelSize + 3] : 255;
+            }
+            return;
+        }
+
+        const UInt32 blocksX = (w + 3) / 4;
+        UInt8 block[16 * 4];
+
+        for (UInt32 by = 0; by < (h + 3) / 4; ++by) {
+            for (UInt32 bx = 0; bx < blocksX; ++bx) {
+                decodeBC1Block(data + (size_t(by) * blocksX + bx) * 8, block);
+
+                for (UInt32 y = 0; y < 4 && by * 4 + y < h; ++y) {
+                    for (UInt32 x = 0; x < 4 && bx * 4 + x < w; ++x) {
+                        memcpy(&out[(size_t(by * 4 + y) * w + bx * 4 + x) * 4], &block[(y * 4 + x) * 4], 4);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Encode a block of 4x4 RGBA8 texels, alpha ignored.
+     * @param texels 16 texels, row by row.
+     * @param out 8 bytes: two RGB565 endpoints, the first one greater, and 2 bits indices.
+     */
+    static void encodeBC1Block(const UInt8 *texels, UInt8 *out)
+    {
+        Int32 lo[3] = { 255, 255, 255 };
+        Int32 hi[3] = { 0, 0, 0 };
+        Int32 mean[3] = { 0, 0, 0 };
+
+        for (UInt32 i = 0; i < 16; ++i) {
+            for (UInt32 c = 0; c < 3; ++c) {
+                lo[c] = std::min<Int32>(lo[c], texels[i * 4 + c]);
+                hi[c] = std::max<Int32>(hi[c], texels[i * 4 + c]);
+                mean[c] += texels[i * 4 + c];
+            }
+        }
+
+        // the diagonal of the bounding box that follows the colors, by the sign of the
+        // covariances of red and blue with green
+        Int32 covRG = 0, covBG = 0;
+        for (UInt32 i = 0; i < 16; ++i) {
+            const Int32 g = texels[i * 4 + 1] * 16 - mean[1];
+            covRG += (texels[i * 4] * 16 - mean[0]) * g;
+            covBG += (texels[i * 4 + 2] * 16 - mean[2]) * g;
+        }
+
+        if (covRG < 0) {
+            std::swap(lo[0], hi[0]);
+        }
+        if (covBG < 0) {
+            std::swap(lo[2], hi[2]);
+        }
+
+        // inset of 1/16 of the range, the extremes are rarely the best endpoints
+        for (UInt32 c = 0; c < 3; ++c) {
+            const Int32 inset = (hi[c] - lo[c]) / 16;
+            hi[c] -= inset;
+            lo[c] += inset;
+        }
+
+        UInt16 c0 = pack565(hi);
+        UInt16 c1 = pack565(lo);
+
+        if (c0 < c1) {
+            std::swap(c0, c1);
+        }
+
+        UInt32 indices = 0;
+
+        if (c0 != c1) {
+            Int32 palette[4][3];
+            unpack565(c0, palette[0]);
+            unpack565(c1, palette[1]);
+
+            for (UInt32 c = 0; c < 3; ++c) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (UInt32 i = 0; i < 16; ++i) {
+                Int32 best = 0x7fffffff;
+                UInt32 index = 0;
+
+                for (UInt32 p = 0; p < 4; ++p) {
+                    const Int32 dr = texels[i * 4] - palette[p][0];
+                    const Int32 dg = texels[i * 4 + 1] - palette[p][1];
+                    const Int32 db = texels[i * 4 + 2] - palette[p][2];
+                    const Int32 d = dr*dr + dg*dg + db*db;
+
+                    if (d < best) {
+                        best = d;
+                        index = p;
+                    }
+                }
+
+                indices |= index << (i * 2);
+            }
+        }
+
+        out[0] = UInt8(c0 & 0xff);
+        out[1] = UInt8(c0 >> 8);
+        out[2] = UInt8(c1 & 0xff);
+        out[3] = UInt8(c1 >> 8);
+        out[4] = UInt8(indices & 0xff);
+        out[5] = UInt8((indices >> 8) & 0xff);
+        out[6] = UInt8((indices >> 16) & 0xff);
+        out[7] = UInt8(indices >> 24);
+    }
+
+    //! Decode a BC1 block to 4x4 RGBA8 texels.
+    static void decodeBC1Block(const UInt8 *block, UInt8 *texels)
+    {
+        const UInt16 c0 = UInt16(block[0] | (block[1] << 8));
+        const UInt16 c1 = UInt16(block[2] | (block[3] << 8));
+        const UInt32 indices = UInt32(block[4]) | (UInt32(block[5]) << 8) | (UInt32(block[6]) << 16) | (UInt32(block[7]) << 24);
+
+        Int32 palette[4][4];
+        unpack565(c0, palette[0]);
+        unpack565(c1, palette[1]);
+        palette[0][3] = palette[1][3] = palette[2][3] = 255;
+
+        if (c0 > c1) {
+            for (UInt32 c = 0; c < 3; ++c) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            palette[3][3] = 255;
+        } else {
+            for (UInt32 c = 0; c < 3; ++c) {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+            palette[3][3] = 0;
+        }
+
+        for (UInt32 i = 0; i < 16; ++i) {
+            const UInt32 index = (indices >> (i * 2)) & 3;
+            for (UInt32 c = 0; c < 4; ++c) {
+                texels[i * 4 + c] = UInt8(palette[index][c]);
+            }
+        }
+    }
+
+private:
+
+    BakedTextureHeader m_header;
+    std::vector<UInt8> m_data;      //!< Whole file content, header included.
+
+    static UInt16 pack565(const Int32 *rgb)
+    {
+        return UInt16(((rgb[0] * 31 + 127) / 255) << 11 | ((rgb[1] * 63 + 127) / 255) << 5 | ((rgb[2] * 31 + 127) / 255));
+    }
+
+    static void unpack565(UInt16 c, Int32 *rgb)
+    {
+        const Int32 r = (c >> 11) & 31;
+        const Int32 g = (c >> 5) & 63;
+        const Int32 b = c & 31;
+
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    //! Next level, 2x2 box filter, the odd last row or column is repeated.
+    static void halve(const std::vector<UInt8> &level, UInt32 width, UInt32 height, UInt32 texelSize,
+                      std::vector<UInt8> &out)
+    {
+        const UInt32 w = (width + 1) / 2;
+        const UInt32 h = (height + 1) / 2;
+
+        out.resize(size_t(w) * h * texelSize);
+
+        for (UInt32 y = 0; y < h; ++y) {
+            const UInt8 *row0 = &level[size_t(std::min(y * 2, height - 1)) * width * texelSize];
+            const UInt8 *row1 = &level[size_t(std::min(y * 2 + 1, height - 1)) * width * texelSize];
+            UInt8 *dst = &out[size_t(y) * w * texelSize];
+
+            for (UInt32 x = 0; x < w; ++x) {
+                const UInt32 a = std::min(x * 2, width - 1) * texelSize;
+                const UInt32 b = std::min(x * 2 + 1, width - 1) * texelSize;
+
+                for (UInt32 c = 0; c < texelSize; ++c) {
+                    dst[x * texelSize + c] = UInt8((row0[a + c] + row0[b + c] + row1[a + c] + row1[b + c] + 2) / 4);
+                }
+            }
+        }
+    }
+
+    //! Encode a level, by rows of blocks, the texels past the border repeat the last ones.
+    static void encodeBC1(const UInt8 *texels, UInt32 width, UInt32 height, UInt32 texelSize, Bool bgr,
+                          UInt8 *out, WorkerPool *pool)
+    {
+        const UInt32 blocksX = (width + 3) / 4;
+        const UInt32 blocksY = (height + 3) / 4;
+
+        // the block is red first
+        const UInt32 red = bgr ? 2 : 0;
+
+        auto encode = [&] (UInt32 begin, UInt32 end) {
+            UInt8 block[16 * 4];
+
+            for (UInt32 by = begin; by < end; ++by) {
+                for (UInt32 bx = 0; bx < blocksX; ++bx) {
+                    for (UInt32 y = 0; y < 4; ++y) {
+                        const UInt32 sy = std::min(by * 4 + y, height - 1);
+
+                        for (UInt32 x = 0; x < 4; ++x) {
+                            const UInt32 sx = std::min(bx * 4 + x, width - 1);
+                            const UInt8 *src = &texels[(size_t(sy) * width + sx) * texelSize];
+
+                            block[(y * 4 + x) * 4] = src[red];
+                            block[(y * 4 + x) * 4 + 1] = src[1];
+                            block[(y * 4 + x) * 4 + 2] = src[2 - red];
+                            block[(y * 4 + x) * 4 + 3] = 255;
+                        }
+                    }
+
+                    encodeBC1Block(block, out + (size_t(by) * blocksX + bx) * 8);
+                }
+            }
+        };
+
+        if (pool) {
+            pool->parallelFor(blocksY, 4, encode);
+        } else {
+            encode(0, blocksY);
+        }
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_BAKEDTEXTURE_H
@@ -0,0 +1,516 @@
+/**
+ * @file chunklod.h
+ * @brief Chunked quadtree LOD of a heightmap, with skirts and frustum selection.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_CHUNKLOD_H
+#define _O3DSAMPLES_CHUNKLOD_H
+
+#include "workerpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief View frustum as six planes pointing inside.
+ */
+struct Frustum
+{
+    Float planes[6][4];
+
+    /**
+     * @brief Set from a perspective camera.
+     * @param eye Position.
+     * @param forward Normalized view direction.
+     * @param up Normalized up direction, orthogonal to forward.
+     * @param fov Vertical field of view in degrees, like Camera::setFov.
+     * @param aspect Width over height.
+     * @param znear Near distance.
+     * @param zfar Far distance, like Camera::setZfar.
+     */
+    void set(const Float *eye, const Float *forward, const Float *up, Float fov, Float aspect, Float znear, Float zfar)
+    {
+        const Float right[3] = {
+            forward[1]*up[2] - forward[2]*up[1],
+            forward[2]*up[0] - forward[0]*up[2],
+            forward[0]*up[1] - forward[1]*up[0] };
+
+        const Float tanY = std::tan(fov * 0.5f * 3.14159265f / 180.0f);
+        const Float tanX = tanY * aspect;
+
+        // side planes: normals of the planes through the eye, toward the inside
+        Float normals[4][3];
+        for (UInt32 c = 0; c < 3; ++c) {
+            normals[0][c] = forward[c] * tanX + right[c];   // left
+            normals[1][c] = forward[c] * tanX - right[c];   // right
+            normals[2][c] = forward[c] * tanY + up[c];      // bottom
+            normals[3][c] = forward[c] * tanY - up[c];      // top
+        }
+
+        for (UInt32 p = 0; p < 4; ++p) {
+            setPlane(p, normals[p], eye);
+        }
+
+        const Float nearPoint[3] = { eye[0] + forward[0]*znear, eye[1] + forward[1]*znear, eye[2] + forward[2]*znear };
+        const Float farPoint[3] = { eye[0] + forward[0]*zfar, eye[1] + forward[1]*zfar, eye[2] + forward[2]*zfar };
+        const Float backward[3] = { -forward[0], -forward[1], -forward[2] };
+
+        setPlane(4, forward, nearPoint);
+        setPlane(5, backward, farPoint);
+    }
+
+    //! Does a box intersect the frustum (conservative, boxes near the corners can pass).
+    Bool intersects(const Float *boxMin, const Float *boxMax) const
+    {
+        for (const Float *plane : planes) {
+            // the corner of the box the most inside the plane
+            const Float x = plane[0] >= 0.0f ? boxMax[0] : boxMin[0];
+            const Float y = plane[1] >= 0.0f ? boxMax[1] : boxMin[1];
+            const Float z = plane[2] >= 0.0f ? boxMax[2] : boxMin[2];
+
+            if (plane[0]*x + plane[1]*y + plane[2]*z + plane[3] < 0.0f) {
+                return False;
+            }
+        }
+
+        return True;
+    }
+
+private:
+
+    void setPlane(UInt32 p, const Float *normal, const Float *point)
+    {
+        const Float length = std::sqrt(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+        const Float inv = length > 0.0f ? 1.0f / length : 0.0f;
+
+        planes[p][0] = normal[0] * inv;
+        planes[p][1] = normal[1] * inv;
+        planes[p][2] = normal[2] * inv;
+        planes[p][3] = -(planes[p][0]*point[0] + planes[p][1]*point[1] + planes[p][2]*point[2]);
+    }
+};
+
+/**
+ * @brief Parameters of the chunk LOD. The camera values follow the heightmap sample.
+ */
+struct ChunkLodParams
+{
+    UInt32 chunkSize;       //!< Quads per chunk side, a power of two.
+    Float pixelError;       //!< Tolerated error on the screen, in pixels.
+    Float fov;              //!< Vertical field of view in degrees.
+    Float aspect;           //!< Width over height of the viewport.
+    Float znear;            //!< Camera::setZnear.
+    Float zfar;             //!< Camera::setZfar.
+    UInt32 viewportHeight;  //!< Pixels.
+
+    ChunkLodParams() :
+        chunkSize(32),
+        pixelError(2.0f),
+        fov(60.0f),
+        aspect(800.0f / 600.0f),
+        znear(0.25f),
+        zfar(500.0f),
+        viewportHeight(600)
+    {
+    }
+};
+
+/**
+ * @brief Chunked quadtree LOD of a heightmap.
+ * - The leaves are chunks of chunkSize quads at the full resolution. Each level up
+ *   covers four times the area with the same number of quads, taking every other
+ *   vertex, up to a root covering the whole heightmap.
+ * - The geometric error of a chunk is computed at build, as the largest vertical
+ *   distance between the heights and its decimated grid, and made at least the error
+ *   of its children so the refinement is monotonic.
+ * - The selection walks the tree from the root, culls the chunks out of the frustum
+ *   (so out of zfar) and keeps a chunk once its error projected at its nearest
+ *   distance is under pixelError. The number of triangles depends on the frustum and
+ *   on the error, not on the size of the heightmap.
+ * - Neighbour chunks of different levels do not share their border vertices. Each
+ *   chunk has skirts hanging from its borders by the error of its parent, which hide
+ *   the cracks.
+ */
+class ChunkLod
+{
+public:
+
+    struct Node
+    {
+        UInt32 x, z;            //!< First vertex.
+        UInt32 quadsX, quadsZ;  //!< Quads of the chunk, clipped to the heightmap.
+        UInt32 level;           //!< 0 is the full resolution.
+        Float boxMin[3];
+        Float boxMax[3];
+        Float error;            //!< Geometric error in world units.
+        Float skirt;            //!< Skirt depth.
+        Int32 children[4];      //!< -1 if none.
+    };
+
+    struct Stats
+    {
+        UInt32 numSelected;     //!< Chunks selected.
+        UInt32 numTriangles;    //!< Triangles of the selected chunks, skirts included.
+        UInt32 numVisited;      //!< Nodes tested.
+        UInt32 numCulled;       //!< Nodes out of the frustum.
+        UInt32 maxLevel;        //!< Coarsest selected level.
+        Float selectTime;       //!< Microseconds.
+    };
+
+    ChunkLod() :
+        m_heights(nullptr),
+        m_width(0),
+        m_height(0),
+        m_unitX(1.0f),
+        m_unitZ(1.0f),
+        m_root(-1),
+        m_numLevels(0)
+    {
+        m_stats = Stats();
+    }
+
+    /**
+     * @brief Build the tree and the errors.
+     * @param heights width * height heights in world units, row by row along Z. They are
+     * kept by the LOD and must outlive it.
+     * @param width Vertices along X.
+     * @param height Vertices along Z.
+     * @param unitX Distance between two vertices along X.
+     * @param unitZ Distance between two vertices along Z.
+     * @param params LOD parameters.
+     * @param pool Optional pool for the errors.
+     */
+    Bool build(const Float *heights, UInt32 width, UInt32 height, Float unitX, Float unitZ,
+               const ChunkLodParams &params, WorkerPool *pool = nullptr)
+    {
+        m_nodes.clear();
+        m_root = -1;
+
+        if (!heights || (width < 2) || (height < 2) || !params.chunkSize || (params.chunkSize & (params.chunkSize - 1))) {
+            return False;
+        }
+
+        m_heights = heights;
+        m_width = width;
+        m_height = height;
+        m_unitX = unitX;
+        m_unitZ = unitZ;
+        m_params = params;
+
+        m_numLevels = 1;
+        while ((UInt64(params.chunkSize) << (m_numLevels - 1)) < std::max(width, height) - 1) {
+            ++m_numLevels;
+        }
+
+        m_root = createNode(0, 0, m_numLevels - 1);
+
+        // the errors level by level from the leaves, a node needs the ones of its children
+        std::vector<std::vector<UInt32>> levels(m_numLevels);
+        for (UInt32 i = 0; i < m_nodes.size(); ++i) {
+            levels[m_nodes[i].level].push_back(i);
+        }
+
+        for (UInt32 l = 0; l < m_numLevels; ++l) {
+            const std::vector<UInt32> &nodes = levels[l];
+
+            auto compute = [this, &nodes] (UInt32 begin, UInt32 end) {
+                for (UInt32 i = begin; i < end; ++i) {
+                    computeNode(m_nodes[nodes[i]]);
+                }
+            };
+
+            if (pool) {
+                pool->parallelFor(UInt32(nodes.size()), 4, compute);
+            } else {
+                compute(0, UInt32(nodes.size()));
+            }
+        }
+
+        // the skirts hang by the error of the parent, the largest step to a neighbour
+        for (Node &node : m_nodes) {
+            node.skirt = std::max(node.error, m_unitX * 0.5f);
+            for (Int32 child : node.children) {
+                if (child >= 0) {
+                    m_nodes[child].skirt = std::max(m_nodes[child].skirt, node.error);
+                }
+            }
+        }
+
+        return True;
+    }
+
+    /**
+     * @brief Select the chunks for a camera.
+     * @param eye Position.
+     * @param forward Normalized view direction.
+     * @param up Normalized up direction.
+     */
+    void select(const Float *eye, const Float *forward, const Float *up)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        m_selection.clear();
+        m_stats = Stats();
+
+        if (m_root < 0) {
+            return;
+        }
+
+        Frustum frustum;
+        frustum.set(eye, forward, up, m_params.fov, m_params.aspect, m_params.znear, m_params.zfar);
+
+        // pixels per world unit at a distance of 1
+        const Float scale = m_params.viewportHeight / (2.0f * std::tan(m_params.fov * 0.5f * 3.14159265f / 180.0f));
+
+        m_stack.clear();
+        m_stack.push_back(m_root);
+
+        while (!m_stack.empty()) {
+            const UInt32 index = m_stack.back();
+            const Node &node = m_nodes[index];
+            m_stack.pop_back();
+
+            ++m_stats.numVisited;
+
+            if (!frustum.intersects(node.boxMin, node.boxMax)) {
+                ++m_stats.numCulled;
+                continue;
+            }
+
+            const Float distance = std::max(boxDistance(node, eye), m_params.znear);
+
+            if ((node.level == 0) || (node.error * scale <= m_params.pixelError * distance)) {
+                m_selection.push_back(index);
+                m_stats.numTriangles += getNumTriangles(node);
+                m_stats.maxLevel = std::max(m_stats.maxLevel, node.level);
+                continue;
+            }
+
+            for (Int32 child : node.children) {
+                if (child >= 0) {
+                    m_stack.push_back(UInt32(child));
+                }
+            }
+        }
+
+        m_stats.numSelected = UInt32(m_selection.size());
+        m_stats.selectTime = std::chrono::duration<Float, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    //! Selected nodes of the last select.
+    const std::vector<UInt32>& getSelection() const { return m_selection; }
+
+    const Node& getNode(UInt32 i) const { return m_nodes[i]; }
+    UInt32 getNumNodes() const { return UInt32(m_nodes.size()); }
+    UInt32 getNumLevels() const { return m_numLevels; }
+
+    const Stats& getStats() const { return m_stats; }
+
+    //! Triangles of the single full resolution grid.
+    UInt64 getGridTriangles() const { return m_root >= 0 ? UInt64(m_width - 1) * (m_height - 1) * 2 : 0; }
+
+    //! Triangles of a chunk, with its skirts.
+    static UInt32 getNumTriangles(const Node &node)
+    {
+        return node.quadsX * node.quadsZ * 2 + (node.quadsX + node.quadsZ) * 4;
+    }
+
+    /**
+     * @brief Geometry of a chunk: the grid vertices row by row, then the skirt vertices
+     * under the border vertices (the lower side, the right side, the upper side and the
+     * left side, in this order).
+     * @param node A node.
+     * @param positions Receives x, y, z per vertex.
+     * @param indices Receives three indices per triangle.
+     */
+    void getGeometry(const Node &node, std::vector<Float> &positions, std::vector<UInt32> &indices) const
+    {
+        const UInt32 step = 1u << node.level;
+        const UInt32 nx = node.quadsX + 1, nz = node.quadsZ + 1;
+
+        positions.clear();
+        indices.clear();
+
+        for (UInt32 j = 0; j < nz; ++j) {
+            for (UInt32 i = 0; i < nx; ++i) {
+                addVertex(node.x + std::min(i * step, m_width - 1 - node.x),
+                          node.z + std::min(j * step, m_height - 1 - node.z), positions);
+            }
+        }
+
+        for (UInt32 j = 0; j < node.quadsZ; ++j) {
+            for (UInt32 i = 0; i < node.quadsX; ++i) {
+                const UInt32 v = j * nx + i;
+                addQuad(v, v + 1, v + nx, v + nx + 1, indices);
+            }
+        }
+
+        // the border loop, counter clockwise seen from above
+        std::vector<UInt32> border;
+        for (UInt32 i = 0; i < node.quadsX; ++i) border.push_back(i);
+        for (UInt32 j = 0; j < node.quadsZ; ++j) border.push_back(j * nx + nx - 1);
+        for (UInt32 i = node.quadsX; i > 0; --i) border.push_back(node.quadsZ * nx + i);
+        for (UInt32 j = node.quadsZ; j > 0; --j) border.push_back(j * nx);
+
+        const UInt32 first = nx * nz;
+
+        for (UInt32 b = 0; b < border.size(); ++b) {
+            const Float *top = &positions[border[b] * 3];
+            positions.push_back(top[0]);
+            positions.push_back(top[1] - node.skirt);
+            positions.push_back(top[2]);
+        }
+
+        for (UInt32 b = 0; b < border.size(); ++b) {
+            const UInt32 next = (b + 1) % UInt32(border.size());
+            addQuad(border[b], border[next], first + b, first + next, indices);
+        }
+    }
+
+    //! Height at a vertex.
+    Float getHeight(UInt32 x, UInt32 z) const { return m_heights[size_t(z) * m_width + x]; }
+
+private:
+
+    const Float *m_heights;
+    UInt32 m_width;
+    UInt32 m_height;
+    Float m_unitX;
+    Float m_unitZ;
+
+    ChunkLodParams m_params;
+
+    std::vector<Node> m_nodes;
+    Int32 m_root;
+    UInt32 m_numLevels;
+
+    std::vector<UInt32> m_selection;
+    std::vector<UInt32> m_stack;
+
+    Stats m_stats;
+
+    Int32 createNode(UInt32 x, UInt32 z, UInt32 level)
+    {
+        const UInt32 step = 1u << level;
+        const UInt32 span = m_params.chunkSize << level;
+
+        if ((x >= m_width - 1) || (z >= m_height - 1)) {
+            return -1;
+        }
+
+        Node node;
+        node.x = x;
+        node.z = z;
+        node.level = level;
+        node.quadsX = (std::min(span, m_width - 1 - x) + step - 1) / step;
+        node.quadsZ = (std::min(span, m_height - 1 - z) + step - 1) / step;
+        node.error = 0.0f;
+        node.skirt = 0.0f;
+
+        for (Int32 &child : node.children) {
+            child = -1;
+        }
+
+        const Int32 index = Int32(m_nodes.size());
+        m_nodes.push_back(node);
+
+        if (level > 0) {
+            const UInt32 half = span / 2;
+            const Int32 children[4] = {
+                createNode(x, z, level - 1),
+                createNode(x + half, z, level - 1),
+                createNode(x, z + half, level - 1),
+                createNode(x + half, z + half, level - 1) };
+
+            std::copy(children, children + 4, m_nodes[index].children);
+        }
+
+        return index;
+    }
+
+    //! Bounding box and error of a node, the ones of its children must be known.
+    void computeNode(Node &node)
+    {
+        const UInt32 step = 1u << node.level;
+        const UInt32 endX = std::min(node.x + node.quadsX * step, m_width - 1);
+        const UInt32 endZ = std::min(node.z + node.quadsZ * step, m_height - 1);
+
+        Float minY = getHeight(node.x, node.z), maxY = minY;
+        Float error = 0.0f;
+
+        for (UInt32 z = node.z; z <= endZ; ++z) {
+            const UInt32 z0 = node.z + ((z - node.z) / step) * step;
+            const UInt32 z1 = std::min(z0 + step, endZ);
+            const Float tz = z1 > z0 ? Float(z - z0) / Float(z1 - z0) : 0.0f;
+
+            for (UInt32 x = node.x; x <= endX; ++x) {
+                const Float h = getHeight(x, z);
+                minY = std::min(minY, h);
+                maxY = std::max(maxY, h);
+
+                if (node.level == 0) {
+                    continue;
+                }
+
+                const UInt32 x0 = node.x + ((x - node.x) / step) * step;
+                const UInt32 x1 = std::min(x0 + step, endX);
+                const Float tx = x1 > x0 ? Float(x - x0) / Float(x1 - x0) : 0.0f;
+
+                const Float h0 = getHeight(x0, z0) + (getHeight(x1, z0) - getHeight(x0, z0)) * tx;
+                const Float h1 = getHeight(x0, z1) + (getHeight(x1, z1) - getHeight(x0, z1)) * tx;
+
+                error = std::max(error, std::fabs(h0 + (h1 - h0) * tz - h));
+            }
+        }
+
+        for (Int32 child : node.children) {
+            if (child >= 0) {
+                error = std::max(error, m_nodes[child].error);
+            }
+        }
+
+        node.boxMin[0] = node.x * m_unitX;
+        node.boxMin[1] = minY;
+        node.boxMin[2] = node.z * m_unitZ;
+        node.boxMax[0] = endX * m_unitX;
+        node.boxMax[1] = maxY;
+        node.boxMax[2] = endZ * m_unitZ;
+        node.error = error;
+    }
+
+    static Float boxDistance(const Node &node, const Float *eye)
+    {
+        Float squared = 0.0f;
+        for (UInt32 c = 0; c < 3; ++c) {
+            const Float d = std::max(std::max(node.boxMin[c] - eye[c], eye[c] - node.boxMax[c]), 0.0f);
+            squared += d * d;
+        }
+
+        return std::sqrt(squared);
+    }
+
+    void addVertex(UInt32 x, UInt32 z, std::vector<Float> &positions) const
+    {
+        positions.push_back(x * m_unitX);
+        positions.push_back(getHeight(x, z));
+        positions.push_back(z * m_unitZ);
+    }
+
+    static void addQuad(UInt32 v00, UInt32 v10, UInt32 v01, UInt32 v11, std::vector<UInt32> &indices)
+    {
+        indices.push_back(v00); indices.push_back(v01); indices.push_back(v10);
+        indices.push_back(v10); indices.push_back(v01); indices.push_back(v11);
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_CHUNKLOD_H
@@ -0,0 +1,300 @@
+/**
+ * @file clmterrain.h
+ * @brief Read-only access to the zones of a PCLOD terrain (.hclm header and .dclm data).
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_CLMTERRAIN_H
+#define _O3DSAMPLES_CLMTERRAIN_H
+
+#include <o3d/core/base.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace o3dsamples {
+
+using namespace o3d;
+
+/**
+ * @brief A zone of a PCLOD terrain.
+ * Origins and sizes are given in vertices, heights are stored row by row (Z major).
+ */
+struct ClmZone
+{
+    Int32 x, y;              //!< Zone coordinates into the zone grid.
+    UInt32 originX;          //!< First vertex of the zone on X.
+    UInt32 originZ;          //!< First vertex of the zone on Z.
+    UInt32 sizeX;            //!< Number of vertices on X.
+    UInt32 sizeZ;            //!< Number of vertices on Z.
+    std::string dataFile;    //!< Data file name, relative to the data directory.
+    UInt32 heightmapOffset;  //!< Offset of the height chunk into the data file.
+
+    Float minHeight, maxHeight;
+    std::vector<Float> heights;
+
+    inline Float getHeight(UInt32 i, UInt32 j) const { return heights[j * sizeX + i]; }
+};
+
+/**
+ * @brief Reader of the zone layout and of the heights of a PCLOD terrain.
+ * It only understands the parts of the format needed by CPU side tools (zone table
+ * and height chunks), the rendering data is left to PCLODTerrain.
+ * The .hclm contains an 8 bytes tag, a version, the terrain name, the number of zones,
+ * the zone table (coordinates biased by 0x8000 and offset of each zone record), then
+ * the zone records. Each zone record refers to a height chunk into a .dclm file.
+ */
+class ClmTerrain
+{
+public:
+
+    ClmTerrain() :
+        m_minX(0), m_minY(0), m_maxX(-1), m_maxY(-1),
+        m_unit(1.0f)
+    {
+    }
+
+    /**
+     * @brief Load the zone layout and optionally the heights.
+     * @param headerFile Terrain header (.hclm).
+     * @param dataDir Directory of the data files (.dclm), with a trailing separator or empty.
+     * @param loadHeights Read the height chunks of each zone.
+     * @return True if success.
+     */
+    Bool load(const std::string &headerFile, const std::string &dataDir, Bool loadHeights = True)
+    {
+        m_zones.clear();
+
+        FILE *file = fopen(headerFile.c_str(), "rb");
+        if (!file) {
+            return False;
+        }
+
+        std::vector<UInt8> header;
+        UInt8 buffer[4096];
+        size_t read;
+
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            header.insert(header.end(), buffer, buffer + read);
+        }
+
+        fclose(file);
+
+        Reader reader(header);
+
+        char tag[8];
+        if (!reader.read(tag, 8) || (memcmp(tag, "O3DHCLM ", 8) != 0)) {
+            return False;
+        }
+
+        UInt32 version = 0, unused = 0, nameLen = 0;
+        if (!reader.read(version) || (version != 1) ||
+            !reader.read(unused) || !reader.read(unused) ||
+            !reader.read(nameLen) || !reader.readString(m_name, nameLen)) {
+            return False;
+        }
+
+        UInt32 numZones = 0;
+        UInt16 zoneSizeX = 0, zoneSizeZ = 0;
+        if (!reader.read(unused) || !reader.read(unused) ||
+            !reader.read(numZones) || !reader.read(zoneSizeX) || !reader.read(zoneSizeZ)) {
+            return False;
+        }
+
+        std::vector<UInt32> offsets(numZones);
+
+        for (UInt32 i = 0; i < numZones; ++i) {
+            UInt16 x, y;
+            if (!reader.read(x) || !reader.read(y) || !reader.read(offsets[i])) {
+                return False;
+            }
+        }
+
+        m_zones.resize(numZones);
+
+        for (UInt32 i = 0; i < numZones; ++i) {
+            ClmZone &zone = m_zones[i];
+
+            reader.seek(offsets[i]);
+
+            UInt16 x, y;
+            UInt32 len = 0;
+
+            if (!reader.read(tag, 4) || (memcmp(tag, "ZONE", 4) != 0) ||
+                !reader.read(x) || !reader.read(y) ||
+                !reader.read(zone.originX) || !reader.read(zone.originZ) ||
+                !reader.read(zone.sizeX) || !reader.read(zone.sizeZ) ||
+                !reader.read(len) || !reader.readString(zone.dataFile, len) ||
+                !reader.read(zone.heightmapOffset)) {
+                m_zones.clear();
+                return False;
+            }
+
+            zone.x = Int32(x) - 0x8000;
+            zone.y = Int32(y) - 0x8000;
+            zone.minHeight = zone.maxHeight = 0.0f;
+
+            if (i == 0) {
+                m_minX = m_maxX = zone.x;
+                m_minY = m_maxY = zone.y;
+            } else {
+                m_minX = zone.x < m_minX ? zone.x : m_minX;
+                m_maxX = zone.x > m_maxX ? zone.x : m_maxX;
+                m_minY = zone.y < m_minY ? zone.y : m_minY;
+                m_maxY = zone.y > m_maxY ? zone.y : m_maxY;
+            }
+        }
+
+        if (loadHeights) {
+            for (ClmZone &zone : m_zones) {
+                if (!loadZoneHeights(zone, dataDir + zone.dataFile)) {
+                    m_zones.clear();
+                    return False;
+                }
+            }
+        }
+
+        return True;
+    }
+
+    //! Terrain name.
+    const std::string& getName() const { return m_name; }
+
+    //! Number of zones.
+    UInt32 getNumZones() const { return static_cast<UInt32>(m_zones.size()); }
+
+    //! Get a zone by index.
+    const ClmZone& getZone(UInt32 i) const { return m_zones[i]; }
+
+    //! Get all the zones.
+    const std::vector<ClmZone>& getZones() const { return m_zones; }
+
+    //! Number of zones on X.
+    Int32 getGridWidth() const { return m_maxX - m_minX + 1; }
+    //! Number of zones on Z.
+    Int32 getGridHeight() const { return m_maxY - m_minY + 1; }
+
+    //! Zone at given grid coordinates, or nullptr.
+    const ClmZone* findZone(Int32 x, Int32 y) const
+    {
+        if ((x < m_minX) || (x > m_maxX) || (y < m_minY) || (y > m_maxY)) {
+            return nullptr;
+        }
+
+        // zones are stored row by row when the grid is complete
+        const size_t index = size_t(y - m_minY) * getGridWidth() + (x - m_minX);
+        if ((index < m_zones.size()) && (m_zones[index].x == x) && (m_zones[index].y == y)) {
+            return &m_zones[index];
+        }
+
+        for (const ClmZone &zone : m_zones) {
+            if ((zone.x == x) && (zone.y == y)) {
+                return &zone;
+            }
+        }
+
+        return nullptr;
+    }
+
+    //! Set the world size of a vertex spacing (default 1).
+    void setUnit(Float unit) { m_unit = unit; }
+    //! Get the world size of a vertex spacing.
+    Float getUnit() const { return m_unit; }
+
+private:
+
+    /**
+     * @brief Bounds checked little endian reader over a memory block.
+     */
+    class Reader
+    {
+    public:
+
+        Reader(const std::vector<UInt8> &data) : m_data(data), m_pos(0) {}
+
+        void seek(size_t pos) { m_pos = pos; }
+
+        Bool read(void *dst, size_t size)
+        {
+            if (m_pos + size > m_data.size()) {
+                return False;
+            }
+
+            memcpy(dst, &m_data[m_pos], size);
+            m_pos += size;
+
+            return True;
+        }
+
+        template <class T>
+        Bool read(T &value) { return read(&value, sizeof(T)); }
+
+        //! Read a zero terminated string of len bytes (terminal zero included).
+        Bool readString(std::string &str, UInt32 len)
+        {
+            if ((len == 0) || (m_pos + len > m_data.size())) {
+                return False;
+            }
+
+            str.assign(reinterpret_cast<const char*>(&m_data[m_pos]), len - 1);
+            m_pos += len;
+
+            return True;
+        }
+
+    private:
+
+        const std::vector<UInt8> &m_data;
+        size_t m_pos;
+    };
+
+    std::string m_name;
+    std::vector<ClmZone> m_zones;
+
+    Int32 m_minX, m_minY, m_maxX, m_maxY;
+    Float m_unit;
+
+    //! The height chunk is a 8 bytes tag, a version, a reserved field, the size and the heights.
+    static Bool loadZoneHeights(ClmZone &zone, const std::string &dataFile)
+    {
+        FILE *file = fopen(dataFile.c_str(), "rb");
+        if (!file) {
+            return False;
+        }
+
+        char tag[8];
+        UInt32 chunk[4];
+
+        Bool ok = (fseek(file, zone.heightmapOffset, SEEK_SET) == 0) &&
+                  (fread(tag, 1, 8, file) == 8) &&
+                  (memcmp(tag, "ZONEHMP ", 8) == 0) &&
+                  (fread(chunk, sizeof(UInt32), 4, file) == 4) &&
+                  (chunk[2] == zone.sizeX) && (chunk[3] == zone.sizeZ);
+
+        if (ok) {
+            zone.heights.resize(size_t(zone.sizeX) * zone.sizeZ);
+            ok = fread(zone.heights.data(), sizeof(Float), zone.heights.size(), file) == zone.heights.size();
+        }
+
+        fclose(file);
+
+        if (ok && !zone.heights.empty()) {
+            zone.minHeight = zone.maxHeight = zone.heights[0];
+            for (Float h : zone.heights) {
+                zone.minHeight = h < zone.minHeight ? h : zone.minHeight;
+                zone.maxHeight = h > zone.maxHeight ? h : zone.maxHeight;
+            }
+        }
+
+        return ok;
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_CLMTERRAIN_H
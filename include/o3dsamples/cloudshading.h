@@ -0,0 +1,398 @@
+/**
+ * @file cloudshading.h
+ * @brief Cloud density, shading and ground shadow mask updated on a background thread.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_CLOUDSHADING_H
+#define _O3DSAMPLES_CLOUDSHADING_H
+
+#include "workerpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief Parameters of the cloud layer. The names follow CloudLayerPerlin, distances
+ * are in texture widths.
+ */
+struct CloudShadingParams
+{
+    Float coveringRate;     //!< CloudLayerPerlin::setCoveringRate, part of the sky covered.
+    Float contrast;         //!< CloudLayerPerlin::setContrast, sharpness of the cloud borders.
+    Float velocity[2];      //!< CloudLayerPerlin::setVelocity, texture widths per second.
+    Float absorption;       //!< Optical depth of a full density over a texture width.
+    UInt32 marchSteps;      //!< Samples toward the light for the self shading.
+    Float marchLength;      //!< Distance of the self shading march.
+    Float layerHeight;      //!< Height of the layer over the ground, for the shadow offset.
+    Float shadowOpacity;    //!< Light removed under a full density.
+
+    CloudShadingParams() :
+        coveringRate(0.45f),
+        contrast(20.0f),
+        absorption(40.0f),
+        marchSteps(8),
+        marchLength(0.05f),
+        layerHeight(0.1f),
+        shadowOpacity(0.8f)
+    {
+        velocity[0] = 0.005f;
+        velocity[1] = 0.001f;
+    }
+};
+
+/**
+ * @brief Scrolling cloud layer computed from a tileable noise at a fixed cadence.
+ * - A dedicated thread computes a frame per tick, on a WorkerPool if given, whatever
+ *   the frame rate of the caller. Late ticks are skipped, not queued.
+ * - Frames are triple buffered: the thread writes a back frame and publishes it with an
+ *   atomic exchange, the owner takes the newest one with acquire(). Neither side ever
+ *   waits for the other, acquire() is a single atomic load when nothing is new.
+ * - setParams and setLightDirection can be called from any thread, they are taken
+ *   into account from the next tick.
+ */
+class CloudShading
+{
+public:
+
+    //! A computed frame, every map has size * size values.
+    struct Frame
+    {
+        std::vector<Float> density;   //!< Cloud density in [0, 1].
+        std::vector<Float> shading;   //!< Light reaching each cloud texel in [0, 1].
+        std::vector<Float> shadow;    //!< Light reaching the ground under each texel in [0, 1].
+        Double time;                  //!< Cloud time in seconds.
+        UInt32 sequence;              //!< Number of the tick.
+    };
+
+    struct Stats
+    {
+        UInt32 numUpdates;        //!< Frames computed.
+        UInt32 numLate;           //!< Ticks skipped because a frame took too long.
+        Float averageCompute;     //!< Milliseconds per frame on the background thread.
+        Float maxCompute;         //!< Milliseconds.
+    };
+
+    CloudShading() :
+        m_size(0),
+        m_pool(nullptr),
+        m_period(0.1),
+        m_running(False),
+        m_quit(False),
+        m_write(1),
+        m_middle(2),
+        m_read(0),
+        m_totalCompute(0.0),
+        m_stats()
+    {
+        m_light[0] = 0.0f;
+        m_light[1] = 1.0f;
+        m_light[2] = 0.0f;
+    }
+
+    ~CloudShading()
+    {
+        stop();
+    }
+
+    //! Set the noise of the clouds, rescaled to [0, 1]. Stops the updates.
+    void setNoise(const std::vector<Float> &values, UInt32 size)
+    {
+        stop();
+
+        m_size = size;
+        m_noise = values;
+
+        if (!m_noise.empty()) {
+            const auto range = std::minmax_element(m_noise.begin(), m_noise.end());
+            const Float low = *range.first;
+            const Float scale = *range.second > low ? 1.0f / (*range.second - low) : 0.0f;
+
+            for (Float &v : m_noise) {
+                v = (v - low) * scale;
+            }
+        }
+
+        for (Frame &frame : m_frames) {
+            frame.density.assign(size_t(size) * size, 0.0f);
+            frame.shading.assign(size_t(size) * size, 1.0f);
+            frame.shadow.assign(size_t(size) * size, 1.0f);
+            frame.time = 0.0;
+            frame.sequence = 0;
+        }
+    }
+
+    //! Parameters of the layer, from the next tick.
+    void setParams(const CloudShadingParams &params)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_params = params;
+    }
+
+    //! Direction toward the light, from the next tick.
+    void setLightDirection(const Float *dir)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_light[0] = dir[0];
+        m_light[1] = dir[1];
+        m_light[2] = dir[2];
+    }
+
+    /**
+     * @brief Start the updates.
+     * @param frequency Frames per second.
+     * @param pool Optional pool of workers to compute the rows.
+     */
+    void start(Float frequency, WorkerPool *pool = nullptr)
+    {
+        stop();
+
+        if (m_size == 0) {
+            return;
+        }
+
+        m_period = 1.0 / std::max(frequency, 0.01f);
+        m_pool = pool;
+        m_quit = False;
+        m_running = True;
+
+        m_thread = std::thread(&CloudShading::run, this);
+    }
+
+    //! Stop the updates, the current frame stays readable.
+    void stop()
+    {
+        if (!m_running) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = True;
+        }
+
+        m_wakeUp.notify_all();
+        m_thread.join();
+
+        m_running = False;
+    }
+
+    //! Are the updates running.
+    Bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Take the newest published frame, if any. Owner thread only.
+     * @return True if the frame changed.
+     */
+    Bool acquire()
+    {
+        if ((m_middle.load(std::memory_order_acquire) & NEW_FRAME) == 0) {
+            return False;
+        }
+
+        m_read = m_middle.exchange(m_read, std::memory_order_acq_rel) & INDEX_MASK;
+        return True;
+    }
+
+    //! The last acquired frame. Owner thread only.
+    const Frame& getFrame() const { return m_frames[m_read]; }
+
+    //! Bilinear ground shadow of the last acquired frame, at texture coordinates (wrapped).
+    Float sampleShadow(Float u, Float v) const
+    {
+        if (m_size == 0) {
+            return 1.0f;
+        }
+
+        return sample(m_frames[m_read].shadow.data(), u * m_size, v * m_size);
+    }
+
+    //! Compute a frame for a cloud time on the calling thread and publish it, while stopped.
+    void update(Double time, UInt32 sequence = 0)
+    {
+        CloudShadingParams params;
+        Float light[3];
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            params = m_params;
+            light[0] = m_light[0];
+            light[1] = m_light[1];
+            light[2] = m_light[2];
+        }
+
+        Frame &frame = m_frames[m_write];
+        computeFrame(frame, params, light, time);
+        frame.sequence = sequence;
+
+        m_write = m_middle.exchange(m_write | NEW_FRAME, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    Stats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    //! Size of the maps.
+    UInt32 getSize() const { return m_size; }
+
+private:
+
+    static const UInt32 NEW_FRAME = 4;
+    static const UInt32 INDEX_MASK = 3;
+    static const UInt32 ROW_GRAIN = 16;
+
+    UInt32 m_size;
+    std::vector<Float> m_noise;
+
+    CloudShadingParams m_params;
+    Float m_light[3];
+
+    WorkerPool *m_pool;
+    Double m_period;
+
+    std::thread m_thread;
+    Bool m_running;
+    Bool m_quit;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+
+    Frame m_frames[3];
+    UInt32 m_write;                     //!< Frame of the background thread.
+    std::atomic<UInt32> m_middle;       //!< Last published frame, with NEW_FRAME if not acquired.
+    UInt32 m_read;                      //!< Frame of the owner.
+
+    Double m_totalCompute;
+    Stats m_stats;
+
+    //! Bilinear fetch with wrapping, x and y in texels.
+    Float sample(const Float *map, Float x, Float y) const
+    {
+        const Float fx = x - std::floor(x / m_size) * m_size;
+        const Float fy = y - std::floor(y / m_size) * m_size;
+
+        const UInt32 x0 = UInt32(fx) % m_size, y0 = UInt32(fy) % m_size;
+        const UInt32 x1 = (x0 + 1) % m_size, y1 = (y0 + 1) % m_size;
+        const Float tx = fx - std::floor(fx), ty = fy - std::floor(fy);
+
+        const Float a = map[y0 * m_size + x0] + (map[y0 * m_size + x1] - map[y0 * m_size + x0]) * tx;
+        const Float b = map[y1 * m_size + x0] + (map[y1 * m_size + x1] - map[y1 * m_size + x0]) * tx;
+
+        return a + (b - a) * ty;
+    }
+
+    void computeFrame(Frame &frame, const CloudShadingParams &params, const Float *light, Double time)
+    {
+        const Float size = Float(m_size);
+
+        // scrolling, in texels and wrapped
+        const Float offsetX = Float(std::fmod(params.velocity[0] * time, 1.0)) * size;
+        const Float offsetY = Float(std::fmod(params.velocity[1] * time, 1.0)) * size;
+
+        const Float threshold = 1.0f - params.coveringRate;
+
+        // horizontal part of the light, the texture lies on the x,z plane
+        const Float lenXZ = std::sqrt(light[0]*light[0] + light[2]*light[2]);
+        const Float invLenXZ = lenXZ > 0.0f ? 1.0f / lenXZ : 0.0f;
+        const UInt32 steps = std::max<UInt32>(params.marchSteps, 1);
+        const Float stepLength = params.marchLength * size / steps;
+        const Float marchX = light[0] * invLenXZ * stepLength;
+        const Float marchY = light[2] * invLenXZ * stepLength;
+        const Float stepDepth = params.absorption * params.marchLength / steps;
+
+        // the ground point sees the layer toward the light, a low light is limited to 45 degrees
+        const Float elevation = std::max(light[1], lenXZ);
+        const Float shadowX = elevation > 0.0f ? light[0] / elevation * params.layerHeight * size : 0.0f;
+        const Float shadowY = elevation > 0.0f ? light[2] / elevation * params.layerHeight * size : 0.0f;
+
+        forRows([&] (UInt32 begin, UInt32 end) {
+            for (UInt32 y = begin; y < end; ++y) {
+                for (UInt32 x = 0; x < m_size; ++x) {
+                    const Float n = sample(m_noise.data(), x + offsetX, y + offsetY);
+                    frame.density[y * m_size + x] = 1.0f - std::exp(-std::max(n - threshold, 0.0f) * params.contrast);
+                }
+            }
+        });
+
+        forRows([&] (UInt32 begin, UInt32 end) {
+            const Float *density = frame.density.data();
+
+            for (UInt32 y = begin; y < end; ++y) {
+                for (UInt32 x = 0; x < m_size; ++x) {
+                    Float depth = 0.0f;
+                    for (UInt32 s = 1; s <= steps; ++s) {
+                        depth += sample(density, x + marchX * s, y + marchY * s);
+                    }
+
+                    frame.shading[y * m_size + x] = std::exp(-depth * stepDepth);
+                    frame.shadow[y * m_size + x] = 1.0f - params.shadowOpacity * sample(density, x + shadowX, y + shadowY);
+                }
+            }
+        });
+
+        frame.time = time;
+    }
+
+    template <class F>
+    void forRows(const F &func)
+    {
+        if (m_pool) {
+            m_pool->parallelFor(m_size, ROW_GRAIN, func);
+        } else {
+            func(0, m_size);
+        }
+    }
+
+    void run()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<Double>(m_period));
+
+        UInt32 tick = 0;
+
+        for (;;) {
+            const auto computeStart = std::chrono::steady_clock::now();
+            update(std::chrono::duration<Double>(period * tick).count(), tick);
+
+            const auto now = std::chrono::steady_clock::now();
+            const Float compute = std::chrono::duration<Float, std::milli>(now - computeStart).count();
+
+            // the next tick not yet passed
+            UInt32 next = tick + 1;
+            while (start + period * next <= now) {
+                ++next;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            ++m_stats.numUpdates;
+            m_stats.numLate += next - tick - 1;
+            m_totalCompute += compute;
+            m_stats.averageCompute = Float(m_totalCompute / m_stats.numUpdates);
+            m_stats.maxCompute = std::max(m_stats.maxCompute, compute);
+
+            tick = next;
+
+            if (m_wakeUp.wait_until(lock, start + period * tick, [this] { return m_quit; })) {
+                break;
+            }
+        }
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_CLOUDSHADING_H
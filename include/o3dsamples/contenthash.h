@@ -0,0 +1,120 @@
+/**
+ * @file contenthash.h
+ * @brief 64 bits FNV-1a content hash used to key on-disk caches of the samples.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_CONTENTHASH_H
+#define _O3DSAMPLES_CONTENTHASH_H
+
+#include <o3d/core/base.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace o3dsamples {
+
+using namespace o3d;
+
+/**
+ * @brief Incremental FNV-1a 64 bits hash.
+ * It is not a cryptographic hash, only a fast and stable key for cache entries.
+ * Values are hashed using their in-memory representation, so only feed it with
+ * plain data types (no pointers, no padding).
+ */
+class ContentHash
+{
+public:
+
+    ContentHash() :
+        m_hash(OFFSET_BASIS)
+    {
+    }
+
+    //! Reset to the initial state.
+    void reset() { m_hash = OFFSET_BASIS; }
+
+    //! Hash a block of bytes.
+    void update(const void *data, size_t size)
+    {
+        const UInt8 *bytes = reinterpret_cast<const UInt8*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            m_hash ^= bytes[i];
+            m_hash *= PRIME;
+        }
+    }
+
+    //! Hash a plain value.
+    template <class T>
+    void updateValue(const T &value)
+    {
+        update(&value, sizeof(T));
+    }
+
+    //! Hash a C string, including its length to avoid ambiguous concatenations.
+    void updateString(const char *str)
+    {
+        const UInt32 len = static_cast<UInt32>(strlen(str));
+        updateValue(len);
+        update(str, len);
+    }
+
+    //! Hash the content of a file. Returns False if the file cannot be read.
+    Bool updateFile(const char *filename)
+    {
+        FILE *file = fopen(filename, "rb");
+        if (!file) {
+            return False;
+        }
+
+        UInt8 buffer[16384];
+        size_t read;
+
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            update(buffer, read);
+        }
+
+        const Bool ok = ferror(file) == 0;
+        fclose(file);
+
+        return ok;
+    }
+
+    //! Get the current hash value.
+    UInt64 get() const { return m_hash; }
+
+    //! Get the current hash value as 16 lower case hexadecimal characters.
+    std::string getHex() const
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex(16, '0');
+
+        for (Int32 i = 15; i >= 0; --i) {
+            hex[i] = digits[(m_hash >> ((15 - i) * 4)) & 0xf];
+        }
+
+        return hex;
+    }
+
+    //! Helper that hashes a single file. Returns 0 if the file cannot be read.
+    static UInt64 hashFile(const char *filename)
+    {
+        ContentHash hash;
+        return hash.updateFile(filename) ? hash.get() : 0;
+    }
+
+private:
+
+    static const UInt64 OFFSET_BASIS = 14695981039346656037ULL;
+    static const UInt64 PRIME = 1099511628211ULL;
+
+    UInt64 m_hash;
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_CONTENTHASH_H
@@ -0,0 +1,397 @@
+/**
+ * @file debugdraw.h
+ * @brief Debug symbols (bones, bounding volumes, light and sound symbols) of many objects
+ * collected in parallel into one line stream per frame, with a budget per category.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_DEBUGDRAW_H
+#define _O3DSAMPLES_DEBUGDRAW_H
+
+#include "primitivebatch.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace o3dsamples {
+
+//! Categories of debug symbols, each one with its budget and its state.
+enum DebugCategory
+{
+    DEBUG_BONES = 0,
+    DEBUG_BOUNDING_VOLUMES,
+    DEBUG_LIGHTS,
+    DEBUG_SOUNDS,
+    DEBUG_LOCAL_AXIS,
+    DEBUG_NUM_CATEGORIES
+};
+
+/**
+ * @brief Lines of the symbols of a range of objects, given to the collect function.
+ * Every shape is appended as a line list to its category.
+ */
+class DebugStream
+{
+public:
+
+    static const UInt32 CIRCLE_SEGMENTS = 16;
+
+    void setColor(Float r, Float g, Float b, Float a = 1.0f) { m_color = PrimitiveVertex::packColor(r, g, b, a); }
+
+    void line(DebugCategory category, const Float a[3], const Float b[3])
+    {
+        std::vector<PrimitiveVertex> &lines = m_lines[category];
+
+        PrimitiveVertex v0 = { a[0], a[1], a[2], m_color };
+        PrimitiveVertex v1 = { b[0], b[1], b[2], m_color };
+
+        lines.push_back(v0);
+        lines.push_back(v1);
+    }
+
+    //! Axis aligned box, 12 lines.
+    void box(DebugCategory category, const Float min[3], const Float max[3])
+    {
+        Float corners[8][3];
+        for (UInt32 i = 0; i < 8; ++i) {
+            corners[i][0] = (i & 1) ? max[0] : min[0];
+            corners[i][1] = (i & 2) ? max[1] : min[1];
+            corners[i][2] = (i & 4) ? max[2] : min[2];
+        }
+
+        // the corners differing by one bit
+        for (UInt32 i = 0; i < 8; ++i) {
+            for (UInt32 bit = 1; bit < 8; bit <<= 1) {
+                if (!(i & bit)) {
+                    line(category, corners[i], corners[i | bit]);
+                }
+            }
+        }
+    }
+
+    //! Sphere, a circle in each of the three axis planes.
+    void sphere(DebugCategory category, const Float center[3], Float radius)
+    {
+        for (UInt32 axis = 0; axis < 3; ++axis) {
+            circle(category, center, radius, axis);
+        }
+    }
+
+    //! Circle about an axis (0 for X, 1 for Y, 2 for Z).
+    void circle(DebugCategory category, const Float center[3], Float radius, UInt32 axis)
+    {
+        const UInt32 u = (axis + 1) % 3, v = (axis + 2) % 3;
+        const Float *c = cosSin();
+
+        Float prev[3], next[3];
+        prev[axis] = next[axis] = center[axis];
+        prev[u] = center[u] + radius;
+        prev[v] = center[v];
+
+        for (UInt32 s = 1; s <= CIRCLE_SEGMENTS; ++s) {
+            next[u] = center[u] + radius * c[(s % CIRCLE_SEGMENTS) * 2];
+            next[v] = center[v] + radius * c[(s % CIRCLE_SEGMENTS) * 2 + 1];
+
+            line(category, prev, next);
+            memcpy(prev, next, sizeof(prev));
+        }
+    }
+
+    //! Local axis of a transform, X red, Y green and Z blue, the color being kept.
+    void axis(DebugCategory category, const Float origin[3], const Float x[3], const Float y[3], const Float z[3], Float size)
+    {
+        const UInt32 color = m_color;
+        const Float *axes[3] = { x, y, z };
+
+        for (UInt32 i = 0; i < 3; ++i) {
+            const Float end[3] = { origin[0] + axes[i][0] * size, origin[1] + axes[i][1] * size, origin[2] + axes[i][2] * size };
+
+            m_color = 0xff000000 | (0xffu << (i * 8));
+            line(category, origin, end);
+        }
+
+        m_color = color;
+    }
+
+    /**
+     * @brief Cone of a spot light, its apex at the light.
+     * @param apex Position of the light.
+     * @param dir Normalized direction.
+     * @param length Distance of the base.
+     * @param radius Radius of the base.
+     */
+    void cone(DebugCategory category, const Float apex[3], const Float dir[3], Float length, Float radius)
+    {
+        // a base of the plane orthogonal to the direction
+        const Float ref[3] = { std::fabs(dir[1]) < 0.9f ? 0.0f : 1.0f, std::fabs(dir[1]) < 0.9f ? 1.0f : 0.0f, 0.0f };
+
+        Float u[3] = { dir[1] * ref[2] - dir[2] * ref[1], dir[2] * ref[0] - dir[0] * ref[2], dir[0] * ref[1] - dir[1] * ref[0] };
+        const Float invLen = 1.0f / std::sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+        u[0] *= invLen; u[1] *= invLen; u[2] *= invLen;
+
+        const Float v[3] = { dir[1] * u[2] - dir[2] * u[1], dir[2] * u[0] - dir[0] * u[2], dir[0] * u[1] - dir[1] * u[0] };
+
+        const Float *c = cosSin();
+        Float prev[3] = { 0.0f, 0.0f, 0.0f };
+
+        for (UInt32 s = 0; s <= CIRCLE_SEGMENTS; ++s) {
+            const Float cs = radius * c[(s % CIRCLE_SEGMENTS) * 2];
+            const Float sn = radius * c[(s % CIRCLE_SEGMENTS) * 2 + 1];
+
+            Float p[3];
+            for (UInt32 i = 0; i < 3; ++i) {
+                p[i] = apex[i] + dir[i] * length + u[i] * cs + v[i] * sn;
+            }
+
+            if (s > 0) {
+                line(category, prev, p);
+            }
+
+            // four sides
+            if ((s < CIRCLE_SEGMENTS) && (s % (CIRCLE_SEGMENTS / 4) == 0)) {
+                line(category, apex, p);
+            }
+
+            memcpy(prev, p, sizeof(prev));
+        }
+    }
+
+    //! Lines of a category, two vertices each.
+    const std::vector<PrimitiveVertex>& getLines(DebugCategory category) const { return m_lines[category]; }
+
+    void clear()
+    {
+        for (std::vector<PrimitiveVertex> &lines : m_lines) {
+            lines.clear();
+        }
+    }
+
+private:
+
+    std::vector<PrimitiveVertex> m_lines[DEBUG_NUM_CATEGORIES];
+    UInt32 m_color = 0xffffffff;
+
+    //! Cosine and sine of the segments of a circle.
+    static const Float* cosSin()
+    {
+        static const std::vector<Float> table = [] () {
+            std::vector<Float> t(CIRCLE_SEGMENTS * 2);
+            for (UInt32 s = 0; s < CIRCLE_SEGMENTS; ++s) {
+                const Float angle = Float(s) * 6.2831853f / Float(CIRCLE_SEGMENTS);
+                t[s * 2] = std::cos(angle);
+                t[s * 2 + 1] = std::sin(angle);
+            }
+            return t;
+        }();
+
+        return table.data();
+    }
+};
+
+/**
+ * @brief Collect the debug symbols of all the objects of a frame into one line stream,
+ * instead of a draw per object symbol.
+ * The objects are split into chunks collected in parallel on a pool, each chunk into
+ * its own DebugStream. The streams are then concatenated by category, in the order of
+ * the chunks so the result does not depend on the scheduling, and the lines of a
+ * category beyond its budget are dropped, from the last objects. A flush gives one
+ * PRIMITIVE_LINES submit per run of categories of a same state, as PrimitiveBatch does.
+ */
+class DebugDraw
+{
+public:
+
+    //! Symbols of the objects [begin, end).
+    typedef std::function<void(UInt32 begin, UInt32 end, DebugStream &stream)> CollectFunc;
+
+    struct Stats
+    {
+        UInt32 numObjects;
+        UInt32 numLines[DEBUG_NUM_CATEGORIES];      //!< Lines kept.
+        UInt32 numDropped[DEBUG_NUM_CATEGORIES];    //!< Lines over the budget.
+        UInt32 numSubmits;
+
+        Stats() : numObjects(0), numSubmits(0)
+        {
+            for (UInt32 c = 0; c < DEBUG_NUM_CATEGORIES; ++c) {
+                numLines[c] = numDropped[c] = 0;
+            }
+        }
+
+        UInt32 getNumLines() const
+        {
+            UInt32 n = 0;
+            for (UInt32 c = 0; c < DEBUG_NUM_CATEGORIES; ++c) {
+                n += numLines[c];
+            }
+            return n;
+        }
+    };
+
+    /**
+     * @brief Constructor.
+     * @param grain Objects per chunk.
+     * @param maxLines Default budget of each category, in lines.
+     */
+    DebugDraw(UInt32 grain = 256, UInt32 maxLines = 65536) :
+        m_grain(grain > 0 ? grain : 1)
+    {
+        for (UInt32 c = 0; c < DEBUG_NUM_CATEGORIES; ++c) {
+            m_budgets[c] = maxLines;
+            m_states[c] = 0;
+            m_enabled[c] = True;
+            m_first[c] = 0;
+        }
+    }
+
+    //! Maximal number of lines of a category per frame.
+    void setBudget(DebugCategory category, UInt32 maxLines) { m_budgets[category] = maxLines; }
+
+    //! State given to the submits of a category, a depth test or none for example.
+    void setState(DebugCategory category, UInt32 state) { m_states[category] = state; }
+
+    //! A disabled category is skipped by the flush, its lines being still collected.
+    void enable(DebugCategory category, Bool enable) { m_enabled[category] = enable; }
+
+    /**
+     * @brief Collect the symbols of the frame.
+     * @param numObjects Number of objects.
+     * @param func Called per chunk of objects, from any thread.
+     * @param pool Pool to collect in parallel, or null.
+     */
+    void collect(UInt32 numObjects, const CollectFunc &func, WorkerPool *pool = nullptr)
+    {
+        const UInt32 numChunks = (numObjects + m_grain - 1) / m_grain;
+
+        if (m_streams.size() < numChunks) {
+            m_streams.resize(numChunks);
+        }
+
+        auto collectChunks = [this, numObjects, &func] (UInt32 from, UInt32 to) {
+            for (UInt32 chunk = from; chunk < to; ++chunk) {
+                DebugStream &stream = m_streams[chunk];
+                stream.clear();
+                func(chunk * m_grain, std::min(numObjects, (chunk + 1) * m_grain), stream);
+            }
+        };
+
+        if (pool) {
+            pool->parallelFor(numChunks, 1, collectChunks);
+        } else {
+            collectChunks(0, numChunks);
+        }
+
+        // offsets of the chunks in the stream, in the order of the categories
+        m_stats = Stats();
+        m_stats.numObjects = numObjects;
+        m_offsets.resize(size_t(numChunks) * DEBUG_NUM_CATEGORIES);
+
+        UInt32 offset = 0;
+        for (UInt32 c = 0; c < DEBUG_NUM_CATEGORIES; ++c) {
+            m_first[c] = offset;
+
+            UInt32 numLines = 0;
+            for (UInt32 chunk = 0; chunk < numChunks; ++chunk) {
+                const UInt32 lines = UInt32(m_streams[chunk].getLines(DebugCategory(c)).size() / 2);
+                const UInt32 kept = std::min(lines, m_budgets[c] - numLines);
+
+                m_offsets[size_t(chunk) * DEBUG_NUM_CATEGORIES + c] = offset;
+                numLines += kept;
+                offset += kept * 2;
+                m_stats.numDropped[c] += lines - kept;
+            }
+
+            m_stats.numLines[c] = numLines;
+        }
+
+        m_vertices.resize(offset);
+
+        auto copyChunks = [this] (UInt32 from, UInt32 to) {
+            for (UInt32 chunk = from; chunk < to; ++chunk) {
+                for (UInt32 c = 0; c < DEBUG_NUM_CATEGORIES; ++c) {
+                    const std::vector<PrimitiveVertex> &lines = m_streams[chunk].getLines(DebugCategory(c));
+                    const UInt32 first = m_offsets[size_t(chunk) * DEBUG_NUM_CATEGORIES + c];
+                    const UInt32 end = m_first[c] + m_stats.numLines[c] * 2;
+                    const UInt32 count = std::min(UInt32(lines.size()), end - first);
+
+                    if (count) {
+                        memcpy(&m_vertices[first], lines.data(), count * sizeof(PrimitiveVertex));
+                    }
+                }
+            }
+        };
+
+        if (pool) {
+            pool->parallelFor(numChunks, 4, copyChunks);
+        } else {
+            copyChunks(0, numChunks);
+        }
+    }
+
+    //! Submit the stream, a draw per run of enabled categories of a same state.
+    void flush(const PrimitiveBatch::SubmitFunc &submit)
+    {
+        m_stats.numSubmits = 0;
+
+        PrimitiveSubmit run = { PRIMITIVE_LINES, 0, 0, 0, 0 };
+
+        for (UInt32 c = 0; c < DEBUG_NUM_CATEGORIES; ++c) {
+            const UInt32 count = m_stats.numLines[c] * 2;
+            if (!m_enabled[c] || !count) {
+                continue;
+            }
+
+            // the categories are contiguous in the stream
+            if (run.count && (run.state == m_states[c]) && (run.first + run.count == m_first[c])) {
+                run.count += count;
+                ++run.numDraws;
+                continue;
+            }
+
+            if (run.count) {
+                submit(run, m_vertices.data());
+                ++m_stats.numSubmits;
+            }
+
+            run.state = m_states[c];
+            run.first = m_first[c];
+            run.count = count;
+            run.numDraws = 1;
+        }
+
+        if (run.count) {
+            submit(run, m_vertices.data());
+            ++m_stats.numSubmits;
+        }
+    }
+
+    //! Line list of the frame, the categories one after the other.
+    const std::vector<PrimitiveVertex>& getVertices() const { return m_vertices; }
+
+    const Stats& getStats() const { return m_stats; }
+
+private:
+
+    UInt32 m_grain;
+    UInt32 m_budgets[DEBUG_NUM_CATEGORIES];
+    UInt32 m_states[DEBUG_NUM_CATEGORIES];
+    Bool m_enabled[DEBUG_NUM_CATEGORIES];
+
+    std::vector<DebugStream> m_streams;         //!< One per chunk, kept from frame to frame.
+    std::vector<UInt32> m_offsets;              //!< First vertex per chunk and category.
+    UInt32 m_first[DEBUG_NUM_CATEGORIES];       //!< First vertex per category.
+    std::vector<PrimitiveVertex> m_vertices;
+
+    Stats m_stats;
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_DEBUGDRAW_H
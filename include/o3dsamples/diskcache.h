@@ -0,0 +1,308 @@
+/**
+ * @file diskcache.h
+ * @brief Content addressed on-disk cache, and a lazy cache of generated noises.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_DISKCACHE_H
+#define _O3DSAMPLES_DISKCACHE_H
+
+#include "contenthash.h"
+#include "perlinnoise.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief Entries of a directory named by the 64 bits key of their content inputs.
+ * Each file starts with a header holding the key, the size and a hash of the data,
+ * so a truncated or foreign file is a miss. Entries are written to a temporary file
+ * renamed at the end, a reader never sees a partial entry.
+ * The directory must exist.
+ */
+class DiskCache
+{
+public:
+
+    DiskCache(const std::string &directory = ".") :
+        m_directory(directory)
+    {
+        if (!m_directory.empty() && (m_directory.back() != '/') && (m_directory.back() != '\\')) {
+            m_directory += '/';
+        }
+    }
+
+    //! Directory of the entries, with a trailing separator.
+    const std::string& getDirectory() const { return m_directory; }
+
+    //! File name of an entry.
+    std::string getPath(UInt64 key, const char *ext) const
+    {
+        return m_directory + toHex(key) + "." + ext;
+    }
+
+    //! Read an entry. Returns False if missing or invalid.
+    Bool read(UInt64 key, const char *ext, std::vector<UInt8> &data) const
+    {
+        FILE *file = fopen(getPath(key, ext).c_str(), "rb");
+        if (!file) {
+            return False;
+        }
+
+        Header header;
+        Bool ok = (fread(&header, sizeof(Header), 1, file) == 1) &&
+                  (memcmp(header.magic, getMagic(), 8) == 0) &&
+                  (header.key == key);
+
+        // read by chunks rather than sized from the header, so a corrupt size costs at
+        // most the length of the file
+        if (ok) {
+            data.clear();
+
+            UInt8 buffer[16384];
+            size_t count;
+
+            while ((data.size() < header.size) && ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)) {
+                count = size_t(std::min<UInt64>(count, header.size - data.size()));
+                data.insert(data.end(), buffer, buffer + count);
+            }
+
+            ok = data.size() == header.size;
+        }
+
+        fclose(file);
+
+        if (ok) {
+            ContentHash hash;
+            hash.update(data.data(), data.size());
+            ok = hash.get() == header.hash;
+        }
+
+        if (!ok) {
+            data.clear();
+        }
+
+        return ok;
+    }
+
+    //! Write an entry, replacing any previous one. Returns False on error.
+    Bool write(UInt64 key, const char *ext, const void *data, size_t size) const
+    {
+        const std::string path = getPath(key, ext);
+        const std::string tmp = path + ".tmp";
+
+        Header header;
+        memcpy(header.magic, getMagic(), 8);
+        header.key = key;
+        header.size = size;
+
+        ContentHash hash;
+        hash.update(data, size);
+        header.hash = hash.get();
+
+        FILE *file = fopen(tmp.c_str(), "wb");
+        if (!file) {
+            return False;
+        }
+
+        Bool ok = fwrite(&header, sizeof(Header), 1, file) == 1;
+        ok = ok && ((size == 0) || (fwrite(data, 1, size, file) == size));
+        ok = (fclose(file) == 0) && ok;
+
+        // rename does not replace an existing file on every platform
+        if (ok) {
+            remove(path.c_str());
+            ok = rename(tmp.c_str(), path.c_str()) == 0;
+        }
+
+        if (!ok) {
+            remove(tmp.c_str());
+        }
+
+        return ok;
+    }
+
+    //! Remove an entry.
+    void erase(UInt64 key, const char *ext) const
+    {
+        remove(getPath(key, ext).c_str());
+    }
+
+    //! The 16 lower case hexadecimal characters of a key.
+    static std::string toHex(UInt64 key)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex(16, '0');
+
+        for (Int32 i = 15; i >= 0; --i) {
+            hex[i] = digits[(key >> ((15 - i) * 4)) & 0xf];
+        }
+
+        return hex;
+    }
+
+private:
+
+    struct Header
+    {
+        char magic[8];
+        UInt64 key;
+        UInt64 size;
+        UInt64 hash;
+    };
+
+    std::string m_directory;
+
+    static const char* getMagic() { return "O3DCACHE"; }
+};
+
+/**
+ * @brief Every input of a PerlinNoise, and the key of its output.
+ */
+struct NoiseDesc
+{
+    std::vector<Float> amplitudes;
+    std::vector<Float> frequencies;
+    Bool repeat;
+    Bool positive;
+    UInt32 size;
+    UInt32 seed;
+
+    NoiseDesc() :
+        repeat(True),
+        positive(False),
+        size(128),
+        seed(0)
+    {
+    }
+
+    //! Key of the generated noise. Changing any input changes the key.
+    UInt64 getKey() const
+    {
+        ContentHash hash;
+
+        // the generator version, to change along with its output
+        hash.updateString("PerlinNoise 1");
+
+        hash.updateValue(UInt32(amplitudes.size()));
+        hash.update(amplitudes.data(), amplitudes.size() * sizeof(Float));
+        hash.updateValue(UInt32(frequencies.size()));
+        hash.update(frequencies.data(), frequencies.size() * sizeof(Float));
+        hash.updateValue(UInt32(repeat ? 1 : 0));
+        hash.updateValue(UInt32(positive ? 1 : 0));
+        hash.updateValue(size);
+        hash.updateValue(seed);
+
+        return hash.get();
+    }
+
+    //! Set the parameters of a generator.
+    void apply(PerlinNoise &noise) const
+    {
+        noise.setAmplitudes(amplitudes);
+        noise.setFrequencies(frequencies);
+        noise.setRepeat(repeat);
+        noise.setPositive(positive);
+        noise.setSize(size);
+        noise.setRandomSeed(seed);
+    }
+};
+
+/**
+ * @brief Noises generated on demand and kept in memory, backed by a DiskCache.
+ * get() returns the noise from the memory, else from the disk, else generates and
+ * stores it. Editing a parameter gives another key, so only the new variant is
+ * generated and the previous one is still cached.
+ */
+class NoiseCache
+{
+public:
+
+    struct Stats
+    {
+        UInt32 memoryHits;
+        UInt32 diskHits;
+        UInt32 generated;
+        Float loadTime;        //!< Milliseconds spent reading the disk hits.
+        Float generateTime;    //!< Milliseconds spent generating and writing the misses.
+    };
+
+    NoiseCache(const DiskCache &disk, WorkerPool *pool = nullptr) :
+        m_disk(disk),
+        m_pool(pool),
+        m_stats()
+    {
+    }
+
+    //! Values of a noise, size * size row by row.
+    const std::vector<Float>& get(const NoiseDesc &desc)
+    {
+        const UInt64 key = desc.getKey();
+
+        auto it = m_noises.find(key);
+        if (it != m_noises.end()) {
+            ++m_stats.memoryHits;
+            return it->second;
+        }
+
+        std::vector<Float> &values = m_noises[key];
+        const size_t count = size_t(desc.size) * desc.size;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        std::vector<UInt8> data;
+        if (m_disk.read(key, getExtension(), data) && (data.size() == count * sizeof(Float))) {
+            values.resize(count);
+            memcpy(values.data(), data.data(), data.size());
+
+            ++m_stats.diskHits;
+            m_stats.loadTime += elapsed(start);
+        } else {
+            PerlinNoise noise;
+            desc.apply(noise);
+
+            values.resize(count);
+            noise.generate(values.data(), m_pool);
+
+            m_disk.write(key, getExtension(), values.data(), count * sizeof(Float));
+
+            ++m_stats.generated;
+            m_stats.generateTime += elapsed(start);
+        }
+
+        return values;
+    }
+
+    //! Drop the noises kept in memory.
+    void clear() { m_noises.clear(); }
+
+    const Stats& getStats() const { return m_stats; }
+
+private:
+
+    const DiskCache &m_disk;
+    WorkerPool *m_pool;
+
+    std::map<UInt64, std::vector<Float>> m_noises;
+    Stats m_stats;
+
+    static const char* getExtension() { return "noise"; }
+
+    static Float elapsed(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_DISKCACHE_H
@@ -0,0 +1,337 @@
+/**
+ * @file drawcommands.h
+ * @brief Draw commands recorded in parallel, radix sorted by state, replayed with the
+ * redundant state changes removed.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_DRAWCOMMANDS_H
+#define _O3DSAMPLES_DRAWCOMMANDS_H
+
+#include "workerpool.h"
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief A draw command, the states it needs and what it draws.
+ * The states are small indices given by the caller (its material, texture and mesh
+ * tables), the backend binds them.
+ */
+struct DrawItem
+{
+    UInt64 key;           //!< Sort key, see DrawKey.
+    UInt32 pass;
+    UInt32 material;
+    UInt32 texture;
+    UInt32 mesh;
+    UInt32 object;        //!< Object drawn, its transform for instance.
+};
+
+/**
+ * @brief 64 bits sort keys, the most expensive state change in the highest bits.
+ * Opaque: pass (4) | material (12) | texture (14) | mesh (14) | depth (20), front to back.
+ * Translucent: pass (4) | depth (20), back to front | material (12) | texture (14) | mesh (14).
+ * The depth is a distance to the camera in [0, 1].
+ * An id too large for its field asserts in debug builds. In release builds its high
+ * bits are dropped: the command still binds its own states, but sorts among other ids,
+ * see fits and DrawCommands::Stats::numOverflows.
+ */
+struct DrawKey
+{
+    static const UInt32 PASS_BITS = 4;
+    static const UInt32 MATERIAL_BITS = 12;
+    static const UInt32 TEXTURE_BITS = 14;
+    static const UInt32 MESH_BITS = 14;
+    static const UInt32 DEPTH_BITS = 20;
+
+    static UInt64 opaque(UInt32 pass, UInt32 material, UInt32 texture, UInt32 mesh, Float depth)
+    {
+        return (UInt64(field(pass, PASS_BITS)) << 60) |
+               (UInt64(field(material, MATERIAL_BITS)) << 48) |
+               (UInt64(field(texture, TEXTURE_BITS)) << 34) |
+               (UInt64(field(mesh, MESH_BITS)) << 20) |
+               UInt64(quantize(depth));
+    }
+
+    static UInt64 translucent(UInt32 pass, UInt32 material, UInt32 texture, UInt32 mesh, Float depth)
+    {
+        const UInt32 maxDepth = (1u << DEPTH_BITS) - 1;
+
+        return (UInt64(field(pass, PASS_BITS)) << 60) |
+               (UInt64(maxDepth - quantize(depth)) << 40) |
+               (UInt64(field(material, MATERIAL_BITS)) << 28) |
+               (UInt64(field(texture, TEXTURE_BITS)) << 14) |
+               UInt64(field(mesh, MESH_BITS));
+    }
+
+    //! True if every id fits in its field.
+    static Bool fits(UInt32 pass, UInt32 material, UInt32 texture, UInt32 mesh)
+    {
+        return !(pass >> PASS_BITS) && !(material >> MATERIAL_BITS) && !(texture >> TEXTURE_BITS) && !(mesh >> MESH_BITS);
+    }
+
+private:
+
+    static UInt32 field(UInt32 value, UInt32 bits)
+    {
+        assert(!(value >> bits) && "state id too large for its DrawKey field");
+        return value & ((1u << bits) - 1);
+    }
+
+    static UInt32 quantize(Float depth)
+    {
+        const Float d = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+        return UInt32(d * Float((1u << DEPTH_BITS) - 1));
+    }
+};
+
+/**
+ * @brief Record, sort and replay the draw commands of a frame.
+ * The commands are recorded per bucket (a visibility cell, a chunk of objects), each
+ * bucket having its own list so the buckets are recorded in parallel without lock. sort
+ * merges the buckets and orders the commands by key with a LSD radix sort, the key bytes
+ * equal for every command being skipped. replay gives the commands to a backend, calling
+ * its state functions only when the state changes:
+ * - setPass(UInt32), setMaterial(UInt32), setTexture(UInt32), setMesh(UInt32)
+ * - draw(const DrawItem&)
+ * The lists keep their capacity from a frame to the next.
+ */
+class DrawCommands
+{
+public:
+
+    //! State changes and draws of a replay.
+    struct Stats
+    {
+        UInt32 numDraws;
+        UInt32 numPassChanges;
+        UInt32 numMaterialChanges;
+        UInt32 numTextureChanges;
+        UInt32 numMeshChanges;
+        UInt32 numOverflows;      //!< Draws whose ids do not fit their key fields, see DrawKey.
+
+        Stats() :
+            numDraws(0),
+            numPassChanges(0),
+            numMaterialChanges(0),
+            numTextureChanges(0),
+            numMeshChanges(0),
+            numOverflows(0)
+        {
+        }
+
+        UInt32 getNumStateChanges() const
+        {
+            return numPassChanges + numMaterialChanges + numTextureChanges + numMeshChanges;
+        }
+    };
+
+    //! Recording function of a bucket, called from any thread.
+    typedef std::function<void(UInt32 bucket, std::vector<DrawItem> &items)> RecordFunc;
+
+    //! Clear the commands and set the number of buckets.
+    void reset(UInt32 numBuckets)
+    {
+        m_buckets.resize(numBuckets);
+        for (std::vector<DrawItem> &bucket : m_buckets) {
+            bucket.clear();
+        }
+
+        m_items.clear();
+        m_order.clear();
+    }
+
+    //! Commands of a bucket, to be filled by a single thread.
+    std::vector<DrawItem>& getBucket(UInt32 bucket) { return m_buckets[bucket]; }
+
+    UInt32 getNumBuckets() const { return UInt32(m_buckets.size()); }
+
+    /**
+     * @brief Record every bucket, in parallel if a pool is given.
+     * @param numBuckets Number of buckets, the previous commands are cleared.
+     * @param func Records the commands of a bucket into its list.
+     */
+    void record(UInt32 numBuckets, const RecordFunc &func, WorkerPool *pool = nullptr)
+    {
+        reset(numBuckets);
+
+        if (pool) {
+            pool->parallelFor(numBuckets, 1, [this, &func] (UInt32 begin, UInt32 end) {
+                for (UInt32 b = begin; b < end; ++b) {
+                    func(b, m_buckets[b]);
+                }
+            });
+        } else {
+            for (UInt32 b = 0; b < numBuckets; ++b) {
+                func(b, m_buckets[b]);
+            }
+        }
+    }
+
+    //! Merge the buckets in their order, without sorting.
+    void merge()
+    {
+        m_items.clear();
+        for (const std::vector<DrawItem> &bucket : m_buckets) {
+            m_items.insert(m_items.end(), bucket.begin(), bucket.end());
+        }
+
+        m_order.resize(m_items.size());
+        for (UInt32 i = 0; i < UInt32(m_order.size()); ++i) {
+            m_order[i] = i;
+        }
+    }
+
+    //! Merge the buckets and order the commands by key, equal keys keeping their order.
+    void sort()
+    {
+        merge();
+
+        const UInt32 count = UInt32(m_items.size());
+        if (count < 2) {
+            return;
+        }
+
+        // histograms of the 8 key bytes in a single pass
+        UInt32 histograms[8][256];
+        memset(histograms, 0, sizeof(histograms));
+
+        for (const DrawItem &item : m_items) {
+            const UInt64 key = item.key;
+            for (UInt32 d = 0; d < 8; ++d) {
+                ++histograms[d][(key >> (d * 8)) & 0xff];
+            }
+        }
+
+        m_keys.resize(count);
+        m_tmpKeys.resize(count);
+        m_tmpOrder.resize(count);
+
+        for (UInt32 i = 0; i < count; ++i) {
+            m_keys[i] = m_items[i].key;
+        }
+
+        for (UInt32 d = 0; d < 8; ++d) {
+            UInt32 *histogram = histograms[d];
+
+            // a byte equal for every key does not change the order
+            const UInt32 first = UInt32((m_keys[0] >> (d * 8)) & 0xff);
+            if (histogram[first] == count) {
+                continue;
+            }
+
+            UInt32 offset = 0;
+            for (UInt32 b = 0; b < 256; ++b) {
+                const UInt32 n = histogram[b];
+                histogram[b] = offset;
+                offset += n;
+            }
+
+            const UInt32 shift = d * 8;
+            for (UInt32 i = 0; i < count; ++i) {
+                const UInt32 dst = histogram[(m_keys[i] >> shift) & 0xff]++;
+                m_tmpKeys[dst] = m_keys[i];
+                m_tmpOrder[dst] = m_order[i];
+            }
+
+            m_keys.swap(m_tmpKeys);
+            m_order.swap(m_tmpOrder);
+        }
+    }
+
+    UInt32 getNumItems() const { return UInt32(m_items.size()); }
+
+    //! Command at a position of the order set by merge or sort.
+    const DrawItem& getItem(UInt32 i) const { return m_items[m_order[i]]; }
+
+    /**
+     * @brief Give the commands to a backend in the order set by merge or sort.
+     * A state is set again after a change of a state above it, pass then material, a
+     * material being able to change the texture units and a pass every state.
+     */
+    template <class Backend>
+    Stats replay(Backend &backend) const
+    {
+        Stats stats;
+
+        UInt32 pass = INVALID, material = INVALID, texture = INVALID, mesh = INVALID;
+
+        for (const UInt32 index : m_order) {
+            const DrawItem &item = m_items[index];
+
+            if (item.pass != pass) {
+                backend.setPass(item.pass);
+                pass = item.pass;
+                material = texture = mesh = INVALID;
+                ++stats.numPassChanges;
+            }
+
+            if (item.material != material) {
+                backend.setMaterial(item.material);
+                material = item.material;
+                texture = INVALID;
+                ++stats.numMaterialChanges;
+            }
+
+            if (item.texture != texture) {
+                backend.setTexture(item.texture);
+                texture = item.texture;
+                ++stats.numTextureChanges;
+            }
+
+            if (item.mesh != mesh) {
+                backend.setMesh(item.mesh);
+                mesh = item.mesh;
+                ++stats.numMeshChanges;
+            }
+
+            if (!DrawKey::fits(item.pass, item.material, item.texture, item.mesh)) {
+                ++stats.numOverflows;
+            }
+
+            backend.draw(item);
+            ++stats.numDraws;
+        }
+
+        return stats;
+    }
+
+    //! State changes of a replay, without a backend.
+    Stats countStateChanges() const
+    {
+        NullBackend backend;
+        return replay(backend);
+    }
+
+private:
+
+    static const UInt32 INVALID = 0xffffffff;
+
+    struct NullBackend
+    {
+        void setPass(UInt32) {}
+        void setMaterial(UInt32) {}
+        void setTexture(UInt32) {}
+        void setMesh(UInt32) {}
+        void draw(const DrawItem&) {}
+    };
+
+    std::vector<std::vector<DrawItem>> m_buckets;
+    std::vector<DrawItem> m_items;
+    std::vector<UInt32> m_order;
+
+    std::vector<UInt64> m_keys;
+    std::vector<UInt64> m_tmpKeys;
+    std::vector<UInt32> m_tmpOrder;
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_DRAWCOMMANDS_H
@@ -0,0 +1,362 @@
+/**
+ * @file framecapture.h
+ * @brief Frame captures copied into a ring of staging buffers, encoded on a pool.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_FRAMECAPTURE_H
+#define _O3DSAMPLES_FRAMECAPTURE_H
+
+#include "workerpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief A captured frame, texels row by row, top row first once flipped.
+ */
+struct CaptureFrame
+{
+    UInt32 id;
+    UInt32 width;
+    UInt32 height;
+    UInt32 texelSize;     //!< Bytes per texel.
+    UInt32 format;        //!< Pixel format of the texels, given back to the encoder.
+    std::vector<UInt8> data;
+
+    CaptureFrame() : id(0), width(0), height(0), texelSize(0), format(0) {}
+};
+
+/**
+ * @brief Result of a capture, given to the done function.
+ */
+struct CaptureResult
+{
+    UInt32 id;
+    Bool valid;           //!< False if the read back or the encoding failed.
+    UInt32 width;
+    UInt32 height;
+    UInt32 delay;         //!< Frames from the request to the read back.
+    Float readbackTime;   //!< Milliseconds mapping and copying the texels, on the draw thread.
+    Float encodeTime;     //!< Milliseconds flipping and encoding, on a worker.
+
+    CaptureResult() :
+        id(0),
+        valid(False),
+        width(0),
+        height(0),
+        delay(0),
+        readbackTime(0.0f),
+        encodeTime(0.0f)
+    {
+    }
+};
+
+/**
+ * @brief Take frame captures, the flip and the encoding off the draw thread.
+ * A request is read back a few frames after it is made (the delay), out of the event
+ * that makes it. The read back itself is the caller's map of the texels, synchronous
+ * when the engine has no fence nor pixel buffer to read them asynchronously: its time
+ * is given to submit and reported with the copy as the read back time. The texels are
+ * copied into one of a ring of staging buffers, then flipped and encoded on a WorkerPool
+ * while the next frames are drawn. A request waits for a free buffer if every one is
+ * encoding.
+ * The done function is called on the thread calling update, once a capture is encoded.
+ * request, isReadbackDue, submit and update must be called from the same thread, the
+ * draw one for the read back.
+ */
+class FrameCapture
+{
+public:
+
+    //! Encode a captured frame, on a worker.
+    typedef std::function<Bool(const CaptureFrame &frame)> EncodeFunc;
+    //! Report a finished capture, on the update thread.
+    typedef std::function<void(const CaptureResult &result)> DoneFunc;
+
+    struct Stats
+    {
+        UInt32 numRequests;       //!< Calls to request.
+        UInt32 numCaptured;       //!< Captures encoded.
+        UInt32 numFailed;         //!< Captures not read back or not encoded.
+        UInt32 numWaits;          //!< Frames a due request waited for a free buffer.
+        Float readbackTime;       //!< Milliseconds mapping and copying on the draw thread, sum.
+        Float maxReadbackTime;    //!< Longest read back.
+        Float encodeTime;         //!< Milliseconds encoding on the workers, sum.
+
+        Stats() :
+            numRequests(0),
+            numCaptured(0),
+            numFailed(0),
+            numWaits(0),
+            readbackTime(0.0f),
+            maxReadbackTime(0.0f),
+            encodeTime(0.0f)
+        {
+        }
+    };
+
+    /**
+     * @brief Constructor.
+     * @param pool Pool running the encodings.
+     * @param encode Encoding function, called on the workers.
+     * @param done Completion function, called by update.
+     * @param numBuffers Staging buffers, two to read back a frame while the previous
+     * one is encoding.
+     * @param delay Frames between a request and its read back.
+     */
+    FrameCapture(WorkerPool &pool, EncodeFunc encode, DoneFunc done, UInt32 numBuffers = 2, UInt32 delay = 1) :
+        m_pool(pool),
+        m_encode(encode),
+        m_done(done),
+        m_buffers(std::max<UInt32>(numBuffers, 1)),
+        m_delay(delay),
+        m_frame(0),
+        m_nextId(0),
+        m_numEncoding(0)
+    {
+    }
+
+    ~FrameCapture()
+    {
+        wait();
+    }
+
+    /**
+     * @brief Request a capture, read back after the delay.
+     * @param flip True if the rows are read bottom up, as by OpenGL.
+     * @return The id of the capture.
+     */
+    UInt32 request(Bool flip = True)
+    {
+        Request request;
+        request.id = m_nextId++;
+        request.frame = m_frame;
+        request.flip = flip;
+
+        m_requests.push_back(request);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.numRequests;
+
+        return request.id;
+    }
+
+    //! True if the oldest request must be read back now, a staging buffer being free.
+    Bool isReadbackDue()
+    {
+        if (m_requests.empty() || (m_frame - m_requests.front().frame < m_delay)) {
+            return False;
+        }
+
+        if (findFreeBuffer() >= m_buffers.size()) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_stats.numWaits;
+            return False;
+        }
+
+        return True;
+    }
+
+    /**
+     * @brief Copy the mapped texels of the oldest due request, and queue its encoding.
+     * @param data Mapped texels, or null if the map failed, the capture fails then.
+     * @param mapTime Milliseconds the caller spent mapping the texels.
+     * @return False if no request is due or no staging buffer is free.
+     */
+    Bool submit(const UInt8 *data, UInt32 width, UInt32 height, UInt32 texelSize, UInt32 format,
+                Float mapTime = 0.0f)
+    {
+        if (m_requests.empty() || (m_frame - m_requests.front().frame < m_delay)) {
+            return False;
+        }
+
+        const size_t slot = findFreeBuffer();
+        if (slot >= m_buffers.size()) {
+            return False;
+        }
+
+        const Request request = m_requests.front();
+        m_requests.pop_front();
+
+        CaptureResult result;
+        result.id = request.id;
+        result.width = width;
+        result.height = height;
+        result.delay = m_frame - request.frame;
+
+        if (!data || !width || !height || !texelSize) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_stats.numFailed;
+            m_results.push_back(result);
+            return True;
+        }
+
+        // the map and the copy are the only work left on the draw thread, the buffers are reused
+        const auto start = std::chrono::steady_clock::now();
+
+        Buffer &buffer = m_buffers[slot];
+        buffer.frame.id = request.id;
+        buffer.frame.width = width;
+        buffer.frame.height = height;
+        buffer.frame.texelSize = texelSize;
+        buffer.frame.format = format;
+        buffer.frame.data.resize(size_t(width) * height * texelSize);
+        memcpy(buffer.frame.data.data(), data, buffer.frame.data.size());
+
+        result.readbackTime = mapTime + std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.readbackTime += result.readbackTime;
+            m_stats.maxReadbackTime = std::max(m_stats.maxReadbackTime, result.readbackTime);
+            buffer.busy = True;
+            ++m_numEncoding;
+        }
+
+        const Bool flip = request.flip;
+        m_pool.submit([this, slot, flip, result] () { encode(slot, flip, result); });
+
+        return True;
+    }
+
+    //! Next frame, and call the done function of the finished captures.
+    void update()
+    {
+        ++m_frame;
+
+        std::deque<CaptureResult> results;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            results.swap(m_results);
+        }
+
+        for (const CaptureResult &result : results) {
+            m_done(result);
+        }
+    }
+
+    //! Number of captures requested and not yet reported.
+    UInt32 getNumPending() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return UInt32(m_requests.size()) + m_numEncoding + UInt32(m_results.size());
+    }
+
+    //! Wait for the running encodings, the pending requests are kept.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_encoded.wait(lock, [this] { return m_numEncoding == 0; });
+    }
+
+    Stats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+private:
+
+    struct Request
+    {
+        UInt32 id;
+        UInt32 frame;
+        Bool flip;
+    };
+
+    struct Buffer
+    {
+        CaptureFrame frame;
+        Bool busy;        //!< Set while encoding, guarded by the mutex.
+
+        Buffer() : busy(False) {}
+    };
+
+    WorkerPool &m_pool;
+    EncodeFunc m_encode;
+    DoneFunc m_done;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_encoded;
+
+    std::vector<Buffer> m_buffers;
+    std::deque<Request> m_requests;       //!< Not read back yet, draw thread only.
+    std::deque<CaptureResult> m_results;  //!< Finished, not reported yet.
+
+    UInt32 m_delay;
+    UInt32 m_frame;
+    UInt32 m_nextId;
+    UInt32 m_numEncoding;
+    Stats m_stats;
+
+    size_t findFreeBuffer() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (size_t i = 0; i < m_buffers.size(); ++i) {
+            if (!m_buffers[i].busy) {
+                return i;
+            }
+        }
+
+        return m_buffers.size();
+    }
+
+    //! Flip and encode a staging buffer, on a worker.
+    void encode(size_t slot, Bool flip, CaptureResult result)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        CaptureFrame &frame = m_buffers[slot].frame;
+
+        if (flip) {
+            const size_t pitch = size_t(frame.width) * frame.texelSize;
+            std::vector<UInt8> row(pitch);
+
+            for (UInt32 y = 0; y < frame.height / 2; ++y) {
+                UInt8 *top = &frame.data[size_t(y) * pitch];
+                UInt8 *bottom = &frame.data[size_t(frame.height - 1 - y) * pitch];
+
+                memcpy(row.data(), top, pitch);
+                memcpy(top, bottom, pitch);
+                memcpy(bottom, row.data(), pitch);
+            }
+        }
+
+        result.valid = m_encode(frame);
+        result.encodeTime = std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_buffers[slot].busy = False;
+        --m_numEncoding;
+
+        if (result.valid) {
+            ++m_stats.numCaptured;
+        } else {
+            ++m_stats.numFailed;
+        }
+
+        m_stats.encodeTime += result.encodeTime;
+        m_results.push_back(result);
+
+        // under the lock, the capture may be destroyed as soon as wait returns
+        m_encoded.notify_all();
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_FRAMECAPTURE_H
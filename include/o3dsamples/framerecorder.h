@@ -0,0 +1,494 @@
+/**
+ * @file framerecorder.h
+ * @brief Continuous frame capture through bounded lock-free queues to encoder threads.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_FRAMERECORDER_H
+#define _O3DSAMPLES_FRAMERECORDER_H
+
+#include "framecapture.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace o3dsamples {
+
+/**
+ * @brief Bounded single producer single consumer ring of preallocated items.
+ * The producer fills the item returned by beginPush then publishes it with endPush, the
+ * consumer processes the item returned by front in place then releases it with pop. The
+ * items are reused, their buffers keep their capacity. The capacity is a power of two.
+ */
+template <class T>
+class SpscRing
+{
+public:
+
+    SpscRing(UInt32 capacity) :
+        m_items(roundUp(capacity)),
+        m_mask(UInt32(m_items.size()) - 1),
+        m_head(0),
+        m_tail(0)
+    {
+    }
+
+    UInt32 getCapacity() const { return UInt32(m_items.size()); }
+
+    //! Item to fill, or null if the ring is full. Producer only.
+    T* beginPush()
+    {
+        const UInt32 tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+            return nullptr;
+        }
+
+        return &m_items[tail & m_mask];
+    }
+
+    //! Publish the item returned by beginPush. Producer only.
+    void endPush()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    //! Oldest item, or null if the ring is empty. Consumer only.
+    T* front()
+    {
+        const UInt32 head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        return &m_items[head & m_mask];
+    }
+
+    //! Release the item returned by front. Consumer only.
+    void pop()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+
+    std::vector<T> m_items;
+    const UInt32 m_mask;
+
+    std::atomic<UInt32> m_head;   //!< Next item to consume.
+    std::atomic<UInt32> m_tail;   //!< Next item to produce.
+
+    static UInt32 roundUp(UInt32 capacity)
+    {
+        UInt32 size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+
+        return size;
+    }
+};
+
+/**
+ * @brief Record every Nth frame with encoder threads.
+ * Each encoder thread has its own SpscRing, the draw thread gives the frames to the
+ * encoders in turn, skipping a full ring. If every ring is full the frame is dropped,
+ * the rendering never waits for the encoding. Frames are numbered by their order of
+ * capture, a sink writing numbered files may run on several encoders. A sink writing a
+ * single stream needs the frames in order, so a single encoder.
+ * The sink is called on the encoder threads, with the index of the encoder. A sink
+ * calling the engine image codecs holds an ImageCodecLock around them, the codecs of
+ * several encoders then run one at a time.
+ * The recorder is started by its constructor and stopped by stop or its destructor,
+ * the queued frames being encoded first.
+ */
+class FrameRecorder
+{
+public:
+
+    //! Write a frame, on an encoder thread. The frame id is its number.
+    typedef std::function<Bool(const CaptureFrame &frame, UInt32 encoder)> SinkFunc;
+
+    struct Stats
+    {
+        UInt32 numFrames;         //!< Frames given to push.
+        UInt32 numQueued;         //!< Frames copied to a queue.
+        UInt32 numDropped;        //!< Frames dropped, every queue being full.
+        UInt32 numEncoded;        //!< Frames written by the sink.
+        UInt32 numFailed;         //!< Frames the sink could not write.
+        UInt64 encodedBytes;      //!< Texel bytes of the written frames.
+        Float pushTime;           //!< Milliseconds copying on the draw thread, sum.
+        Float maxPushTime;        //!< Longest copy.
+        Float encodeTime;         //!< Milliseconds in the sink, sum over the encoders.
+
+        Stats() :
+            numFrames(0),
+            numQueued(0),
+            numDropped(0),
+            numEncoded(0),
+            numFailed(0),
+            encodedBytes(0),
+            pushTime(0.0f),
+            maxPushTime(0.0f),
+            encodeTime(0.0f)
+        {
+        }
+    };
+
+    /**
+     * @brief Constructor, starts the encoder threads.
+     * @param sink Frame writer, called on the encoders.
+     * @param numEncoders Encoder threads.
+     * @param queueSize Frames queued per encoder, their buffers are kept.
+     * @param interval Record one frame every interval calls to isFrameDue.
+     */
+    FrameRecorder(SinkFunc sink, UInt32 numEncoders = 2, UInt32 queueSize = 4, UInt32 interval = 1) :
+        m_sink(sink),
+        m_interval(std::max<UInt32>(interval, 1)),
+        m_frame(0),
+        m_next(0),
+        m_quit(False),
+        m_pushTime(0.0f),
+        m_maxPushTime(0.0f)
+    {
+        numEncoders = std::max<UInt32>(numEncoders, 1);
+
+        for (UInt32 i = 0; i < numEncoders; ++i) {
+            m_encoders.emplace_back(new Encoder(queueSize));
+        }
+
+        for (UInt32 i = 0; i < numEncoders; ++i) {
+            m_encoders[i]->thread = std::thread(&FrameRecorder::run, this, i);
+        }
+    }
+
+    ~FrameRecorder()
+    {
+        stop();
+    }
+
+    //! Next frame, True if it must be recorded, one every interval frames. Producer only.
+    Bool isFrameDue()
+    {
+        return (m_frame++ % m_interval) == 0;
+    }
+
+    /**
+     * @brief Copy a frame to the queue of the next encoder with room. Producer only.
+     * @param flip True if the rows are bottom up, as read back by OpenGL.
+     * @return False if the frame is dropped.
+     */
+    Bool push(const UInt8 *data, UInt32 width, UInt32 height, UInt32 texelSize, UInt32 format, Bool flip = True)
+    {
+        m_stats.numFrames.fetch_add(1, std::memory_order_relaxed);
+
+        if (!data || !width || !height || !texelSize || m_quit.load(std::memory_order_relaxed)) {
+            m_stats.numDropped.fetch_add(1, std::memory_order_relaxed);
+            return False;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const UInt32 numEncoders = UInt32(m_encoders.size());
+
+        for (UInt32 i = 0; i < numEncoders; ++i) {
+            Encoder &encoder = *m_encoders[(m_next + i) % numEncoders];
+
+            Item *item = encoder.queue.beginPush();
+            if (!item) {
+                continue;
+            }
+
+            item->flip = flip;
+            item->frame.id = m_stats.numQueued.load(std::memory_order_relaxed);
+            item->frame.width = width;
+            item->frame.height = height;
+            item->frame.texelSize = texelSize;
+            item->frame.format = format;
+            item->frame.data.resize(size_t(width) * height * texelSize);
+            memcpy(item->frame.data.data(), data, item->frame.data.size());
+
+            encoder.queue.endPush();
+            encoder.wakeUp.notify_one();
+
+            m_next = (m_next + i + 1) % numEncoders;
+            m_stats.numQueued.fetch_add(1, std::memory_order_relaxed);
+
+            const Float time = std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - start).count();
+            m_pushTime += time;
+            m_maxPushTime = std::max(m_maxPushTime, time);
+
+            return True;
+        }
+
+        // back-pressure, the frame is dropped rather than waiting for an encoder
+        m_stats.numDropped.fetch_add(1, std::memory_order_relaxed);
+        return False;
+    }
+
+    //! Encode the queued frames and stop the encoders.
+    void stop()
+    {
+        if (m_quit.exchange(True)) {
+            return;
+        }
+
+        for (auto &encoder : m_encoders) {
+            encoder->wakeUp.notify_one();
+        }
+
+        for (auto &encoder : m_encoders) {
+            encoder->thread.join();
+        }
+    }
+
+    UInt32 getNumEncoders() const { return UInt32(m_encoders.size()); }
+
+    //! Statistics, the push times being those of the producer thread.
+    Stats getStats() const
+    {
+        Stats stats;
+        stats.numFrames = m_stats.numFrames.load();
+        stats.numQueued = m_stats.numQueued.load();
+        stats.numDropped = m_stats.numDropped.load();
+        stats.numEncoded = m_stats.numEncoded.load();
+        stats.numFailed = m_stats.numFailed.load();
+        stats.encodedBytes = m_stats.encodedBytes.load();
+        stats.pushTime = m_pushTime;
+        stats.maxPushTime = m_maxPushTime;
+
+        for (const auto &encoder : m_encoders) {
+            stats.encodeTime += Float(encoder->encodeTime.load()) / 1000.f;
+        }
+
+        return stats;
+    }
+
+private:
+
+    struct Item
+    {
+        CaptureFrame frame;
+        Bool flip;
+
+        Item() : flip(False) {}
+    };
+
+    struct Encoder
+    {
+        SpscRing<Item> queue;
+        std::thread thread;
+
+        //! Only to sleep when the queue is empty, the queue itself is lock-free.
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+
+        std::atomic<UInt64> encodeTime;   //!< Microseconds.
+
+        Encoder(UInt32 queueSize) : queue(std::max<UInt32>(queueSize, 1)), encodeTime(0) {}
+    };
+
+    struct AtomicStats
+    {
+        std::atomic<UInt32> numFrames;
+        std::atomic<UInt32> numQueued;
+        std::atomic<UInt32> numDropped;
+        std::atomic<UInt32> numEncoded;
+        std::atomic<UInt32> numFailed;
+        std::atomic<UInt64> encodedBytes;
+
+        AtomicStats() :
+            numFrames(0),
+            numQueued(0),
+            numDropped(0),
+            numEncoded(0),
+            numFailed(0),
+            encodedBytes(0)
+        {
+        }
+    };
+
+    SinkFunc m_sink;
+    std::vector<std::unique_ptr<Encoder>> m_encoders;
+
+    const UInt32 m_interval;
+    UInt32 m_frame;
+    UInt32 m_next;                //!< Encoder given the next frame first.
+    std::atomic<Bool> m_quit;
+
+    AtomicStats m_stats;
+    Float m_pushTime;
+    Float m_maxPushTime;
+
+    void run(UInt32 index)
+    {
+        Encoder &encoder = *m_encoders[index];
+
+        for (;;) {
+            Item *item = encoder.queue.front();
+
+            if (!item) {
+                if (m_quit.load()) {
+                    return;
+                }
+
+                // a push may be missed between the test and the wait, hence the timeout
+                std::unique_lock<std::mutex> lock(encoder.mutex);
+                encoder.wakeUp.wait_for(lock, std::chrono::milliseconds(2));
+                continue;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            CaptureFrame &frame = item->frame;
+
+            if (item->flip) {
+                flipRows(frame);
+            }
+
+            if (m_sink(frame, index)) {
+                m_stats.numEncoded.fetch_add(1);
+                m_stats.encodedBytes.fetch_add(frame.data.size());
+            } else {
+                m_stats.numFailed.fetch_add(1);
+            }
+
+            encoder.encodeTime.fetch_add(UInt64(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                    std::chrono::steady_clock::now() - start).count()));
+
+            encoder.queue.pop();
+        }
+    }
+
+    static void flipRows(CaptureFrame &frame)
+    {
+        const size_t pitch = size_t(frame.width) * frame.texelSize;
+        std::vector<UInt8> row(pitch);
+
+        for (UInt32 y = 0; y < frame.height / 2; ++y) {
+            UInt8 *top = &frame.data[size_t(y) * pitch];
+            UInt8 *bottom = &frame.data[size_t(frame.height - 1 - y) * pitch];
+
+            memcpy(row.data(), top, pitch);
+            memcpy(top, bottom, pitch);
+            memcpy(bottom, row.data(), pitch);
+        }
+    }
+};
+
+/**
+ * @brief Raw YUV 4:2:0 (I420) stream, BT.601 limited range, from RGB or RGBA frames.
+ * An odd last row or column is dropped. The file plays with, for instance:
+ * ffplay -f rawvideo -pixel_format yuv420p -video_size WxH file.yuv
+ * write must be called with the frames in order, from one thread at a time.
+ */
+class YuvStreamWriter
+{
+public:
+
+    YuvStreamWriter() : m_file(nullptr), m_width(0), m_height(0), m_numFrames(0) {}
+
+    ~YuvStreamWriter()
+    {
+        close();
+    }
+
+    Bool open(const char *path)
+    {
+        close();
+        m_file = fopen(path, "wb");
+        return m_file != nullptr;
+    }
+
+    void close()
+    {
+        if (m_file) {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    //! Append a frame, every frame must have the size of the first one.
+    Bool write(const CaptureFrame &frame)
+    {
+        if (!m_file || (frame.texelSize < 3)) {
+            return False;
+        }
+
+        const UInt32 w = frame.width & ~1u;
+        const UInt32 h = frame.height & ~1u;
+
+        if (!m_numFrames) {
+            m_width = w;
+            m_height = h;
+        } else if ((w != m_width) || (h != m_height)) {
+            return False;
+        }
+
+        m_planes.resize(size_t(w) * h * 3 / 2);
+
+        UInt8 *yPlane = m_planes.data();
+        UInt8 *uPlane = yPlane + size_t(w) * h;
+        UInt8 *vPlane = uPlane + size_t(w / 2) * (h / 2);
+
+        const UInt32 ts = frame.texelSize;
+        const size_t pitch = size_t(frame.width) * ts;
+
+        for (UInt32 y = 0; y < h; y += 2) {
+            const UInt8 *row0 = &frame.data[size_t(y) * pitch];
+            const UInt8 *row1 = row0 + pitch;
+
+            for (UInt32 x = 0; x < w; x += 2) {
+                Int32 r = 0, g = 0, b = 0;
+
+                const UInt8 *texels[4] = { row0 + x * ts, row0 + (x + 1) * ts, row1 + x * ts, row1 + (x + 1) * ts };
+                UInt8 *luma[4] = {
+                    &yPlane[size_t(y) * w + x], &yPlane[size_t(y) * w + x + 1],
+                    &yPlane[size_t(y + 1) * w + x], &yPlane[size_t(y + 1) * w + x + 1] };
+
+                for (UInt32 i = 0; i < 4; ++i) {
+                    const Int32 tr = texels[i][0], tg = texels[i][1], tb = texels[i][2];
+                    *luma[i] = UInt8(((66 * tr + 129 * tg + 25 * tb + 128) >> 8) + 16);
+                    r += tr;
+                    g += tg;
+                    b += tb;
+                }
+
+                // chroma of the 2x2 average
+                r = (r + 2) >> 2;
+                g = (g + 2) >> 2;
+                b = (b + 2) >> 2;
+
+                const size_t c = size_t(y / 2) * (w / 2) + x / 2;
+                uPlane[c] = UInt8(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                vPlane[c] = UInt8(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+
+        if (fwrite(m_planes.data(), 1, m_planes.size(), m_file) != m_planes.size()) {
+            return False;
+        }
+
+        ++m_numFrames;
+        return True;
+    }
+
+    UInt32 getNumFrames() const { return m_numFrames; }
+    UInt32 getWidth() const { return m_width; }
+    UInt32 getHeight() const { return m_height; }
+
+private:
+
+    FILE *m_file;
+    UInt32 m_width;
+    UInt32 m_height;
+    UInt32 m_numFrames;
+    std::vector<UInt8> m_planes;
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_FRAMERECORDER_H
@@ -0,0 +1,189 @@
+/**
+ * @file frontbackorder.h
+ * @brief Persistent front to back order of the cells of a regular grid around a camera.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_FRONTBACKORDER_H
+#define _O3DSAMPLES_FRONTBACKORDER_H
+
+#include <o3d/core/base.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace o3dsamples {
+
+using namespace o3d;
+
+/**
+ * @brief Front to back order of the cells of a grid (terrain patches) without sorting.
+ * The distance from the camera to a cell, quantized to the cell size, only depends on
+ * the offset between the camera cell and that cell. The offsets in range are sorted
+ * once by quantized distance (buckets), then the order for a camera cell is obtained by
+ * walking this table. The order is only rebuilt when the camera crosses a cell
+ * boundary, and it costs a walk of the cells in range, never a comparison sort.
+ * Inside a bucket the cells are in the same order for any camera position, so the
+ * order is exact up to one cell size.
+ */
+class FrontToBackOrder
+{
+public:
+
+    static const UInt32 NONE = 0xffffffff;
+
+    FrontToBackOrder() :
+        m_originX(0.0f),
+        m_originZ(0.0f),
+        m_cellSize(1.0f),
+        m_cellsX(0),
+        m_cellsZ(0),
+        m_cameraI(0),
+        m_cameraJ(0),
+        m_valid(False),
+        m_numRebuilds(0),
+        m_lastWork(0)
+    {
+    }
+
+    /**
+     * @brief Define the grid and the range of the order.
+     * @param originX, originZ Position of the corner of the first cell.
+     * @param cellSize Size of a cell.
+     * @param cellsX, cellsZ Number of cells.
+     * @param radius Cells farther than this distance from the camera are not ordered.
+     */
+    void setGrid(Float originX, Float originZ, Float cellSize, Int32 cellsX, Int32 cellsZ, Float radius)
+    {
+        m_originX = originX;
+        m_originZ = originZ;
+        m_cellSize = cellSize;
+        m_cellsX = cellsX;
+        m_cellsZ = cellsZ;
+
+        m_cells.assign(size_t(cellsX) * cellsZ, UInt32(NONE));
+        m_valid = False;
+
+        // offsets in range, sorted once by quantized min distance then by center distance
+        const Int32 r = Int32(std::ceil(radius / cellSize)) + 1;
+
+        m_offsets.clear();
+
+        for (Int32 dj = -r; dj <= r; ++dj) {
+            for (Int32 di = -r; di <= r; ++di) {
+                // min distance from any point of the camera cell to the cell
+                const Float mi = Float(std::max(std::abs(di) - 1, 0));
+                const Float mj = Float(std::max(std::abs(dj) - 1, 0));
+                const Float minDist = std::sqrt(mi*mi + mj*mj) * cellSize;
+
+                if (minDist <= radius) {
+                    Offset offset = { di, dj, UInt32(minDist / cellSize), di*di + dj*dj };
+                    m_offsets.push_back(offset);
+                }
+            }
+        }
+
+        std::sort(m_offsets.begin(), m_offsets.end(), [] (const Offset &a, const Offset &b) {
+            return (a.bucket < b.bucket) || ((a.bucket == b.bucket) && (a.dist2 < b.dist2));
+        });
+    }
+
+    //! Set the identifier of the object of a cell (NONE for an empty cell).
+    void setCell(Int32 i, Int32 j, UInt32 id)
+    {
+        m_cells[size_t(j) * m_cellsX + i] = id;
+        m_valid = False;
+    }
+
+    /**
+     * @brief Update the order for a camera position.
+     * @return True if the order was rebuilt (the camera changed of cell).
+     */
+    Bool update(Float x, Float z)
+    {
+        const Int32 i = Int32(std::floor((x - m_originX) / m_cellSize));
+        const Int32 j = Int32(std::floor((z - m_originZ) / m_cellSize));
+
+        m_lastWork = 0;
+
+        if (m_valid && (i == m_cameraI) && (j == m_cameraJ)) {
+            return False;
+        }
+
+        m_cameraI = i;
+        m_cameraJ = j;
+        m_valid = True;
+
+        m_order.clear();
+        m_buckets.clear();
+
+        for (const Offset &offset : m_offsets) {
+            const Int32 ci = i + offset.di, cj = j + offset.dj;
+
+            if ((ci < 0) || (cj < 0) || (ci >= m_cellsX) || (cj >= m_cellsZ)) {
+                continue;
+            }
+
+            const UInt32 id = m_cells[size_t(cj) * m_cellsX + ci];
+            if (id == NONE) {
+                continue;
+            }
+
+            while (m_buckets.size() <= offset.bucket) {
+                m_buckets.push_back(static_cast<UInt32>(m_order.size()));
+            }
+
+            m_order.push_back(id);
+        }
+
+        m_lastWork = static_cast<UInt32>(m_offsets.size());
+        ++m_numRebuilds;
+
+        return True;
+    }
+
+    //! Identifiers of the cells in range, front to back.
+    const std::vector<UInt32>& getOrder() const { return m_order; }
+
+    //! Start index into the order of each quantized distance bucket.
+    const std::vector<UInt32>& getBuckets() const { return m_buckets; }
+
+    //! Number of rebuilds since the start.
+    UInt32 getNumRebuilds() const { return m_numRebuilds; }
+
+    //! Number of table entries walked by the last update (0 if the order was kept).
+    UInt32 getLastWork() const { return m_lastWork; }
+
+private:
+
+    struct Offset
+    {
+        Int32 di, dj;
+        UInt32 bucket;
+        Int32 dist2;
+    };
+
+    Float m_originX, m_originZ;
+    Float m_cellSize;
+    Int32 m_cellsX, m_cellsZ;
+
+    std::vector<UInt32> m_cells;
+    std::vector<Offset> m_offsets;
+
+    std::vector<UInt32> m_order;
+    std::vector<UInt32> m_buckets;
+
+    Int32 m_cameraI, m_cameraJ;
+    Bool m_valid;
+
+    UInt32 m_numRebuilds;
+    UInt32 m_lastWork;
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_FRONTBACKORDER_H
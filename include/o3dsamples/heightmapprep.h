@@ -0,0 +1,366 @@
+/**
+ * @file heightmapprep.h
+ * @brief Fused and tiled preprocessing of a heightmap: flip, scale, noise and normals.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_HEIGHTMAPPREP_H
+#define _O3DSAMPLES_HEIGHTMAPPREP_H
+
+#include "workerpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief Parameters of the preprocessing, the units follow HeightmapSplatting::setUnits.
+ */
+struct HeightmapPrepParams
+{
+    Bool flip;              //!< Reverse the rows, like Image::hFlip.
+    Float unitX;            //!< Distance between two texels along X.
+    Float unitY;            //!< Height of a texel value of 1.
+    Float unitZ;            //!< Distance between two rows.
+    Bool normals;           //!< Compute the normal map.
+    Bool texels;            //!< Write the height texels. Without noise they are the flipped source.
+    Float noiseAmplitude;   //!< Height added by the detail noise at its extremes (0 disables it).
+    Float noiseScale;       //!< Heightmap texels per noise texel.
+    UInt32 tileSize;        //!< Texels per tile side.
+
+    HeightmapPrepParams() :
+        flip(True),
+        unitX(1.0f),
+        unitY(0.1f),
+        unitZ(1.0f),
+        normals(True),
+        texels(True),
+        noiseAmplitude(0.0f),
+        noiseScale(2.0f),
+        tileSize(128)
+    {
+    }
+};
+
+/**
+ * @brief Build the data of a heightmap terrain in a single pass over tiles.
+ * Each tile first computes its block of final heights, one texel larger on each side
+ * (flipped rows, scaled values, detail noise added), then derives every output of the
+ * tile from this block while it is in the cache: the heights in world units, the
+ * height texels in the source format, the Sobel normals and the flipped colors.
+ * A color image of another size than the heights is flipped at its own size, in a
+ * pass over its rows after the tiles.
+ * The clamped source columns and the noise columns of a tile are computed once for all
+ * its rows. The outputs are not initialized before being written, so each byte of them
+ * is written once, and only the requested outputs are allocated. The tiles are independent and split across a WorkerPool. The output
+ * does not depend on the tile size nor on the number of threads.
+ * The normals are stored as RGB8 with red along X, green along Z and blue up.
+ */
+class HeightmapPrep
+{
+public:
+
+    //! An image in memory, rows from the first to the last.
+    struct Source
+    {
+        const UInt8 *data;
+        UInt32 width;
+        UInt32 height;
+        UInt32 texelSize;   //!< Bytes per texel, the first one is used for the heights and the noise.
+
+        Source() : data(nullptr), width(0), height(0), texelSize(0) {}
+
+        Source(const UInt8 *_data, UInt32 _width, UInt32 _height, UInt32 _texelSize) :
+            data(_data), width(_width), height(_height), texelSize(_texelSize) {}
+    };
+
+    HeightmapPrep() :
+        m_width(0),
+        m_height(0),
+        m_texelSize(0),
+        m_colorWidth(0),
+        m_colorHeight(0),
+        m_colorSize(0),
+        m_texelsDone(False),
+        m_normalsDone(False),
+        m_heightsCapacity(0),
+        m_texelsCapacity(0),
+        m_normalsCapacity(0),
+        m_colorsCapacity(0),
+        m_time(0.0f)
+    {
+    }
+
+    /**
+     * @brief Process a heightmap.
+     * @param heights Height image.
+     * @param colors Optional color image of any size, flipped along.
+     * @param noise Optional detail noise, tiled over the heightmap.
+     * @param params Parameters.
+     * @param pool Optional pool of workers.
+     */
+    Bool run(const Source &heights, const Source *colors, const Source *noise,
+             const HeightmapPrepParams &params, WorkerPool *pool = nullptr)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        if (!heights.data || !heights.width || !heights.height || !heights.texelSize || !params.tileSize) {
+            return False;
+        }
+
+        if (colors && (!colors->data || !colors->width || !colors->height || !colors->texelSize)) {
+            return False;
+        }
+
+        if ((heights.texelSize > 4) || (colors && (colors->texelSize > 4))) {
+            return False;
+        }
+
+        m_width = heights.width;
+        m_height = heights.height;
+        m_texelSize = heights.texelSize;
+        m_colorWidth = colors ? colors->width : 0;
+        m_colorHeight = colors ? colors->height : 0;
+        m_colorSize = colors ? colors->texelSize : 0;
+        m_texelsDone = params.texels;
+        m_normalsDone = params.normals;
+
+        const size_t count = size_t(m_width) * m_height;
+
+        // the buffers are kept between two runs, and never cleared
+        reserve(m_heights, m_heightsCapacity, count);
+
+        if (m_texelsDone) {
+            reserve(m_texels, m_texelsCapacity, count * m_texelSize);
+        }
+        if (m_normalsDone) {
+            reserve(m_normals, m_normalsCapacity, count * 3);
+        }
+        if (colors) {
+            reserve(m_colors, m_colorsCapacity, size_t(m_colorWidth) * m_colorHeight * m_colorSize);
+        }
+
+        // the colors of the size of the heights are flipped along the tiles
+        const Bool fusedColors = colors && (m_colorWidth == m_width) && (m_colorHeight == m_height);
+
+        const UInt32 tilesX = (m_width + params.tileSize - 1) / params.tileSize;
+        const UInt32 tilesY = (m_height + params.tileSize - 1) / params.tileSize;
+
+        auto process = [&] (UInt32 begin, UInt32 end) {
+            Scratch scratch;
+            for (UInt32 t = begin; t < end; ++t) {
+                processTile(t % tilesX, t / tilesX, heights, fusedColors ? colors : nullptr, noise, params, scratch);
+            }
+        };
+
+        auto flipColors = [&] (UInt32 begin, UInt32 end) {
+            const size_t pitch = size_t(m_colorWidth) * m_colorSize;
+            for (UInt32 y = begin; y < end; ++y) {
+                memcpy(&m_colors[y * pitch], colors->data + sourceRow(y, m_colorHeight, params.flip) * pitch, pitch);
+            }
+        };
+
+        if (pool) {
+            pool->parallelFor(tilesX * tilesY, 1, process);
+
+            if (colors && !fusedColors) {
+                pool->parallelFor(m_colorHeight, 64, flipColors);
+            }
+        } else {
+            process(0, tilesX * tilesY);
+
+            if (colors && !fusedColors) {
+                flipColors(0, m_colorHeight);
+            }
+        }
+
+        m_time = std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return True;
+    }
+
+    UInt32 getWidth() const { return m_width; }
+    UInt32 getHeight() const { return m_height; }
+
+    //! Heights in world units, width * height row by row.
+    const Float* getHeights() const { return m_heights.get(); }
+    //! Height texels in the source format, flipped, nullptr if not written.
+    const UInt8* getHeightTexels() const { return m_texelsDone ? m_texels.get() : nullptr; }
+    //! RGB8 normals, nullptr if not computed.
+    const UInt8* getNormals() const { return m_normalsDone ? m_normals.get() : nullptr; }
+    //! Colors in the source format at the size of the source, flipped, nullptr without colors.
+    const UInt8* getColors() const { return m_colorSize ? m_colors.get() : nullptr; }
+
+    UInt32 getColorWidth() const { return m_colorWidth; }
+    UInt32 getColorHeight() const { return m_colorHeight; }
+
+    //! Bytes of the height texels, of the normals and of the colors.
+    size_t getHeightTexelBytes() const { return m_texelsDone ? size_t(m_width) * m_height * m_texelSize : 0; }
+    size_t getNormalBytes() const { return m_normalsDone ? size_t(m_width) * m_height * 3 : 0; }
+    size_t getColorBytes() const { return size_t(m_colorWidth) * m_colorHeight * m_colorSize; }
+
+    //! Milliseconds of the last run.
+    Float getTime() const { return m_time; }
+
+    //! Encode a normal component from [-1, 1] to a byte.
+    static UInt8 encode(Float n)
+    {
+        return UInt8(std::min(std::max((n * 0.5f + 0.5f) * 255.0f + 0.5f, 0.0f), 255.0f));
+    }
+
+private:
+
+    //! Per thread buffers.
+    struct Scratch
+    {
+        std::vector<Float> block;          //!< Final heights of a tile and its border.
+        std::vector<UInt32> columns;       //!< Clamped source columns of the block.
+        std::vector<UInt32> noiseColumns;  //!< Noise columns of the block.
+    };
+
+    UInt32 m_width;
+    UInt32 m_height;
+    UInt32 m_texelSize;
+    UInt32 m_colorWidth;
+    UInt32 m_colorHeight;
+    UInt32 m_colorSize;
+    Bool m_texelsDone;
+    Bool m_normalsDone;
+
+    size_t m_heightsCapacity;
+    size_t m_texelsCapacity;
+    size_t m_normalsCapacity;
+    size_t m_colorsCapacity;
+
+    std::unique_ptr<Float[]> m_heights;
+    std::unique_ptr<UInt8[]> m_texels;
+    std::unique_ptr<UInt8[]> m_normals;
+    std::unique_ptr<UInt8[]> m_colors;
+
+    Float m_time;
+
+    //! Grow a buffer, without initializing it.
+    template <class T>
+    static void reserve(std::unique_ptr<T[]> &buffer, size_t &capacity, size_t count)
+    {
+        if (count > capacity) {
+            buffer.reset(new T[count]);
+            capacity = count;
+        }
+    }
+
+    //! Source row of an output row.
+    static UInt32 sourceRow(UInt32 y, UInt32 height, Bool flip) { return flip ? height - 1 - y : y; }
+
+    void processTile(UInt32 tx, UInt32 ty, const Source &heights, const Source *colors, const Source *noise,
+                     const HeightmapPrepParams &params, Scratch &scratch)
+    {
+        const UInt32 x0 = tx * params.tileSize;
+        const UInt32 y0 = ty * params.tileSize;
+        const UInt32 w = std::min(params.tileSize, m_width - x0);
+        const UInt32 h = std::min(params.tileSize, m_height - y0);
+        const UInt32 bw = w + 2;
+        const UInt32 texelSize = heights.texelSize;
+
+        const Bool hasNoise = noise && noise->data && (params.noiseAmplitude != 0.0f);
+        const Float invNoiseScale = 1.0f / params.noiseScale;
+
+        // columns of the block, the same for every row
+        scratch.columns.resize(bw);
+        scratch.noiseColumns.resize(bw);
+
+        for (UInt32 i = 0; i < bw; ++i) {
+            const UInt32 cx = UInt32(std::min(std::max(Int32(x0 + i) - 1, 0), Int32(m_width) - 1));
+            scratch.columns[i] = cx * texelSize;
+            scratch.noiseColumns[i] = hasNoise ? (UInt32(cx * invNoiseScale) % noise->width) * noise->texelSize : 0;
+        }
+
+        // final heights of the tile and of its border: flipped, scaled and with the noise
+        scratch.block.resize(size_t(bw) * (h + 2));
+
+        for (UInt32 j = 0; j < h + 2; ++j) {
+            const UInt32 cy = UInt32(std::min(std::max(Int32(y0 + j) - 1, 0), Int32(m_height) - 1));
+            const UInt8 *src = heights.data + size_t(sourceRow(cy, m_height, params.flip)) * m_width * texelSize;
+            Float *dst = &scratch.block[size_t(j) * bw];
+
+            for (UInt32 i = 0; i < bw; ++i) {
+                dst[i] = src[scratch.columns[i]] * params.unitY;
+            }
+
+            if (hasNoise) {
+                const UInt8 *noiseRow = noise->data + size_t(UInt32(cy * invNoiseScale) % noise->height) * noise->width * noise->texelSize;
+
+                for (UInt32 i = 0; i < bw; ++i) {
+                    const Float n = noiseRow[scratch.noiseColumns[i]] / 255.0f - 0.5f;
+                    dst[i] += n * 2.0f * params.noiseAmplitude;
+                }
+            }
+        }
+
+        const Float invY = params.unitY != 0.0f ? 1.0f / params.unitY : 0.0f;
+        const Float invX = 1.0f / (8.0f * params.unitX);
+        const Float invZ = 1.0f / (8.0f * params.unitZ);
+
+        for (UInt32 j = 0; j < h; ++j) {
+            const UInt32 y = y0 + j;
+            const UInt32 sy = sourceRow(y, m_height, params.flip);
+            const Float *above = &scratch.block[size_t(j) * bw];
+            const Float *row = above + bw;
+            const Float *below = row + bw;
+
+            const size_t first = size_t(y) * m_width + x0;
+            const UInt8 *srcTexels = heights.data + (size_t(sy) * m_width + x0) * texelSize;
+
+            memcpy(&m_heights[first], row + 1, w * sizeof(Float));
+
+            if (params.texels) {
+                memcpy(&m_texels[first * texelSize], srcTexels, size_t(w) * texelSize);
+            }
+
+            // the first channel of the texels takes the noise
+            if (params.texels && hasNoise) {
+                for (UInt32 i = 0; i < w; ++i) {
+                    m_texels[(first + i) * texelSize] = UInt8(std::min(std::max(row[i + 1] * invY + 0.5f, 0.0f), 255.0f));
+                }
+            }
+
+            if (colors) {
+                memcpy(&m_colors[first * m_colorSize],
+                       colors->data + (size_t(sy) * m_width + x0) * m_colorSize,
+                       size_t(w) * m_colorSize);
+            }
+
+            if (!params.normals) {
+                continue;
+            }
+
+            for (UInt32 i = 0; i < w; ++i) {
+                const size_t out = first + i;
+
+                // Sobel gradients in world units, the rows go along +Z
+                const Float dx = ((above[i + 2] + 2.0f * row[i + 2] + below[i + 2]) -
+                                  (above[i] + 2.0f * row[i] + below[i])) * invX;
+                const Float dz = ((below[i] + 2.0f * below[i + 1] + below[i + 2]) -
+                                  (above[i] + 2.0f * above[i + 1] + above[i + 2])) * invZ;
+
+                const Float inv = 1.0f / std::sqrt(dx*dx + dz*dz + 1.0f);
+
+                UInt8 *normal = &m_normals[out * 3];
+                normal[0] = encode(-dx * inv);
+                normal[1] = encode(-dz * inv);
+                normal[2] = encode(inv);
+            }
+        }
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_HEIGHTMAPPREP_H
@@ -0,0 +1,57 @@
+/**
+ * @file imagecodec.h
+ * @brief Serialization of the engine image codecs called from worker threads.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_IMAGECODEC_H
+#define _O3DSAMPLES_IMAGECODEC_H
+
+#include <o3d/core/base.h>
+
+#include <mutex>
+
+namespace o3dsamples {
+
+using namespace o3d;
+
+/**
+ * @brief Held around each Image::load and Image::save made out of the main thread.
+ * The engine does not document its image codecs and its file manager as thread safe,
+ * so a single process wide lock lets one of them run at a time. The work around the
+ * codec (reading the sizes, flips, conversions, queues) stays parallel.
+ * Building with O3DSAMPLES_THREADSAFE_CODECS removes the lock, to measure the parallel
+ * codecs with an engine known to support them.
+ */
+class ImageCodecLock
+{
+public:
+
+#ifdef O3DSAMPLES_THREADSAFE_CODECS
+    ImageCodecLock() {}
+#else
+    ImageCodecLock() : m_lock(getMutex()) {}
+#endif
+
+private:
+
+#ifndef O3DSAMPLES_THREADSAFE_CODECS
+    std::lock_guard<std::mutex> m_lock;
+
+    static std::mutex& getMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+#endif
+
+    ImageCodecLock(const ImageCodecLock&) = delete;
+    ImageCodecLock& operator=(const ImageCodecLock&) = delete;
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_IMAGECODEC_H
@@ -0,0 +1,149 @@
+/**
+ * @file imageloader.h
+ * @brief Decoding of a list of images with timings.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_IMAGELOADER_H
+#define _O3DSAMPLES_IMAGELOADER_H
+
+#include "imagecodec.h"
+
+#include <o3d/core/string.h>
+#include <o3d/image/image.h>
+
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief Decode a list of images one after the other on the calling thread, and keep
+ * the size and the time of the decoding.
+ * There is no parallel path : the JPEG and PNG decoders belong to the engine, which does
+ * not state them thread-safe, so they are called under the ImageCodecLock and a pool
+ * would only wait on it. A faster decoding must come from the engine image module.
+ */
+class ImageLoader
+{
+public:
+
+    struct Stats
+    {
+        UInt32 numImages;     //!< Images of the last load.
+        UInt32 numFailed;     //!< Images that could not be decoded.
+        UInt64 fileBytes;     //!< Bytes of the files.
+        UInt64 texelBytes;    //!< Bytes of the decoded texels.
+        Float time;           //!< Milliseconds of the whole load.
+        Float decodeTime;     //!< Sum of the milliseconds of each decoding.
+
+        Stats() :
+            numImages(0),
+            numFailed(0),
+            fileBytes(0),
+            texelBytes(0),
+            time(0.0f),
+            decodeTime(0.0f)
+        {
+        }
+    };
+
+    /**
+     * @brief Queue an image.
+     * @param fileName File to decode.
+     * @param image Image receiving the content.
+     * @param flip Flip the rows once decoded, like Image::hFlip.
+     */
+    void add(const String &fileName, Image &image, Bool flip = False)
+    {
+        Request request;
+        request.fileName = fileName;
+        request.image = &image;
+        request.flip = flip;
+        request.fileBytes = fileSize(fileName);
+        request.decodeTime = 0.0f;
+        request.valid = False;
+
+        m_requests.push_back(request);
+    }
+
+    //! Number of queued images.
+    UInt32 getNumRequests() const { return UInt32(m_requests.size()); }
+
+    /**
+     * @brief Decode the queued images, then clear the queue.
+     * @return True if every image is valid.
+     */
+    Bool load()
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (Request &request : m_requests) {
+            const auto decodeStart = std::chrono::steady_clock::now();
+
+            {
+                ImageCodecLock lock;
+                request.valid = request.image->load(request.fileName) && request.image->isValid();
+            }
+
+            if (request.valid && request.flip) {
+                request.image->hFlip();
+            }
+
+            request.decodeTime = std::chrono::duration<Float, std::milli>(
+                                     std::chrono::steady_clock::now() - decodeStart).count();
+        }
+
+        m_stats = Stats();
+        m_stats.numImages = UInt32(m_requests.size());
+
+        for (const Request &request : m_requests) {
+            m_stats.fileBytes += request.fileBytes;
+            m_stats.decodeTime += request.decodeTime;
+
+            if (request.valid) {
+                m_stats.texelBytes += UInt64(request.image->getWidth()) * request.image->getHeight() *
+                                      (request.image->getBpp() / 8);
+            } else {
+                ++m_stats.numFailed;
+            }
+        }
+
+        m_stats.time = std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_requests.clear();
+
+        return m_stats.numFailed == 0;
+    }
+
+    //! Statistics of the last load.
+    const Stats& getStats() const { return m_stats; }
+
+private:
+
+    struct Request
+    {
+        String fileName;
+        Image *image;
+        Bool flip;
+        UInt64 fileBytes;
+        Float decodeTime;
+        Bool valid;
+    };
+
+    std::vector<Request> m_requests;
+    Stats m_stats;
+
+    static UInt64 fileSize(const String &fileName)
+    {
+        std::ifstream file(fileName.toUtf8().getData(), std::ios::binary | std::ios::ate);
+        return file ? UInt64(file.tellg()) : 0;
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_IMAGELOADER_H
@@ -0,0 +1,158 @@
+/**
+ * @file instancing.h
+ * @brief Grouping of the sorted draw commands of a same mesh and material into instanced
+ * draws, with their instance buffer of transforms.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_INSTANCING_H
+#define _O3DSAMPLES_INSTANCING_H
+
+#include "drawcommands.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief A draw of count instances of a mesh, their transforms being in the instance
+ * buffer from first.
+ */
+struct InstanceBatch
+{
+    UInt32 pass;
+    UInt32 material;
+    UInt32 texture;
+    UInt32 mesh;
+    UInt32 first;         //!< First instance in the instance buffer.
+    UInt32 count;         //!< Number of instances, 1 for a plain draw.
+};
+
+/**
+ * @brief Group the commands of a sorted DrawCommands sharing their pass, material,
+ * texture and mesh, which the sort key makes adjacent, into instanced draws.
+ * The translucent commands have their depth above the material in their key, so only
+ * the neighbours in depth order are grouped and the blending order is kept.
+ * The instance buffer holds a 3x4 row major transform (12 floats) per instance, copied
+ * from the transforms of the objects in parallel on a pool. A group smaller than the
+ * minimum instance count is kept as plain draws.
+ */
+class InstanceBatcher
+{
+public:
+
+    static const UInt32 TRANSFORM_SIZE = 12;  //!< Floats per instance.
+
+    struct Stats
+    {
+        UInt32 numCommands;       //!< Draw calls before grouping.
+        UInt32 numBatches;        //!< Draw calls after grouping.
+        UInt32 numInstanced;      //!< Batches of more than one instance.
+        UInt32 maxInstances;      //!< Largest batch.
+
+        Stats() : numCommands(0), numBatches(0), numInstanced(0), maxInstances(0) {}
+    };
+
+    InstanceBatcher(UInt32 minInstances = 2) : m_minInstances(minInstances > 1 ? minInstances : 2) {}
+
+    /**
+     * @brief Build the batches and the instance buffer.
+     * @param commands Commands ordered by sort.
+     * @param transforms TRANSFORM_SIZE floats per object, indexed by DrawItem::object.
+     * @param pool Pool to copy the transforms, or null.
+     */
+    void build(const DrawCommands &commands, const Float *transforms, WorkerPool *pool = nullptr)
+    {
+        const UInt32 count = commands.getNumItems();
+
+        m_batches.clear();
+        m_stats = Stats();
+        m_stats.numCommands = count;
+
+        UInt32 begin = 0;
+        while (begin < count) {
+            const DrawItem &first = commands.getItem(begin);
+
+            UInt32 end = begin + 1;
+            while ((end < count) && sameState(first, commands.getItem(end))) {
+                ++end;
+            }
+
+            InstanceBatch batch;
+            batch.pass = first.pass;
+            batch.material = first.material;
+            batch.texture = first.texture;
+            batch.mesh = first.mesh;
+
+            if (end - begin >= m_minInstances) {
+                batch.first = begin;
+                batch.count = end - begin;
+                m_batches.push_back(batch);
+
+                ++m_stats.numInstanced;
+                m_stats.maxInstances = std::max(m_stats.maxInstances, batch.count);
+            } else {
+                for (UInt32 i = begin; i < end; ++i) {
+                    batch.first = i;
+                    batch.count = 1;
+                    m_batches.push_back(batch);
+                }
+
+                m_stats.maxInstances = std::max<UInt32>(m_stats.maxInstances, 1);
+            }
+
+            begin = end;
+        }
+
+        m_stats.numBatches = UInt32(m_batches.size());
+
+        // the instances are in the order of the commands
+        m_instances.resize(size_t(count) * TRANSFORM_SIZE);
+
+        auto copy = [this, &commands, transforms] (UInt32 from, UInt32 to) {
+            for (UInt32 i = from; i < to; ++i) {
+                memcpy(&m_instances[size_t(i) * TRANSFORM_SIZE],
+                       &transforms[size_t(commands.getItem(i).object) * TRANSFORM_SIZE],
+                       TRANSFORM_SIZE * sizeof(Float));
+            }
+        };
+
+        if (pool) {
+            pool->parallelFor(count, 4096, copy);
+        } else {
+            copy(0, count);
+        }
+    }
+
+    const std::vector<InstanceBatch>& getBatches() const { return m_batches; }
+
+    //! TRANSFORM_SIZE floats per instance.
+    const std::vector<Float>& getInstances() const { return m_instances; }
+
+    size_t getInstanceBytes() const { return m_instances.size() * sizeof(Float); }
+
+    const Stats& getStats() const { return m_stats; }
+
+private:
+
+    UInt32 m_minInstances;
+
+    std::vector<InstanceBatch> m_batches;
+    std::vector<Float> m_instances;
+    Stats m_stats;
+
+    static Bool sameState(const DrawItem &a, const DrawItem &b)
+    {
+        return (a.pass == b.pass) && (a.material == b.material) &&
+               (a.texture == b.texture) && (a.mesh == b.mesh);
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_INSTANCING_H
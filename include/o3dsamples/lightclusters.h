@@ -0,0 +1,643 @@
+/**
+ * @file lightclusters.h
+ * @brief Assignment of point and spot lights to clusters, screen tiles crossed with depth
+ * slices, as compact index lists for a deferred or forward+ lighting pass.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_LIGHTCLUSTERS_H
+#define _O3DSAMPLES_LIGHTCLUSTERS_H
+
+#include "simdmath.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief A light given to the cluster assignment, in view space (the camera looking
+ * down -Z, Y up).
+ */
+struct ClusterLight
+{
+    enum Type
+    {
+        POINT_LIGHT = 0,
+        SPOT_LIGHT
+    };
+
+    Type type;
+    Float position[3];
+    Float direction[3];   //!< Normalized, spot lights only.
+    Float range;          //!< Distance of influence.
+    Float cutOff;         //!< Half angle of the cone in degrees, spot lights only.
+};
+
+/**
+ * @brief Assign lights to the clusters of a perspective view, tiles of tileSize pixels
+ * crossed with numSlices depth slices distributed exponentially from the near plane to
+ * the far plane.
+ * A light is first tested against the four side planes of each tile, 1, 4 or 8 lights
+ * at a time. Each candidate of a tile is then tested against the boxes bounding the
+ * froxels (the frustum pieces of the clusters) of the slices its depth covers, 1, 4 or
+ * 8 slices at a time, with a sphere test for the point lights and a sphere and cone
+ * test for the spot lights. The paths give the same lists, and the tiles are processed
+ * in parallel by rows on a pool.
+ * The result is a range (offset, count) per cluster into one list of 16 bits light
+ * indices, ready to be uploaded, each list being ordered by light index.
+ */
+class LightClusters
+{
+public:
+
+    enum Path
+    {
+        PATH_SCALAR = 0,
+        PATH_SSE2,
+        PATH_AVX,
+        PATH_BEST
+    };
+
+    static const UInt32 MAX_LIGHTS = 65536;     //!< Lights beyond are ignored.
+
+    struct Stats
+    {
+        UInt32 numLights;             //!< Lights given to build.
+        UInt32 numVisible;            //!< Lights overlapping the depth range.
+        UInt32 numCandidates;         //!< Light and tile pairs passing the tile test.
+        UInt32 numIndices;            //!< Light and cluster pairs.
+        UInt32 maxPerCluster;
+        UInt32 numEmpty;              //!< Clusters without light.
+
+        Stats() : numLights(0), numVisible(0), numCandidates(0), numIndices(0), maxPerCluster(0), numEmpty(0) {}
+    };
+
+    LightClusters() :
+        m_path(PATH_BEST),
+        m_width(0),
+        m_height(0),
+        m_tileSize(1),
+        m_tilesX(0),
+        m_tilesY(0),
+        m_numSlices(0),
+        m_tanX(0.0f),
+        m_tanY(0.0f),
+        m_near(0.0f),
+        m_far(0.0f),
+        m_logScale(0.0f),
+        m_froxelStride(0),
+        m_numVisible(0)
+    {
+    }
+
+    //! Is a path compiled in.
+    static Bool hasPath(Path path)
+    {
+        switch (path) {
+            case PATH_SCALAR:
+            case PATH_BEST:
+                return True;
+            case PATH_SSE2:
+            #ifdef O3D_SSE2
+                return True;
+            #else
+                return False;
+            #endif
+            case PATH_AVX:
+            #ifdef O3DSAMPLES_AVX
+                return True;
+            #else
+                return False;
+            #endif
+            default:
+                return False;
+        }
+    }
+
+    //! Choose the computation path (default PATH_BEST). Unavailable paths fall back.
+    void setPath(Path path) { m_path = path; }
+
+    /**
+     * @brief Define the view and the clusters, and compute the froxels.
+     * @param width Width of the viewport in pixels.
+     * @param height Height of the viewport in pixels.
+     * @param tileSize Size of a tile in pixels.
+     * @param numSlices Number of depth slices.
+     * @param fovY Vertical field of view in degrees.
+     * @param nearPlane Distance of the near plane.
+     * @param farPlane Distance of the far plane.
+     */
+    void setup(UInt32 width, UInt32 height, UInt32 tileSize, UInt32 numSlices,
+               Float fovY, Float nearPlane, Float farPlane)
+    {
+        m_width = std::max<UInt32>(width, 1);
+        m_height = std::max<UInt32>(height, 1);
+        m_tileSize = std::max<UInt32>(tileSize, 1);
+        m_tilesX = (m_width + m_tileSize - 1) / m_tileSize;
+        m_tilesY = (m_height + m_tileSize - 1) / m_tileSize;
+        m_numSlices = std::max<UInt32>(numSlices, 1);
+
+        m_tanY = std::tan(fovY * 0.5f * 3.14159265f / 180.0f);
+        m_tanX = m_tanY * Float(m_width) / Float(m_height);
+        m_near = nearPlane;
+        m_far = std::max(farPlane, nearPlane * 1.001f);
+        m_logScale = Float(m_numSlices) / std::log(m_far / m_near);
+
+        const UInt32 numTiles = m_tilesX * m_tilesY;
+
+        // the froxels of a tile as structure of arrays, padded to be read 8 slices at a time
+        m_froxelStride = m_numSlices + 7;
+
+        m_planes.resize(size_t(numTiles) * 12);
+        m_froxels.assign(size_t(numTiles) * NUM_FROXEL_FIELDS * m_froxelStride, 0.0f);
+
+        for (UInt32 ty = 0; ty < m_tilesY; ++ty) {
+            for (UInt32 tx = 0; tx < m_tilesX; ++tx) {
+                const UInt32 tile = ty * m_tilesX + tx;
+
+                // bounds of the tile in normalized device coordinates, scaled by the tangents
+                const Float x0 = (-1.0f + 2.0f * Float(tx * m_tileSize) / Float(m_width)) * m_tanX;
+                const Float x1 = (-1.0f + 2.0f * Float(std::min((tx + 1) * m_tileSize, m_width)) / Float(m_width)) * m_tanX;
+                const Float y0 = (-1.0f + 2.0f * Float(ty * m_tileSize) / Float(m_height)) * m_tanY;
+                const Float y1 = (-1.0f + 2.0f * Float(std::min((ty + 1) * m_tileSize, m_height)) / Float(m_height)) * m_tanY;
+
+                // side planes through the eye, the normals toward the inside
+                Float *planes = &m_planes[size_t(tile) * 12];
+                setPlane(planes, 1.0f, 0.0f, x0);
+                setPlane(planes + 3, -1.0f, 0.0f, -x1);
+                setPlane(planes + 6, 0.0f, 1.0f, y0);
+                setPlane(planes + 9, 0.0f, -1.0f, -y1);
+
+                Float *f = getFroxels(tile);
+
+                for (UInt32 s = 0; s < m_froxelStride; ++s) {
+                    Float min[3], max[3];
+
+                    if (s < m_numSlices) {
+                        const Float dn = getSliceDepth(s);
+                        const Float df = getSliceDepth(s + 1);
+
+                        min[0] = std::min(x0 * dn, x0 * df);
+                        max[0] = std::max(x1 * dn, x1 * df);
+                        min[1] = std::min(y0 * dn, y0 * df);
+                        max[1] = std::max(y1 * dn, y1 * df);
+                        min[2] = -df;
+                        max[2] = -dn;
+                    } else {
+                        // the padding overlaps nothing
+                        min[0] = min[1] = min[2] = 1e30f;
+                        max[0] = max[1] = max[2] = -1e30f;
+                    }
+
+                    Float radiusSq = 0.0f;
+                    for (UInt32 i = 0; i < 3; ++i) {
+                        const Float center = (min[i] + max[i]) * 0.5f;
+
+                        f[(FROXEL_MIN_X + i) * m_froxelStride + s] = min[i];
+                        f[(FROXEL_MAX_X + i) * m_froxelStride + s] = max[i];
+                        f[(FROXEL_CENTER_X + i) * m_froxelStride + s] = center;
+
+                        radiusSq += (max[i] - center) * (max[i] - center);
+                    }
+
+                    f[FROXEL_RADIUS * m_froxelStride + s] = std::sqrt(radiusSq);
+                }
+            }
+        }
+
+        m_tileLists.resize(numTiles);
+        m_counts.resize(size_t(numTiles) * m_numSlices);
+        m_ranges.resize(size_t(numTiles) * m_numSlices * 2);
+    }
+
+    /**
+     * @brief Assign the lights to the clusters.
+     * @param lights Lights in view space.
+     * @param count Number of lights.
+     * @param pool Pool to process the tiles in parallel, or null.
+     */
+    void build(const ClusterLight *lights, UInt32 count, WorkerPool *pool = nullptr)
+    {
+        const UInt32 numTiles = m_tilesX * m_tilesY;
+
+        m_stats = Stats();
+        m_stats.numLights = count;
+
+        prepareLights(lights, std::min(count, MAX_LIGHTS));
+
+        std::vector<UInt32> candidates(numTiles);
+
+        auto cullTiles = [this, &candidates] (UInt32 from, UInt32 to) {
+            std::vector<UInt32> selected;
+            std::vector<UInt16> sliceIndices;
+            std::vector<UInt32> sliceCounts(m_numSlices);
+
+            for (UInt32 tile = from; tile < to; ++tile) {
+                candidates[tile] = cullTile(tile, selected, sliceIndices, sliceCounts);
+            }
+        };
+
+        // a row of tiles per job
+        if (pool) {
+            pool->parallelFor(numTiles, m_tilesX, cullTiles);
+        } else {
+            cullTiles(0, numTiles);
+        }
+
+        // ranges in the order of the clusters, slice then row then column
+        UInt32 offset = 0;
+        for (UInt32 s = 0; s < m_numSlices; ++s) {
+            for (UInt32 tile = 0; tile < numTiles; ++tile) {
+                const UInt32 n = m_counts[size_t(tile) * m_numSlices + s];
+                const size_t cluster = size_t(s) * numTiles + tile;
+
+                m_ranges[cluster * 2] = offset;
+                m_ranges[cluster * 2 + 1] = n;
+                offset += n;
+
+                m_stats.maxPerCluster = std::max(m_stats.maxPerCluster, n);
+                m_stats.numEmpty += n == 0 ? 1 : 0;
+            }
+        }
+
+        for (UInt32 tile = 0; tile < numTiles; ++tile) {
+            m_stats.numCandidates += candidates[tile];
+        }
+
+        m_stats.numIndices = offset;
+        m_indices.resize(offset);
+
+        auto copyTiles = [this, numTiles] (UInt32 from, UInt32 to) {
+            for (UInt32 tile = from; tile < to; ++tile) {
+                const UInt16 *list = m_tileLists[tile].data();
+
+                for (UInt32 s = 0; s < m_numSlices; ++s) {
+                    const size_t cluster = size_t(s) * numTiles + tile;
+                    const UInt32 n = m_ranges[cluster * 2 + 1];
+
+                    if (n) {
+                        memcpy(&m_indices[m_ranges[cluster * 2]], list, n * sizeof(UInt16));
+                        list += n;
+                    }
+                }
+            }
+        };
+
+        if (pool) {
+            pool->parallelFor(numTiles, m_tilesX, copyTiles);
+        } else {
+            copyTiles(0, numTiles);
+        }
+    }
+
+    UInt32 getTilesX() const { return m_tilesX; }
+    UInt32 getTilesY() const { return m_tilesY; }
+    UInt32 getNumSlices() const { return m_numSlices; }
+    UInt32 getNumClusters() const { return m_tilesX * m_tilesY * m_numSlices; }
+
+    //! Index of the cluster of a tile and a slice.
+    UInt32 getCluster(UInt32 tileX, UInt32 tileY, UInt32 slice) const
+    {
+        return (slice * m_tilesY + tileY) * m_tilesX + tileX;
+    }
+
+    //! Slice of a view depth (positive distance), clamped to the slices.
+    UInt32 getSlice(Float depth) const
+    {
+        if (depth <= m_near) {
+            return 0;
+        }
+
+        const Int32 s = Int32(std::floor(std::log(depth / m_near) * m_logScale));
+        return UInt32(std::min(std::max(s, 0), Int32(m_numSlices) - 1));
+    }
+
+    //! Offset and count per cluster into the indices.
+    const std::vector<UInt32>& getRanges() const { return m_ranges; }
+
+    //! Light indices of all the clusters.
+    const std::vector<UInt16>& getIndices() const { return m_indices; }
+
+    //! Size of the ranges and of the indices to upload.
+    size_t getUploadBytes() const
+    {
+        return m_ranges.size() * sizeof(UInt32) + m_indices.size() * sizeof(UInt16);
+    }
+
+    const Stats& getStats() const { return m_stats; }
+
+private:
+
+    enum FroxelField
+    {
+        FROXEL_MIN_X = 0,
+        FROXEL_MIN_Y,
+        FROXEL_MIN_Z,
+        FROXEL_MAX_X,
+        FROXEL_MAX_Y,
+        FROXEL_MAX_Z,
+        FROXEL_CENTER_X,
+        FROXEL_CENTER_Y,
+        FROXEL_CENTER_Z,
+        FROXEL_RADIUS,            //!< Of the sphere around the box, for the cone test.
+        NUM_FROXEL_FIELDS
+    };
+
+    //! Lights as structure of arrays, for the lanes of the tile test.
+    struct LightSoa
+    {
+        // bounding sphere
+        std::vector<Float> x, y, z, r;
+        std::vector<UInt32> sliceMin, sliceMax;
+        // cone, the point lights having spot at 0
+        std::vector<Float> px, py, pz, dx, dy, dz, range, cosA, sinA, spot;
+        std::vector<UInt16> index;
+
+        void resize(size_t n)
+        {
+            for (std::vector<Float> *v : { &x, &y, &z, &r, &px, &py, &pz, &dx, &dy, &dz, &range, &cosA, &sinA, &spot }) {
+                v->resize(n);
+            }
+
+            sliceMin.resize(n);
+            sliceMax.resize(n);
+            index.resize(n);
+        }
+    };
+
+    Path m_path;
+
+    UInt32 m_width;
+    UInt32 m_height;
+    UInt32 m_tileSize;
+    UInt32 m_tilesX;
+    UInt32 m_tilesY;
+    UInt32 m_numSlices;
+
+    Float m_tanX;
+    Float m_tanY;
+    Float m_near;
+    Float m_far;
+    Float m_logScale;             //!< Slices per unit of log(depth / near).
+
+    std::vector<Float> m_planes;  //!< Four planes (nx, ny, nz) per tile.
+    std::vector<Float> m_froxels; //!< Per tile, NUM_FROXEL_FIELDS arrays of m_froxelStride slices.
+    UInt32 m_froxelStride;
+
+    LightSoa m_lights;            //!< Visible lights.
+    UInt32 m_numVisible;
+
+    std::vector<std::vector<UInt16>> m_tileLists;   //!< Indices of a tile, by slice.
+    std::vector<UInt32> m_counts;                   //!< Per tile then per slice.
+
+    std::vector<UInt32> m_ranges;
+    std::vector<UInt16> m_indices;
+
+    Stats m_stats;
+
+    static void setPlane(Float *plane, Float nx, Float ny, Float nz)
+    {
+        const Float invLen = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+        plane[0] = nx * invLen;
+        plane[1] = ny * invLen;
+        plane[2] = nz * invLen;
+    }
+
+    Float getSliceDepth(UInt32 slice) const
+    {
+        return m_near * std::pow(m_far / m_near, Float(slice) / Float(m_numSlices));
+    }
+
+    Float* getFroxels(UInt32 tile) { return &m_froxels[size_t(tile) * NUM_FROXEL_FIELDS * m_froxelStride]; }
+    const Float* getFroxels(UInt32 tile) const { return &m_froxels[size_t(tile) * NUM_FROXEL_FIELDS * m_froxelStride]; }
+
+    //! Bounding sphere, slices and cone of the lights overlapping the depth range.
+    void prepareLights(const ClusterLight *lights, UInt32 count)
+    {
+        m_lights.resize(count);
+        m_numVisible = 0;
+
+        for (UInt32 i = 0; i < count; ++i) {
+            const ClusterLight &light = lights[i];
+            const size_t n = m_numVisible;
+
+            Float center[3] = { light.position[0], light.position[1], light.position[2] };
+            Float radius = light.range;
+
+            m_lights.px[n] = light.position[0];
+            m_lights.py[n] = light.position[1];
+            m_lights.pz[n] = light.position[2];
+            m_lights.range[n] = light.range;
+
+            if (light.type == ClusterLight::SPOT_LIGHT) {
+                const Float angle = std::min(light.cutOff, 90.0f) * 3.14159265f / 180.0f;
+                const Float cosA = std::cos(angle), sinA = std::sin(angle);
+
+                // smallest sphere around the cone
+                Float offset;
+                if (angle <= 3.14159265f / 4.0f) {
+                    radius = light.range / (2.0f * cosA);
+                    offset = radius;
+                } else {
+                    radius = light.range * sinA;
+                    offset = light.range * cosA;
+                }
+
+                for (UInt32 c = 0; c < 3; ++c) {
+                    center[c] += light.direction[c] * offset;
+                }
+
+                m_lights.dx[n] = light.direction[0];
+                m_lights.dy[n] = light.direction[1];
+                m_lights.dz[n] = light.direction[2];
+                m_lights.cosA[n] = cosA;
+                m_lights.sinA[n] = sinA;
+                m_lights.spot[n] = 1.0f;
+            } else {
+                m_lights.dx[n] = m_lights.dy[n] = 0.0f;
+                m_lights.dz[n] = -1.0f;
+                m_lights.cosA[n] = 1.0f;
+                m_lights.sinA[n] = 0.0f;
+                m_lights.spot[n] = 0.0f;
+            }
+
+            const Float depthMin = -center[2] - radius;
+            const Float depthMax = -center[2] + radius;
+
+            if ((depthMax < m_near) || (depthMin > m_far)) {
+                continue;
+            }
+
+            m_lights.x[n] = center[0];
+            m_lights.y[n] = center[1];
+            m_lights.z[n] = center[2];
+            m_lights.r[n] = radius;
+            m_lights.sliceMin[n] = getSlice(depthMin);
+            m_lights.sliceMax[n] = getSlice(depthMax);
+            m_lights.index[n] = UInt16(i);
+
+            ++m_numVisible;
+        }
+
+        m_stats.numVisible = m_numVisible;
+    }
+
+    //! Lanes of lights whose sphere is inside the four planes of a tile.
+    template <class V>
+    static UInt32 testTile(const Float *planes, const LightSoa &l, UInt32 i)
+    {
+        const V x = V::load(&l.x[i]), y = V::load(&l.y[i]), z = V::load(&l.z[i]);
+        const V negR = V(0.0f) - V::load(&l.r[i]);
+
+        UInt32 mask = (1u << V::WIDTH) - 1;
+        for (UInt32 p = 0; p < 4; ++p, planes += 3) {
+            mask &= vmaskle(negR, x * V(planes[0]) + y * V(planes[1]) + z * V(planes[2]));
+        }
+
+        return mask;
+    }
+
+    //! Lanes of the froxels from a slice overlapped by a light: sphere against the box, cone against its sphere.
+    template <class V>
+    static UInt32 testSlices(const Float *f, UInt32 stride, const LightSoa &l, UInt32 i, UInt32 slice)
+    {
+        f += slice;
+
+        const V zero(0.0f);
+        const V x(l.x[i]), y(l.y[i]), z(l.z[i]);
+
+        const V ex = vmax(vmax(V::load(f + FROXEL_MIN_X * stride) - x, x - V::load(f + FROXEL_MAX_X * stride)), zero);
+        const V ey = vmax(vmax(V::load(f + FROXEL_MIN_Y * stride) - y, y - V::load(f + FROXEL_MAX_Y * stride)), zero);
+        const V ez = vmax(vmax(V::load(f + FROXEL_MIN_Z * stride) - z, z - V::load(f + FROXEL_MAX_Z * stride)), zero);
+
+        const UInt32 mask = vmaskle(ex * ex + ey * ey + ez * ez, V(l.r[i] * l.r[i]));
+        if (!mask || (l.spot[i] == 0.0f)) {
+            return mask;
+        }
+
+        // distance from the froxel sphere to the cone
+        const V vx = V::load(f + FROXEL_CENTER_X * stride) - V(l.px[i]);
+        const V vy = V::load(f + FROXEL_CENTER_Y * stride) - V(l.py[i]);
+        const V vz = V::load(f + FROXEL_CENTER_Z * stride) - V(l.pz[i]);
+
+        const V lenSq = vx * vx + vy * vy + vz * vz;
+        const V along = vx * V(l.dx[i]) + vy * V(l.dy[i]) + vz * V(l.dz[i]);
+        const V dist = V(l.cosA[i]) * vsqrt(vmax(lenSq - along * along, zero)) - along * V(l.sinA[i]);
+
+        const V radius = V::load(f + FROXEL_RADIUS * stride);
+
+        return mask & vmaskle(dist, radius) & vmaskle(along, radius + V(l.range[i])) & vmaskle(zero - radius, along);
+    }
+
+    //! Lists of the slices of a tile, returns the number of candidates of the tile.
+    UInt32 cullTile(UInt32 tile, std::vector<UInt32> &selected, std::vector<UInt16> &sliceIndices, std::vector<UInt32> &sliceCounts)
+    {
+        const Float *planes = &m_planes[size_t(tile) * 12];
+
+        selected.clear();
+
+        UInt32 i = 0;
+
+    #ifdef O3DSAMPLES_AVX
+        if ((m_path == PATH_AVX) || (m_path == PATH_BEST)) {
+            for (; i + 8 <= m_numVisible; i += 8) {
+                pushLanes(testTile<Float8>(planes, m_lights, i), i, selected);
+            }
+        }
+    #endif
+
+    #ifdef O3D_SSE2
+        if (m_path != PATH_SCALAR) {
+            for (; i + 4 <= m_numVisible; i += 4) {
+                pushLanes(testTile<Float4>(planes, m_lights, i), i, selected);
+            }
+        }
+    #endif
+
+        for (; i < m_numVisible; ++i) {
+            pushLanes(testTile<Float1>(planes, m_lights, i), i, selected);
+        }
+
+        // a list of up to a light per candidate for each slice
+        const UInt32 n = UInt32(selected.size());
+        if (sliceIndices.size() < size_t(n) * m_numSlices) {
+            sliceIndices.resize(size_t(n) * m_numSlices);
+        }
+
+        std::fill(sliceCounts.begin(), sliceCounts.end(), 0);
+
+        // the slices covered by each candidate, in the order of the lights
+        const Float *f = getFroxels(tile);
+
+        for (UInt32 c : selected) {
+            const UInt32 last = m_lights.sliceMax[c];
+            UInt32 s = m_lights.sliceMin[c];
+
+            while (s <= last) {
+                UInt32 mask, width;
+
+            #ifdef O3DSAMPLES_AVX
+                if ((m_path == PATH_AVX) || (m_path == PATH_BEST)) {
+                    mask = testSlices<Float8>(f, m_froxelStride, m_lights, c, s);
+                    width = 8;
+                } else
+            #endif
+            #ifdef O3D_SSE2
+                if (m_path != PATH_SCALAR) {
+                    mask = testSlices<Float4>(f, m_froxelStride, m_lights, c, s);
+                    width = 4;
+                } else
+            #endif
+                {
+                    mask = testSlices<Float1>(f, m_froxelStride, m_lights, c, s);
+                    width = 1;
+                }
+
+                // the lanes past the last slice of the light are ignored
+                if (last - s + 1 < width) {
+                    mask &= (1u << (last - s + 1)) - 1;
+                }
+
+                for (UInt32 b = 0; mask; ++b, mask >>= 1) {
+                    if (mask & 1) {
+                        sliceIndices[size_t(s + b) * n + sliceCounts[s + b]++] = m_lights.index[c];
+                    }
+                }
+
+                s += width;
+            }
+        }
+
+        std::vector<UInt16> &list = m_tileLists[tile];
+        list.clear();
+
+        for (UInt32 s = 0; s < m_numSlices; ++s) {
+            const UInt16 *first = sliceIndices.data() + size_t(s) * n;
+
+            list.insert(list.end(), first, first + sliceCounts[s]);
+            m_counts[size_t(tile) * m_numSlices + s] = sliceCounts[s];
+        }
+
+        return n;
+    }
+
+    static void pushLanes(UInt32 mask, UInt32 i, std::vector<UInt32> &selected)
+    {
+        for (UInt32 b = 0; mask; ++b, mask >>= 1) {
+            if (mask & 1) {
+                selected.push_back(i + b);
+            }
+        }
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_LIGHTCLUSTERS_H
@@ -0,0 +1,318 @@
+/**
+ * @file lightmapstreamer.h
+ * @brief Per zone lightmap mip residency driven by camera distance and a memory cap.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_LIGHTMAPSTREAMER_H
+#define _O3DSAMPLES_LIGHTMAPSTREAMER_H
+
+#include "clmterrain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief Decide which lightmap mip level of each terrain zone is resident.
+ * Levels follow the PCLOD lightmap points convention: 0 is the full resolution,
+ * -1 the half resolution and so on. A zone at level L keeps its mip chain from L
+ * down to 1x1 resident. The level 0 lightmap of a zone has a texel per heightmap
+ * quad, its size is taken from the largest zone of the terrain.
+ * - The target level of a zone comes from the distance points (like
+ *   PCLODConfigs::setLightmapPoint) applied to the distance between the camera and
+ *   the zone rectangle.
+ * - A zone only changes of level once the distance is past the point by the
+ *   hysteresis distance, so a camera moving around a point does not thrash.
+ * - The coarsest level of every zone is always resident. The remaining of the memory
+ *   cap is given to the nearest zones first, so the farthest zones are coarsened first.
+ *   A refinement is only granted if it leaves the part of the cap above the low water
+ *   mark free, so zones at the limit of the budget do not oscillate.
+ */
+class LightmapStreamer
+{
+public:
+
+    struct Stats
+    {
+        UInt64 residentBytes;       //!< Bytes of the resident mip chains.
+        UInt64 peakResidentBytes;   //!< Highest resident bytes since the start.
+        UInt32 numTransitions;      //!< Total number of level changes.
+        Float transitionsPerSecond; //!< Level changes per second over the last second.
+        UInt32 numCapped;           //!< Zones currently coarser than their target.
+    };
+
+    /**
+     * @brief Constructor.
+     * @param bytesPerTexel Size of a lightmap texel.
+     */
+    explicit LightmapStreamer(UInt32 bytesPerTexel) :
+        m_lightmapSize(1),
+        m_bytesPerTexel(bytesPerTexel),
+        m_minLevel(0),
+        m_memoryCap(0),
+        m_lowWaterMark(0.9f),
+        m_hysteresis(5.0f),
+        m_windowStart(-1.0f),
+        m_windowTransitions(0)
+    {
+        m_stats = Stats();
+    }
+
+    //! Add a distance point. From this distance the level is used (0, -1, -2...).
+    void setPoint(Float distance, Int32 level)
+    {
+        Point point = { distance, level };
+
+        auto it = std::lower_bound(m_points.begin(), m_points.end(), point,
+                                   [] (const Point &a, const Point &b) { return a.distance < b.distance; });
+
+        if ((it != m_points.end()) && (it->distance == distance)) {
+            it->level = point.level;
+        } else {
+            m_points.insert(it, point);
+        }
+    }
+
+    //! Memory cap in bytes for all the resident lightmaps (0 means no cap).
+    void setMemoryCap(UInt64 bytes) { m_memoryCap = bytes; }
+    //! Fraction of the cap under which refinements are granted (default 0.9).
+    void setLowWaterMark(Float ratio) { m_lowWaterMark = ratio; }
+    //! Distance past a point before changing of level (default 5).
+    void setHysteresis(Float distance) { m_hysteresis = distance; }
+
+    //! Define the zones and the lightmap size from a terrain. All zones start at their coarsest level.
+    void setZones(const ClmTerrain &terrain)
+    {
+        const Float unit = terrain.getUnit();
+
+        // a texel per quad of the largest zone, to the next power of two
+        UInt32 numQuads = 1;
+        for (const ClmZone &zone : terrain.getZones()) {
+            numQuads = std::max(numQuads, std::max(std::max(zone.sizeX, zone.sizeZ), 2u) - 1);
+        }
+
+        m_lightmapSize = 1;
+        while (m_lightmapSize < numQuads) {
+            m_lightmapSize <<= 1;
+        }
+
+        m_minLevel = 0;
+        while ((m_lightmapSize >> -m_minLevel) > 1) {
+            --m_minLevel;
+        }
+
+        m_zones.resize(terrain.getNumZones());
+
+        for (UInt32 i = 0; i < terrain.getNumZones(); ++i) {
+            const ClmZone &src = terrain.getZone(i);
+            Zone &zone = m_zones[i];
+
+            zone.minX = src.originX * unit;
+            zone.minZ = src.originZ * unit;
+            zone.maxX = (src.originX + src.sizeX - 1) * unit;
+            zone.maxZ = (src.originZ + src.sizeZ - 1) * unit;
+            zone.level = m_minLevel;
+            zone.wanted = m_minLevel;
+            zone.target = m_minLevel;
+            zone.distance = 0.0f;
+        }
+
+        m_order.resize(m_zones.size());
+        for (UInt32 i = 0; i < m_order.size(); ++i) {
+            m_order[i] = i;
+        }
+
+        m_stats.residentBytes = m_zones.size() * chainBytes(m_minLevel);
+        m_stats.peakResidentBytes = m_stats.residentBytes;
+    }
+
+    /**
+     * @brief Update the resident levels.
+     * @param x Camera position on X.
+     * @param z Camera position on Z.
+     * @param time Current time in seconds, used for the transition rate.
+     */
+    void update(Float x, Float z, Float time)
+    {
+        if (m_zones.empty() || m_points.empty()) {
+            return;
+        }
+
+        // distances and wanted levels, the hysteresis is applied around the current level:
+        // the level a hysteresis nearer is the finest the zone can keep, the level a
+        // hysteresis farther the coarsest it can keep
+        for (Zone &zone : m_zones) {
+            const Float dx = std::max(std::max(zone.minX - x, x - zone.maxX), 0.0f);
+            const Float dz = std::max(std::max(zone.minZ - z, z - zone.maxZ), 0.0f);
+
+            zone.distance = std::sqrt(dx*dx + dz*dz);
+            zone.target = levelAt(zone.distance);
+
+            const Int32 finest = levelAt(zone.distance - m_hysteresis);
+            const Int32 coarsest = levelAt(zone.distance + m_hysteresis);
+
+            if (finest < zone.level) {
+                zone.wanted = finest;
+            } else if (coarsest > zone.level) {
+                zone.wanted = coarsest;
+            } else {
+                zone.wanted = zone.level;
+            }
+        }
+
+        // the coarsest level of every zone is always resident, the remaining of the cap
+        // is given to the nearest zones first
+        std::sort(m_order.begin(), m_order.end(), [this] (UInt32 a, UInt32 b) {
+            return m_zones[a].distance < m_zones[b].distance;
+        });
+
+        const UInt64 base = m_zones.size() * chainBytes(m_minLevel);
+        const UInt64 cap = m_memoryCap ? std::max(m_memoryCap, base) : 0;
+        const UInt64 spare = cap > base ? cap - base : 0;
+        const UInt64 reserve = UInt64(spare * (1.0f - m_lowWaterMark));
+
+        UInt64 budget = spare;
+        UInt64 resident = base;
+
+        for (UInt32 i : m_order) {
+            Zone &zone = m_zones[i];
+            Int32 level = zone.wanted;
+
+            if (cap) {
+                // a refinement must leave the reserve free, otherwise the zone keeps its level
+                if ((level > zone.level) && (extraBytes(level) + reserve > budget)) {
+                    level = zone.level;
+                }
+
+                while ((level > m_minLevel) && (extraBytes(level) > budget)) {
+                    --level;
+                }
+
+                budget -= extraBytes(level);
+            }
+
+            resident += extraBytes(level);
+            setLevel(zone, level);
+        }
+
+        m_stats.residentBytes = resident;
+        m_stats.peakResidentBytes = std::max(m_stats.peakResidentBytes, resident);
+
+        m_stats.numCapped = 0;
+        for (const Zone &zone : m_zones) {
+            if (zone.level < zone.target) {
+                ++m_stats.numCapped;
+            }
+        }
+
+        // transition rate over a one second window
+        if (m_windowStart < 0.0f) {
+            m_windowStart = time;
+        } else if (time - m_windowStart >= 1.0f) {
+            m_stats.transitionsPerSecond = m_windowTransitions / (time - m_windowStart);
+            m_windowTransitions = 0;
+            m_windowStart = time;
+        }
+    }
+
+    //! Size in texels of the level 0 lightmap of a zone.
+    UInt32 getLightmapSize() const { return m_lightmapSize; }
+
+    //! Coarsest level, the 1x1 mip, always resident.
+    Int32 getMinLevel() const { return m_minLevel; }
+
+    //! Number of zones.
+    UInt32 getNumZones() const { return static_cast<UInt32>(m_zones.size()); }
+
+    //! Resident level of a zone.
+    Int32 getZoneLevel(UInt32 i) const { return m_zones[i].level; }
+
+    //! Level given by the distance points only, ignoring the cap and the hysteresis.
+    Int32 getZoneTarget(UInt32 i) const { return m_zones[i].target; }
+
+    //! Current statistics.
+    const Stats& getStats() const { return m_stats; }
+
+    //! Bytes of a mip chain from a level down to 1x1.
+    UInt64 chainBytes(Int32 level) const
+    {
+        UInt64 bytes = 0;
+        for (Int32 l = level; l >= m_minLevel; --l) {
+            const UInt64 size = m_lightmapSize >> -l;
+            bytes += size * size * m_bytesPerTexel;
+        }
+
+        return bytes;
+    }
+
+private:
+
+    //! Bytes of a mip chain above the coarsest level.
+    UInt64 extraBytes(Int32 level) const { return chainBytes(level) - chainBytes(m_minLevel); }
+
+    struct Point
+    {
+        Float distance;
+        Int32 level;
+    };
+
+    struct Zone
+    {
+        Float minX, minZ, maxX, maxZ;
+        Float distance;
+        Int32 level;
+        Int32 wanted;
+        Int32 target;
+    };
+
+    UInt32 m_lightmapSize;
+    UInt32 m_bytesPerTexel;
+    Int32 m_minLevel;
+
+    UInt64 m_memoryCap;
+    Float m_lowWaterMark;
+    Float m_hysteresis;
+
+    std::vector<Point> m_points;
+    std::vector<Zone> m_zones;
+    std::vector<UInt32> m_order;
+
+    Float m_windowStart;
+    UInt32 m_windowTransitions;
+
+    Stats m_stats;
+
+    //! Level given by the points at a distance. Before the first point the first level is used.
+    Int32 levelAt(Float distance) const
+    {
+        Int32 level = m_points.front().level;
+        for (const Point &point : m_points) {
+            if (distance >= point.distance) {
+                level = point.level;
+            } else {
+                break;
+            }
+        }
+
+        return std::max(level, m_minLevel);
+    }
+
+    void setLevel(Zone &zone, Int32 level)
+    {
+        if (zone.level != level) {
+            zone.level = level;
+            ++m_stats.numTransitions;
+            ++m_windowTransitions;
+        }
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_LIGHTMAPSTREAMER_H
@@ -0,0 +1,331 @@
+/**
+ * @file perlinnoise.h
+ * @brief Octave fused 2D gradient noise, SIMD and parallel over the rows.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_PERLINNOISE_H
+#define _O3DSAMPLES_PERLINNOISE_H
+
+#include "simdmath.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief Square 2D Perlin noise, sum of octaves of gradient noise.
+ * The parameters follow PerlinNoise2d (amplitudes and frequencies per octave, repeated
+ * boundary, positive octaves, size and random seed).
+ * - The gradients of the lattice of each octave are computed once per seed and stored
+ *   as tables, the kernel only fetches them.
+ * - The octaves are fused: each sample is computed through every octave before being
+ *   stored, 8 samples at a time with AVX, 4 with SSE2, the rest with the scalar path.
+ * - The rows can be split across a WorkerPool.
+ * Every path runs the same operations in the same order, so the output for a given
+ * seed is bit identical whatever the path and the number of threads (the build must
+ * not contract multiply-add into FMA, which is the default without -mfma).
+ */
+class PerlinNoise
+{
+public:
+
+    enum Path
+    {
+        PATH_SCALAR = 0,
+        PATH_SSE2,
+        PATH_AVX,
+        PATH_BEST
+    };
+
+    PerlinNoise() :
+        m_size(128),
+        m_seed(0),
+        m_repeat(True),
+        m_positive(False),
+        m_path(PATH_BEST),
+        m_dirty(True)
+    {
+    }
+
+    //! Geometric sequence of count terms starting at first, like PerlinNoise2d::geometricSequence.
+    static std::vector<Float> geometricSequence(UInt32 count, Float ratio, Float first)
+    {
+        std::vector<Float> sequence(count);
+        Float term = first;
+
+        for (UInt32 i = 0; i < count; ++i) {
+            sequence[i] = term;
+            term *= ratio;
+        }
+
+        return sequence;
+    }
+
+    //! Is a path compiled in.
+    static Bool hasPath(Path path)
+    {
+        switch (path) {
+            case PATH_SCALAR:
+            case PATH_BEST:
+                return True;
+            case PATH_SSE2:
+            #ifdef O3D_SSE2
+                return True;
+            #else
+                return False;
+            #endif
+            case PATH_AVX:
+            #ifdef O3DSAMPLES_AVX
+                return True;
+            #else
+                return False;
+            #endif
+            default:
+                return False;
+        }
+    }
+
+    //! Width and height of the generated noise.
+    void setSize(UInt32 size) { m_size = std::max<UInt32>(size, 1); m_dirty = True; }
+    UInt32 getSize() const { return m_size; }
+
+    //! Amplitude of each octave.
+    void setAmplitudes(const std::vector<Float> &amplitudes) { m_amplitudes = amplitudes; m_dirty = True; }
+    //! Frequency of each octave, in lattice cells over the size.
+    void setFrequencies(const std::vector<Float> &frequencies) { m_frequencies = frequencies; m_dirty = True; }
+
+    //! Tile the noise over its size (default True), the frequencies are rounded.
+    void setRepeat(Bool repeat) { m_repeat = repeat; m_dirty = True; }
+    //! Map each octave from [-1, 1] to [0, 1] (default False).
+    void setPositive(Bool positive) { m_positive = positive; }
+
+    //! Seed of the gradients.
+    void setRandomSeed(UInt32 seed) { m_seed = seed; m_dirty = True; }
+    UInt32 getRandomSeed() const { return m_seed; }
+
+    //! Choose the computation path (default PATH_BEST). Unavailable paths fall back.
+    void setPath(Path path) { m_path = path; }
+
+    //! Build the gradient tables if a parameter changed, generate does it otherwise.
+    void prepare()
+    {
+        if (m_dirty) {
+            buildGradients();
+        }
+    }
+
+    /**
+     * @brief Generate the noise.
+     * @param out Receives size * size values, row by row.
+     * @param pool Optional pool of workers.
+     */
+    void generate(Float *out, WorkerPool *pool = nullptr)
+    {
+        prepare();
+
+        if (pool) {
+            pool->parallelFor(m_size, ROW_GRAIN, [this, out] (UInt32 begin, UInt32 end) {
+                generateRows(out, begin, end);
+            });
+        } else {
+            generateRows(out, 0, m_size);
+        }
+    }
+
+    //! Memory used by the gradient tables.
+    UInt64 getTableBytes() const
+    {
+        UInt64 bytes = 0;
+        for (const Octave &octave : m_octaves) {
+            bytes += octave.gradients.size() * sizeof(Float);
+        }
+
+        return bytes;
+    }
+
+private:
+
+    static const UInt32 ROW_GRAIN = 8;
+    static const UInt32 NUM_DIRECTIONS = 256;
+
+    struct Octave
+    {
+        Float scale;                   //!< Lattice units per sample.
+        Float amplitude;
+        UInt32 cells;                  //!< Lattice cells over the size.
+        std::vector<Float> gradients;  //!< Interleaved x,y on (cells + 1)^2 lattice points.
+    };
+
+    UInt32 m_size;
+    UInt32 m_seed;
+    Bool m_repeat;
+    Bool m_positive;
+    Path m_path;
+    Bool m_dirty;
+
+    std::vector<Float> m_amplitudes;
+    std::vector<Float> m_frequencies;
+    std::vector<Octave> m_octaves;
+
+    //! Integer hash of a lattice point, well mixed for consecutive inputs.
+    static UInt32 hash(UInt32 seed, UInt32 octave, UInt32 x, UInt32 y)
+    {
+        UInt32 h = seed * 0x9e3779b9u ^ octave * 0x85ebca6bu;
+        h ^= x * 0xc2b2ae35u;
+        h = (h ^ (h >> 15)) * 0x2c1b3c6du;
+        h ^= y * 0x27d4eb2fu;
+        h = (h ^ (h >> 12)) * 0x297a2d39u;
+        return h ^ (h >> 15);
+    }
+
+    void buildGradients()
+    {
+        Float dirX[NUM_DIRECTIONS], dirY[NUM_DIRECTIONS];
+        for (UInt32 d = 0; d < NUM_DIRECTIONS; ++d) {
+            const Double angle = 2.0 * 3.14159265358979 * d / NUM_DIRECTIONS;
+            dirX[d] = Float(std::cos(angle));
+            dirY[d] = Float(std::sin(angle));
+        }
+
+        const UInt32 numOctaves = UInt32(std::min(m_amplitudes.size(), m_frequencies.size()));
+        m_octaves.resize(numOctaves);
+
+        for (UInt32 o = 0; o < numOctaves; ++o) {
+            Octave &octave = m_octaves[o];
+
+            const Float frequency = std::max(m_frequencies[o], 1.0f);
+            octave.cells = m_repeat ? UInt32(frequency + 0.5f) : UInt32(std::ceil(frequency));
+            octave.scale = (m_repeat ? Float(octave.cells) : frequency) / Float(m_size);
+            octave.amplitude = m_amplitudes[o];
+
+            // the last row and column wrap to the first ones when repeated
+            const UInt32 points = octave.cells + 1;
+            const UInt32 wrap = m_repeat ? octave.cells : points;
+
+            octave.gradients.resize(size_t(points) * points * 2);
+
+            for (UInt32 y = 0; y < points; ++y) {
+                for (UInt32 x = 0; x < points; ++x) {
+                    const UInt32 d = hash(m_seed, o, x % wrap, y % wrap) % NUM_DIRECTIONS;
+                    octave.gradients[(size_t(y) * points + x) * 2] = dirX[d];
+                    octave.gradients[(size_t(y) * points + x) * 2 + 1] = dirY[d];
+                }
+            }
+        }
+
+        m_dirty = False;
+    }
+
+    void generateRows(Float *out, UInt32 firstRow, UInt32 lastRow) const
+    {
+        for (UInt32 row = firstRow; row < lastRow; ++row) {
+            Float *line = out + size_t(row) * m_size;
+            UInt32 x = 0;
+
+        #ifdef O3DSAMPLES_AVX
+            if ((m_path == PATH_AVX) || (m_path == PATH_BEST)) {
+                for (; x + 8 <= m_size; x += 8) {
+                    computeSamples<Float8>(row, x, line + x);
+                }
+            }
+        #endif
+
+        #ifdef O3D_SSE2
+            if (m_path != PATH_SCALAR) {
+                for (; x + 4 <= m_size; x += 4) {
+                    computeSamples<Float4>(row, x, line + x);
+                }
+            }
+        #endif
+
+            for (; x < m_size; ++x) {
+                computeSamples<Float1>(row, x, line + x);
+            }
+        }
+    }
+
+    //! Quintic fade curve 6t^5 - 15t^4 + 10t^3.
+    template <class V>
+    static V fade(V t)
+    {
+        return t * t * t * (t * (t * V(6.0f) - V(15.0f)) + V(10.0f));
+    }
+
+    //! Every octave of V::WIDTH consecutive samples of a row, starting at column x.
+    template <class V>
+    void computeSamples(UInt32 row, UInt32 x, Float *out) const
+    {
+        Float columns[V::WIDTH];
+        for (UInt32 k = 0; k < V::WIDTH; ++k) {
+            columns[k] = Float(x + k);
+        }
+
+        const V column = V::load(columns);
+        V sum(0.0f);
+
+        for (const Octave &octave : m_octaves) {
+            const UInt32 points = octave.cells + 1;
+
+            // the row part is the same for every lane
+            const Float fy = Float(row) * octave.scale;
+            const UInt32 iy = std::min(UInt32(fy), octave.cells - 1);
+            const V ty(fy - Float(iy));
+            const V tym1 = ty - V(1.0f);
+
+            const Float *row0 = &octave.gradients[size_t(iy) * points * 2];
+            const Float *row1 = row0 + points * 2;
+
+            const V fx = column * V(octave.scale);
+            const V ix = vmin(vfloor(fx), V(Float(octave.cells - 1)));
+            const V tx = fx - ix;
+            const V txm1 = tx - V(1.0f);
+
+            Float cells[V::WIDTH];
+            ix.store(cells);
+
+            Float g00x[V::WIDTH], g00y[V::WIDTH], g10x[V::WIDTH], g10y[V::WIDTH];
+            Float g01x[V::WIDTH], g01y[V::WIDTH], g11x[V::WIDTH], g11y[V::WIDTH];
+
+            // no gather before AVX2, the gradients are loaded per lane
+            for (UInt32 k = 0; k < V::WIDTH; ++k) {
+                const Float *p0 = row0 + UInt32(cells[k]) * 2;
+                const Float *p1 = row1 + UInt32(cells[k]) * 2;
+
+                g00x[k] = p0[0]; g00y[k] = p0[1];
+                g10x[k] = p0[2]; g10y[k] = p0[3];
+                g01x[k] = p1[0]; g01y[k] = p1[1];
+                g11x[k] = p1[2]; g11y[k] = p1[3];
+            }
+
+            const V d00 = V::load(g00x) * tx + V::load(g00y) * ty;
+            const V d10 = V::load(g10x) * txm1 + V::load(g10y) * ty;
+            const V d01 = V::load(g01x) * tx + V::load(g01y) * tym1;
+            const V d11 = V::load(g11x) * txm1 + V::load(g11y) * tym1;
+
+            const V u = fade(tx);
+            const V v = fade(ty);
+
+            // gradient noise is within [-sqrt(2)/2, sqrt(2)/2], scaled to [-1, 1]
+            V n = vlerp(vlerp(d00, d10, u), vlerp(d01, d11, u), v) * V(1.41421356f);
+
+            if (m_positive) {
+                n = n * V(0.5f) + V(0.5f);
+            }
+
+            sum += n * V(octave.amplitude);
+        }
+
+        sum.store(out);
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_PERLINNOISE_H
@@ -0,0 +1,313 @@
+/**
+ * @file primitivebatch.h
+ * @brief Immediate mode primitives recorded per frame, the consecutive draws of a same
+ * state being coalesced into one submit.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_PRIMITIVEBATCH_H
+#define _O3DSAMPLES_PRIMITIVEBATCH_H
+
+#include <o3d/core/base.h>
+
+#include <functional>
+#include <vector>
+
+namespace o3dsamples {
+
+using namespace o3d;
+
+/**
+ * @brief A vertex of a primitive, its color packed RGBA8.
+ */
+struct PrimitiveVertex
+{
+    Float x, y, z;
+    UInt32 color;         //!< Red in the lowest byte.
+
+    static UInt32 packColor(Float r, Float g, Float b, Float a)
+    {
+        return UInt32(toByte(r)) | (UInt32(toByte(g)) << 8) | (UInt32(toByte(b)) << 16) | (UInt32(toByte(a)) << 24);
+    }
+
+    //! Color as 4 floats in [0, 1].
+    void getColor(Float rgba[4]) const
+    {
+        for (UInt32 c = 0; c < 4; ++c) {
+            rgba[c] = Float((color >> (c * 8)) & 0xff) / 255.f;
+        }
+    }
+
+private:
+
+    static UInt8 toByte(Float v)
+    {
+        return UInt8(v <= 0.0f ? 0 : (v >= 1.0f ? 255 : UInt32(v * 255.f + 0.5f)));
+    }
+};
+
+//! Primitive modes, the strips and the loops being given to the submit as lists.
+enum PrimitiveMode
+{
+    PRIMITIVE_POINTS = 0,
+    PRIMITIVE_LINES,
+    PRIMITIVE_LINE_STRIP,
+    PRIMITIVE_LINE_LOOP,
+    PRIMITIVE_TRIANGLES,
+    PRIMITIVE_TRIANGLE_STRIP
+};
+
+/**
+ * @brief A draw given to the submit function, vertices of a list mode (points, lines
+ * or triangles) of a same state.
+ */
+struct PrimitiveSubmit
+{
+    PrimitiveMode mode;   //!< PRIMITIVE_POINTS, PRIMITIVE_LINES or PRIMITIVE_TRIANGLES.
+    UInt32 state;         //!< State given by setState.
+    UInt32 first;         //!< First vertex in the region of the frame.
+    UInt32 count;         //!< Number of vertices.
+    UInt32 numDraws;      //!< beginDraw/endDraw pairs coalesced.
+};
+
+/**
+ * @brief Record primitives like immediate mode, beginDraw, addVertex, endDraw, and
+ * submit them with one draw per run of a same state.
+ * Each primitive is converted to its list mode at endDraw, so the strips and the loops
+ * of a same state are merged too, and appended to the region of the current frame.
+ * What is saved is the number of draws given to the backend, not the vertex traffic:
+ * the engine primitive access the samples submit to copies every vertex again, and
+ * nothing reads the region after the submit returns. The recording and the loops given
+ * as lists cost more CPU than drawing directly (see primitivebench), it pays only when
+ * the draw calls cost more than the copies.
+ * As the submit copies, one region is enough. A backend keeping the pointer, as a
+ * persistently mapped buffer read by the GPU frames later would, needs numFrames
+ * regions, the frames in flight plus the current one, the vertices of a frame staying
+ * valid until its region is reused numFrames frames later. The regions keep their
+ * capacity, only a frame larger than every previous one allocates.
+ * The state is any value of the caller, its blending, depth test or projection, the
+ * draws of different states are never merged.
+ */
+class PrimitiveBatch
+{
+public:
+
+    //! Draw a run of vertices, the pointer being valid until the region is reused, see
+    //! the constructor.
+    typedef std::function<void(const PrimitiveSubmit &submit, const PrimitiveVertex *vertices)> SubmitFunc;
+
+    struct Stats
+    {
+        UInt32 numDraws;          //!< beginDraw/endDraw pairs of the last frame.
+        UInt32 numSubmits;        //!< Submits of the last frame.
+        UInt32 numVertices;       //!< Vertices of the last frame, as lists.
+        UInt32 numGrows;          //!< Frames whose region had to grow, since the creation.
+        size_t regionBytes;       //!< Capacity of the regions.
+
+        Stats() : numDraws(0), numSubmits(0), numVertices(0), numGrows(0), regionBytes(0) {}
+    };
+
+    /**
+     * @brief Constructor.
+     * @param numFrames Regions, 1 for a submit that copies the vertices, else the frames
+     * the backend reads them after their submit plus one.
+     * @param frameVertices Initial capacity of a region.
+     */
+    PrimitiveBatch(UInt32 numFrames = 1, UInt32 frameVertices = 4096) :
+        m_regions(numFrames > 0 ? numFrames : 1),
+        m_frame(0),
+        m_mode(PRIMITIVE_POINTS),
+        m_state(0),
+        m_color(0xffffffff),
+        m_drawing(False),
+        m_numFlushed(0),
+        m_lastDraws(0)
+    {
+        for (std::vector<PrimitiveVertex> &region : m_regions) {
+            region.reserve(frameVertices);
+        }
+
+        m_capacity = m_regions[0].capacity();
+    }
+
+    //! State of the next draws.
+    void setState(UInt32 state) { m_state = state; }
+
+    //! Color of the next vertices given without color.
+    void setColor(Float r, Float g, Float b, Float a = 1.0f) { m_color = PrimitiveVertex::packColor(r, g, b, a); }
+
+    void beginDraw(PrimitiveMode mode)
+    {
+        m_mode = mode;
+        m_drawing = True;
+        m_primitive.clear();
+    }
+
+    void addVertex(Float x, Float y, Float z)
+    {
+        PrimitiveVertex vertex = { x, y, z, m_color };
+        m_primitive.push_back(vertex);
+    }
+
+    void addVertex(Float x, Float y, Float z, Float r, Float g, Float b, Float a = 1.0f)
+    {
+        PrimitiveVertex vertex = { x, y, z, PrimitiveVertex::packColor(r, g, b, a) };
+        m_primitive.push_back(vertex);
+    }
+
+    //! Convert the primitive to its list mode and append it, to the last run if possible.
+    void endDraw()
+    {
+        if (!m_drawing) {
+            return;
+        }
+
+        m_drawing = False;
+
+        std::vector<PrimitiveVertex> &region = m_regions[m_frame];
+        const UInt32 first = UInt32(region.size());
+        const UInt32 n = UInt32(m_primitive.size());
+        const PrimitiveVertex *v = m_primitive.data();
+
+        PrimitiveMode listMode = PRIMITIVE_POINTS;
+
+        switch (m_mode) {
+            case PRIMITIVE_POINTS:
+                region.insert(region.end(), v, v + n);
+                break;
+
+            case PRIMITIVE_LINES:
+                listMode = PRIMITIVE_LINES;
+                region.insert(region.end(), v, v + (n & ~1u));
+                break;
+
+            case PRIMITIVE_LINE_STRIP:
+            case PRIMITIVE_LINE_LOOP:
+                listMode = PRIMITIVE_LINES;
+                for (UInt32 i = 1; i < n; ++i) {
+                    region.push_back(v[i - 1]);
+                    region.push_back(v[i]);
+                }
+
+                if ((m_mode == PRIMITIVE_LINE_LOOP) && (n > 2)) {
+                    region.push_back(v[n - 1]);
+                    region.push_back(v[0]);
+                }
+                break;
+
+            case PRIMITIVE_TRIANGLES:
+                listMode = PRIMITIVE_TRIANGLES;
+                region.insert(region.end(), v, v + (n - n % 3));
+                break;
+
+            case PRIMITIVE_TRIANGLE_STRIP:
+                listMode = PRIMITIVE_TRIANGLES;
+                // the odd triangles are swapped to keep the winding of the strip
+                for (UInt32 i = 2; i < n; ++i) {
+                    region.push_back(v[(i & 1) ? i - 1 : i - 2]);
+                    region.push_back(v[(i & 1) ? i - 2 : i - 1]);
+                    region.push_back(v[i]);
+                }
+                break;
+        }
+
+        const UInt32 count = UInt32(region.size()) - first;
+        if (count == 0) {
+            return;
+        }
+
+        ++m_stats.numDraws;
+
+        // merged with the last run if it is not submitted yet
+        if ((m_runs.size() > m_numFlushed) &&
+            (m_runs.back().mode == listMode) && (m_runs.back().state == m_state)) {
+            m_runs.back().count += count;
+            ++m_runs.back().numDraws;
+            return;
+        }
+
+        PrimitiveSubmit run;
+        run.mode = listMode;
+        run.state = m_state;
+        run.first = first;
+        run.count = count;
+        run.numDraws = 1;
+
+        m_runs.push_back(run);
+    }
+
+    //! Submit the runs recorded since the last flush of the frame.
+    void flush(const SubmitFunc &submit)
+    {
+        const PrimitiveVertex *vertices = m_regions[m_frame].data();
+
+        for (size_t i = m_numFlushed; i < m_runs.size(); ++i) {
+            submit(m_runs[i], vertices);
+        }
+
+        m_numFlushed = m_runs.size();
+    }
+
+    //! End of the frame, the region of the oldest frame is reused for the next one.
+    void nextFrame()
+    {
+        const std::vector<PrimitiveVertex> &region = m_regions[m_frame];
+
+        m_stats.numSubmits = UInt32(m_numFlushed);
+        m_stats.numVertices = UInt32(region.size());
+
+        if (region.capacity() > m_capacity) {
+            ++m_stats.numGrows;
+            m_capacity = region.capacity();
+        }
+
+        m_stats.regionBytes = 0;
+        for (const std::vector<PrimitiveVertex> &r : m_regions) {
+            m_stats.regionBytes += r.capacity() * sizeof(PrimitiveVertex);
+        }
+
+        m_frame = (m_frame + 1) % UInt32(m_regions.size());
+
+        // the next region gets the largest capacity, not to grow again during the frame
+        m_regions[m_frame].clear();
+        m_regions[m_frame].reserve(m_capacity);
+
+        m_runs.clear();
+        m_numFlushed = 0;
+        m_lastDraws = m_stats.numDraws;
+        m_stats.numDraws = 0;
+    }
+
+    //! Statistics of the last finished frame.
+    Stats getStats() const
+    {
+        Stats stats = m_stats;
+        stats.numDraws = m_lastDraws;
+        return stats;
+    }
+
+private:
+
+    std::vector<std::vector<PrimitiveVertex>> m_regions;
+    UInt32 m_frame;
+    size_t m_capacity;            //!< Largest capacity of a region.
+
+    PrimitiveMode m_mode;
+    UInt32 m_state;
+    UInt32 m_color;
+    Bool m_drawing;
+
+    std::vector<PrimitiveVertex> m_primitive;   //!< Vertices of the primitive being drawn.
+    std::vector<PrimitiveSubmit> m_runs;
+    size_t m_numFlushed;
+
+    Stats m_stats;
+    UInt32 m_lastDraws;           //!< Draws of the last finished frame.
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_PRIMITIVEBATCH_H
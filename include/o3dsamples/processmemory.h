@@ -0,0 +1,63 @@
+/**
+ * @file processmemory.h
+ * @brief Resident memory of the process, for the memory reports of the samples.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_PROCESSMEMORY_H
+#define _O3DSAMPLES_PROCESSMEMORY_H
+
+#include <o3d/core/base.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace o3dsamples {
+
+using namespace o3d;
+
+/**
+ * @brief Resident set size of the process, read from /proc/self/status.
+ * The values are 0 where /proc is not available.
+ */
+class ProcessMemory
+{
+public:
+
+    //! Current resident bytes (VmRSS).
+    static UInt64 getResidentBytes() { return readStatus("VmRSS:"); }
+
+    //! Highest resident bytes since the start of the process (VmHWM).
+    static UInt64 getPeakResidentBytes() { return readStatus("VmHWM:"); }
+
+private:
+
+    static UInt64 readStatus(const char *field)
+    {
+        FILE *file = fopen("/proc/self/status", "r");
+        if (!file) {
+            return 0;
+        }
+
+        const size_t length = strlen(field);
+        char line[256];
+        unsigned long long kb = 0;
+
+        while (fgets(line, sizeof(line), file)) {
+            if (strncmp(line, field, length) == 0) {
+                sscanf(line + length, "%llu", &kb);
+                break;
+            }
+        }
+
+        fclose(file);
+        return UInt64(kb) * 1024;
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_PROCESSMEMORY_H
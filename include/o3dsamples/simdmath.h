@@ -0,0 +1,198 @@
+/**
+ * @file simdmath.h
+ * @brief Float lanes of width 1, 4 (SSE2) and 8 (AVX) sharing the same interface.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_SIMDMATH_H
+#define _O3DSAMPLES_SIMDMATH_H
+
+#include <o3d/core/base.h>
+
+#include <cmath>
+#include <cstring>
+
+#ifdef O3D_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX__
+#include <immintrin.h>
+#define O3DSAMPLES_AVX
+#endif
+
+namespace o3dsamples {
+
+using namespace o3d;
+
+/*
+ * A kernel written once as a template over the lane type runs on 1, 4 or 8 values at
+ * a time. The three types provide the same operators and functions, and vexp uses the
+ * same polynomial for all of them, so the widths only differ by rounding.
+ */
+
+/**
+ * @brief Single float lane, the scalar fallback.
+ */
+struct Float1
+{
+    static const UInt32 WIDTH = 1;
+
+    Float v;
+
+    Float1() {}
+    Float1(Float a) : v(a) {}
+
+    static Float1 load(const Float *p) { return Float1(p[0]); }
+    void store(Float *p) const { p[0] = v; }
+
+    friend Float1 operator+(Float1 a, Float1 b) { return Float1(a.v + b.v); }
+    friend Float1 operator-(Float1 a, Float1 b) { return Float1(a.v - b.v); }
+    friend Float1 operator*(Float1 a, Float1 b) { return Float1(a.v * b.v); }
+    friend Float1 operator/(Float1 a, Float1 b) { return Float1(a.v / b.v); }
+
+    Float1& operator+=(Float1 a) { v += a.v; return *this; }
+    Float1& operator*=(Float1 a) { v *= a.v; return *this; }
+
+    friend Float1 vmin(Float1 a, Float1 b) { return Float1(a.v < b.v ? a.v : b.v); }
+    friend Float1 vmax(Float1 a, Float1 b) { return Float1(a.v > b.v ? a.v : b.v); }
+    friend Float1 vsqrt(Float1 a) { return Float1(std::sqrt(a.v)); }
+    friend Float1 vfloor(Float1 a) { return Float1(std::floor(a.v)); }
+
+    //! Bit i set if the lane i of a is lower or equal to the one of b.
+    friend UInt32 vmaskle(Float1 a, Float1 b) { return a.v <= b.v ? 1 : 0; }
+
+    //! 2^i for an integral valued lane in [-126, 127].
+    friend Float1 vexp2i(Float1 a)
+    {
+        const UInt32 bits = UInt32(Int32(a.v) + 127) << 23;
+        Float r;
+        memcpy(&r, &bits, sizeof(Float));
+        return Float1(r);
+    }
+};
+
+#ifdef O3D_SSE2
+/**
+ * @brief Four float lanes using SSE2.
+ */
+struct Float4
+{
+    static const UInt32 WIDTH = 4;
+
+    __m128 v;
+
+    Float4() {}
+    Float4(Float a) : v(_mm_set1_ps(a)) {}
+    Float4(__m128 a) : v(a) {}
+
+    static Float4 load(const Float *p) { return Float4(_mm_loadu_ps(p)); }
+    void store(Float *p) const { _mm_storeu_ps(p, v); }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return Float4(_mm_add_ps(a.v, b.v)); }
+    friend Float4 operator-(Float4 a, Float4 b) { return Float4(_mm_sub_ps(a.v, b.v)); }
+    friend Float4 operator*(Float4 a, Float4 b) { return Float4(_mm_mul_ps(a.v, b.v)); }
+    friend Float4 operator/(Float4 a, Float4 b) { return Float4(_mm_div_ps(a.v, b.v)); }
+
+    Float4& operator+=(Float4 a) { v = _mm_add_ps(v, a.v); return *this; }
+    Float4& operator*=(Float4 a) { v = _mm_mul_ps(v, a.v); return *this; }
+
+    friend Float4 vmin(Float4 a, Float4 b) { return Float4(_mm_min_ps(a.v, b.v)); }
+    friend Float4 vmax(Float4 a, Float4 b) { return Float4(_mm_max_ps(a.v, b.v)); }
+    friend Float4 vsqrt(Float4 a) { return Float4(_mm_sqrt_ps(a.v)); }
+    friend UInt32 vmaskle(Float4 a, Float4 b) { return UInt32(_mm_movemask_ps(_mm_cmple_ps(a.v, b.v))); }
+
+    //! SSE2 has no floor, truncate then correct the negative values.
+    friend Float4 vfloor(Float4 a)
+    {
+        const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+        return Float4(_mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.0f))));
+    }
+
+    friend Float4 vexp2i(Float4 a)
+    {
+        const __m128i i = _mm_add_epi32(_mm_cvttps_epi32(a.v), _mm_set1_epi32(127));
+        return Float4(_mm_castsi128_ps(_mm_slli_epi32(i, 23)));
+    }
+};
+#endif
+
+#ifdef O3DSAMPLES_AVX
+/**
+ * @brief Eight float lanes using AVX (the integer part uses two SSE2 halves).
+ */
+struct Float8
+{
+    static const UInt32 WIDTH = 8;
+
+    __m256 v;
+
+    Float8() {}
+    Float8(Float a) : v(_mm256_set1_ps(a)) {}
+    Float8(__m256 a) : v(a) {}
+
+    static Float8 load(const Float *p) { return Float8(_mm256_loadu_ps(p)); }
+    void store(Float *p) const { _mm256_storeu_ps(p, v); }
+
+    friend Float8 operator+(Float8 a, Float8 b) { return Float8(_mm256_add_ps(a.v, b.v)); }
+    friend Float8 operator-(Float8 a, Float8 b) { return Float8(_mm256_sub_ps(a.v, b.v)); }
+    friend Float8 operator*(Float8 a, Float8 b) { return Float8(_mm256_mul_ps(a.v, b.v)); }
+    friend Float8 operator/(Float8 a, Float8 b) { return Float8(_mm256_div_ps(a.v, b.v)); }
+
+    Float8& operator+=(Float8 a) { v = _mm256_add_ps(v, a.v); return *this; }
+    Float8& operator*=(Float8 a) { v = _mm256_mul_ps(v, a.v); return *this; }
+
+    friend Float8 vmin(Float8 a, Float8 b) { return Float8(_mm256_min_ps(a.v, b.v)); }
+    friend Float8 vmax(Float8 a, Float8 b) { return Float8(_mm256_max_ps(a.v, b.v)); }
+    friend Float8 vsqrt(Float8 a) { return Float8(_mm256_sqrt_ps(a.v)); }
+    friend Float8 vfloor(Float8 a) { return Float8(_mm256_floor_ps(a.v)); }
+    friend UInt32 vmaskle(Float8 a, Float8 b) { return UInt32(_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ))); }
+
+    friend Float8 vexp2i(Float8 a)
+    {
+        const __m256i i = _mm256_cvttps_epi32(a.v);
+        const __m128i bias = _mm_set1_epi32(127);
+
+        const __m128i lo = _mm_slli_epi32(_mm_add_epi32(_mm256_castsi256_si128(i), bias), 23);
+        const __m128i hi = _mm_slli_epi32(_mm_add_epi32(_mm256_extractf128_si256(i, 1), bias), 23);
+
+        return Float8(_mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1)));
+    }
+};
+#endif
+
+/**
+ * @brief Exponential, relative error under 2e-5 on the range [-87, 88].
+ * exp(x) = 2^i * 2^f with i the integral part of x/ln(2) and 2^f from a degree 6 polynomial.
+ */
+template <class V>
+inline V vexp(V x)
+{
+    const V y = vmin(vmax(x * V(1.44269504f), V(-126.0f)), V(126.0f));
+    const V i = vfloor(y);
+    const V f = y - i;
+
+    V p = V(1.5403530e-4f);
+    p = p * f + V(1.3333558e-3f);
+    p = p * f + V(9.6181291e-3f);
+    p = p * f + V(5.5504109e-2f);
+    p = p * f + V(2.4022651e-1f);
+    p = p * f + V(6.9314718e-1f);
+    p = p * f + V(1.0f);
+
+    return p * vexp2i(i);
+}
+
+//! Linear interpolation a + (b - a) * t.
+template <class V>
+inline V vlerp(V a, V b, V t)
+{
+    return a + (b - a) * t;
+}
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_SIMDMATH_H
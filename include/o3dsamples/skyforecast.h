@@ -0,0 +1,332 @@
+/**
+ * @file skyforecast.h
+ * @brief Cancellable background computation of the sky dome, double buffered.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_SKYFORECAST_H
+#define _O3DSAMPLES_SKYFORECAST_H
+
+#include "skyscatter.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace o3dsamples {
+
+/**
+ * @brief Computes the sky of the requested time on a WorkerPool, while the previous
+ * one stays readable.
+ * - The front dome is the last completed one, it is only accessed by the owner thread.
+ *   The back dome is computed by a single background job, and swapped by update().
+ * - The job works by chunks of rows. Between two chunks it checks a generation number
+ *   used as cancellation token: when setTime moves the request out of the tolerance of
+ *   the time being computed, the job drops its work and restarts at the latest
+ *   requested time, so a time jump never waits for a stale sky.
+ * - The latency is measured from the first setTime that the front dome no longer
+ *   satisfies, to the update() that presents a dome within the tolerance.
+ * setTime, update and the getters must be called from the same thread.
+ */
+class SkyForecast
+{
+public:
+
+    /**
+     * @brief Define the lights of a sky for a time (clearLights then addLight).
+     * Called from the job, it must not access data modified by the owner thread.
+     */
+    typedef std::function<void(Double time, SkyScatter &sky)> LightFunc;
+
+    struct Stats
+    {
+        UInt32 numRequests;       //!< Requests that invalidated the front dome.
+        UInt32 numStarted;        //!< Jobs started.
+        UInt32 numCancelled;      //!< Computations dropped and restarted.
+        UInt32 numCompleted;      //!< Domes completed.
+        Float lastLatency;        //!< In milliseconds.
+        Float maxLatency;         //!< In milliseconds.
+        Float averageLatency;     //!< In milliseconds.
+    };
+
+    SkyForecast(WorkerPool &pool) :
+        m_pool(pool),
+        m_front(&m_domes[0]),
+        m_back(&m_domes[1]),
+        m_tolerance(0.0),
+        m_chunkRows(4),
+        m_generation(0),
+        m_cancellable(True),
+        m_quit(False),
+        m_requestedTime(0.0),
+        m_jobTime(0.0),
+        m_backTime(0.0),
+        m_frontTime(0.0),
+        m_hasFront(False),
+        m_running(False),
+        m_ready(False),
+        m_stale(False),
+        m_totalLatency(0.0),
+        m_numLatencies(0)
+    {
+        resetStats();
+    }
+
+    ~SkyForecast()
+    {
+        m_quit = True;
+        ++m_generation;
+
+        wait();
+    }
+
+    /**
+     * @brief Define the atmosphere, the dome and the lights. Waits for the current job.
+     * @param params Atmosphere.
+     * @param precision Dome precision, as SkyScatter::setDomePrecision.
+     * @param lights Defines the lights for a time.
+     */
+    void setup(const SkyScatterParams &params, UInt32 precision, const LightFunc &lights)
+    {
+        ++m_generation;
+        wait();
+
+        for (SkyScatter &dome : m_domes) {
+            dome.setParams(params);
+            dome.setDomePrecision(precision);
+        }
+
+        m_lights = lights;
+        m_hasFront = m_ready = m_stale = False;
+
+        resetStats();
+    }
+
+    //! Largest time difference for a dome to be correct (default 0).
+    void setTolerance(Double tolerance) { m_tolerance = tolerance; }
+
+    //! Rows computed between two checks of the cancellation token (default 4), set it while idle.
+    void setChunkRows(UInt32 rows) { m_chunkRows = rows ? rows : 1; }
+
+    //! Let the requests cancel the running job (default True).
+    void setCancellable(Bool cancellable) { m_cancellable = cancellable; }
+
+    //! Request the sky of a time. Cancels the running job if too far from it.
+    void setTime(Double time)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_requestedTime = time;
+
+        if (!m_stale && !isCorrect(m_frontTime)) {
+            m_stale = True;
+            m_staleSince = std::chrono::steady_clock::now();
+            ++m_stats.numRequests;
+        }
+
+        if (m_running && (std::fabs(time - m_jobTime) > m_tolerance)) {
+            ++m_generation;
+        }
+    }
+
+    /**
+     * @brief Present the completed dome, and start a job if the front one is not correct.
+     * @return True if the front dome changed.
+     */
+    Bool update()
+    {
+        Bool changed = False;
+        Bool start = False;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (m_ready) {
+                std::swap(m_front, m_back);
+                m_frontTime = m_backTime;
+                m_hasFront = True;
+                m_ready = False;
+                changed = True;
+            }
+
+            if (isCorrect(m_frontTime)) {
+                if (m_stale) {
+                    m_stale = False;
+
+                    const Float latency = std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - m_staleSince).count();
+                    m_totalLatency += latency;
+                    ++m_numLatencies;
+
+                    m_stats.lastLatency = latency;
+                    m_stats.maxLatency = std::max(m_stats.maxLatency, latency);
+                    m_stats.averageLatency = Float(m_totalLatency / m_numLatencies);
+                }
+            } else if (!m_running && !m_ready && m_lights) {
+                m_running = True;
+                m_jobTime = m_requestedTime;
+                ++m_stats.numStarted;
+                start = True;
+            }
+        }
+
+        if (start) {
+            m_pool.submit([this] () { run(); });
+        }
+
+        return changed;
+    }
+
+    //! Wait for the running job, if any.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished.wait(lock, [this] { return !m_running; });
+    }
+
+    //! Is the front dome within the tolerance of the requested time.
+    Bool isUpToDate() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return isCorrect(m_frontTime);
+    }
+
+    //! Is a job running.
+    Bool isComputing() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_running;
+    }
+
+    //! Time of the front dome.
+    Double getTime() const { return m_frontTime; }
+    //! Last requested time.
+    Double getRequestedTime() const { return m_requestedTime; }
+
+    //! Front dome.
+    const SkyScatter& getSky() const { return *m_front; }
+    //! RGB colors of the front dome.
+    const std::vector<Float>& getColors() const { return m_front->getColors(); }
+
+    Stats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+private:
+
+    WorkerPool &m_pool;
+
+    SkyScatter m_domes[2];
+    SkyScatter *m_front;
+    SkyScatter *m_back;          //!< Only accessed by the job while it runs.
+
+    LightFunc m_lights;
+    Double m_tolerance;
+    UInt32 m_chunkRows;
+
+    std::atomic<UInt32> m_generation;   //!< Cancellation token, incremented to cancel.
+    std::atomic<Bool> m_cancellable;
+    std::atomic<Bool> m_quit;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_finished;
+
+    Double m_requestedTime;
+    Double m_jobTime;
+    Double m_backTime;
+    Double m_frontTime;
+
+    Bool m_hasFront;
+    Bool m_running;
+    Bool m_ready;
+    Bool m_stale;
+
+    std::chrono::steady_clock::time_point m_staleSince;
+    Double m_totalLatency;
+    UInt32 m_numLatencies;
+
+    Stats m_stats;
+
+    void resetStats()
+    {
+        m_stats = Stats();
+        m_totalLatency = 0.0;
+        m_numLatencies = 0;
+    }
+
+    //! Must be called with the mutex locked.
+    Bool isCorrect(Double time) const
+    {
+        return m_hasFront && (std::fabs(m_requestedTime - time) <= m_tolerance);
+    }
+
+    Bool isCancelled(UInt32 generation) const
+    {
+        return (m_generation.load() != generation) && (m_cancellable || m_quit);
+    }
+
+    void run()
+    {
+        for (;;) {
+            Double time;
+            UInt32 generation;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                if (m_quit) {
+                    break;
+                }
+
+                // always the latest request
+                time = m_jobTime = m_requestedTime;
+                generation = m_generation.load();
+            }
+
+            m_lights(time, *m_back);
+
+            const UInt32 numRows = m_back->getNumRows();
+            Bool cancelled = False;
+
+            for (UInt32 row = 0; row < numRows; row += m_chunkRows) {
+                if (isCancelled(generation)) {
+                    cancelled = True;
+                    break;
+                }
+
+                const UInt32 count = std::min(m_chunkRows, numRows - row);
+                SkyScatter *sky = m_back;
+
+                m_pool.parallelFor(count, 1, [sky, row] (UInt32 begin, UInt32 end) {
+                    sky->computeRows(row + begin, row + end);
+                });
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (cancelled) {
+                ++m_stats.numCancelled;
+                continue;
+            }
+
+            m_backTime = time;
+            m_ready = True;
+            ++m_stats.numCompleted;
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = False;
+        m_finished.notify_all();
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_SKYFORECAST_H
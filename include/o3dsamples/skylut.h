@@ -0,0 +1,384 @@
+/**
+ * @file skylut.h
+ * @brief Sky colors precomputed by sun elevation, persisted to disk.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_SKYLUT_H
+#define _O3DSAMPLES_SKYLUT_H
+
+#include "contenthash.h"
+#include "skyscatter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace o3dsamples {
+
+/**
+ * @brief Lookup tables of the in-scattered colors of the dome and of the transmittance
+ * toward the sun, for numAngles sun elevations (cosine of the zenith angle from
+ * MIN_COS to 1), for a light of unit intensity.
+ * The dome being symmetric around the vertical, a sun azimuth is a rotation of the
+ * segments, so any sun position is a fetch of two elevations and two segments instead
+ * of an integration, and there is nothing to forecast.
+ * The tables are valid for a set of parameters, a dome precision and the wave lengths
+ * given at build. loadOrBuild keys the file with a hash of all of them.
+ */
+class SkyLut
+{
+public:
+
+    static const UInt32 DEFAULT_NUM_ANGLES = 64;
+    static constexpr Float MIN_COS = -0.2f;   //!< Lowest sun, the twilight goes to zero under.
+
+    SkyLut() :
+        m_key(0),
+        m_precision(0),
+        m_numAngles(0),
+        m_numRows(0),
+        m_numSegments(0),
+        m_loaded(False),
+        m_startupTime(0.0f)
+    {
+        m_wavelength[0] = m_wavelength[1] = m_wavelength[2] = 0.0f;
+    }
+
+    //! Key of the tables for a set of inputs.
+    static UInt64 computeKey(
+            const SkyScatterParams &params,
+            UInt32 precision,
+            const Float *wavelength,
+            UInt32 numAngles)
+    {
+        ContentHash hash;
+
+        // only 32 bits fields, no padding
+        hash.updateValue(params);
+        hash.updateValue(precision);
+        hash.update(wavelength, 3 * sizeof(Float));
+        hash.updateValue(numAngles);
+
+        return hash.get();
+    }
+
+    /**
+     * @brief Integrate the dome for each sun elevation.
+     * @param params Atmosphere.
+     * @param precision Dome precision, as SkyScatter::setDomePrecision.
+     * @param wavelength Wave lengths of the lights that will use the tables.
+     * @param numAngles Number of sun elevations (at least 2).
+     * @param pool Optional pool of workers.
+     */
+    void build(
+            const SkyScatterParams &params,
+            UInt32 precision,
+            const Float *wavelength,
+            UInt32 numAngles = DEFAULT_NUM_ANGLES,
+            WorkerPool *pool = nullptr)
+    {
+        numAngles = numAngles < 2 ? 2 : numAngles;
+
+        SkyScatter sky;
+        sky.setParams(params);
+        sky.setDomePrecision(precision);
+
+        setLayout(computeKey(params, precision, wavelength, numAngles), precision, wavelength,
+                  numAngles, sky.getNumRows(), sky.getNumSegments());
+
+        const UInt32 domeSize = sky.getNumVertices() * 3;
+
+        for (UInt32 a = 0; a < numAngles; ++a) {
+            const Float mu = getAngleCos(a);
+
+            SkyLight light = { { 0.0f, mu, std::sqrt(1.0f - mu*mu) }, { 1.0f, 1.0f, 1.0f },
+                               { wavelength[0], wavelength[1], wavelength[2] } };
+
+            sky.clearLights();
+            sky.addLight(light);
+            sky.compute(pool);
+
+            std::copy(sky.getColors().begin(), sky.getColors().end(), m_colors.begin() + size_t(a) * domeSize);
+            sky.getTransmittance(light, &m_transmittance[a * 3]);
+        }
+    }
+
+    //! Write the tables. Returns False on error.
+    Bool save(const char *filename) const
+    {
+        if (!isValid()) {
+            return False;
+        }
+
+        FILE *file = fopen(filename, "wb");
+        if (!file) {
+            return False;
+        }
+
+        const UInt32 header[5] = { VERSION, m_precision, m_numAngles, m_numRows, m_numSegments };
+
+        Bool ok = fwrite(getMagic(), 1, 8, file) == 8;
+        ok = ok && (fwrite(&m_key, sizeof(UInt64), 1, file) == 1);
+        ok = ok && (fwrite(header, sizeof(UInt32), 5, file) == 5);
+        ok = ok && (fwrite(m_wavelength, sizeof(Float), 3, file) == 3);
+        ok = ok && (fwrite(m_transmittance.data(), sizeof(Float), m_transmittance.size(), file) == m_transmittance.size());
+        ok = ok && (fwrite(m_colors.data(), sizeof(Float), m_colors.size(), file) == m_colors.size());
+
+        ok = (fclose(file) == 0) && ok;
+        if (!ok) {
+            remove(filename);
+        }
+
+        return ok;
+    }
+
+    //! Read tables written by save. Returns False if missing, invalid or of another key.
+    Bool load(const char *filename, UInt64 key)
+    {
+        FILE *file = fopen(filename, "rb");
+        if (!file) {
+            return False;
+        }
+
+        char magic[8];
+        UInt64 fileKey = 0;
+        UInt32 header[5];
+        Float wavelength[3];
+
+        Bool ok = (fread(magic, 1, 8, file) == 8) && (memcmp(magic, getMagic(), 8) == 0);
+        ok = ok && (fread(&fileKey, sizeof(UInt64), 1, file) == 1) && (fileKey == key);
+        ok = ok && (fread(header, sizeof(UInt32), 5, file) == 5) && (header[0] == VERSION);
+        ok = ok && (header[2] >= 2) && (header[3] == (1u << header[1]) + 1) && (header[4] == (4u << header[1]));
+        ok = ok && (fread(wavelength, sizeof(Float), 3, file) == 3);
+
+        if (ok) {
+            setLayout(fileKey, header[1], wavelength, header[2], header[3], header[4]);
+
+            ok = (fread(m_transmittance.data(), sizeof(Float), m_transmittance.size(), file) == m_transmittance.size()) &&
+                 (fread(m_colors.data(), sizeof(Float), m_colors.size(), file) == m_colors.size());
+        }
+
+        fclose(file);
+
+        if (!ok) {
+            clear();
+        }
+
+        return ok;
+    }
+
+    /**
+     * @brief Load the tables of the given inputs from filename, or build and save them.
+     * @return True if the tables were loaded, False if they were built.
+     */
+    Bool loadOrBuild(
+            const char *filename,
+            const SkyScatterParams &params,
+            UInt32 precision,
+            const Float *wavelength,
+            UInt32 numAngles = DEFAULT_NUM_ANGLES,
+            WorkerPool *pool = nullptr)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        m_loaded = load(filename, computeKey(params, precision, wavelength, numAngles < 2 ? 2 : numAngles));
+
+        if (!m_loaded) {
+            build(params, precision, wavelength, numAngles, pool);
+            save(filename);
+        }
+
+        m_startupTime = std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return m_loaded;
+    }
+
+    //! Are the tables defined.
+    Bool isValid() const { return m_numAngles >= 2; }
+
+    /**
+     * @brief Add the in-scattered colors of a light to a dome (SkyScatter vertex order).
+     * @param light Its wave lengths must be the ones of the tables.
+     * @param colors RGB per vertex, getNumVertices() * 3 values.
+     */
+    void accumulate(const SkyLight &light, Float *colors) const
+    {
+        UInt32 a0;
+        Float ta, shift;
+        locate(light, a0, ta, shift);
+
+        shift -= std::floor(shift / m_numSegments) * m_numSegments;
+        const UInt32 s0 = UInt32(shift) % m_numSegments;
+        const Float ts = shift - std::floor(shift);
+
+        const Float *lo = &m_colors[size_t(a0) * getNumVertices() * 3];
+        const Float *hi = lo + getNumVertices() * 3;
+
+        for (UInt32 row = 0; row < m_numRows; ++row) {
+            const UInt32 first = row * m_numSegments;
+
+            for (UInt32 seg = 0; seg < m_numSegments; ++seg) {
+                // the vertex at seg sees the tables at seg - shift
+                const UInt32 src0 = first + (seg + m_numSegments - s0) % m_numSegments;
+                const UInt32 src1 = first + (seg + 2 * m_numSegments - s0 - 1) % m_numSegments;
+
+                Float *out = colors + (first + seg) * 3;
+
+                for (Int32 c = 0; c < 3; ++c) {
+                    const Float l = lo[src0*3+c] + (lo[src1*3+c] - lo[src0*3+c]) * ts;
+                    const Float h = hi[src0*3+c] + (hi[src1*3+c] - hi[src0*3+c]) * ts;
+
+                    out[c] += light.intensity[c] * (l + (h - l) * ta);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief In-scattered color of a light in a view direction.
+     * Directions under the horizon get the color of the horizon.
+     */
+    void sample(const SkyLight &light, const Float *viewDir, Float *out) const
+    {
+        UInt32 a0;
+        Float ta, shift;
+        locate(light, a0, ta, shift);
+
+        const Float len = std::sqrt(viewDir[0]*viewDir[0] + viewDir[1]*viewDir[1] + viewDir[2]*viewDir[2]);
+        const Float elevation = std::asin(std::min(std::max(viewDir[1] / len, 0.0f), 1.0f));
+
+        const Float fr = (1.0f - elevation / HALF_PI) * (m_numRows - 1);
+        const UInt32 r0 = std::min(UInt32(fr), m_numRows - 2);
+        const Float tr = fr - r0;
+
+        Float fs = std::atan2(viewDir[0], viewDir[2]) / TWO_PI * m_numSegments - shift;
+        fs -= std::floor(fs / m_numSegments) * m_numSegments;
+        const UInt32 s0 = UInt32(fs) % m_numSegments;
+        const UInt32 s1 = (s0 + 1) % m_numSegments;
+        const Float ts = fs - std::floor(fs);
+
+        const UInt32 i00 = r0 * m_numSegments + s0, i10 = r0 * m_numSegments + s1;
+        const UInt32 i01 = i00 + m_numSegments, i11 = i10 + m_numSegments;
+
+        for (Int32 c = 0; c < 3; ++c) {
+            Float v[2];
+
+            for (UInt32 k = 0; k < 2; ++k) {
+                const Float *t = &m_colors[size_t(a0 + k) * getNumVertices() * 3];
+
+                const Float top = t[i00*3+c] + (t[i10*3+c] - t[i00*3+c]) * ts;
+                const Float bottom = t[i01*3+c] + (t[i11*3+c] - t[i01*3+c]) * ts;
+
+                v[k] = top + (bottom - top) * tr;
+            }
+
+            out[c] = light.intensity[c] * (v[0] + (v[1] - v[0]) * ta);
+        }
+    }
+
+    //! Color of the direct light of a light at the ground (intensity times transmittance).
+    void getLightColor(const SkyLight &light, Float *out) const
+    {
+        UInt32 a0;
+        Float ta, shift;
+        locate(light, a0, ta, shift);
+
+        for (Int32 c = 0; c < 3; ++c) {
+            const Float l = m_transmittance[a0*3+c];
+            const Float h = m_transmittance[(a0+1)*3+c];
+
+            out[c] = light.intensity[c] * (l + (h - l) * ta);
+        }
+    }
+
+    //! Key of the current tables.
+    UInt64 getKey() const { return m_key; }
+    //! Dome precision of the tables.
+    UInt32 getPrecision() const { return m_precision; }
+    //! Number of sun elevations.
+    UInt32 getNumAngles() const { return m_numAngles; }
+    //! Number of dome rings.
+    UInt32 getNumRows() const { return m_numRows; }
+    //! Vertices per ring.
+    UInt32 getNumSegments() const { return m_numSegments; }
+    //! Number of dome vertices.
+    UInt32 getNumVertices() const { return m_numRows * m_numSegments; }
+
+    //! Memory used by the tables.
+    UInt64 getBytes() const { return (m_colors.size() + m_transmittance.size()) * sizeof(Float); }
+
+    //! Were the tables loaded from the disk by the last loadOrBuild.
+    Bool isLoaded() const { return m_loaded; }
+    //! Duration of the last loadOrBuild in milliseconds.
+    Float getStartupTime() const { return m_startupTime; }
+
+private:
+
+    static const UInt32 VERSION = 1;
+    static constexpr Float HALF_PI = 1.57079632679f;
+    static constexpr Float TWO_PI = 6.28318530718f;
+
+    UInt64 m_key;
+    UInt32 m_precision;
+    UInt32 m_numAngles;
+    UInt32 m_numRows;
+    UInt32 m_numSegments;
+    Float m_wavelength[3];
+
+    //! Dome colors by sun elevation, in the vertex order of SkyScatter.
+    std::vector<Float> m_colors;
+    //! RGB transmittance toward the sun by sun elevation.
+    std::vector<Float> m_transmittance;
+
+    Bool m_loaded;
+    Float m_startupTime;
+
+    static const char* getMagic() { return "O3DSKYLT"; }
+
+    //! Cosine of the sun zenith angle of a table.
+    Float getAngleCos(UInt32 a) const
+    {
+        return MIN_COS + (1.0f - MIN_COS) * Float(a) / Float(m_numAngles - 1);
+    }
+
+    void setLayout(UInt64 key, UInt32 precision, const Float *wavelength, UInt32 numAngles, UInt32 numRows, UInt32 numSegments)
+    {
+        m_key = key;
+        m_precision = precision;
+        m_numAngles = numAngles;
+        m_numRows = numRows;
+        m_numSegments = numSegments;
+        memcpy(m_wavelength, wavelength, sizeof(m_wavelength));
+
+        m_colors.assign(size_t(numAngles) * numRows * numSegments * 3, 0.0f);
+        m_transmittance.assign(numAngles * 3, 0.0f);
+    }
+
+    void clear()
+    {
+        m_key = 0;
+        m_numAngles = m_numRows = m_numSegments = 0;
+        m_colors.clear();
+        m_transmittance.clear();
+    }
+
+    //! Lower table and weight of the sun elevation, and azimuth of the sun in segments.
+    void locate(const SkyLight &light, UInt32 &a0, Float &ta, Float &shift) const
+    {
+        const Float *dir = light.direction;
+        const Float len = std::sqrt(dir[0]*dir[0] + dir[1]*dir[1] + dir[2]*dir[2]);
+
+        const Float fa = std::min(std::max((dir[1] / len - MIN_COS) / (1.0f - MIN_COS), 0.0f), 1.0f) * (m_numAngles - 1);
+        a0 = std::min(UInt32(fa), m_numAngles - 2);
+        ta = fa - a0;
+
+        shift = std::atan2(dir[0], dir[2]) / TWO_PI * m_numSegments;
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_SKYLUT_H
@@ -0,0 +1,513 @@
+/**
+ * @file skyscatter.h
+ * @brief CPU Rayleigh/Mie single scattering integrator over a sky dome.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_SKYSCATTER_H
+#define _O3DSAMPLES_SKYSCATTER_H
+
+#include "simdmath.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief Parameters of the atmosphere. The names follow the SkyScattering setters,
+ * distances are in the unit of the planet radius (km in the samples).
+ */
+struct SkyScatterParams
+{
+    Float planetRadius;           //!< SkyScattering::setPlanetRadius.
+    Float atmosphereThickness;    //!< SkyScattering::setAtmosphereThickness.
+    Float rayleighScaleHeight;    //!< Height where the molecule density is divided by e.
+    Float mieScaleHeight;         //!< Height where the aerosol density is divided by e.
+    Float moleculePhase[2];       //!< SkyScattering::setMoleculePhaseFunctionCoefficients, x + y.cos^2.
+    Float mieG;                   //!< Aerosol asymmetry factor.
+    Float mieScattering;          //!< Aerosol scattering coefficient at sea level.
+    Float rayleighReference;      //!< Molecule scattering coefficient at 650 nm at sea level.
+    Float stepFactor;             //!< SkyScattering::setIntegrationStepFactor, ratio between two steps.
+    UInt32 stepIndex;             //!< SkyScattering::setIntegrationStepIndex, 4 steps per index.
+
+    SkyScatterParams() :
+        planetRadius(6400.0f),
+        atmosphereThickness(100.0f),
+        rayleighScaleHeight(8.0f),
+        mieScaleHeight(1.2f),
+        mieG(0.76f),
+        mieScattering(21.0e-3f),
+        rayleighReference(5.5e-3f),
+        stepFactor(1.1f),
+        stepIndex(5)
+    {
+        moleculePhase[0] = 1.75f;
+        moleculePhase[1] = 0.25f;
+    }
+};
+
+/**
+ * @brief A light of the sky (a SkyObject like the sun or the moon).
+ */
+struct SkyLight
+{
+    Float direction[3];   //!< Direction toward the light, normalized by addLight.
+    Float intensity[3];   //!< SkyObject::setIntensity.
+    Float wavelength[3];  //!< SkyObject::setWaveLength in meters.
+};
+
+/**
+ * @brief Single scattering of the lights through the atmosphere, for each vertex of a
+ * hemispherical dome seen from the ground.
+ * - The view ray is cut into steps growing by the step factor, the optical depth
+ *   toward each light is fetched from precomputed 2D tables (height, cosine of the
+ *   light zenith angle) instead of being integrated at each sample.
+ * - The dome is computed 8 vertices at a time with AVX, 4 with SSE2, the remaining
+ *   ones with the scalar path, and its rows can be split across a WorkerPool.
+ */
+class SkyScatter
+{
+public:
+
+    enum Path
+    {
+        PATH_SCALAR = 0,
+        PATH_SSE2,
+        PATH_AVX,
+        PATH_BEST
+    };
+
+    static const UInt32 MAX_LIGHTS = 4;
+    static const UInt32 TABLE_HEIGHTS = 64;   //!< Rows of the optical depth tables (height).
+    static const UInt32 TABLE_ANGLES = 128;   //!< Columns of the optical depth tables (cosine).
+
+    SkyScatter() :
+        m_numRings(0),
+        m_numSegments(0),
+        m_path(PATH_BEST),
+        m_firstStep(0.0f),
+        m_numSteps(0)
+    {
+        setParams(SkyScatterParams());
+    }
+
+    //! Is a path compiled in.
+    static Bool hasPath(Path path)
+    {
+        switch (path) {
+            case PATH_SCALAR:
+            case PATH_BEST:
+                return True;
+            case PATH_SSE2:
+            #ifdef O3D_SSE2
+                return True;
+            #else
+                return False;
+            #endif
+            case PATH_AVX:
+            #ifdef O3DSAMPLES_AVX
+                return True;
+            #else
+                return False;
+            #endif
+            default:
+                return False;
+        }
+    }
+
+    //! Set the atmosphere and rebuild the optical depth tables.
+    void setParams(const SkyScatterParams &params)
+    {
+        m_params = params;
+        m_numSteps = std::max<UInt32>(params.stepIndex * 4, 1);
+
+        // the first step of a geometric progression of numSteps steps summing to 1
+        const Double f = params.stepFactor;
+        m_firstStep = std::fabs(f - 1.0) < 1e-6 ? Float(1.0 / m_numSteps) : Float((f - 1.0) / (std::pow(f, Double(m_numSteps)) - 1.0));
+
+        buildTables();
+    }
+
+    //! Get the atmosphere.
+    const SkyScatterParams& getParams() const { return m_params; }
+
+    /**
+     * @brief Define the dome, like SkyScattering::setDomePrecision.
+     * The dome has 2^precision rings from the zenith to the horizon and 4 * 2^precision
+     * vertices per ring.
+     */
+    void setDomePrecision(UInt32 precision)
+    {
+        m_numRings = 1 << precision;
+        m_numSegments = 4 << precision;
+
+        const UInt32 numVertices = getNumVertices();
+
+        m_dirX.resize(numVertices);
+        m_dirY.resize(numVertices);
+        m_dirZ.resize(numVertices);
+        m_colors.assign(numVertices * 3, 0.0f);
+
+        for (UInt32 ring = 0; ring <= m_numRings; ++ring) {
+            const Double elevation = 3.14159265358979 * 0.5 * (1.0 - Double(ring) / m_numRings);
+
+            for (UInt32 seg = 0; seg < m_numSegments; ++seg) {
+                const Double azimuth = 2.0 * 3.14159265358979 * seg / m_numSegments;
+                const UInt32 i = ring * m_numSegments + seg;
+
+                m_dirX[i] = Float(std::cos(elevation) * std::sin(azimuth));
+                m_dirY[i] = Float(std::sin(elevation));
+                m_dirZ[i] = Float(std::cos(elevation) * std::cos(azimuth));
+            }
+        }
+    }
+
+    //! Number of rings, the zenith and the horizon included.
+    UInt32 getNumRows() const { return m_numRings + 1; }
+    //! Vertices per ring.
+    UInt32 getNumSegments() const { return m_numSegments; }
+    //! Number of dome vertices.
+    UInt32 getNumVertices() const { return (m_numRings + 1) * m_numSegments; }
+
+    //! Remove all the lights.
+    void clearLights() { m_lights.clear(); }
+
+    //! Add a light (up to MAX_LIGHTS).
+    Bool addLight(const SkyLight &light)
+    {
+        if (m_lights.size() >= MAX_LIGHTS) {
+            return False;
+        }
+
+        LightData data;
+        const Float len = std::sqrt(light.direction[0]*light.direction[0] +
+                                    light.direction[1]*light.direction[1] +
+                                    light.direction[2]*light.direction[2]);
+
+        for (Int32 c = 0; c < 3; ++c) {
+            data.dir[c] = light.direction[c] / len;
+            data.intensity[c] = light.intensity[c];
+
+            // molecule scattering goes with the inverse of the fourth power of the wave length
+            const Double ratio = 650.0e-9 / light.wavelength[c];
+            data.betaR[c] = Float(m_params.rayleighReference * ratio * ratio * ratio * ratio);
+        }
+
+        m_lights.push_back(data);
+        return True;
+    }
+
+    //! Choose the computation path (default PATH_BEST). Unavailable paths fall back.
+    void setPath(Path path) { m_path = path; }
+
+    //! Compute the colors of every vertex, on a pool of workers if given.
+    void compute(WorkerPool *pool = nullptr)
+    {
+        const UInt32 numRows = getNumRows();
+
+        if (pool) {
+            pool->parallelFor(numRows, 1, [this] (UInt32 begin, UInt32 end) {
+                computeRows(begin, end);
+            });
+        } else {
+            computeRows(0, numRows);
+        }
+    }
+
+    //! Compute a range of rows. Different rows can be computed concurrently.
+    void computeRows(UInt32 firstRow, UInt32 lastRow)
+    {
+        for (UInt32 row = firstRow; row < lastRow; ++row) {
+            const UInt32 end = (row + 1) * m_numSegments;
+            UInt32 i = row * m_numSegments;
+
+        #ifdef O3DSAMPLES_AVX
+            if ((m_path == PATH_AVX) || (m_path == PATH_BEST)) {
+                for (; i + 8 <= end; i += 8) {
+                    computeVertices<Float8>(i);
+                }
+            }
+        #endif
+
+        #ifdef O3D_SSE2
+            if (m_path != PATH_SCALAR) {
+                for (; i + 4 <= end; i += 4) {
+                    computeVertices<Float4>(i);
+                }
+            }
+        #endif
+
+            for (; i < end; ++i) {
+                computeVertices<Float1>(i);
+            }
+        }
+    }
+
+    //! RGB color of each vertex, ring by ring from the zenith.
+    const std::vector<Float>& getColors() const { return m_colors; }
+
+    //! Direction of a vertex.
+    void getDirection(UInt32 i, Float *dir) const
+    {
+        dir[0] = m_dirX[i];
+        dir[1] = m_dirY[i];
+        dir[2] = m_dirZ[i];
+    }
+
+    /**
+     * @brief Transmittance from the top of the atmosphere down to the ground, along the
+     * direction of a light. Multiplied by the intensity it is the color of the direct light.
+     */
+    void getTransmittance(const SkyLight &light, Float *out) const
+    {
+        const Float len = std::sqrt(light.direction[0]*light.direction[0] +
+                                    light.direction[1]*light.direction[1] +
+                                    light.direction[2]*light.direction[2]);
+
+        Float1 depthR, depthM;
+        fetchOpticalDepth(Float1(light.direction[1] / len * 0.5f + 0.5f), Float1(0.0f), depthR, depthM);
+
+        for (Int32 c = 0; c < 3; ++c) {
+            const Double ratio = 650.0e-9 / light.wavelength[c];
+            const Float betaR = Float(m_params.rayleighReference * ratio * ratio * ratio * ratio);
+
+            out[c] = std::exp(-(betaR * depthR.v + m_params.mieScattering * 1.1f * depthM.v));
+        }
+    }
+
+    //! Memory used by the optical depth tables.
+    UInt64 getTableBytes() const { return m_opticalDepth.size() * sizeof(Float); }
+
+private:
+
+    struct LightData
+    {
+        Float dir[3];
+        Float intensity[3];
+        Float betaR[3];
+    };
+
+    SkyScatterParams m_params;
+
+    UInt32 m_numRings;
+    UInt32 m_numSegments;
+
+    std::vector<Float> m_dirX, m_dirY, m_dirZ;
+    std::vector<Float> m_colors;
+    std::vector<LightData> m_lights;
+
+    //! Molecule and aerosol optical depths interleaved, toward the top of the atmosphere.
+    std::vector<Float> m_opticalDepth;
+
+    Path m_path;
+    Float m_firstStep;
+    UInt32 m_numSteps;
+
+    /**
+     * @brief Optical depths from a point toward the top of the atmosphere, by height
+     * (rows, 0 to the thickness) and cosine of the direction with the vertical (columns,
+     * -1 to 1). Directions hitting the planet get a large depth (no light).
+     */
+    void buildTables()
+    {
+        const Double R = m_params.planetRadius;
+        const Double Ra = R + m_params.atmosphereThickness;
+        const UInt32 numSamples = 64;
+
+        m_opticalDepth.resize(TABLE_HEIGHTS * TABLE_ANGLES * 2);
+
+        for (UInt32 row = 0; row < TABLE_HEIGHTS; ++row) {
+            const Double r = R + m_params.atmosphereThickness * row / (TABLE_HEIGHTS - 1);
+
+            for (UInt32 col = 0; col < TABLE_ANGLES; ++col) {
+                const Double c = -1.0 + 2.0 * col / (TABLE_ANGLES - 1);
+                const Double b = r * c;
+
+                Double depthR = 0.0, depthM = 0.0;
+
+                const Double discPlanet = b*b - (r*r - R*R);
+                if ((discPlanet >= 0.0) && (-b - std::sqrt(discPlanet) > 0.0)) {
+                    depthR = depthM = 1.0e4;
+                } else {
+                    const Double len = -b + std::sqrt(std::max(b*b - (r*r - Ra*Ra), 0.0));
+                    const Double ds = len / numSamples;
+                    const Double s = std::sqrt(std::max(1.0 - c*c, 0.0));
+
+                    for (UInt32 k = 0; k < numSamples; ++k) {
+                        const Double t = (k + 0.5) * ds;
+                        const Double x = s * t, y = r + c * t;
+                        const Double h = std::sqrt(x*x + y*y) - R;
+
+                        depthR += std::exp(-h / m_params.rayleighScaleHeight) * ds;
+                        depthM += std::exp(-h / m_params.mieScaleHeight) * ds;
+                    }
+                }
+
+                m_opticalDepth[(row * TABLE_ANGLES + col) * 2] = Float(depthR);
+                m_opticalDepth[(row * TABLE_ANGLES + col) * 2 + 1] = Float(depthM);
+            }
+        }
+    }
+
+    /**
+     * @brief Bilinear fetch of both optical depths.
+     * @param u Cosine mapped to [0, 1].
+     * @param v Height mapped to [0, 1].
+     */
+    template <class V>
+    void fetchOpticalDepth(V u, V v, V &depthR, V &depthM) const
+    {
+        const V fx = vmin(vmax(u, V(0.0f)), V(1.0f)) * V(TABLE_ANGLES - 1 - 1.0f/1024.0f);
+        const V fy = vmin(vmax(v, V(0.0f)), V(1.0f)) * V(TABLE_HEIGHTS - 1 - 1.0f/1024.0f);
+
+        const V x0 = vfloor(fx), y0 = vfloor(fy);
+        const V tx = fx - x0, ty = fy - y0;
+
+        Float ax[V::WIDTH], ay[V::WIDTH];
+        Float r00[V::WIDTH], r10[V::WIDTH], r01[V::WIDTH], r11[V::WIDTH];
+        Float m00[V::WIDTH], m10[V::WIDTH], m01[V::WIDTH], m11[V::WIDTH];
+
+        x0.store(ax);
+        y0.store(ay);
+
+        // no gather before AVX2, the 2x2 footprints are loaded per lane
+        for (UInt32 k = 0; k < V::WIDTH; ++k) {
+            const Float *p = &m_opticalDepth[(UInt32(ay[k]) * TABLE_ANGLES + UInt32(ax[k])) * 2];
+            const Float *q = p + TABLE_ANGLES * 2;
+
+            r00[k] = p[0]; m00[k] = p[1];
+            r10[k] = p[2]; m10[k] = p[3];
+            r01[k] = q[0]; m01[k] = q[1];
+            r11[k] = q[2]; m11[k] = q[3];
+        }
+
+        depthR = vlerp(vlerp(V::load(r00), V::load(r10), tx), vlerp(V::load(r01), V::load(r11), tx), ty);
+        depthM = vlerp(vlerp(V::load(m00), V::load(m10), tx), vlerp(V::load(m01), V::load(m11), tx), ty);
+    }
+
+    //! Integrate V::WIDTH consecutive vertices starting at first.
+    template <class V>
+    void computeVertices(UInt32 first)
+    {
+        const Float R = m_params.planetRadius;
+        const Float Ra = R + m_params.atmosphereThickness;
+        const UInt32 numLights = static_cast<UInt32>(m_lights.size());
+
+        const V dx = V::load(&m_dirX[first]);
+        const V dy = V::load(&m_dirY[first]);
+        const V dz = V::load(&m_dirZ[first]);
+
+        // length of the view ray from the ground to the top of the atmosphere
+        const V b = V(R) * dy;
+        const V length = vsqrt(b*b + V(Ra*Ra - R*R)) - b;
+
+        const V invThickness(1.0f / m_params.atmosphereThickness);
+        const V invScaleR(-1.0f / m_params.rayleighScaleHeight);
+        const V invScaleM(-1.0f / m_params.mieScaleHeight);
+        const V betaM(m_params.mieScattering);
+        const V betaMExt(m_params.mieScattering * 1.1f);
+
+        V cosView[MAX_LIGHTS];
+        V accR[MAX_LIGHTS][3], accM[MAX_LIGHTS][3];
+
+        for (UInt32 l = 0; l < numLights; ++l) {
+            cosView[l] = dx * V(m_lights[l].dir[0]) + dy * V(m_lights[l].dir[1]) + dz * V(m_lights[l].dir[2]);
+
+            for (Int32 c = 0; c < 3; ++c) {
+                accR[l][c] = V(0.0f);
+                accM[l][c] = V(0.0f);
+            }
+        }
+
+        V ds = length * V(m_firstStep);
+        V t(0.0f);
+        V viewR(0.0f), viewM(0.0f);
+
+        for (UInt32 step = 0; step < m_numSteps; ++step) {
+            const V half = ds * V(0.5f);
+            const V tm = t + half;
+
+            // sample at the middle of the step, o = (0, R, 0)
+            const V r = vsqrt(V(R*R) + V(2.0f*R) * dy * tm + tm*tm);
+            const V h = r - V(R);
+
+            const V rhoR = vexp(h * invScaleR);
+            const V rhoM = vexp(h * invScaleM);
+
+            // optical depth from the viewer to the sample
+            const V depthViewR = viewR + rhoR * half;
+            const V depthViewM = viewM + rhoM * half;
+
+            viewR += rhoR * ds;
+            viewM += rhoM * ds;
+
+            const V rhoRds = rhoR * ds;
+            const V rhoMds = rhoM * ds;
+            const V heightCoord = h * invThickness;
+
+            for (UInt32 l = 0; l < numLights; ++l) {
+                const LightData &light = m_lights[l];
+
+                // cosine of the light zenith angle at the sample
+                const V cosLight = (V(R * light.dir[1]) + tm * cosView[l]) / r;
+
+                V depthR, depthM;
+                fetchOpticalDepth(cosLight * V(0.5f) + V(0.5f), heightCoord, depthR, depthM);
+
+                const V totalR = depthViewR + depthR;
+                const V totalM = (depthViewM + depthM) * betaMExt;
+
+                for (Int32 c = 0; c < 3; ++c) {
+                    const V transmittance = vexp(V(0.0f) - (V(light.betaR[c]) * totalR + totalM));
+
+                    accR[l][c] += rhoRds * transmittance;
+                    accM[l][c] += rhoMds * transmittance;
+                }
+            }
+
+            t = t + ds;
+            ds *= V(m_params.stepFactor);
+        }
+
+        // phase functions and lights contributions
+        const Float g = m_params.mieG;
+        const Float mieK = 1.5f * (1.0f - g*g) / (2.0f + g*g);
+
+        V color[3] = { V(0.0f), V(0.0f), V(0.0f) };
+
+        for (UInt32 l = 0; l < numLights; ++l) {
+            const LightData &light = m_lights[l];
+
+            const V cos2 = cosView[l] * cosView[l];
+            const V phaseR = V(m_params.moleculePhase[0]) + V(m_params.moleculePhase[1]) * cos2;
+
+            const V denom = V(1.0f + g*g) - V(2.0f*g) * cosView[l];
+            const V phaseM = V(mieK) * (V(1.0f) + cos2) / (denom * vsqrt(denom));
+
+            for (Int32 c = 0; c < 3; ++c) {
+                color[c] += V(light.intensity[c]) * (V(light.betaR[c]) * phaseR * accR[l][c] + betaM * phaseM * accM[l][c]);
+            }
+        }
+
+        Float out[3][V::WIDTH];
+        for (Int32 c = 0; c < 3; ++c) {
+            color[c].store(out[c]);
+        }
+
+        for (UInt32 k = 0; k < V::WIDTH; ++k) {
+            m_colors[(first + k) * 3] = out[0][k];
+            m_colors[(first + k) * 3 + 1] = out[1][k];
+            m_colors[(first + k) * 3 + 2] = out[2][k];
+        }
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_SKYSCATTER_H
@@ -0,0 +1,301 @@
+/**
+ * @file terrainheightquery.h
+ * @brief Thread-safe batch height and normal queries over a terrain height grid.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_TERRAINHEIGHTQUERY_H
+#define _O3DSAMPLES_TERRAINHEIGHTQUERY_H
+
+#include "clmterrain.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef O3D_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace o3dsamples {
+
+/**
+ * @brief Ground height and normal queries with bilinear filtering.
+ * The heights of the zones are gathered into a single grid at build, after what the
+ * object is read-only, so any number of threads can query it at the same time.
+ * Positions are given as interleaved x,z pairs (an array of Vector2f works), out of
+ * grid positions are clamped to the border and NaN positions give the grid origin.
+ * With O3D_SSE2 the batches are processed by 4, the result is bit identical to the
+ * scalar path (same operations in the same order).
+ */
+class TerrainHeightQuery
+{
+public:
+
+    TerrainHeightQuery() :
+        m_width(0),
+        m_height(0),
+        m_originX(0.0f),
+        m_originZ(0.0f),
+        m_unit(1.0f),
+        m_invUnit(1.0f),
+        m_maxFx(0.0f),
+        m_maxFz(0.0f),
+        m_simd(True)
+    {
+    }
+
+    //! Build from a terrain loaded with its heights.
+    Bool build(const ClmTerrain &terrain)
+    {
+        if (terrain.getNumZones() == 0) {
+            return False;
+        }
+
+        UInt32 minX = 0xffffffff, minZ = 0xffffffff, maxX = 0, maxZ = 0;
+
+        for (const ClmZone &zone : terrain.getZones()) {
+            if (zone.heights.empty()) {
+                return False;
+            }
+
+            minX = std::min(minX, zone.originX);
+            minZ = std::min(minZ, zone.originZ);
+            maxX = std::max(maxX, zone.originX + zone.sizeX);
+            maxZ = std::max(maxZ, zone.originZ + zone.sizeZ);
+        }
+
+        std::vector<Float> heights(size_t(maxX - minX) * (maxZ - minZ), 0.0f);
+
+        // adjacent zones share their border vertices
+        for (const ClmZone &zone : terrain.getZones()) {
+            for (UInt32 j = 0; j < zone.sizeZ; ++j) {
+                std::copy(zone.heights.begin() + j * zone.sizeX,
+                          zone.heights.begin() + (j + 1) * zone.sizeX,
+                          heights.begin() + size_t(zone.originZ - minZ + j) * (maxX - minX) + (zone.originX - minX));
+            }
+        }
+
+        setGrid(heights.data(), maxX - minX, maxZ - minZ,
+                minX * terrain.getUnit(), minZ * terrain.getUnit(), terrain.getUnit());
+
+        return True;
+    }
+
+    /**
+     * @brief Build from a height grid (a heightmap for instance).
+     * @param heights Row by row heights, Z major.
+     * @param width, height Size of the grid (at least 2x2).
+     * @param originX, originZ Position of the first sample.
+     * @param unit Distance between two samples.
+     */
+    void setGrid(const Float *heights, UInt32 width, UInt32 height, Float originX, Float originZ, Float unit)
+    {
+        m_heights.assign(heights, heights + size_t(width) * height);
+        m_width = width;
+        m_height = height;
+        m_originX = originX;
+        m_originZ = originZ;
+        m_unit = unit;
+        m_invUnit = 1.0f / unit;
+
+        // clamped to the float just under the last sample, so the 2x2 footprint stays
+        // inside: a fixed epsilon is lost to the rounding from 32769 samples
+        m_maxFx = std::nextafter(Float(width - 1), 0.0f);
+        m_maxFz = std::nextafter(Float(height - 1), 0.0f);
+    }
+
+    //! Enable the SSE2 path if compiled in (default True).
+    void setSimd(Bool enable) { m_simd = enable; }
+
+    //! Is the grid defined.
+    Bool isValid() const { return (m_width >= 2) && (m_height >= 2); }
+
+    //! Height at a single position.
+    Float getHeight(Float x, Float z) const
+    {
+        Float h;
+        const Float xz[2] = { x, z };
+        getHeightsScalar(xz, &h, 1);
+        return h;
+    }
+
+    /**
+     * @brief Heights at count positions.
+     * @param xz Interleaved x,z pairs.
+     * @param out Receives count heights.
+     */
+    void getHeights(const Float *xz, Float *out, UInt32 count) const
+    {
+        UInt32 done = 0;
+
+    #ifdef O3D_SSE2
+        if (m_simd) {
+            done = count & ~3u;
+            getHeightsSSE2(xz, out, done);
+        }
+    #endif
+
+        getHeightsScalar(xz + done * 2, out + done, count - done);
+    }
+
+    /**
+     * @brief Normals at count positions, from the central differences of the heights.
+     * @param xz Interleaved x,z pairs.
+     * @param out Receives count normalized x,y,z normals.
+     */
+    void getNormals(const Float *xz, Float *out, UInt32 count) const
+    {
+        Float pos[NORMAL_CHUNK * 8];
+        Float h[NORMAL_CHUNK * 4];
+
+        for (UInt32 first = 0; first < count; first += NORMAL_CHUNK) {
+            const UInt32 n = count - first < NORMAL_CHUNK ? count - first : NORMAL_CHUNK;
+
+            // left, right, up and down samples of each position, in one height batch
+            for (UInt32 i = 0; i < n; ++i) {
+                const Float x = xz[(first + i) * 2], z = xz[(first + i) * 2 + 1];
+
+                pos[i*2] = x - m_unit;           pos[i*2+1] = z;
+                pos[(n+i)*2] = x + m_unit;       pos[(n+i)*2+1] = z;
+                pos[(2*n+i)*2] = x;              pos[(2*n+i)*2+1] = z - m_unit;
+                pos[(3*n+i)*2] = x;              pos[(3*n+i)*2+1] = z + m_unit;
+            }
+
+            getHeights(pos, h, n * 4);
+
+            for (UInt32 i = 0; i < n; ++i) {
+                const Float nx = h[i] - h[n+i];
+                const Float ny = 2.0f * m_unit;
+                const Float nz = h[2*n+i] - h[3*n+i];
+                const Float invLen = 1.0f / std::sqrt(nx*nx + ny*ny + nz*nz);
+
+                Float *normal = out + (first + i) * 3;
+                normal[0] = nx * invLen;
+                normal[1] = ny * invLen;
+                normal[2] = nz * invLen;
+            }
+        }
+    }
+
+    //! Heights using a pool of workers, for large batches.
+    void getHeights(WorkerPool &pool, const Float *xz, Float *out, UInt32 count) const
+    {
+        pool.parallelFor(count, PARALLEL_GRAIN, [this, xz, out] (UInt32 begin, UInt32 end) {
+            getHeights(xz + begin * 2, out + begin, end - begin);
+        });
+    }
+
+    //! Normals using a pool of workers, for large batches.
+    void getNormals(WorkerPool &pool, const Float *xz, Float *out, UInt32 count) const
+    {
+        pool.parallelFor(count, PARALLEL_GRAIN, [this, xz, out] (UInt32 begin, UInt32 end) {
+            getNormals(xz + begin * 2, out + begin * 3, end - begin);
+        });
+    }
+
+    //! Number of samples on X.
+    UInt32 getGridWidth() const { return m_width; }
+    //! Number of samples on Z.
+    UInt32 getGridHeight() const { return m_height; }
+
+private:
+
+    static const UInt32 NORMAL_CHUNK = 64;
+    static const UInt32 PARALLEL_GRAIN = 4096;
+
+    std::vector<Float> m_heights;
+    UInt32 m_width, m_height;
+    Float m_originX, m_originZ;
+    Float m_unit, m_invUnit;
+    Float m_maxFx, m_maxFz;
+    Bool m_simd;
+
+    void getHeightsScalar(const Float *xz, Float *out, UInt32 count) const
+    {
+        const Float *heights = m_heights.data();
+
+        for (UInt32 k = 0; k < count; ++k) {
+            // written so a NaN fails the test and gives 0, like _mm_max_ps, before the
+            // conversion to integer
+            const Float gx = (xz[k*2] - m_originX) * m_invUnit;
+            const Float gz = (xz[k*2+1] - m_originZ) * m_invUnit;
+
+            const Float fx = gx > 0.0f ? std::min(gx, m_maxFx) : 0.0f;
+            const Float fz = gz > 0.0f ? std::min(gz, m_maxFz) : 0.0f;
+
+            const Int32 ix = Int32(fx), iz = Int32(fz);
+            const Float tx = fx - Float(ix), tz = fz - Float(iz);
+
+            const Float *row = heights + size_t(iz) * m_width + ix;
+
+            const Float h0 = row[0] + (row[1] - row[0]) * tx;
+            const Float h1 = row[m_width] + (row[m_width + 1] - row[m_width]) * tx;
+
+            out[k] = h0 + (h1 - h0) * tz;
+        }
+    }
+
+#ifdef O3D_SSE2
+    //! count must be a multiple of 4.
+    void getHeightsSSE2(const Float *xz, Float *out, UInt32 count) const
+    {
+        const Float *heights = m_heights.data();
+
+        const __m128 originX = _mm_set1_ps(m_originX);
+        const __m128 originZ = _mm_set1_ps(m_originZ);
+        const __m128 invUnit = _mm_set1_ps(m_invUnit);
+        const __m128 maxFx = _mm_set1_ps(m_maxFx);
+        const __m128 maxFz = _mm_set1_ps(m_maxFz);
+        const __m128 zero = _mm_setzero_ps();
+
+        alignas(16) Int32 ix[4], iz[4];
+
+        for (UInt32 k = 0; k < count; k += 4) {
+            // deinterleave x0 z0 x1 z1 | x2 z2 x3 z3
+            const __m128 a = _mm_loadu_ps(xz + k*2);
+            const __m128 b = _mm_loadu_ps(xz + k*2 + 4);
+            const __m128 x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 z = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+            // _mm_max_ps returns its second operand when one is a NaN, so NaN gives 0 and
+            // the infinites are clamped to the borders before the conversion to integer
+            const __m128 fx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(x, originX), invUnit), zero), maxFx);
+            const __m128 fz = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(z, originZ), invUnit), zero), maxFz);
+
+            const __m128i vix = _mm_cvttps_epi32(fx);
+            const __m128i viz = _mm_cvttps_epi32(fz);
+
+            const __m128 tx = _mm_sub_ps(fx, _mm_cvtepi32_ps(vix));
+            const __m128 tz = _mm_sub_ps(fz, _mm_cvtepi32_ps(viz));
+
+            _mm_store_si128(reinterpret_cast<__m128i*>(ix), vix);
+            _mm_store_si128(reinterpret_cast<__m128i*>(iz), viz);
+
+            // no gather with SSE2, the 2x2 footprints are loaded per lane
+            const Float *r0 = heights + size_t(iz[0]) * m_width + ix[0];
+            const Float *r1 = heights + size_t(iz[1]) * m_width + ix[1];
+            const Float *r2 = heights + size_t(iz[2]) * m_width + ix[2];
+            const Float *r3 = heights + size_t(iz[3]) * m_width + ix[3];
+
+            const __m128 h00 = _mm_setr_ps(r0[0], r1[0], r2[0], r3[0]);
+            const __m128 h10 = _mm_setr_ps(r0[1], r1[1], r2[1], r3[1]);
+            const __m128 h01 = _mm_setr_ps(r0[m_width], r1[m_width], r2[m_width], r3[m_width]);
+            const __m128 h11 = _mm_setr_ps(r0[m_width+1], r1[m_width+1], r2[m_width+1], r3[m_width+1]);
+
+            const __m128 h0 = _mm_add_ps(h00, _mm_mul_ps(_mm_sub_ps(h10, h00), tx));
+            const __m128 h1 = _mm_add_ps(h01, _mm_mul_ps(_mm_sub_ps(h11, h01), tx));
+
+            _mm_storeu_ps(out + k, _mm_add_ps(h0, _mm_mul_ps(_mm_sub_ps(h1, h0), tz)));
+        }
+    }
+#endif
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_TERRAINHEIGHTQUERY_H
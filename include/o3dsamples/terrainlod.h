@@ -0,0 +1,456 @@
+/**
+ * @file terrainlod.h
+ * @brief CPU model of the PCLOD patch LOD selection and refresh, without renderer.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_TERRAINLOD_H
+#define _O3DSAMPLES_TERRAINLOD_H
+
+#include "clmterrain.h"
+#include "frontbackorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief Parameters of the LOD model. They mirror the PCLODConfigs settings used by
+ * the pclodterrain sample, so a set of values can be tuned here first.
+ */
+struct TerrainLodParams
+{
+    Float viewDistance;             //!< PCLODConfigs::setViewDistance.
+    Float distanceOnlyMaterial;     //!< PCLODConfigs::setDistanceOnlyMaterial.
+    Float distanceOnlyColormap;     //!< PCLODConfigs::setDistanceOnlyColormap.
+    Float frontToBackMinViewMove;   //!< PCLODConfigs::setFrontToBackMinViewMove.
+    UInt32 frontToBackPeriodicity;  //!< PCLODConfigs::setFrontToBackRefreshPeriodicity (frames).
+    Float refreshFrequency;         //!< PCLODConfigs::setRefreshFrequency (Hz).
+    UInt32 colormapPrecision;       //!< PCLODConfigs::setColormapPrecision.
+    UInt32 patchSize;               //!< Quads per patch side, a power of two dividing the zone size.
+    Float maxError;                 //!< Tolerated geometric error per distance unit.
+    Float fov;                      //!< Horizontal field of view in degrees (0 disables the culling).
+    Bool incrementalOrder;          //!< Use a FrontToBackOrder instead of the periodic sort.
+
+    TerrainLodParams() :
+        viewDistance(40.0f),
+        distanceOnlyMaterial(10.0f),
+        distanceOnlyColormap(25.0f),
+        frontToBackMinViewMove(10.0f),
+        frontToBackPeriodicity(100),
+        refreshFrequency(10.0f),
+        colormapPrecision(2),
+        patchSize(8),
+        maxError(0.005f),
+        fov(60.0f),
+        incrementalOrder(False)
+    {
+    }
+};
+
+/**
+ * @brief Patch LOD selection and asynchronous refresh of a PCLOD terrain.
+ * Each zone is cut into patches. A patch has a level per power of two decimation,
+ * with the geometric error of the decimated grid against the full one. At each
+ * refresh (refreshFrequency times per second) the visible patches take the coarsest
+ * level whose error over distance is under maxError, and a patch is counted as
+ * refreshed when its level or its texturing mode changes. Between two refreshes the
+ * selection is kept, like the asynchronous refresh of the engine.
+ */
+class TerrainLod
+{
+public:
+
+    enum Mode
+    {
+        MODE_MATERIAL = 0,  //!< Only materials (near).
+        MODE_BLEND,         //!< Materials blended with the colormap.
+        MODE_COLORMAP       //!< Only the colormap (far).
+    };
+
+    struct FrameStats
+    {
+        UInt32 numVisible;      //!< Patches in range and in the view.
+        UInt32 numTriangles;    //!< Triangles of the selected levels.
+        UInt32 numRefreshed;    //!< Patches whose level or mode changed this frame.
+        UInt32 numModes[3];     //!< Visible patches per texturing mode.
+        Bool refreshed;         //!< A refresh happened this frame.
+        Bool sorted;            //!< The front to back order was rebuilt this frame.
+        Float sortTime;         //!< Time spent to rebuild the order in microseconds.
+        UInt32 numMisordered;   //!< Drawn patches nearer than the previous one by more than a patch.
+        UInt32 numUnordered;    //!< Visible patches missing from the order, drawn last.
+        UInt64 geometryBytes;   //!< Vertex and index bytes of the visible patches.
+        UInt64 colormapBytes;   //!< Bytes of the colormaps of the zones needing one.
+    };
+
+    TerrainLod() :
+        m_numLevels(0),
+        m_frame(0),
+        m_lastRefresh(-1.0f),
+        m_framesSinceSort(0),
+        m_sortX(0.0f),
+        m_sortY(0.0f),
+        m_sortZ(0.0f)
+    {
+        m_stats = FrameStats();
+    }
+    //! Build the patches and their errors. The terrain must be loaded with its heights.
+    Bool build(const ClmTerrain &terrain, const TerrainLodParams &params)
+    {
+        m_params = params;
+        m_patches.clear();
+        m_zones.clear();
+
+        m_numLevels = 1;
+        while ((params.patchSize >> (m_numLevels-1)) > 1) {
+            ++m_numLevels;
+        }
+
+        const Float unit = terrain.getUnit();
+        const Float patchWorldSize = params.patchSize * unit;
+
+        for (UInt32 z = 0; z < terrain.getNumZones(); ++z) {
+            const ClmZone &zone = terrain.getZone(z);
+
+            if (zone.heights.empty() || ((zone.sizeX - 1) % params.patchSize) || ((zone.sizeZ - 1) % params.patchSize)) {
+                return False;
+            }
+
+            ZoneState zoneState = { (zone.sizeX - 1) * (zone.sizeZ - 1), False };
+            m_zones.push_back(zoneState);
+
+            for (UInt32 pj = 0; pj < zone.sizeZ - 1; pj += params.patchSize) {
+                for (UInt32 pi = 0; pi < zone.sizeX - 1; pi += params.patchSize) {
+                    Patch patch;
+
+                    patch.zone = z;
+                    patch.minX = (zone.originX + pi) * unit;
+                    patch.minZ = (zone.originZ + pj) * unit;
+                    patch.maxX = patch.minX + patchWorldSize;
+                    patch.maxZ = patch.minZ + patchWorldSize;
+                    patch.minY = patch.maxY = zone.getHeight(pi, pj);
+
+                    for (UInt32 j = pj; j <= pj + params.patchSize; ++j) {
+                        for (UInt32 i = pi; i <= pi + params.patchSize; ++i) {
+                            patch.minY = std::min(patch.minY, zone.getHeight(i, j));
+                            patch.maxY = std::max(patch.maxY, zone.getHeight(i, j));
+                        }
+                    }
+
+                    patch.errors.resize(m_numLevels);
+                    for (UInt32 l = 0; l < m_numLevels; ++l) {
+                        patch.errors[l] = levelError(zone, pi, pj, params.patchSize, 1 << l);
+                    }
+
+                    patch.level = -1;
+                    patch.mode = MODE_COLORMAP;
+                    patch.distance = 0.0f;
+                    patch.visible = False;
+
+                    m_patches.push_back(patch);
+                }
+            }
+        }
+
+        // the patches form a regular grid, used by the incremental front to back order
+        Float minX = 0.0f, minZ = 0.0f, maxX = 0.0f, maxZ = 0.0f;
+        for (size_t i = 0; i < m_patches.size(); ++i) {
+            minX = i ? std::min(minX, m_patches[i].minX) : m_patches[i].minX;
+            minZ = i ? std::min(minZ, m_patches[i].minZ) : m_patches[i].minZ;
+            maxX = i ? std::max(maxX, m_patches[i].maxX) : m_patches[i].maxX;
+            maxZ = i ? std::max(maxZ, m_patches[i].maxZ) : m_patches[i].maxZ;
+        }
+
+        m_frontToBack.setGrid(minX, minZ, patchWorldSize,
+                              Int32((maxX - minX) / patchWorldSize + 0.5f),
+                              Int32((maxZ - minZ) / patchWorldSize + 0.5f),
+                              params.viewDistance);
+
+        for (UInt32 i = 0; i < m_patches.size(); ++i) {
+            m_frontToBack.setCell(Int32((m_patches[i].minX - minX) / patchWorldSize + 0.5f),
+                                  Int32((m_patches[i].minZ - minZ) / patchWorldSize + 0.5f),
+                                  i);
+        }
+
+        m_lastRefresh = -1.0f;
+        m_framesSinceSort = params.frontToBackPeriodicity;
+        m_order.clear();
+        m_drawOrder.clear();
+        m_drawn.assign(m_patches.size(), 0);
+        m_frame = 0;
+
+        return True;
+    }
+
+    /**
+     * @brief Update for a new frame.
+     * @param x, y, z Camera position.
+     * @param yaw Camera heading around Y in radians, 0 looking toward -Z.
+     * @param time Current time in seconds.
+     */
+    void update(Float x, Float y, Float z, Float yaw, Float time)
+    {
+        m_stats = FrameStats();
+
+        // visibility is evaluated each frame, the levels only at the refresh rate
+        const Float dirX = -std::sin(yaw), dirZ = -std::cos(yaw);
+        const Float halfFov = m_params.fov * 0.5f * 3.14159265f / 180.0f;
+        const Float cosFov = std::cos(halfFov), sinFov = std::sin(halfFov);
+
+        for (Patch &patch : m_patches) {
+            const Float dx = std::max(std::max(patch.minX - x, x - patch.maxX), 0.0f);
+            const Float dy = std::max(std::max(patch.minY - y, y - patch.maxY), 0.0f);
+            const Float dz = std::max(std::max(patch.minZ - z, z - patch.maxZ), 0.0f);
+
+            patch.distance = std::sqrt(dx*dx + dy*dy + dz*dz);
+            patch.visible = (patch.distance <= m_params.viewDistance) &&
+                            ((m_params.fov <= 0.0f) || inView(patch, x, z, dirX, dirZ, cosFov, sinFov));
+        }
+
+        const Float period = m_params.refreshFrequency > 0.0f ? 1.0f / m_params.refreshFrequency : 0.0f;
+
+        if ((m_lastRefresh < 0.0f) || (time - m_lastRefresh >= period)) {
+            refresh();
+            m_lastRefresh = time;
+            m_stats.refreshed = True;
+        }
+
+        // front to back order, either rebuilt once the camera moved enough or periodically,
+        // or maintained by cell crossing
+        const auto sortStart = std::chrono::steady_clock::now();
+
+        if (m_params.incrementalOrder) {
+            m_stats.sorted = m_frontToBack.update(x, z);
+        } else {
+            const Float mx = x - m_sortX, my = y - m_sortY, mz = z - m_sortZ;
+
+            if ((++m_framesSinceSort >= m_params.frontToBackPeriodicity) ||
+                (mx*mx + my*my + mz*mz >= m_params.frontToBackMinViewMove * m_params.frontToBackMinViewMove)) {
+                sortFrontToBack();
+                m_sortX = x; m_sortY = y; m_sortZ = z;
+                m_framesSinceSort = 0;
+                m_stats.sorted = True;
+            }
+        }
+
+        m_stats.sortTime = std::chrono::duration<Float, std::micro>(std::chrono::steady_clock::now() - sortStart).count();
+
+        buildDrawOrder(m_params.incrementalOrder ? m_frontToBack.getOrder() : m_order);
+
+        // selection and memory of the frame
+        for (ZoneState &zone : m_zones) {
+            zone.colormap = False;
+        }
+
+        for (const Patch &patch : m_patches) {
+            if (!patch.visible || (patch.level < 0)) {
+                continue;
+            }
+
+            const UInt32 quads = m_params.patchSize >> patch.level;
+
+            ++m_stats.numVisible;
+            ++m_stats.numModes[patch.mode];
+
+            m_stats.numTriangles += quads * quads * 2;
+            m_stats.geometryBytes += (quads + 1) * (quads + 1) * VERTEX_SIZE + quads * quads * 6 * sizeof(UInt16);
+
+            if (patch.mode != MODE_MATERIAL) {
+                m_zones[patch.zone].colormap = True;
+            }
+        }
+
+        for (const ZoneState &zone : m_zones) {
+            if (zone.colormap) {
+                m_stats.colormapBytes += UInt64(zone.numQuads) * m_params.colormapPrecision * m_params.colormapPrecision * 4;
+            }
+        }
+    }
+
+    //! Statistics of the last frame.
+    const FrameStats& getStats() const { return m_stats; }
+
+    //! Number of patches.
+    UInt32 getNumPatches() const { return static_cast<UInt32>(m_patches.size()); }
+
+    //! Number of levels per patch.
+    UInt32 getNumLevels() const { return m_numLevels; }
+
+    //! Draw order of the visible patches of the last frame.
+    const std::vector<UInt32>& getDrawOrder() const { return m_drawOrder; }
+
+    //! Parameters given at build.
+    const TerrainLodParams& getParams() const { return m_params; }
+
+private:
+
+    static const UInt32 VERTEX_SIZE = 32;  //!< Position, normal and texture coordinates.
+
+    struct Patch
+    {
+        UInt32 zone;
+        Float minX, minY, minZ, maxX, maxY, maxZ;
+        std::vector<Float> errors;
+        Float distance;
+        Int32 level;
+        Mode mode;
+        Bool visible;
+    };
+
+    struct ZoneState
+    {
+        UInt32 numQuads;
+        Bool colormap;
+    };
+
+    TerrainLodParams m_params;
+    UInt32 m_numLevels;
+
+    std::vector<Patch> m_patches;
+    std::vector<ZoneState> m_zones;
+    std::vector<UInt32> m_order;
+    std::vector<UInt32> m_drawOrder;
+    std::vector<UInt32> m_drawn;
+    UInt32 m_frame;
+
+    FrontToBackOrder m_frontToBack;
+
+    Float m_lastRefresh;
+    UInt32 m_framesSinceSort;
+    Float m_sortX, m_sortY, m_sortZ;
+
+    FrameStats m_stats;
+
+    //! Max difference between the heights and the grid decimated by step.
+    static Float levelError(const ClmZone &zone, UInt32 pi, UInt32 pj, UInt32 size, UInt32 step)
+    {
+        Float error = 0.0f;
+
+        for (UInt32 j = 0; j <= size; ++j) {
+            const UInt32 j0 = (j / step) * step;
+            const UInt32 j1 = std::min(j0 + step, size);
+            const Float tj = j1 > j0 ? Float(j - j0) / (j1 - j0) : 0.0f;
+
+            for (UInt32 i = 0; i <= size; ++i) {
+                const UInt32 i0 = (i / step) * step;
+                const UInt32 i1 = std::min(i0 + step, size);
+                const Float ti = i1 > i0 ? Float(i - i0) / (i1 - i0) : 0.0f;
+
+                const Float h00 = zone.getHeight(pi + i0, pj + j0);
+                const Float h10 = zone.getHeight(pi + i1, pj + j0);
+                const Float h01 = zone.getHeight(pi + i0, pj + j1);
+                const Float h11 = zone.getHeight(pi + i1, pj + j1);
+
+                const Float h = (h00 * (1.0f - ti) + h10 * ti) * (1.0f - tj) + (h01 * (1.0f - ti) + h11 * ti) * tj;
+
+                error = std::max(error, std::fabs(h - zone.getHeight(pi + i, pj + j)));
+            }
+        }
+
+        return error;
+    }
+
+    //! Conservative test of the bounding circle of a patch against the horizontal view wedge.
+    static Bool inView(const Patch &patch, Float x, Float z, Float dirX, Float dirZ, Float cosFov, Float sinFov)
+    {
+        const Float cx = (patch.minX + patch.maxX) * 0.5f - x;
+        const Float cz = (patch.minZ + patch.maxZ) * 0.5f - z;
+        const Float hx = (patch.maxX - patch.minX) * 0.5f;
+        const Float hz = (patch.maxZ - patch.minZ) * 0.5f;
+        const Float radius = std::sqrt(hx*hx + hz*hz);
+
+        // normals of the left and right planes of the wedge, pointing inside
+        const Float lx = dirX * sinFov - dirZ * cosFov, lz = dirZ * sinFov + dirX * cosFov;
+        const Float rx = dirX * sinFov + dirZ * cosFov, rz = dirZ * sinFov - dirX * cosFov;
+
+        return (cx*lx + cz*lz >= -radius) && (cx*rx + cz*rz >= -radius);
+    }
+
+    void refresh()
+    {
+        for (Patch &patch : m_patches) {
+            if (!patch.visible) {
+                continue;
+            }
+
+            // coarsest level under the tolerated error at this distance
+            const Float tolerance = m_params.maxError * std::max(patch.distance, 1.0f);
+            Int32 level = 0;
+
+            while ((level + 1 < Int32(m_numLevels)) && (patch.errors[level + 1] <= tolerance)) {
+                ++level;
+            }
+
+            Mode mode = MODE_COLORMAP;
+            if (patch.distance < m_params.distanceOnlyMaterial) {
+                mode = MODE_MATERIAL;
+            } else if (patch.distance < m_params.distanceOnlyColormap) {
+                mode = MODE_BLEND;
+            }
+
+            if ((level != patch.level) || (mode != patch.mode)) {
+                patch.level = level;
+                patch.mode = mode;
+                ++m_stats.numRefreshed;
+            }
+        }
+    }
+
+    /**
+     * @brief Draw order of the frame: the visible patches of the order, then the visible
+     * patches missing from it. Measures how far the order is from an exact one.
+     */
+    void buildDrawOrder(const std::vector<UInt32> &order)
+    {
+        // misordering within the diagonal of a patch is the quantization of the incremental order
+        const Float tolerance = m_patches.empty() ? 0.0f : (m_patches[0].maxX - m_patches[0].minX) * 1.5f;
+
+        ++m_frame;
+        m_drawOrder.clear();
+
+        for (UInt32 i : order) {
+            if (m_patches[i].visible && (m_patches[i].level >= 0)) {
+                m_drawOrder.push_back(i);
+                m_drawn[i] = m_frame;
+            }
+        }
+
+        for (UInt32 i = 0; i < m_patches.size(); ++i) {
+            if (m_patches[i].visible && (m_patches[i].level >= 0) && (m_drawn[i] != m_frame)) {
+                m_drawOrder.push_back(i);
+                ++m_stats.numUnordered;
+            }
+        }
+
+        for (size_t i = 1; i < m_drawOrder.size(); ++i) {
+            if (m_patches[m_drawOrder[i]].distance + tolerance < m_patches[m_drawOrder[i-1]].distance) {
+                ++m_stats.numMisordered;
+            }
+        }
+    }
+
+    void sortFrontToBack()
+    {
+        m_order.clear();
+
+        for (UInt32 i = 0; i < m_patches.size(); ++i) {
+            if (m_patches[i].visible) {
+                m_order.push_back(i);
+            }
+        }
+
+        std::sort(m_order.begin(), m_order.end(), [this] (UInt32 a, UInt32 b) {
+            return m_patches[a].distance < m_patches[b].distance;
+        });
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_TERRAINLOD_H
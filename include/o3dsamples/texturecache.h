@@ -0,0 +1,420 @@
+/**
+ * @file texturecache.h
+ * @brief Texture slots shared by normalized path and by file content, reference counted.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_TEXTURECACHE_H
+#define _O3DSAMPLES_TEXTURECACHE_H
+
+#include "contenthash.h"
+
+#include <cctype>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief Give the same slot to every request of the same texture.
+ * A request is looked up by its normalized path on the calling thread, without reading
+ * its file. The first request of a path gets a new slot to load, the next ones only take
+ * a reference, even while the load is in flight. The loader then resolves the content of
+ * the slot (hash and size of its file), on its own thread: when another slot of the same
+ * content is still loading, its load delivers this slot too, so two copies of a file are
+ * decoded once. A content found after the other slot is loaded is given that slot, with
+ * a reference, and the caller reuses its texture.
+ * The slots are indices, the caller keeps its texture per slot. Slots are never reused,
+ * a slot whose references are all released is forgotten, a later request of its file
+ * gets a new slot.
+ * The cache is thread safe.
+ */
+class TextureCache
+{
+public:
+
+    struct Stats
+    {
+        UInt32 numRequests;       //!< Calls to acquire.
+        UInt32 numLoads;          //!< Requests that had to load their slot.
+        UInt32 numPathHits;       //!< Requests found by their path.
+        UInt32 numContentHits;    //!< Slots delivered by the load of another file.
+        UInt32 numFailed;         //!< Slots of unreadable files.
+        UInt32 numReleased;       //!< Slots whose references are all released.
+        UInt64 loadedBytes;       //!< Bytes of the loaded slots.
+        UInt64 savedBytes;        //!< Bytes the shared requests would have loaded again.
+        Float loadTime;           //!< Milliseconds of the loads of the slots.
+        Float savedTime;          //!< Milliseconds the shared requests would have spent.
+        Float hashTime;           //!< Milliseconds hashing the files, by the loaders.
+
+        Stats() :
+            numRequests(0),
+            numLoads(0),
+            numPathHits(0),
+            numContentHits(0),
+            numFailed(0),
+            numReleased(0),
+            loadedBytes(0),
+            savedBytes(0),
+            loadTime(0.0f),
+            savedTime(0.0f),
+            hashTime(0.0f)
+        {
+        }
+    };
+
+    static const UInt32 INVALID_SLOT = 0xffffffff;
+
+    /**
+     * @brief Take a reference on the slot of a file, by its path only.
+     * @param fileName Path of the file.
+     * @param load Set to True if the caller must load the slot: call resolve from the
+     * loader, then setLoaded.
+     * @return The slot.
+     */
+    UInt32 acquire(const std::string &fileName, Bool &load)
+    {
+        load = False;
+
+        const std::string path = normalize(fileName);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.numRequests;
+
+        auto it = m_paths.find(path);
+        if (it != m_paths.end()) {
+            Slot &hit = m_slots[it->second];
+            ++m_stats.numPathHits;
+            ++hit.refCount;
+
+            // the saving goes to the slot actually loaded
+            ++(hit.owner != INVALID_SLOT ? m_slots[hit.owner] : hit).numShared;
+
+            return it->second;
+        }
+
+        const UInt32 slot = UInt32(m_slots.size());
+        m_slots.push_back(Slot());
+        m_slots[slot].path = path;
+        m_slots[slot].refCount = 1;
+        m_paths[path] = slot;
+
+        ++m_stats.numLoads;
+        load = True;
+
+        return slot;
+    }
+
+    /**
+     * @brief Look up the content of a slot to load, from its loader. The file is read
+     * and hashed here, outside of the lock.
+     * @param fileName Path given to acquire.
+     * @param shared Set to True if the slot must not be loaded: either it is delivered by
+     * the load of another slot of the same content, see setLoaded, or that slot is already
+     * loaded and returned instead.
+     * @return The slot of the path, or the loaded slot of the same content with a reference
+     * taken for the caller to release, or INVALID_SLOT if the file cannot be read.
+     */
+    UInt32 resolve(const std::string &fileName, Bool &shared)
+    {
+        shared = False;
+
+        const std::string path = normalize(fileName);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        ContentHash hash;
+        const Bool readable = hash.updateFile(path.c_str());
+        const Key key(hash.get(), fileSize(path));
+
+        const Float hashTime = std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.hashTime += hashTime;
+
+        auto pathIt = m_paths.find(path);
+        if (pathIt == m_paths.end()) {
+            return INVALID_SLOT;
+        }
+
+        const UInt32 slot = pathIt->second;
+
+        if (!readable) {
+            ++m_stats.numFailed;
+            return INVALID_SLOT;
+        }
+
+        m_slots[slot].key = key;
+
+        auto it = m_contents.find(key);
+        if ((it == m_contents.end()) || (it->second == slot)) {
+            m_contents[key] = slot;
+            return slot;
+        }
+
+        Slot &owner = m_slots[it->second];
+
+        owner.numShared += m_slots[slot].numShared + 1;
+        m_slots[slot].numShared = 0;
+        m_slots[slot].owner = it->second;
+
+        --m_stats.numLoads;
+        ++m_stats.numContentHits;
+
+        shared = True;
+
+        if (owner.loaded) {
+            // too late to be delivered with it, its texture is taken as it is
+            ++owner.refCount;
+            return it->second;
+        }
+
+        owner.delivered.push_back(slot);
+        return slot;
+    }
+
+    /**
+     * @brief Content hash and size of the file of a slot, once resolved.
+     * @return False before, or for an unreadable file.
+     */
+    Bool getContent(UInt32 slot, UInt64 &hash, UInt64 &size) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if ((slot >= m_slots.size()) || !m_slots[slot].key.second) {
+            return False;
+        }
+
+        hash = m_slots[slot].key.first;
+        size = m_slots[slot].key.second;
+
+        return True;
+    }
+
+    /**
+     * @brief Slots delivered by the load of a slot, found by resolve so far. Their
+     * textures take the same levels as the slot.
+     */
+    std::vector<UInt32> getDelivered(UInt32 slot) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return slot < m_slots.size() ? m_slots[slot].delivered : std::vector<UInt32>();
+    }
+
+    /**
+     * @brief Set a slot as loaded, with its size and load time for the statistics. The
+     * slots of the same content resolved from now load their file themselves.
+     * @param slot Slot returned with load set.
+     * @param bytes Bytes of the texels.
+     * @param time Milliseconds of the load.
+     * @return The slots delivered by this load, see getDelivered.
+     */
+    std::vector<UInt32> setLoaded(UInt32 slot, UInt64 bytes, Float time)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (slot >= m_slots.size()) {
+            return std::vector<UInt32>();
+        }
+
+        m_slots[slot].bytes = bytes;
+        m_slots[slot].time = time;
+        m_slots[slot].loaded = True;
+
+        return m_slots[slot].delivered;
+    }
+
+    /**
+     * @brief Release a reference. The last one forgets the path and the content of the
+     * slot. To call once its load and the loads it waits for are done or cancelled.
+     * @return True if it was the last one, the caller may free its texture.
+     */
+    Bool release(UInt32 slot)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if ((slot >= m_slots.size()) || (m_slots[slot].refCount == 0)) {
+            return False;
+        }
+
+        Slot &entry = m_slots[slot];
+
+        if (--entry.refCount > 0) {
+            return False;
+        }
+
+        auto pathIt = m_paths.find(entry.path);
+        if ((pathIt != m_paths.end()) && (pathIt->second == slot)) {
+            m_paths.erase(pathIt);
+        }
+
+        auto it = m_contents.find(entry.key);
+        if ((it != m_contents.end()) && (it->second == slot)) {
+            m_contents.erase(it);
+        }
+
+        ++m_stats.numReleased;
+        return True;
+    }
+
+    UInt32 getNumSlots() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return UInt32(m_slots.size());
+    }
+
+    //! Slot of a path with references, or INVALID_SLOT.
+    UInt32 getSlot(const std::string &fileName) const
+    {
+        const std::string path = normalize(fileName);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_paths.find(path);
+        return it != m_paths.end() ? it->second : INVALID_SLOT;
+    }
+
+    //! Slots still known by their path, with references.
+    UInt32 getNumEntries() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return UInt32(m_paths.size());
+    }
+
+    UInt32 getRefCount(UInt32 slot) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return slot < m_slots.size() ? m_slots[slot].refCount : 0;
+    }
+
+    //! Statistics, the savings are counted from the slots set as loaded.
+    Stats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Stats stats = m_stats;
+
+        for (const Slot &slot : m_slots) {
+            stats.loadedBytes += slot.bytes;
+            stats.loadTime += slot.time;
+
+            if (slot.numShared) {
+                stats.savedBytes += slot.bytes * slot.numShared;
+                stats.savedTime += slot.time * slot.numShared;
+            }
+        }
+
+        return stats;
+    }
+
+    /**
+     * @brief Normalize a path: '/' separators, no "." nor empty component, ".." resolved
+     * when possible, and lower case on Windows.
+     */
+    static std::string normalize(const std::string &fileName)
+    {
+        std::string path(fileName);
+        for (char &c : path) {
+            if (c == '\\') {
+                c = '/';
+            }
+#ifdef O3D_WINDOWS
+            c = char(tolower((unsigned char)c));
+#endif
+        }
+
+        const Bool absolute = !path.empty() && (path[0] == '/');
+        std::vector<std::string> parts;
+
+        size_t begin = 0;
+        while (begin <= path.size()) {
+            size_t end = path.find('/', begin);
+            if (end == std::string::npos) {
+                end = path.size();
+            }
+
+            const std::string part = path.substr(begin, end - begin);
+
+            if (part == "..") {
+                if (!parts.empty() && (parts.back() != "..")) {
+                    parts.pop_back();
+                } else if (!absolute) {
+                    parts.push_back(part);
+                }
+            } else if (!part.empty() && (part != ".")) {
+                parts.push_back(part);
+            }
+
+            begin = end + 1;
+        }
+
+        std::string result(absolute ? "/" : "");
+        for (size_t i = 0; i < parts.size(); ++i) {
+            if (i) {
+                result += '/';
+            }
+            result += parts[i];
+        }
+
+        return result;
+    }
+
+private:
+
+    typedef std::pair<UInt64, UInt64> Key;   //!< Content hash and size.
+
+    struct Slot
+    {
+        std::string path;
+        Key key;
+        UInt32 refCount;
+        UInt32 numShared;     //!< Requests that did not load the slot, by path or content.
+        UInt32 owner;         //!< Slot whose load delivers this one, or INVALID_SLOT.
+        Bool loaded;
+        UInt64 bytes;
+        Float time;
+        std::vector<UInt32> delivered;   //!< Slots of the same content delivered with this one.
+
+        Slot() :
+            key(0, 0),
+            refCount(0),
+            numShared(0),
+            owner(INVALID_SLOT),
+            loaded(False),
+            bytes(0),
+            time(0.0f)
+        {
+        }
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector<Slot> m_slots;
+    std::map<std::string, UInt32> m_paths;
+    std::map<Key, UInt32> m_contents;
+    Stats m_stats;
+
+    static UInt64 fileSize(const std::string &path)
+    {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file) {
+            return 0;
+        }
+
+        fseek(file, 0, SEEK_END);
+        const long size = ftell(file);
+        fclose(file);
+
+        return size > 0 ? UInt64(size) : 0;
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_TEXTURECACHE_H
@@ -0,0 +1,453 @@
+/**
+ * @file texturestreamer.h
+ * @brief Prioritized texture decoding on a pool with a per frame upload budget.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_TEXTURESTREAMER_H
+#define _O3DSAMPLES_TEXTURESTREAMER_H
+
+#include "workerpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace o3dsamples {
+
+/**
+ * @brief A decoded texture level, texels row by row, or blocks of 4x4 texels when
+ * compressed. It may carry its mip chain: the levels follow each other in data, each
+ * one halving the size, rounded up, as given by offsets.
+ */
+struct TextureLevel
+{
+    UInt32 width;
+    UInt32 height;
+    UInt32 texelSize;     //!< Bytes per texel.
+    UInt32 blockBytes;    //!< Bytes per block of 4x4 texels when compressed (8 for BC1), else 0.
+    UInt32 format;        //!< Pixel format of the texels, given back to the upload.
+    Float decodeTime;     //!< Milliseconds to decode the file, set by the streamer.
+    std::vector<UInt8> data;
+    std::vector<size_t> offsets;   //!< Start of each level in data, empty for a single level.
+
+    TextureLevel() : width(0), height(0), texelSize(0), blockBytes(0), format(0), decodeTime(0.0f) {}
+
+    size_t getBytes() const { return data.size(); }
+
+    UInt32 getNumLevels() const { return offsets.empty() ? 1 : UInt32(offsets.size()); }
+
+    UInt32 getLevelWidth(UInt32 level) const { return std::max<UInt32>(((width - 1) >> level) + 1, 1); }
+    UInt32 getLevelHeight(UInt32 level) const { return std::max<UInt32>(((height - 1) >> level) + 1, 1); }
+
+    size_t getLevelSize(UInt32 level) const
+    {
+        const size_t w = getLevelWidth(level), h = getLevelHeight(level);
+        return blockBytes ? ((w + 3) / 4) * ((h + 3) / 4) * blockBytes : w * h * texelSize;
+    }
+
+    const UInt8* getLevelData(UInt32 level) const { return data.data() + (offsets.empty() ? 0 : offsets[level]); }
+
+    //! True if data holds its levels, in their order, and nothing more.
+    Bool isComplete() const
+    {
+        if (!width || !height || (!blockBytes && !texelSize)) {
+            return False;
+        }
+
+        size_t end = 0;
+        for (UInt32 l = 0; l < getNumLevels(); ++l) {
+            if (!offsets.empty() && (offsets[l] != end)) {
+                return False;
+            }
+            end += getLevelSize(l);
+        }
+
+        return end == data.size();
+    }
+
+    //! Half size level of a single uncompressed level, 2x2 box filter, the odd last row
+    //! or column is dropped.
+    void halve(TextureLevel &out) const
+    {
+        out.width = std::max<UInt32>(width / 2, 1);
+        out.height = std::max<UInt32>(height / 2, 1);
+        out.texelSize = texelSize;
+        out.format = format;
+        out.decodeTime = decodeTime;
+        out.data.resize(size_t(out.width) * out.height * texelSize);
+
+        const UInt32 x1 = width > 1 ? 1 : 0;
+        const UInt32 y1 = height > 1 ? 1 : 0;
+
+        for (UInt32 y = 0; y < out.height; ++y) {
+            const UInt8 *row0 = &data[size_t(y * 2) * width * texelSize];
+            const UInt8 *row1 = &data[size_t(y * 2 + y1) * width * texelSize];
+            UInt8 *dst = &out.data[size_t(y) * out.width * texelSize];
+
+            for (UInt32 x = 0; x < out.width; ++x) {
+                const UInt32 a = x * 2 * texelSize;
+                const UInt32 b = (x * 2 + x1) * texelSize;
+
+                for (UInt32 c = 0; c < texelSize; ++c) {
+                    dst[x * texelSize + c] = UInt8((row0[a + c] + row0[b + c] + row1[a + c] + row1[b + c] + 2) / 4);
+                }
+            }
+        }
+    }
+};
+
+/**
+ * @brief Stream textures from their files in the background.
+ * Each request is first given a placeholder by the caller. The decoding runs on a
+ * WorkerPool, a worker always taking the pending request of highest priority, so the
+ * priorities can change until the decoding starts (screen size, distance to the camera).
+ * A decoded texture is delivered in two steps on the thread calling update: its mip tail,
+ * a small level of at most getTailSize texels per side, then its full level. Every tail
+ * is uploaded before any full level, and the full levels are limited to an upload budget
+ * per update, so the first frames show a blurry but complete scene quickly.
+ * The decode function runs on the workers, the upload function on the update thread.
+ * A decode function calling the engine image codecs holds an ImageCodecLock around them.
+ * add, setPriority and update must be called from the same thread.
+ */
+class TextureStreamer
+{
+public:
+
+    //! Decode a file into its full level, on a worker. The tail may be given too, when
+    //! the file has its mips, else it is left empty and built by the streamer. A full
+    //! level given with its mip chain or compressed must come with its tail.
+    //! Returning True with an empty full level marks the request as delivered by another
+    //! one: it is done without any upload.
+    typedef std::function<Bool(const std::string &fileName, TextureLevel &full, TextureLevel &tail)> DecodeFunc;
+    //! Upload a level to the texture of a request, on the update thread.
+    typedef std::function<void(UInt32 id, const TextureLevel &level, Bool final)> UploadFunc;
+
+    struct Stats
+    {
+        UInt32 numRequests;
+        UInt32 numDecoded;
+        UInt32 numFailed;
+        UInt32 numShared;         //!< Requests delivered by another one, see DecodeFunc.
+        UInt32 numTails;          //!< Requests showing their mip tail or better.
+        UInt32 numFull;           //!< Requests at full quality.
+        UInt64 uploadedBytes;     //!< Total bytes uploaded.
+        UInt64 lastUploadBytes;   //!< Bytes uploaded by the last update.
+        Float tailsTime;          //!< Milliseconds from the first request to the last tail, -1 before.
+        Float fullTime;           //!< Milliseconds from the first request to the full quality, -1 before.
+
+        Stats() :
+            numRequests(0),
+            numDecoded(0),
+            numFailed(0),
+            numShared(0),
+            numTails(0),
+            numFull(0),
+            uploadedBytes(0),
+            lastUploadBytes(0),
+            tailsTime(-1.0f),
+            fullTime(-1.0f)
+        {
+        }
+    };
+
+    TextureStreamer(WorkerPool &pool, DecodeFunc decode, UploadFunc upload) :
+        m_pool(pool),
+        m_decode(decode),
+        m_upload(upload),
+        m_uploadBudget(4 * 1024 * 1024),
+        m_tailSize(32),
+        m_cancel(False)
+    {
+    }
+
+    ~TextureStreamer()
+    {
+        cancel();
+    }
+
+    //! Bytes of full levels uploaded per update, at least one level is always uploaded.
+    void setUploadBudget(UInt64 bytes) { m_uploadBudget = bytes; }
+    //! Maximal side of the mip tail level.
+    void setTailSize(UInt32 texels) { m_tailSize = std::max<UInt32>(texels, 1); }
+
+    UInt32 getTailSize() const { return m_tailSize; }
+
+    /**
+     * @brief Request a texture.
+     * @param fileName File given to the decode function.
+     * @param priority Higher first.
+     * @return Id of the request given back to the upload function.
+     */
+    UInt32 add(const std::string &fileName, Float priority)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_requests.empty()) {
+            m_start = std::chrono::steady_clock::now();
+        }
+
+        Request request;
+        request.fileName = fileName;
+        request.priority = priority;
+        m_requests.push_back(request);
+
+        ++m_stats.numRequests;
+
+        const UInt32 id = UInt32(m_requests.size() - 1);
+
+        m_pool.submit([this] () { decodeNext(); });
+
+        return id;
+    }
+
+    //! Change the priority of a request, taken into account until its upload.
+    void setPriority(UInt32 id, Float priority)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (id < m_requests.size()) {
+            m_requests[id].priority = priority;
+        }
+    }
+
+    //! Raise the priority of a request to at least a value, for a texture shared by several users.
+    void raisePriority(UInt32 id, Float priority)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if ((id < m_requests.size()) && (priority > m_requests[id].priority)) {
+            m_requests[id].priority = priority;
+        }
+    }
+
+    /**
+     * @brief Upload the decoded levels, to call on the thread owning the textures.
+     * First every decoded tail, then the full levels by priority within the budget.
+     */
+    void update()
+    {
+        std::vector<UInt32> tails, fulls;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            for (UInt32 i = 0; i < m_requests.size(); ++i) {
+                const Request &request = m_requests[i];
+                if (request.state == STATE_DECODED) {
+                    tails.push_back(i);
+                } else if (request.state == STATE_TAIL) {
+                    fulls.push_back(i);
+                }
+            }
+        }
+
+        // the decoded requests are no longer touched by the workers
+        auto byPriority = [this] (UInt32 a, UInt32 b) {
+            return m_requests[a].priority > m_requests[b].priority;
+        };
+
+        std::sort(tails.begin(), tails.end(), byPriority);
+        std::sort(fulls.begin(), fulls.end(), byPriority);
+
+        UInt64 uploadBytes = 0;
+        size_t numFulls = 0;
+
+        for (UInt32 id : tails) {
+            Request &request = m_requests[id];
+
+            m_upload(id, request.tail, False);
+            uploadBytes += request.tail.getBytes();
+            request.tail = TextureLevel();
+        }
+
+        // the full levels of the tails of this update wait for the next one
+        UInt64 fullBytes = 0;
+
+        for (; numFulls < fulls.size(); ++numFulls) {
+            Request &request = m_requests[fulls[numFulls]];
+
+            if ((fullBytes > 0) && (fullBytes + request.full.getBytes() > m_uploadBudget)) {
+                break;
+            }
+
+            m_upload(fulls[numFulls], request.full, True);
+            fullBytes += request.full.getBytes();
+            request.full = TextureLevel();
+        }
+
+        uploadBytes += fullBytes;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (UInt32 id : tails) {
+            m_requests[id].state = STATE_TAIL;
+        }
+
+        for (size_t i = 0; i < numFulls; ++i) {
+            m_requests[fulls[i]].state = STATE_FULL;
+        }
+
+        m_stats.numTails += UInt32(tails.size());
+        m_stats.numFull += UInt32(numFulls);
+        m_stats.lastUploadBytes = uploadBytes;
+        m_stats.uploadedBytes += uploadBytes;
+
+        const UInt32 numDone = m_stats.numFailed;
+
+        if ((m_stats.tailsTime < 0.0f) && (m_stats.numTails + numDone == m_stats.numRequests) && m_stats.numRequests) {
+            m_stats.tailsTime = elapsed();
+        }
+
+        if ((m_stats.fullTime < 0.0f) && (m_stats.numFull + numDone == m_stats.numRequests) && m_stats.numRequests) {
+            m_stats.fullTime = elapsed();
+        }
+    }
+
+    //! True once every request is at full quality or failed.
+    Bool isDone() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats.numFull + m_stats.numFailed == m_stats.numRequests;
+    }
+
+    //! Stop the decoding of the pending requests, and wait for the running ones.
+    void cancel()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cancel = True;
+        }
+
+        m_pool.waitIdle();
+    }
+
+    Stats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+private:
+
+    enum State
+    {
+        STATE_PENDING = 0,
+        STATE_DECODING,
+        STATE_DECODED,    //!< Both levels ready.
+        STATE_TAIL,       //!< Tail uploaded, full level ready.
+        STATE_FULL,       //!< Full level uploaded.
+        STATE_FAILED
+    };
+
+    struct Request
+    {
+        std::string fileName;
+        Float priority;
+        State state;
+        TextureLevel tail;
+        TextureLevel full;
+
+        Request() : priority(0.0f), state(STATE_PENDING) {}
+    };
+
+    WorkerPool &m_pool;
+    DecodeFunc m_decode;
+    UploadFunc m_upload;
+
+    UInt64 m_uploadBudget;
+    UInt32 m_tailSize;
+
+    mutable std::mutex m_mutex;
+    std::vector<Request> m_requests;   //!< Only grows, the ids are indices.
+    Bool m_cancel;
+
+    std::chrono::steady_clock::time_point m_start;
+    Stats m_stats;
+
+    Float elapsed() const
+    {
+        return std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+    //! Decode the pending request of highest priority, one job per request.
+    void decodeNext()
+    {
+        std::string fileName;
+        UInt32 id = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (m_cancel) {
+                return;
+            }
+
+            Float best = 0.0f;
+            Bool found = False;
+
+            for (UInt32 i = 0; i < m_requests.size(); ++i) {
+                const Request &request = m_requests[i];
+                if ((request.state == STATE_PENDING) && (!found || (request.priority > best))) {
+                    best = request.priority;
+                    id = i;
+                    found = True;
+                }
+            }
+
+            if (!found) {
+                return;
+            }
+
+            m_requests[id].state = STATE_DECODING;
+            fileName = m_requests[id].fileName;
+        }
+
+        TextureLevel full, tail;
+        const auto decodeStart = std::chrono::steady_clock::now();
+
+        const Bool decoded = m_decode(fileName, full, tail);
+        const Bool shared = decoded && !full.width && full.data.empty();
+        const Bool valid = decoded && full.isComplete() &&
+                           (tail.width ? tail.isComplete() : (!full.blockBytes && (full.getNumLevels() == 1)));
+
+        full.decodeTime = std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - decodeStart).count();
+
+        if (valid && !tail.width) {
+            // mip tail, a copy if the texture is already small
+            tail = full;
+            while ((tail.width > m_tailSize) || (tail.height > m_tailSize)) {
+                TextureLevel half;
+                tail.halve(half);
+                tail = std::move(half);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // the vector may have grown, the request is looked up again
+        Request &request = m_requests[id];
+
+        if (shared) {
+            request.state = STATE_FULL;
+            ++m_stats.numShared;
+            ++m_stats.numTails;
+            ++m_stats.numFull;
+        } else if (valid) {
+            request.full = std::move(full);
+            request.tail = std::move(tail);
+            request.state = STATE_DECODED;
+            ++m_stats.numDecoded;
+        } else {
+            request.state = STATE_FAILED;
+            ++m_stats.numFailed;
+        }
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_TEXTURESTREAMER_H
@@ -0,0 +1,681 @@
+/**
+ * @file tiledimage.h
+ * @brief Tiled mip pyramid file of an image, and tile streaming under a memory cap.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_TILEDIMAGE_H
+#define _O3DSAMPLES_TILEDIMAGE_H
+
+#include <o3d/core/base.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+namespace o3dsamples {
+
+using namespace o3d;
+
+/**
+ * @brief Layout of a tiled image file.
+ * A header, the offsets of every tile of every level (level by level, row by row),
+ * then the tiles. Level 0 is the full resolution, each next level halves the size
+ * (rounded up) until the whole image fits a single tile. Every tile has the full
+ * tile size, the texels past the image border repeat the last row and column.
+ * The texels are stored raw, format is a value given by the writer (the engine pixel
+ * format for the samples).
+ */
+struct TiledImageHeader
+{
+    char magic[8];
+    UInt32 version;
+    UInt32 width;
+    UInt32 height;
+    UInt32 texelSize;      //!< Bytes per texel.
+    UInt32 format;         //!< Opaque pixel format.
+    UInt32 tileSize;       //!< Width and height of a tile in texels.
+    UInt32 numLevels;
+    UInt32 reserved;
+
+    static const char* getMagic() { return "O3DTILES"; }
+    static UInt32 getVersion() { return 1; }
+
+    UInt32 getLevelWidth(UInt32 level) const { return std::max<UInt32>(((width - 1) >> level) + 1, 1); }
+    UInt32 getLevelHeight(UInt32 level) const { return std::max<UInt32>(((height - 1) >> level) + 1, 1); }
+    UInt32 getTilesX(UInt32 level) const { return (getLevelWidth(level) + tileSize - 1) / tileSize; }
+    UInt32 getTilesY(UInt32 level) const { return (getLevelHeight(level) + tileSize - 1) / tileSize; }
+    UInt64 getTileBytes() const { return UInt64(tileSize) * tileSize * texelSize; }
+
+    //! Index of the first tile of a level in the offsets table.
+    UInt32 getFirstTile(UInt32 level) const
+    {
+        UInt32 first = 0;
+        for (UInt32 l = 0; l < level; ++l) {
+            first += getTilesX(l) * getTilesY(l);
+        }
+
+        return first;
+    }
+
+    //! Number of levels down to a single tile.
+    static UInt32 computeNumLevels(UInt32 width, UInt32 height, UInt32 tileSize)
+    {
+        UInt32 numLevels = 1;
+        while (std::max(width, height) > tileSize) {
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+            ++numLevels;
+        }
+
+        return numLevels;
+    }
+};
+
+/**
+ * @brief Write a tiled image from its rows, top to bottom.
+ * Only a strip of a tile height is kept per level: every row is copied to the strip of
+ * level 0, and every two rows of a level give a box filtered row of the next level. A
+ * strip is written as a row of tiles once full, so the memory used is about two strips
+ * of the level 0 width, whatever the height of the image.
+ */
+class TiledImageWriter
+{
+public:
+
+    TiledImageWriter() :
+        m_file(nullptr),
+        m_ok(False),
+        m_position(0)
+    {
+        memset(&m_header, 0, sizeof(TiledImageHeader));
+    }
+
+    ~TiledImageWriter()
+    {
+        if (m_file) {
+            fclose(m_file);
+        }
+    }
+
+    /**
+     * @brief Create the file.
+     * @param path File name.
+     * @param width Width of the image.
+     * @param height Height of the image.
+     * @param texelSize Bytes per texel.
+     * @param format Opaque pixel format, returned by the reader.
+     * @param tileSize Width and height of a tile.
+     */
+    Bool open(const char *path, UInt32 width, UInt32 height, UInt32 texelSize, UInt32 format, UInt32 tileSize = 256)
+    {
+        if (m_file || !width || !height || !texelSize || !tileSize) {
+            return False;
+        }
+
+        memcpy(m_header.magic, TiledImageHeader::getMagic(), 8);
+        m_header.version = TiledImageHeader::getVersion();
+        m_header.width = width;
+        m_header.height = height;
+        m_header.texelSize = texelSize;
+        m_header.format = format;
+        m_header.tileSize = tileSize;
+        m_header.numLevels = TiledImageHeader::computeNumLevels(width, height, tileSize);
+
+        m_levels.resize(m_header.numLevels);
+        for (UInt32 l = 0; l < m_header.numLevels; ++l) {
+            Level &level = m_levels[l];
+            level.width = m_header.getLevelWidth(l);
+            level.height = m_header.getLevelHeight(l);
+            level.strip.assign(size_t(tileSize) * level.width * texelSize, 0);
+            level.pending.resize(size_t(level.width) * texelSize);
+            level.down.resize(l + 1 < m_header.numLevels ? size_t(m_header.getLevelWidth(l + 1)) * texelSize : 0);
+            level.stripRows = 0;
+            level.tileRow = 0;
+            level.rows = 0;
+            level.hasPending = False;
+        }
+
+        m_offsets.assign(m_header.getFirstTile(m_header.numLevels), 0);
+        m_tile.resize(size_t(m_header.getTileBytes()));
+
+        m_file = fopen(path, "wb");
+        if (!m_file) {
+            return False;
+        }
+
+        // the offsets are known at the end, the table is written again by close
+        m_ok = fwrite(&m_header, sizeof(TiledImageHeader), 1, m_file) == 1;
+        m_ok = m_ok && (fwrite(m_offsets.data(), sizeof(UInt64), m_offsets.size(), m_file) == m_offsets.size());
+        m_position = sizeof(TiledImageHeader) + m_offsets.size() * sizeof(UInt64);
+
+        return m_ok;
+    }
+
+    /**
+     * @brief Add rows to the image.
+     * @param rows count rows of width texels, contiguous.
+     * @param count Number of rows.
+     */
+    Bool writeRows(const UInt8 *rows, UInt32 count)
+    {
+        if (!m_file) {
+            return False;
+        }
+
+        const size_t pitch = size_t(m_header.width) * m_header.texelSize;
+
+        for (UInt32 i = 0; (i < count) && (m_levels[0].rows < m_header.height); ++i) {
+            pushRow(0, rows + i * pitch);
+        }
+
+        return m_ok;
+    }
+
+    //! Write the table and close the file. Every row must have been given.
+    Bool close()
+    {
+        if (!m_file) {
+            return False;
+        }
+
+        m_ok = m_ok && (m_levels[0].rows == m_header.height);
+        m_ok = m_ok && (fseek(m_file, long(sizeof(TiledImageHeader)), SEEK_SET) == 0);
+        m_ok = m_ok && (fwrite(m_offsets.data(), sizeof(UInt64), m_offsets.size(), m_file) == m_offsets.size());
+        m_ok = (fclose(m_file) == 0) && m_ok;
+        m_file = nullptr;
+
+        return m_ok;
+    }
+
+    const TiledImageHeader& getHeader() const { return m_header; }
+
+private:
+
+    struct Level
+    {
+        UInt32 width;
+        UInt32 height;
+        std::vector<UInt8> strip;     //!< Rows of the current row of tiles.
+        std::vector<UInt8> pending;   //!< Even row waiting for its pair.
+        std::vector<UInt8> down;      //!< Filtered row given to the next level.
+        UInt32 stripRows;
+        UInt32 tileRow;
+        UInt32 rows;                  //!< Rows received.
+        Bool hasPending;
+    };
+
+    TiledImageHeader m_header;
+    FILE *m_file;
+    Bool m_ok;
+    UInt64 m_position;
+
+    std::vector<Level> m_levels;
+    std::vector<UInt64> m_offsets;
+    std::vector<UInt8> m_tile;
+
+    void pushRow(UInt32 l, const UInt8 *row)
+    {
+        Level &level = m_levels[l];
+        const UInt32 texelSize = m_header.texelSize;
+        const size_t pitch = size_t(level.width) * texelSize;
+
+        memcpy(&level.strip[level.stripRows * pitch], row, pitch);
+        ++level.stripRows;
+        ++level.rows;
+
+        if ((level.stripRows == m_header.tileSize) || (level.rows == level.height)) {
+            writeStrip(l);
+        }
+
+        if (l + 1 >= m_header.numLevels) {
+            return;
+        }
+
+        if (!level.hasPending && (level.rows < level.height)) {
+            memcpy(level.pending.data(), row, pitch);
+            level.hasPending = True;
+            return;
+        }
+
+        // an odd last row is paired with itself
+        const UInt8 *even = level.hasPending ? level.pending.data() : row;
+        level.hasPending = False;
+
+        UInt8 *next = level.down.data();
+
+        for (UInt32 x = 0; x < m_levels[l + 1].width; ++x) {
+            const UInt32 x0 = x * 2;
+            const UInt32 x1 = std::min(x0 + 1, level.width - 1);
+
+            for (UInt32 c = 0; c < texelSize; ++c) {
+                const UInt32 sum = even[x0 * texelSize + c] + even[x1 * texelSize + c] +
+                                   row[x0 * texelSize + c] + row[x1 * texelSize + c];
+                next[x * texelSize + c] = UInt8((sum + 2) / 4);
+            }
+        }
+
+        pushRow(l + 1, next);
+    }
+
+    void writeStrip(UInt32 l)
+    {
+        Level &level = m_levels[l];
+        const UInt32 tileSize = m_header.tileSize;
+        const UInt32 texelSize = m_header.texelSize;
+        const size_t pitch = size_t(level.width) * texelSize;
+        const UInt32 tilesX = m_header.getTilesX(l);
+        const UInt32 first = m_header.getFirstTile(l) + level.tileRow * tilesX;
+
+        for (UInt32 tx = 0; tx < tilesX; ++tx) {
+            const UInt32 x0 = tx * tileSize;
+            const UInt32 columns = std::min(tileSize, level.width - x0);
+
+            for (UInt32 y = 0; y < tileSize; ++y) {
+                // the border rows and columns are repeated
+                const UInt8 *src = &level.strip[std::min(y, level.stripRows - 1) * pitch + size_t(x0) * texelSize];
+                UInt8 *dst = &m_tile[size_t(y) * tileSize * texelSize];
+
+                memcpy(dst, src, size_t(columns) * texelSize);
+                for (UInt32 x = columns; x < tileSize; ++x) {
+                    memcpy(dst + size_t(x) * texelSize, src + size_t(columns - 1) * texelSize, texelSize);
+                }
+            }
+
+            m_offsets[first + tx] = m_position;
+            m_ok = m_ok && (fwrite(m_tile.data(), 1, m_tile.size(), m_file) == m_tile.size());
+            m_position += m_tile.size();
+        }
+
+        level.stripRows = 0;
+        ++level.tileRow;
+    }
+};
+
+/**
+ * @brief Read access to the tiles of a tiled image file. readTile can be called from
+ * several threads.
+ */
+class TiledImage
+{
+public:
+
+    TiledImage() :
+        m_file(nullptr)
+    {
+        memset(&m_header, 0, sizeof(TiledImageHeader));
+    }
+
+    ~TiledImage()
+    {
+        close();
+    }
+
+    //! Open a file and read its table. Returns False if missing or invalid.
+    Bool open(const char *path)
+    {
+        close();
+
+        m_file = fopen(path, "rb");
+        if (!m_file) {
+            return False;
+        }
+
+        Bool ok = (fread(&m_header, sizeof(TiledImageHeader), 1, m_file) == 1) &&
+                  (memcmp(m_header.magic, TiledImageHeader::getMagic(), 8) == 0) &&
+                  (m_header.version == TiledImageHeader::getVersion()) &&
+                  m_header.width && m_header.height && m_header.texelSize && m_header.tileSize &&
+                  (m_header.numLevels == TiledImageHeader::computeNumLevels(m_header.width, m_header.height, m_header.tileSize));
+
+        if (ok) {
+            m_offsets.resize(m_header.getFirstTile(m_header.numLevels));
+            ok = fread(m_offsets.data(), sizeof(UInt64), m_offsets.size(), m_file) == m_offsets.size();
+        }
+
+        if (!ok) {
+            close();
+        }
+
+        return ok;
+    }
+
+    void close()
+    {
+        if (m_file) {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+
+        m_offsets.clear();
+    }
+
+    Bool isOpen() const { return m_file != nullptr; }
+
+    const TiledImageHeader& getHeader() const { return m_header; }
+
+    //! Read a tile of getHeader().getTileBytes() bytes.
+    Bool readTile(UInt32 level, UInt32 tx, UInt32 ty, UInt8 *out) const
+    {
+        if (!m_file || (level >= m_header.numLevels) ||
+            (tx >= m_header.getTilesX(level)) || (ty >= m_header.getTilesY(level))) {
+            return False;
+        }
+
+        const UInt64 offset = m_offsets[m_header.getFirstTile(level) + ty * m_header.getTilesX(level) + tx];
+        const size_t bytes = size_t(m_header.getTileBytes());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return seek(m_file, offset) && (fread(out, 1, bytes, m_file) == bytes);
+    }
+
+private:
+
+    TiledImageHeader m_header;
+    FILE *m_file;
+    std::vector<UInt64> m_offsets;
+
+    mutable std::mutex m_mutex;
+
+    //! Seek from the start of the file. fseek takes a long, 32 bits on Windows and on
+    //! 32 bits targets, while the tiles of a large image are past 2 GB.
+    static Bool seek(FILE *file, UInt64 offset)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, __int64(offset), SEEK_SET) == 0;
+#else
+        static_assert(sizeof(off_t) >= 8, "build with _FILE_OFFSET_BITS=64");
+        return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+    }
+};
+
+/**
+ * @brief Keep the tiles around a position resident, under a memory cap.
+ * - At each level the tiles within the radius of the tile of the position are wanted,
+ *   so the area covered doubles per level. The single tile of the coarsest level is
+ *   always wanted.
+ * - The wanted tiles are ranked coarsest level first, then nearest first. The cap
+ *   keeps the first ones, the remaining are counted as capped: a tight cap loses the
+ *   finest levels far from the position first.
+ * - At most a number of tiles are read per update, to bound its time. A tile no longer
+ *   wanted stays resident until its memory is needed, the least recently wanted first.
+ */
+class TileStreamer
+{
+public:
+
+    struct Stats
+    {
+        UInt64 residentBytes;       //!< Bytes of the resident tiles.
+        UInt64 peakResidentBytes;   //!< Highest resident bytes since the start.
+        UInt32 numResident;         //!< Resident tiles.
+        UInt32 numPending;          //!< Wanted tiles kept by the cap but not yet read.
+        UInt32 numCapped;           //!< Wanted tiles dropped by the cap.
+        UInt32 numLoaded;           //!< Total tiles read.
+        UInt32 numEvicted;          //!< Total tiles released.
+        Float lastUpdateTime;       //!< Milliseconds of the last update.
+    };
+
+    TileStreamer(const TiledImage &image) :
+        m_image(image),
+        m_memoryCap(0),
+        m_radius(1),
+        m_maxLoads(8),
+        m_updateCount(0)
+    {
+        m_stats = Stats();
+    }
+
+    //! Memory cap in bytes for the resident tiles (0 means no cap).
+    void setMemoryCap(UInt64 bytes) { m_memoryCap = bytes; }
+    //! Tiles kept on each side of the tile of the position, at each level (default 1).
+    void setRadius(UInt32 tiles) { m_radius = tiles; }
+    //! Tiles read per update at most (default 8, 0 means no limit).
+    void setMaxLoadsPerUpdate(UInt32 count) { m_maxLoads = count; }
+
+    /**
+     * @brief Update the resident tiles.
+     * @param x Position on the width, in level 0 texels.
+     * @param y Position on the height, in level 0 texels.
+     */
+    void update(Float x, Float y)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const TiledImageHeader &header = m_image.getHeader();
+
+        if (!m_image.isOpen()) {
+            return;
+        }
+
+        ++m_updateCount;
+
+        // wanted tiles, coarsest level first then nearest first
+        m_wanted.clear();
+
+        for (Int32 l = Int32(header.numLevels) - 1; l >= 0; --l) {
+            const Float scale = 1.0f / Float(UInt64(header.tileSize) << l);
+            const Int32 cx = Int32(std::floor(x * scale));
+            const Int32 cy = Int32(std::floor(y * scale));
+            const Int32 tilesX = Int32(header.getTilesX(l));
+            const Int32 tilesY = Int32(header.getTilesY(l));
+            const Int32 radius = Int32(m_radius);
+
+            const size_t first = m_wanted.size();
+
+            for (Int32 ty = std::max(cy - radius, 0); ty <= std::min(cy + radius, tilesY - 1); ++ty) {
+                for (Int32 tx = std::max(cx - radius, 0); tx <= std::min(cx + radius, tilesX - 1); ++tx) {
+                    Wanted wanted;
+                    wanted.key = makeKey(l, tx, ty);
+                    wanted.distance = std::max(std::abs(tx - cx), std::abs(ty - cy));
+                    m_wanted.push_back(wanted);
+                }
+            }
+
+            std::stable_sort(m_wanted.begin() + first, m_wanted.end(), [] (const Wanted &a, const Wanted &b) {
+                return a.distance < b.distance;
+            });
+        }
+
+        // the cap keeps the first ones
+        const UInt64 tileBytes = header.getTileBytes();
+        const size_t maxTiles = m_memoryCap ? std::max<size_t>(size_t(m_memoryCap / tileBytes), 1) : std::numeric_limits<size_t>::max();
+        const size_t numKept = std::min(m_wanted.size(), maxTiles);
+
+        m_stats.numCapped = UInt32(m_wanted.size() - numKept);
+
+        for (size_t i = 0; i < numKept; ++i) {
+            auto it = m_tiles.find(m_wanted[i].key);
+            if (it != m_tiles.end()) {
+                it->second.lastWanted = m_updateCount;
+            }
+        }
+
+        UInt32 numLoads = 0;
+        m_stats.numPending = 0;
+
+        for (size_t i = 0; i < numKept; ++i) {
+            const UInt64 key = m_wanted[i].key;
+            if (m_tiles.find(key) != m_tiles.end()) {
+                continue;
+            }
+
+            if ((m_maxLoads && (numLoads >= m_maxLoads)) || !makeRoom(maxTiles)) {
+                ++m_stats.numPending;
+                continue;
+            }
+
+            Tile &tile = m_tiles[key];
+            tile.data.resize(size_t(tileBytes));
+            tile.lastWanted = m_updateCount;
+
+            if (!m_image.readTile(getLevel(key), getTileX(key), getTileY(key), tile.data.data())) {
+                m_tiles.erase(key);
+                continue;
+            }
+
+            ++numLoads;
+            ++m_stats.numLoaded;
+        }
+
+        m_stats.numResident = UInt32(m_tiles.size());
+        m_stats.residentBytes = m_tiles.size() * tileBytes;
+        m_stats.peakResidentBytes = std::max(m_stats.peakResidentBytes, m_stats.residentBytes);
+        m_stats.lastUpdateTime = std::chrono::duration<Float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    //! A resident tile, or nullptr.
+    const UInt8* getTile(UInt32 level, UInt32 tx, UInt32 ty) const
+    {
+        auto it = m_tiles.find(makeKey(level, tx, ty));
+        return it != m_tiles.end() ? it->second.data.data() : nullptr;
+    }
+
+    /**
+     * @brief Texel at a position from the finest resident level.
+     * @return The level used, or -1 if no tile covers the position.
+     */
+    Int32 sample(UInt32 x, UInt32 y, UInt8 *out) const
+    {
+        const TiledImageHeader &header = m_image.getHeader();
+
+        for (UInt32 l = 0; l < header.numLevels; ++l) {
+            const UInt32 lx = std::min(x >> l, header.getLevelWidth(l) - 1);
+            const UInt32 ly = std::min(y >> l, header.getLevelHeight(l) - 1);
+
+            const UInt8 *tile = getTile(l, lx / header.tileSize, ly / header.tileSize);
+            if (tile) {
+                const size_t texel = (size_t(ly % header.tileSize) * header.tileSize + lx % header.tileSize) * header.texelSize;
+                memcpy(out, tile + texel, header.texelSize);
+                return Int32(l);
+            }
+        }
+
+        return -1;
+    }
+
+    /**
+     * @brief Copy a window of a level, rows of width texels. The texels out of the level
+     * repeat its border. Resident tiles are used, the others are read without being kept.
+     * @return Number of tiles read from the file.
+     */
+    UInt32 compose(UInt32 level, Int32 x0, Int32 y0, UInt32 width, UInt32 height, UInt8 *out) const
+    {
+        const TiledImageHeader &header = m_image.getHeader();
+        const UInt32 tileSize = header.tileSize;
+        const UInt32 texelSize = header.texelSize;
+        const Int32 levelWidth = Int32(header.getLevelWidth(level));
+        const Int32 levelHeight = Int32(header.getLevelHeight(level));
+
+        std::vector<UInt8> scratch(size_t(header.getTileBytes()));
+        UInt64 scratchKey = ~UInt64(0);
+        UInt32 numRead = 0;
+
+        for (UInt32 y = 0; y < height; ++y) {
+            const UInt32 ly = UInt32(std::min(std::max(y0 + Int32(y), 0), levelHeight - 1));
+
+            for (UInt32 x = 0; x < width; ++x) {
+                const UInt32 lx = UInt32(std::min(std::max(x0 + Int32(x), 0), levelWidth - 1));
+                const UInt64 key = makeKey(level, lx / tileSize, ly / tileSize);
+
+                auto it = m_tiles.find(key);
+                const UInt8 *tile = nullptr;
+
+                if (it != m_tiles.end()) {
+                    tile = it->second.data.data();
+                } else {
+                    if (scratchKey != key) {
+                        scratchKey = key;
+                        if (m_image.readTile(level, lx / tileSize, ly / tileSize, scratch.data())) {
+                            ++numRead;
+                        } else {
+                            memset(scratch.data(), 0, scratch.size());
+                        }
+                    }
+
+                    tile = scratch.data();
+                }
+
+                memcpy(out + (size_t(y) * width + x) * texelSize,
+                       tile + (size_t(ly % tileSize) * tileSize + lx % tileSize) * texelSize,
+                       texelSize);
+            }
+        }
+
+        return numRead;
+    }
+
+    const Stats& getStats() const { return m_stats; }
+
+private:
+
+    struct Tile
+    {
+        std::vector<UInt8> data;
+        UInt32 lastWanted;    //!< Last update where the tile was kept.
+    };
+
+    struct Wanted
+    {
+        UInt64 key;
+        Int32 distance;
+    };
+
+    const TiledImage &m_image;
+
+    UInt64 m_memoryCap;
+    UInt32 m_radius;
+    UInt32 m_maxLoads;
+    UInt32 m_updateCount;
+
+    std::unordered_map<UInt64, Tile> m_tiles;
+    std::vector<Wanted> m_wanted;
+
+    Stats m_stats;
+
+    static UInt64 makeKey(UInt32 level, UInt32 tx, UInt32 ty) { return (UInt64(level) << 48) | (UInt64(ty) << 24) | tx; }
+    static UInt32 getLevel(UInt64 key) { return UInt32(key >> 48); }
+    static UInt32 getTileX(UInt64 key) { return UInt32(key & 0xffffff); }
+    static UInt32 getTileY(UInt64 key) { return UInt32((key >> 24) & 0xffffff); }
+
+    //! Release the least recently wanted tiles not kept by this update, for one more tile.
+    Bool makeRoom(size_t maxTiles)
+    {
+        while (m_tiles.size() >= maxTiles) {
+            auto victim = m_tiles.end();
+
+            for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+                if ((it->second.lastWanted != m_updateCount) &&
+                    ((victim == m_tiles.end()) || (it->second.lastWanted < victim->second.lastWanted))) {
+                    victim = it;
+                }
+            }
+
+            if (victim == m_tiles.end()) {
+                return False;
+            }
+
+            m_tiles.erase(victim);
+            ++m_stats.numEvicted;
+        }
+
+        return True;
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_TILEDIMAGE_H
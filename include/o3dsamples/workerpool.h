@@ -0,0 +1,211 @@
+/**
+ * @file workerpool.h
+ * @brief Small pool of worker threads for the CPU side jobs of the samples.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#ifndef _O3DSAMPLES_WORKERPOOL_H
+#define _O3DSAMPLES_WORKERPOOL_H
+
+#include <o3d/core/base.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace o3dsamples {
+
+using namespace o3d;
+
+/**
+ * @brief Pool of worker threads.
+ * - parallelFor splits a range into chunks processed by the workers and by the
+ *   calling thread, and returns once every chunk is done.
+ * - submit queues a background job, waitIdle waits for the queue to be empty and
+ *   every job to be finished.
+ * Jobs must not throw. The pool must not be destroyed from one of its jobs.
+ */
+class WorkerPool
+{
+public:
+
+    typedef std::function<void(UInt32 begin, UInt32 end)> RangeFunc;
+
+    /**
+     * @brief Constructor.
+     * @param numWorkers Number of worker threads. 0 means one less than the number of
+     * hardware threads, the calling thread taking its part into parallelFor.
+     */
+    WorkerPool(UInt32 numWorkers = 0) :
+        m_running(0),
+        m_quit(False)
+    {
+        if (numWorkers == 0) {
+            const UInt32 hw = std::thread::hardware_concurrency();
+            numWorkers = hw > 1 ? hw - 1 : 1;
+        }
+
+        for (UInt32 i = 0; i < numWorkers; ++i) {
+            m_workers.emplace_back(&WorkerPool::run, this);
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = True;
+        }
+
+        m_wakeUp.notify_all();
+
+        for (std::thread &worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    //! Number of worker threads.
+    UInt32 getNumWorkers() const { return static_cast<UInt32>(m_workers.size()); }
+
+    //! Queue a background job.
+    void submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+
+        m_wakeUp.notify_one();
+    }
+
+    //! Wait until every submitted job is finished.
+    void waitIdle()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_jobs.empty() && (m_running == 0); });
+    }
+
+    /**
+     * @brief Process the range [0, count) by chunks of grain elements in parallel.
+     * @param count Number of elements.
+     * @param grain Elements per chunk (at least 1).
+     * @param func Called with the bounds of each chunk, from any thread.
+     */
+    void parallelFor(UInt32 count, UInt32 grain, const RangeFunc &func)
+    {
+        if (count == 0) {
+            return;
+        }
+
+        grain = grain ? grain : 1;
+        const UInt32 numChunks = (count + grain - 1) / grain;
+
+        if ((numChunks == 1) || m_workers.empty()) {
+            func(0, count);
+            return;
+        }
+
+        // the state is shared with the helper jobs, which can start after the end of the call
+        std::shared_ptr<Range> range = std::make_shared<Range>();
+        range->func = &func;
+        range->count = count;
+        range->grain = grain;
+        range->numChunks = numChunks;
+        range->next = 0;
+        range->done = 0;
+
+        const UInt32 numHelpers = std::min<UInt32>(getNumWorkers(), numChunks - 1);
+        for (UInt32 i = 0; i < numHelpers; ++i) {
+            submit([range] () { processRange(*range); });
+        }
+
+        processRange(*range);
+
+        std::unique_lock<std::mutex> lock(range->mutex);
+        range->finished.wait(lock, [&range] { return range->done.load() == range->numChunks; });
+    }
+
+private:
+
+    struct Range
+    {
+        const RangeFunc *func;
+        UInt32 count;
+        UInt32 grain;
+        UInt32 numChunks;
+        std::atomic<UInt32> next;
+        std::atomic<UInt32> done;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_jobs;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::condition_variable m_idle;
+
+    UInt32 m_running;
+    Bool m_quit;
+
+    static void processRange(Range &range)
+    {
+        UInt32 chunk;
+        while ((chunk = range.next.fetch_add(1)) < range.numChunks) {
+            const UInt32 begin = chunk * range.grain;
+            const UInt32 end = std::min(begin + range.grain, range.count);
+
+            (*range.func)(begin, end);
+
+            if (range.done.fetch_add(1) + 1 == range.numChunks) {
+                std::lock_guard<std::mutex> lock(range.mutex);
+                range.finished.notify_all();
+            }
+        }
+    }
+
+    void run()
+    {
+        for (;;) {
+            std::function<void()> job;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeUp.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+
+                if (m_jobs.empty()) {
+                    return;
+                }
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+                ++m_running;
+            }
+
+            job();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                --m_running;
+
+                if (m_jobs.empty() && (m_running == 0)) {
+                    m_idle.notify_all();
+                }
+            }
+        }
+    }
+};
+
+} // namespace o3dsamples
+
+#endif // _O3DSAMPLES_WORKERPOOL_H
@@ -0,0 +1,185 @@
+/**
+ * @file instancebench.cpp
+ * @brief Headless instancing benchmark, draw calls before and after grouping.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/string.h>
+
+#include <o3dsamples/instancing.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief A scene of props sharing a few meshes and materials (rocks, trees, crates) and
+ * of unique objects, drawn by an ambient and a light pass. The draw commands are
+ * recorded per visibility cell and sorted, then grouped into instanced draws, one after
+ * the other and then on a pool, the best of a few runs being kept. The instance buffer
+ * is checked against the transforms of the objects.
+ * @date 2026-10-19
+ */
+class InstanceBench
+{
+public:
+
+    static Int32 main()
+    {
+        std::vector<Object> objects;
+        std::vector<Float> transforms;
+        buildScene(objects, transforms);
+
+        WorkerPool pool;
+        DrawCommands commands;
+
+        const UInt32 perBucket = NUM_OBJECTS / NUM_BUCKETS;
+
+        commands.record(NUM_BUCKETS, [&objects, perBucket] (UInt32 bucket, std::vector<DrawItem> &items) {
+            for (UInt32 i = bucket * perBucket; i < (bucket + 1) * perBucket; ++i) {
+                for (UInt32 pass = 0; pass < NUM_PASSES; ++pass) {
+                    DrawItem item;
+                    item.pass = pass;
+                    item.material = objects[i].material;
+                    item.texture = objects[i].material;
+                    item.mesh = objects[i].mesh;
+                    item.object = i;
+                    item.key = DrawKey::opaque(pass, item.material, item.texture, item.mesh, objects[i].depth);
+
+                    items.push_back(item);
+                }
+            }
+        }, &pool);
+
+        commands.sort();
+
+        InstanceBatcher batcher;
+        Float serialTime = 0.0f, parallelTime = 0.0f;
+
+        for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+            Int64 timer = System::getTime();
+            batcher.build(commands, transforms.data());
+            serialTime = best(r, serialTime, elapsed(timer));
+
+            timer = System::getTime();
+            batcher.build(commands, transforms.data(), &pool);
+            parallelTime = best(r, parallelTime, elapsed(timer));
+        }
+
+        // every instance must have the transform of its object
+        const std::vector<Float> &instances = batcher.getInstances();
+        for (UInt32 i = 0; i < commands.getNumItems(); ++i) {
+            const size_t object = commands.getItem(i).object;
+
+            for (UInt32 c = 0; c < InstanceBatcher::TRANSFORM_SIZE; ++c) {
+                if (instances[i * InstanceBatcher::TRANSFORM_SIZE + c] != transforms[object * InstanceBatcher::TRANSFORM_SIZE + c]) {
+                    Application::message(String::print("Wrong transform for the instance %u", i), "Error");
+                    return -1;
+                }
+            }
+        }
+
+        const InstanceBatcher::Stats &stats = batcher.getStats();
+        const DrawCommands::Stats states = commands.countStateChanges();
+
+        Application::message(String::print("%u objects (%u props of %u meshes and %u materials, %u unique), %u passes",
+                                           NUM_OBJECTS, NUM_OBJECTS - NUM_UNIQUE, NUM_PROP_MESHES, NUM_MATERIALS,
+                                           NUM_UNIQUE, NUM_PASSES), "Bench");
+        Application::message(String::print("draw calls: %u before grouping, %u after (x%.1f), %u instanced of up to %u instances",
+                                           stats.numCommands, stats.numBatches, Float(stats.numCommands) / Float(stats.numBatches),
+                                           stats.numInstanced, stats.maxInstances), "Bench");
+        Application::message(String::print("state changes of the sorted commands: %u", states.getNumStateChanges()), "Bench");
+        Application::message(String::print("grouping and instance buffer (%.1f KB): %.2f ms one by one, %.2f ms on %u workers",
+                                           batcher.getInstanceBytes() / 1024.f, serialTime, parallelTime,
+                                           pool.getNumWorkers() + 1), "Bench");
+
+        return 0;
+    }
+
+private:
+
+    static const UInt32 NUM_OBJECTS = 40960;
+    static const UInt32 NUM_UNIQUE = 4096;        //!< Objects with their own mesh.
+    static const UInt32 NUM_BUCKETS = 64;
+    static const UInt32 NUM_PROP_MESHES = 16;
+    static const UInt32 NUM_MATERIALS = 8;
+    static const UInt32 NUM_PASSES = 2;
+    static const UInt32 NUM_RUNS = 5;
+
+    struct Object
+    {
+        UInt32 mesh;
+        UInt32 material;
+        Float depth;
+    };
+
+    //! Props and unique objects mixed over the cells, with a rotation about Y.
+    static void buildScene(std::vector<Object> &objects, std::vector<Float> &transforms)
+    {
+        UInt32 seed = 15;
+        auto random = [&seed] () {
+            seed = seed * 1664525u + 1013904223u;
+            return seed >> 8;
+        };
+
+        objects.resize(NUM_OBJECTS);
+        transforms.resize(size_t(NUM_OBJECTS) * InstanceBatcher::TRANSFORM_SIZE);
+
+        UInt32 numUnique = 0;
+
+        for (UInt32 i = 0; i < NUM_OBJECTS; ++i) {
+            Object &object = objects[i];
+
+            if ((numUnique < NUM_UNIQUE) && (random() % (NUM_OBJECTS / NUM_UNIQUE) == 0)) {
+                object.mesh = NUM_PROP_MESHES + numUnique++;
+            } else {
+                object.mesh = random() % NUM_PROP_MESHES;
+            }
+
+            object.material = object.mesh < NUM_PROP_MESHES ? object.mesh % NUM_MATERIALS : random() % NUM_MATERIALS;
+
+            const Float x = Float(random() % 100000) / 100.0f - 500.0f;
+            const Float z = Float(random() % 100000) / 100.0f - 500.0f;
+            const Float angle = Float(random() % 6283) / 1000.0f;
+
+            object.depth = std::sqrt(x * x + z * z) / 710.0f;
+
+            Float *m = &transforms[size_t(i) * InstanceBatcher::TRANSFORM_SIZE];
+            m[0] = std::cos(angle); m[1] = 0.0f; m[2] = std::sin(angle); m[3] = x;
+            m[4] = 0.0f; m[5] = 1.0f; m[6] = 0.0f; m[7] = 0.0f;
+            m[8] = -std::sin(angle); m[9] = 0.0f; m[10] = std::cos(angle); m[11] = z;
+        }
+    }
+
+    static Float elapsed(Int64 timer)
+    {
+        return (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+    }
+
+    static Float best(UInt32 run, Float current, Float time)
+    {
+        return (run == 0) || (time < current) ? time : current;
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(InstanceBench, MyAppSettings)
@@ -36,6 +36,7 @@
 #include <o3d/engine/object/meshdatamanager.h>
 
 #include <o3d/engine/texture/texturemanager.h>
+#include <o3d/image/image.h>
 #include <o3d/engine/material/lambertmaterial.h>
 #include <o3d/engine/material/ambientmaterial.h>
 #include <o3d/engine/material/pickingmaterial.h>
@@ -57,6 +58,8 @@
 #include <o3d/engine/object/light.h>
 #include <o3d/engine/lodstrategy.h>
 #include <o3d/engine/renderer.h>
+#include <o3d/engine/glextdefines.h>
+#include <o3d/engine/glextensionmanager.h>
 
 #include <o3d/core/localfile.h>
 #include <o3d/core/wintools.h>
@@ -70,6 +73,20 @@
 #include <o3d/physic/forcemanager.h>
 #include <o3d/physic/physicentitymanager.h>
 
+#include <o3dsamples/bakedtexture.h>
+#include <o3dsamples/framecapture.h>
+#include <o3dsamples/framerecorder.h>
+#include <o3dsamples/imagecodec.h>
+#include <o3dsamples/texturecache.h>
+#include <o3dsamples/texturestreamer.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 #define LIGHT1
 #define LIGHT2
 #define LIGHT3
@@ -77,6 +94,7 @@
 #define SYMBOLIC
 
 using namespace o3d;
+using namespace o3dsamples;
 
 class KeyMapping
 {
@@ -182,9 +200,56 @@ private:
     Gui *m_gui;
     AutoPtr<KeyMapping> m_keys;
 
+    //! Textures decoded in the background, placeholders until their upload.
+    //! A texture per slot of the cache, and the slot of each request of the streamer.
+    WorkerPool m_texturePool;
+    AutoPtr<TextureStreamer> m_textureStreamer;
+    TextureCache m_textureCache;
+    std::vector<Texture2D*> m_streamedTextures;
+    std::vector<UInt32> m_streamedSlots;
+    std::vector<UInt32> m_textureRefs;      //!< A slot per reference taken, released on destroy.
+
+    //! Slots found by their content to be a loaded slot, with that slot, queued by the
+    //! decoding for the draw thread, see reuseTextures. The last full level of each
+    //! uploaded slot is kept for them until the full quality.
+    std::mutex m_reusedMutex;
+    std::vector<std::pair<UInt32, UInt32>> m_reusedSlots;
+    std::map<UInt32, TextureLevel> m_loadedLevels;
+
+    //! A user of a streamed texture, its request takes the priority of its largest user.
+    struct StreamedUse
+    {
+        UInt32 request;
+        Float area;           //!< Half width by half height on the screen, in pixels, when faced.
+        Vector3 direction;    //!< Normalized direction from the camera, the users are at infinity.
+    };
+
+    std::vector<StreamedUse> m_streamedUses;
+
+    //! Screenshots of the feedback viewport or of the back buffer, read back a frame
+    //! later and encoded by a single worker, so two captures never write their files at
+    //! the same time. The back buffer is read into its own staging buffer, kept.
+    WorkerPool m_capturePool;
+    AutoPtr<FrameCapture> m_frameCapture;
+    std::vector<UInt8> m_backBuffer;
+
+    //! Recording of the feedback viewport (F4), null when not recording.
+    std::unique_ptr<FrameRecorder> m_frameRecorder;
+
+    Int64 m_startTime;
+    Float m_firstFrameTime;     //!< Seconds from the start to the first frame, -1 before.
+    Bool m_fullQuality;
+
+    static const UInt64 TEXTURE_UPLOAD_BUDGET = 1024 * 1024;   //!< Bytes of full levels per frame.
+    static const UInt32 RECORD_INTERVAL = 2;                   //!< Record one frame out of two.
+
 public:
 
-    Ms3dSample(Dir &basePath)
+    Ms3dSample(Dir &basePath) :
+        m_capturePool(1),
+        m_startTime(System::getTime()),
+        m_firstFrameTime(-1.0f),
+        m_fullQuality(False)
 	{
         m_keys = new KeyMapAzerty;
 
@@ -523,6 +588,56 @@ public:
         // Use the next line to enable asynchronous texture loading
         //getScene()->getTextureManager()->enableAsynchronous();
 
+        // the lens flare textures are streamed, by screen size, see streamTexture
+        m_textureStreamer = new TextureStreamer(
+                                m_texturePool,
+                                [this] (const std::string &fileName, TextureLevel &full, TextureLevel &tail) {
+                                    return decodeTexture(fileName, full, tail);
+                                },
+                                [this] (UInt32 id, const TextureLevel &level, Bool final) {
+                                    const UInt32 lSlot = m_streamedSlots[id];
+
+                                    if (final && !m_fullQuality) {
+                                        m_loadedLevels[lSlot] = level;
+                                    }
+
+                                    // the slots of a copy of the file take the same levels
+                                    std::vector<UInt32> lSlots = final ?
+                                        m_textureCache.setLoaded(lSlot, level.getBytes(), level.decodeTime) :
+                                        m_textureCache.getDelivered(lSlot);
+                                    lSlots.push_back(lSlot);
+
+                                    for (UInt32 lTarget : lSlots) {
+                                        uploadTexture(m_streamedTextures[lTarget], level, final);
+                                    }
+                                });
+
+        m_textureStreamer->setUploadBudget(TEXTURE_UPLOAD_BUDGET);
+
+        // F2 screenshots, see captureFrame
+        m_frameCapture = new FrameCapture(
+                             m_capturePool,
+                             [] (const CaptureFrame &frame) {
+                                 Image image;
+                                 image.loadBuffer(frame.width, frame.height, UInt32(frame.data.size()),
+                                                  PixelFormat(frame.format), frame.data.data());
+
+                                 ImageCodecLock lock;
+                                 return image.save("feedback.png", Image::PNG) &&
+                                        image.save("feedback.jpg", Image::JPEG);
+                             },
+                             [] (const CaptureResult &result) {
+                                 if (result.valid) {
+                                     System::print(String::print("Screenshot %u saved, %ux%u, read back %u frame(s) later "
+                                                                 "in %.2f ms on the draw thread (synchronous map), "
+                                                                 "encoded in %.1f ms in the background",
+                                                                 result.id, result.width, result.height, result.delay,
+                                                                 result.readbackTime, result.encodeTime), "Action");
+                                 } else {
+                                     System::print(String::print("Screenshot %u failed", result.id), "Action");
+                                 }
+                             });
+
         //
         // import the dwarf1.ms3d
         //
@@ -651,19 +766,24 @@ public:
         getGui()->getWidgetManager()->setDefaultTheme(theme);
 
         //
-        // finally, why not to add a simple skybox ?
+        // finally, why not to add a simple skybox ? its faces are streamed like the
+        // flares, a face in front of the camera covers the whole viewport
         //
 
+        Int32 lViewPort[4];
+        getScene()->getContext()->getViewPort(lViewPort);
+        const Float lFaceArea = (lViewPort[2] / 2.f) * (lViewPort[3] / 2.f);
+
         SkyBox *skyBox = new SkyBox(getScene());
         skyBox->setName("skyBox");
         skyBox->create(
                 2048.f,
-                "sky01_xp.jpg",
-                "sky01_xn.jpg",
-                "sky01_yp.jpg",
-                "", // no Y down
-                "sky01_zp.jpg",
-                "sky01_zn.jpg",
+                streamTexture(basePath, "sky01_xp.jpg", lFaceArea, Vector3(1.f, 0.f, 0.f)),
+                streamTexture(basePath, "sky01_xn.jpg", lFaceArea, Vector3(-1.f, 0.f, 0.f)),
+                streamTexture(basePath, "sky01_yp.jpg", lFaceArea, Vector3(0.f, 1.f, 0.f)),
+                nullptr, // no Y down
+                streamTexture(basePath, "sky01_zp.jpg", lFaceArea, Vector3(0.f, 0.f, 1.f)),
+                streamTexture(basePath, "sky01_zn.jpg", lFaceArea, Vector3(0.f, 0.f, -1.f)),
                 True,
                 Texture::TRILINEAR_ANISOTROPIC,
                 4.f);
@@ -673,6 +793,8 @@ public:
         // and a marvelous lens flare ?
         //
 
+        const Vector3 lSunDirection(0.f, 0.5f, -1.0f);
+
         LensFlareModel lensFlareModel;
 
         lensFlareModel.setSizeX(10.0f);
@@ -686,7 +808,7 @@ public:
         lensFlareModel.setSimpleOcclusion(False);
 
         // flare0
-        lensFlareModel.addFlare(getScene()->getTextureManager()->addTexture2D("Flare5.bmp", True),0,0,0);
+        lensFlareModel.addFlare(streamTexture(basePath, "Flare5.bmp", 7.0f * 7.0f, lSunDirection),0,0,0);
         lensFlareModel.getFlare(0)->color.set(0.8f, 0.6f, 0.2f, 0.6f);
         lensFlareModel.getFlare(0)->halfSizeX = 7.0f;
         lensFlareModel.getFlare(0)->halfSizeY = 7.0f;
@@ -694,7 +816,7 @@ public:
         lensFlareModel.getFlare(0)->attenuationRange = 1.0f;
 
         // flare1
-        lensFlareModel.addFlare(getScene()->getTextureManager()->addTexture2D("Flare1.bmp", True),0,0,0);
+        lensFlareModel.addFlare(streamTexture(basePath, "Flare1.bmp", 5.0f * 5.0f, lSunDirection),0,0,0);
         lensFlareModel.getFlare(1)->color.set(0.2f, 0.6f, 1.0f, 1.0f);
         lensFlareModel.getFlare(1)->halfSizeX = 5.0f;
         lensFlareModel.getFlare(1)->halfSizeY = 5.0f;
@@ -702,14 +824,14 @@ public:
         lensFlareModel.getFlare(1)->attenuationRange = 1.0f;
 
         // flare2
-        lensFlareModel.addFlare(getScene()->getTextureManager()->addTexture2D("Flare6.bmp", True),0,0,0);
+        lensFlareModel.addFlare(streamTexture(basePath, "Flare6.bmp", 10.0f * 10.0f, lSunDirection),0,0,0);
         lensFlareModel.getFlare(2)->color.set(0.5f, 0.8f, 0.2f, 0.9f);
         lensFlareModel.getFlare(2)->halfSizeX = 10.0f;
         lensFlareModel.getFlare(2)->halfSizeY = 10.0f;
         lensFlareModel.getFlare(2)->position = 0.4f;
 
         // flare3
-        lensFlareModel.addFlare(getScene()->getTextureManager()->addTexture2D("Flare2.bmp", True),0,0,0);
+        lensFlareModel.addFlare(streamTexture(basePath, "Flare2.bmp", 5.0f * 5.0f, lSunDirection),0,0,0);
         lensFlareModel.getFlare(3)->color.set(0.9f, 0.4f, 0.1f, 1.0f);
         lensFlareModel.getFlare(3)->halfSizeX = 5.0f;
         lensFlareModel.getFlare(3)->halfSizeY = 5.0f;
@@ -717,7 +839,7 @@ public:
         lensFlareModel.getFlare(3)->attenuationRange = 1.0f;
 
         // flare4
-        lensFlareModel.addFlare(getScene()->getTextureManager()->addTexture2D("Flare2.bmp", True),0,0,0);
+        lensFlareModel.addFlare(streamTexture(basePath, "Flare2.bmp", 5.0f * 5.0f, lSunDirection),0,0,0);
         lensFlareModel.getFlare(4)->color.set(1.0f, 1.0f, 0.1f, 1.0f);
         lensFlareModel.getFlare(4)->halfSizeX = 5.0f;
         lensFlareModel.getFlare(4)->halfSizeY = 5.0f;
@@ -725,7 +847,7 @@ public:
         lensFlareModel.getFlare(4)->attenuationRange = 1.0f;
 
         // flare5
-        lensFlareModel.addFlare(getScene()->getTextureManager()->addTexture2D("Flare2.bmp", True),0,0,0);
+        lensFlareModel.addFlare(streamTexture(basePath, "Flare2.bmp", 4.0f * 4.0f, lSunDirection),0,0,0);
         lensFlareModel.getFlare(5)->color.set(1.0f, 0.7f, 0.1f, 1.0f);
         lensFlareModel.getFlare(5)->halfSizeX = 4.0f;
         lensFlareModel.getFlare(5)->halfSizeY = 4.0f;
@@ -733,7 +855,7 @@ public:
         lensFlareModel.getFlare(5)->attenuationRange = 1.0f;
 
         // flare6
-        lensFlareModel.addFlare(getScene()->getTextureManager()->addTexture2D("Flare4.bmp", True),0,0,0);
+        lensFlareModel.addFlare(streamTexture(basePath, "Flare4.bmp", 7.5f * 7.5f, lSunDirection),0,0,0);
         lensFlareModel.getFlare(6)->color.set(1.0f, 0.5f, 0.1f, 0.4f);
         lensFlareModel.getFlare(6)->halfSizeX = 7.5f;
         lensFlareModel.getFlare(6)->halfSizeY = 7.5f;
@@ -741,7 +863,7 @@ public:
         lensFlareModel.getFlare(6)->attenuationRange = 1.0f;
 
         // flare7
-        lensFlareModel.addFlare(getScene()->getTextureManager()->addTexture2D("Flare2.bmp", True),0,0,0);
+        lensFlareModel.addFlare(streamTexture(basePath, "Flare2.bmp", 4.5f * 4.5f, lSunDirection),0,0,0);
         lensFlareModel.getFlare(7)->color.set(0.0f, 0.5f, 1.0f, 1.0f);
         lensFlareModel.getFlare(7)->halfSizeX = 4.5f;
         lensFlareModel.getFlare(7)->halfSizeY = 4.5f;
@@ -749,7 +871,7 @@ public:
         lensFlareModel.getFlare(7)->attenuationRange = 1.0f;
 
         // flare8
-        lensFlareModel.addFlare(getScene()->getTextureManager()->addTexture2D("Flare5.bmp", True),0,0,0);
+        lensFlareModel.addFlare(streamTexture(basePath, "Flare5.bmp", 3.0f * 3.0f, lSunDirection),0,0,0);
         lensFlareModel.getFlare(8)->color.set(1.0f, 1.0f, 0.0f, 1.0f);
         lensFlareModel.getFlare(8)->halfSizeX = 3.0f;
         lensFlareModel.getFlare(8)->halfSizeY = 3.0f;
@@ -757,7 +879,7 @@ public:
         lensFlareModel.getFlare(8)->attenuationRange = 1.0f;
 
         // flare9
-        lensFlareModel.addFlare(getScene()->getTextureManager()->addTexture2D("Flare2.bmp", True),0,0,0);
+        lensFlareModel.addFlare(streamTexture(basePath, "Flare2.bmp", 7.5f * 7.5f, lSunDirection),0,0,0);
         lensFlareModel.getFlare(9)->color.set(1.0f, 0.5f, 0.5f, 1.0f);
         lensFlareModel.getFlare(9)->halfSizeX = 7.5f;
         lensFlareModel.getFlare(9)->halfSizeY = 7.5f;
@@ -765,7 +887,7 @@ public:
         lensFlareModel.getFlare(9)->attenuationRange = 1.0f;
 
         // glow0
-        lensFlareModel.addGlow(getScene()->getTextureManager()->addTexture2D("Flare1.bmp", True),0,0,0);
+        lensFlareModel.addGlow(streamTexture(basePath, "Flare1.bmp", 35.0f * 35.0f, lSunDirection),0,0,0);
         lensFlareModel.getGlow(0)->color.set(0.9f,0.9f,0.32f,1.0f);
         lensFlareModel.getGlow(0)->halfSizeX = 35.0f;
         lensFlareModel.getGlow(0)->halfSizeY = 35.0f;
@@ -774,7 +896,7 @@ public:
         lensFlareModel.getGlow(0)->isBehindEffect = True;
 
         // glow1
-        lensFlareModel.addGlow(getScene()->getTextureManager()->addTexture2D("Flare1.bmp", True),0,0,0);
+        lensFlareModel.addGlow(streamTexture(basePath, "Flare1.bmp", 40.0f * 40.0f, lSunDirection),0,0,0);
         lensFlareModel.getGlow(1)->color.set(0.85f,0.85f,0.3f,0.5f);
         lensFlareModel.getGlow(1)->halfSizeX = 40.0f;
         lensFlareModel.getGlow(1)->halfSizeY = 40.0f;
@@ -782,7 +904,7 @@ public:
         lensFlareModel.getGlow(1)->isBehindEffect = False;
 
         // glow2
-        lensFlareModel.addGlow(getScene()->getTextureManager()->addTexture2D("Shine7.bmp", True),0,0,0);
+        lensFlareModel.addGlow(streamTexture(basePath, "Shine7.bmp", 90.f * 90.f, lSunDirection),0,0,0);
         lensFlareModel.getGlow(2)->color.set(1.0f,0.85f,0.32f,0.4f);
         lensFlareModel.getGlow(2)->halfSizeX = 90.f;
         lensFlareModel.getGlow(2)->halfSizeY = 90.f;
@@ -790,7 +912,7 @@ public:
         lensFlareModel.getGlow(2)->isBehindEffect = False;
 
         // glow3
-        lensFlareModel.addGlow(getScene()->getTextureManager()->addTexture2D("Flare1.bmp", True),0,0,0);
+        lensFlareModel.addGlow(streamTexture(basePath, "Flare1.bmp", 150.0f * 100.0f, lSunDirection),0,0,0);
         lensFlareModel.getGlow(3)->color.set(0.95f,0.95f,0.32f,0.7f);
         lensFlareModel.getGlow(3)->halfSizeX = 150.0f;
         lensFlareModel.getGlow(3)->halfSizeY = 100.0f;
@@ -801,7 +923,7 @@ public:
         lensEffect->setName("sunLensFlare");
         getScene()->getSpecialEffectsManager()->addSpecialEffects(lensEffect);
 
-        lensEffect->setDirection(Vector3(0.f,0.5f,-1.0f));
+        lensEffect->setDirection(lSunDirection);
 
         //getScene()->exportScene(basePath.makeFullFileName("models"), SceneIO());
 	}
@@ -819,6 +941,29 @@ public:
             return;
         }
 
+        // no more decoding nor upload to the textures of the scene
+        m_textureStreamer->cancel();
+
+        // the references taken for the reused textures not handled yet
+        for (const std::pair<UInt32, UInt32> &lReuse : m_reusedSlots) {
+            m_textureRefs.push_back(lReuse.second);
+        }
+
+        m_reusedSlots.clear();
+
+        // the textures themselves are deleted with the scene by the texture manager
+        for (UInt32 lSlot : m_textureRefs) {
+            if (m_textureCache.release(lSlot)) {
+                m_streamedTextures[lSlot] = nullptr;
+            }
+        }
+
+        m_textureRefs.clear();
+
+        // the screenshots being encoded are still saved, and the recorded frames
+        m_frameCapture->wait();
+        m_frameRecorder.reset();
+
         deletePtr(m_scene);
         deletePtr(m_glRenderer);
 
@@ -900,6 +1045,43 @@ public:
 
 	void onSceneDraw()
 	{
+        if (!m_fullQuality) {
+            updateTexturePriorities();
+        }
+
+        m_textureStreamer->update();
+        reuseTextures();
+        captureFrame();
+        recordFrame();
+
+        if (m_firstFrameTime < 0.0f) {
+            m_firstFrameTime = (Float)(System::getTime() - m_startTime) / (Float)System::getTimeFrequency();
+            System::print(String::print("First frame in %.2f s", m_firstFrameTime), "ms3d");
+        }
+
+        if (!m_fullQuality && m_textureStreamer->isDone()) {
+            const TextureStreamer::Stats lStats = m_textureStreamer->getStats();
+
+            System::print(String::print("Full quality in %.2f s, %u textures (%u failed), every mip tail after %.1f ms, "
+                                        "full levels after %.1f ms, %.1f KB uploaded",
+                                        (Float)(System::getTime() - m_startTime) / (Float)System::getTimeFrequency(),
+                                        lStats.numRequests, lStats.numFailed, lStats.tailsTime, lStats.fullTime,
+                                        lStats.uploadedBytes / 1024.f), "ms3d");
+
+            const TextureCache::Stats lCacheStats = m_textureCache.getStats();
+
+            System::print(String::print("Texture cache: %u requests, %u loaded, %u shared by path, %u by content, "
+                                        "%.1f KB and %.2f ms saved, %.2f ms hashing on the pool",
+                                        lCacheStats.numRequests, lCacheStats.numLoads,
+                                        lCacheStats.numPathHits, lCacheStats.numContentHits,
+                                        lCacheStats.savedBytes / 1024.f, lCacheStats.savedTime,
+                                        lCacheStats.hashTime), "ms3d");
+
+            // every request is resolved, no texture is reused any more
+            m_loadedLevels.clear();
+            m_fullQuality = True;
+        }
+
 		// Check for a hit
         if (getScene()->getPicking()->getSingleHit()) {
 			// Dynamic cast to scene object, or you can use two static_cast.
@@ -1111,26 +1293,16 @@ public:
 		}
 
         if (event.isPressed() && (event.key() == KEY_F2)) {
-            FeedbackViewPort *vp = o3d::dynamicCast<FeedbackViewPort*>(getScene()->getViewPortManager()->getViewPort(2));
-            if (vp->getActivity()) {
-                // feedback-viewport used by GBuffer capture
-                Image im;
-                const UInt8 *d = vp->mapData();
-                if (d) {
-                    im.loadBuffer(vp->getDataWidth(), vp->getDataHeight(), vp->getDataSize(), vp->getPixelFormat(), d);
-                    im.vFlip();
-                    im.save("feedback.png", Image::PNG);
-                    im.save("feedback.jpg", Image::JPEG);
-                }
-                vp->unmapData();
-            } else {
-                // back-buffer standard screen-shot
-                m_glRenderer->screenShot("feedback.png", Image::PNG, 255, True);
-                m_glRenderer->screenShot("feedback.jpg", Image::JPEG, 255);
-            }
-            System::print("Take a screenshot using the feeback viewport", "Action");
+            // the feedback viewport used by the GBuffer, or else the back buffer, read back
+            // at the next frame and encoded in the background
+            m_frameCapture->request();
+            System::print("Take a screenshot", "Action");
 		}
 
+        if (event.isPressed() && (event.key() == KEY_F4)) {
+            toggleRecording();
+        }
+
         if (event.isPressed() && (event.key() == KEY_ESCAPE)) {
             System::print("Terminate", "Action");
 			getWindow()->terminate();
@@ -1211,6 +1383,334 @@ public:
 		m_animationPlayer = player;
 	}
 
+    /**
+     * @brief Read back the due screenshot, at most one per frame, from the feedback
+     * viewport when it is active, else from the back buffer of the frame just drawn.
+     * The map, or the read of the pixels, is a synchronous read back, it and the copy of
+     * the texels are done here, the flip and the encoding are left to the capture pool.
+     */
+    void captureFrame()
+    {
+        m_frameCapture->update();
+
+        if (!m_frameCapture->isReadbackDue()) {
+            return;
+        }
+
+        const Int64 lStart = System::getTime();
+
+        FeedbackViewPort *vp = o3d::dynamicCast<FeedbackViewPort*>(getScene()->getViewPortManager()->getViewPort(2));
+        if (!vp->getActivity()) {
+            Int32 lViewPort[4];
+            getScene()->getContext()->getViewPort(lViewPort);
+
+            const UInt32 lWidth = UInt32(std::max(lViewPort[2], 0));
+            const UInt32 lHeight = UInt32(std::max(lViewPort[3], 0));
+
+            m_backBuffer.resize(size_t(lWidth) * lHeight * 4);
+            if (!m_backBuffer.empty()) {
+                glReadPixels(lViewPort[0], lViewPort[1], lWidth, lHeight, GL_RGBA, GL_UNSIGNED_BYTE, m_backBuffer.data());
+            }
+
+            const Float lReadTime = (Float)(System::getTime() - lStart) * 1000.f / (Float)System::getTimeFrequency();
+
+            m_frameCapture->submit(m_backBuffer.empty() ? nullptr : m_backBuffer.data(), lWidth, lHeight, 4,
+                                   UInt32(PF_RGBA_8), lReadTime);
+            return;
+        }
+
+        const UInt8 *d = vp->mapData();
+        const UInt32 lNumTexels = vp->getDataWidth() * vp->getDataHeight();
+
+        const Float lMapTime = (Float)(System::getTime() - lStart) * 1000.f / (Float)System::getTimeFrequency();
+
+        m_frameCapture->submit(d, vp->getDataWidth(), vp->getDataHeight(),
+                               lNumTexels ? vp->getDataSize() / lNumTexels : 0,
+                               UInt32(vp->getPixelFormat()), lMapTime);
+
+        vp->unmapData();
+    }
+
+    /**
+     * @brief Start or stop the recording of the feedback viewport into numbered JPEG
+     * files, record_00000.jpg and so on. The stop waits for the frames still queued.
+     */
+    void toggleRecording()
+    {
+        if (m_frameRecorder.get()) {
+            m_frameRecorder->stop();
+
+            const FrameRecorder::Stats lStats = m_frameRecorder->getStats();
+            System::print(String::print("Recording stopped, %u frames written, %u dropped, %u failed, "
+                                        "copy %.3f ms/frame (max %.3f ms), encode %.1f ms/frame",
+                                        lStats.numEncoded, lStats.numDropped, lStats.numFailed,
+                                        lStats.numQueued ? lStats.pushTime / lStats.numQueued : 0.0f, lStats.maxPushTime,
+                                        lStats.numEncoded ? lStats.encodeTime / lStats.numEncoded : 0.0f), "Action");
+
+            m_frameRecorder.reset();
+            return;
+        }
+
+        FeedbackViewPort *vp = o3d::dynamicCast<FeedbackViewPort*>(getScene()->getViewPortManager()->getViewPort(2));
+        if (!vp->getActivity()) {
+            System::print("Recording needs the feedback viewport (F3)", "Action");
+            return;
+        }
+
+        m_frameRecorder.reset(new FrameRecorder(
+                                  [] (const CaptureFrame &frame, UInt32) {
+                                      Image image;
+                                      image.loadBuffer(frame.width, frame.height, UInt32(frame.data.size()),
+                                                       PixelFormat(frame.format), frame.data.data());
+
+                                      ImageCodecLock lock;
+                                      return image.save(String::print("record_%05u.jpg", frame.id), Image::JPEG);
+                                  },
+                                  2, 4, RECORD_INTERVAL));
+
+        System::print(String::print("Recording one frame out of %u", RECORD_INTERVAL), "Action");
+    }
+
+    //! Queue the feedback viewport to the recorder, or drop it if the encoders are late.
+    void recordFrame()
+    {
+        if (!m_frameRecorder.get() || !m_frameRecorder->isFrameDue()) {
+            return;
+        }
+
+        FeedbackViewPort *vp = o3d::dynamicCast<FeedbackViewPort*>(getScene()->getViewPortManager()->getViewPort(2));
+        if (!vp->getActivity()) {
+            return;
+        }
+
+        const UInt8 *d = vp->mapData();
+        const UInt32 lNumTexels = vp->getDataWidth() * vp->getDataHeight();
+
+        m_frameRecorder->push(d, vp->getDataWidth(), vp->getDataHeight(),
+                              lNumTexels ? vp->getDataSize() / lNumTexels : 0,
+                              UInt32(vp->getPixelFormat()));
+
+        vp->unmapData();
+    }
+
+    /**
+     * @brief Decode a streamed texture, on a worker. The file baked by texturebaker from
+     * the same content of the source is preferred: the full level and the mip tail are
+     * read with their mip chains, raw or BC1, and uploaded as they are.
+     */
+    Bool decodeTexture(const std::string &fileName, TextureLevel &full, TextureLevel &tail)
+    {
+        // the content of the file is hashed here, a missing file counts as failed, a copy
+        // of a file being decoded is given its levels by the upload of the original, and a
+        // copy of a file already uploaded takes its texture
+        Bool lShared = False;
+        const UInt32 lSlot = m_textureCache.resolve(fileName, lShared);
+
+        if (lSlot == TextureCache::INVALID_SLOT) {
+            return False;
+        }
+
+        if (lShared) {
+            const UInt32 lPathSlot = m_textureCache.getSlot(fileName);
+
+            if (lSlot != lPathSlot) {
+                std::lock_guard<std::mutex> lLock(m_reusedMutex);
+                m_reusedSlots.push_back(std::make_pair(lPathSlot, lSlot));
+            }
+
+            return True;
+        }
+
+        // a baked file of another content of the source is stale, the source is decoded
+        UInt64 lHash = 0, lSize = 0;
+        BakedTexture lBaked;
+
+        if (m_textureCache.getContent(lSlot, lHash, lSize) &&
+            lBaked.load(BakedTexture::getFileName(fileName).c_str()) &&
+            lBaked.isBakedFrom(lHash, lSize)) {
+            const BakedTextureHeader &lHeader = lBaked.getHeader();
+
+            // the tail starts at the first level that fits in the tail size
+            UInt32 lTailLevel = 0;
+            while ((lTailLevel + 1 < lHeader.numLevels) &&
+                   ((lHeader.getLevelWidth(lTailLevel) > m_textureStreamer->getTailSize()) ||
+                    (lHeader.getLevelHeight(lTailLevel) > m_textureStreamer->getTailSize()))) {
+                ++lTailLevel;
+            }
+
+            const UInt32 lFirst[2] = { 0, lTailLevel };
+            TextureLevel *lTargets[2] = { &full, &tail };
+
+            for (UInt32 i = 0; i < 2; ++i) {
+                TextureLevel &lLevel = *lTargets[i];
+                const UInt32 lLast = lHeader.numLevels - 1;
+
+                lLevel.width = lHeader.getLevelWidth(lFirst[i]);
+                lLevel.height = lHeader.getLevelHeight(lFirst[i]);
+                lLevel.texelSize = lHeader.format == BakedTextureHeader::FORMAT_RGBA8 ? 4 : 3;
+                lLevel.blockBytes = lHeader.format == BakedTextureHeader::FORMAT_BC1 ? 8 : 0;
+                lLevel.format = lHeader.sourceFormat;
+
+                // the levels follow each other in the file
+                lLevel.data.assign(lBaked.getLevelData(lFirst[i]), lBaked.getLevelData(lLast) + lBaked.getLevelSize(lLast));
+
+                for (UInt32 l = lFirst[i]; l <= lLast; ++l) {
+                    lLevel.offsets.push_back(size_t(lHeader.offsets[l] - lHeader.offsets[lFirst[i]]));
+                }
+            }
+
+            return True;
+        }
+
+        Image lImage;
+        {
+            ImageCodecLock lLock;
+            if (!lImage.load(String(fileName.c_str())) || !lImage.isValid()) {
+                return False;
+            }
+        }
+
+        full.width = lImage.getWidth();
+        full.height = lImage.getHeight();
+        full.texelSize = lImage.getBpp() / 8;
+        full.format = UInt32(lImage.getPixelFormat());
+        full.data.assign(lImage.getData(), lImage.getData() + size_t(full.width) * full.height * full.texelSize);
+
+        return True;
+    }
+
+    /**
+     * @brief Upload a streamed level. A level given with its mip chain, as from a baked
+     * file, is uploaded level by level without any mipmap generation, the BC1 blocks
+     * as they are. A single level generates its mipmaps once it is the final one.
+     */
+    void uploadTexture(Texture2D *texture, const TextureLevel &level, Bool final)
+    {
+        const PixelFormat lFormat = level.blockBytes ? PF_RGB_DXT1 : (level.texelSize == 4 ? PF_RGBA_8 : PF_RGB_8);
+        const PixelFormat lDataFormat = level.blockBytes ? PF_RGB_DXT1 : PixelFormat(level.format);
+
+        if (level.getNumLevels() == 1) {
+            texture->create(final && !level.blockBytes, level.width, level.height, lFormat,
+                            level.getLevelData(0), lDataFormat);
+            return;
+        }
+
+        texture->create(False, level.width, level.height, lFormat, level.getLevelData(0), lDataFormat);
+
+        for (UInt32 l = 1; l < level.getNumLevels(); ++l) {
+            texture->update(level.getLevelData(l), 0, 0, level.getLevelWidth(l), level.getLevelHeight(l), lDataFormat, l);
+        }
+    }
+
+    /**
+     * @brief The slots resolved to a loaded slot of the same content take its texture for
+     * their next requests. Their placeholder, already given to the scene, is given the
+     * kept level of that slot, without decoding it again.
+     */
+    void reuseTextures()
+    {
+        std::vector<std::pair<UInt32, UInt32>> lReused;
+
+        {
+            std::lock_guard<std::mutex> lLock(m_reusedMutex);
+            lReused.swap(m_reusedSlots);
+        }
+
+        for (const std::pair<UInt32, UInt32> &lReuse : lReused) {
+            // the reference taken by resolve, released on destroy
+            m_textureRefs.push_back(lReuse.second);
+
+            auto it = m_loadedLevels.find(lReuse.second);
+            if (it != m_loadedLevels.end()) {
+                uploadTexture(m_streamedTextures[lReuse.first], it->second, True);
+            }
+
+            m_streamedTextures[lReuse.first] = m_streamedTextures[lReuse.second];
+        }
+    }
+
+    /**
+     * @brief The pending textures go by their screen size, scaled down the further their
+     * users are from the view axis, so the sky faces and the flares in front of the camera
+     * come first and the ones behind it last.
+     */
+    void updateTexturePriorities()
+    {
+        SceneObject *lpCamera = getScene()->getSceneObjectManager()->searchName("Camera");
+        if (!lpCamera) {
+            return;
+        }
+
+        // the camera looks toward -Z
+        const Vector3 lView = -lpCamera->getAbsoluteMatrix().getZ();
+
+        std::vector<Float> lPriorities(m_streamedSlots.size(), 0.0f);
+
+        for (const StreamedUse &lUse : m_streamedUses) {
+            const Float lFacing = lView[X] * lUse.direction[X] + lView[Y] * lUse.direction[Y] + lView[Z] * lUse.direction[Z];
+            const Float lPriority = lUse.area * (1.0f + lFacing) * 0.5f;
+
+            lPriorities[lUse.request] = std::max(lPriorities[lUse.request], lPriority);
+        }
+
+        for (UInt32 i = 0; i < lPriorities.size(); ++i) {
+            m_textureStreamer->setPriority(i, lPriorities[i]);
+        }
+    }
+
+    /**
+     * @brief Texture streamed from media/textures. It is an invisible texel until its mip
+     * tail and then its full level are decoded and uploaded. The requests of the same
+     * file, or of a copy of it, share their texture and their decoding.
+     * @param area Half width by half height of the texture on the screen when faced, the
+     * initial priority, see updateTexturePriorities.
+     * @param direction Direction of the user of the texture from the camera.
+     */
+    Texture2D* streamTexture(Dir &basePath, const String &fileName, Float area, const Vector3 &direction)
+    {
+        static const UInt8 lTransparent[4] = { 0, 0, 0, 0 };
+
+        const std::string lFile = basePath.makeFullFileName(String("textures/") + fileName).toUtf8().getData();
+
+        // by path only, the file is read by the decoding
+        Bool lLoad = False;
+        const UInt32 lSlot = m_textureCache.acquire(lFile, lLoad);
+        m_textureRefs.push_back(lSlot);
+
+        StreamedUse lUse;
+        lUse.area = area;
+        lUse.direction = direction;
+        lUse.direction.normalize();
+
+        if (!lLoad) {
+            // already requested, the streamer request of the slot takes the highest priority
+            lUse.request = UInt32(std::find(m_streamedSlots.begin(), m_streamedSlots.end(), lSlot) - m_streamedSlots.begin());
+            m_streamedUses.push_back(lUse);
+            m_textureStreamer->raisePriority(lUse.request, area);
+
+            return m_streamedTextures[lSlot];
+        }
+
+        // owned by the texture manager from here, deleted with the scene like the textures
+        // it loads itself, the streamer only keeps its pointer until the scene is deleted
+        Texture2D *lpTexture = new Texture2D(getScene());
+        lpTexture->setResourceName(fileName);
+        lpTexture->create(False, 1, 1, PF_RGBA_8, lTransparent, PF_RGBA_8);
+        getScene()->getTextureManager()->addTexture(lpTexture);
+
+        if (lSlot >= m_streamedTextures.size()) {
+            m_streamedTextures.resize(lSlot + 1, nullptr);
+        }
+
+        m_streamedTextures[lSlot] = lpTexture;
+        m_streamedSlots.push_back(lSlot);
+
+        lUse.request = m_textureStreamer->add(lFile, area);
+        m_streamedUses.push_back(lUse);
+
+        return lpTexture;
+    }
+
 private:
 
 	AnimationPlayer *m_animationPlayer;
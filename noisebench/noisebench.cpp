@@ -0,0 +1,192 @@
+/**
+ * @file noisebench.cpp
+ * @brief Headless Perlin noise generation benchmark.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/dir.h>
+#include <o3d/core/string.h>
+
+#include <o3d/image/image.h>
+#include <o3d/image/perlinnoise2d.h>
+
+#include <o3dsamples/diskcache.h>
+#include <o3dsamples/perlinnoise.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Generate the noise of the pclodterrain clouds (5 octaves, repeated boundary,
+ * positive octaves, seed 15) at the sizes 128 to 4096, with PerlinNoise2d and with the
+ * scalar, SSE2, AVX and pool paths of PerlinNoise. The paths of PerlinNoise must give
+ * the same bits as its scalar path. Then time the noise cache: first launch, next
+ * launch and an edited parameter.
+ * @date 2026-10-19
+ */
+class NoiseBench
+{
+public:
+
+    static Int32 main()
+    {
+        static const char *paths[3] = { "scalar", "SSE2", "AVX" };
+
+        WorkerPool pool;
+
+        for (UInt32 size = 128; size <= 4096; size *= 2) {
+            // current implementation, the generation and its conversion to an image
+            PerlinNoise2d reference;
+            reference.setAmplitudes(PerlinNoise2d::geometricSequence(5, 0.5f, 1.0f));
+            reference.setFrequencies(PerlinNoise2d::geometricSequence(5, 2, 4));
+            reference.setBoundaryPolicy(PerlinNoise2d::BOUNDARY_REPEAT);
+            reference.setOctaveGenerationPolicy(PerlinNoise2d::OCTAVE_POSITIVE);
+            reference.setSize(size);
+            reference.setRandomSeed(15);
+
+            Image image;
+
+            Int64 timer = System::getTime();
+            reference.toImage(image);
+            const Float referenceTime = elapsed(timer);
+
+            Application::message(String::print("size %u PerlinNoise2d: %.2fms", size, referenceTime), "Bench");
+
+            PerlinNoise noise;
+            noise.setAmplitudes(PerlinNoise::geometricSequence(5, 0.5f, 1.0f));
+            noise.setFrequencies(PerlinNoise::geometricSequence(5, 2, 4));
+            noise.setRepeat(True);
+            noise.setPositive(True);
+            noise.setSize(size);
+
+            timer = System::getTime();
+            noise.setRandomSeed(15);
+            noise.prepare();
+            const Float tableTime = elapsed(timer);
+
+            Application::message(String::print("size %u gradient tables: %.3fms, %.1fKB",
+                                               size, tableTime, noise.getTableBytes() / 1024.f), "Bench");
+
+            std::vector<Float> scalar(size_t(size) * size);
+            std::vector<Float> values(size_t(size) * size);
+
+            for (UInt32 path = PerlinNoise::PATH_SCALAR; path <= PerlinNoise::PATH_AVX; ++path) {
+                if (!PerlinNoise::hasPath(PerlinNoise::Path(path))) {
+                    Application::message(String::print("size %u %s: not compiled in", size, paths[path]), "Bench");
+                    continue;
+                }
+
+                noise.setPath(PerlinNoise::Path(path));
+
+                timer = System::getTime();
+                noise.generate(path == PerlinNoise::PATH_SCALAR ? scalar.data() : values.data());
+                const Float time = elapsed(timer);
+
+                Application::message(String::print("size %u %s: %.2fms (x%.1f) %s",
+                                                   size, paths[path], time, referenceTime / time,
+                                                   path == PerlinNoise::PATH_SCALAR ? "" :
+                                                   (same(scalar, values) ? "identical" : "DIFFERENT")), "Bench");
+            }
+
+            noise.setPath(PerlinNoise::PATH_BEST);
+
+            timer = System::getTime();
+            noise.generate(values.data(), &pool);
+            const Float time = elapsed(timer);
+
+            Application::message(String::print("size %u best on %u workers: %.2fms (x%.1f) %s",
+                                               size, pool.getNumWorkers() + 1, time, referenceTime / time,
+                                               same(scalar, values) ? "identical" : "DIFFERENT"), "Bench");
+        }
+
+        Dir cacheDir("noisebench_cache");
+        if (!cacheDir.exists()) {
+            Dir(".").makeDir("noisebench_cache");
+        }
+
+        DiskCache disk(cacheDir.getFullPathName().toUtf8().getData());
+
+        for (UInt32 size = 1024; size <= 4096; size *= 4) {
+            benchCache(disk, pool, size);
+        }
+
+        return 0;
+    }
+
+private:
+
+    static void benchCache(const DiskCache &disk, WorkerPool &pool, UInt32 size)
+    {
+        NoiseDesc desc;
+        desc.amplitudes = PerlinNoise::geometricSequence(5, 0.5f, 1.0f);
+        desc.frequencies = PerlinNoise::geometricSequence(5, 2, 4);
+        desc.repeat = True;
+        desc.positive = True;
+        desc.size = size;
+        desc.seed = 15;
+
+        NoiseDesc edited = desc;
+        edited.amplitudes[4] = 0.1f;
+
+        disk.erase(desc.getKey(), "noise");
+        disk.erase(edited.getKey(), "noise");
+
+        // first launch, generated and written
+        NoiseCache first(disk, &pool);
+        first.get(desc);
+
+        // next launch, read from the disk, then the same noise again from the memory
+        NoiseCache next(disk, &pool);
+        next.get(desc);
+
+        Int64 timer = System::getTime();
+        next.get(desc);
+        const Float memoryTime = elapsed(timer);
+
+        // an editor changes one amplitude, only this variant is generated
+        next.get(edited);
+        next.get(desc);
+
+        Application::message(String::print("cache size %u: first launch %.2fms, next launch %.2fms, memory %.4fms, "
+                                           "edited %.2fms (%u generated, %u disk hits, %u memory hits)",
+                                           size, first.getStats().generateTime, next.getStats().loadTime, memoryTime,
+                                           next.getStats().generateTime, next.getStats().generated,
+                                           next.getStats().diskHits, next.getStats().memoryHits), "Bench");
+
+        disk.erase(desc.getKey(), "noise");
+        disk.erase(edited.getKey(), "noise");
+    }
+
+    static Float elapsed(Int64 timer)
+    {
+        return (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+    }
+
+    static Bool same(const std::vector<Float> &a, const std::vector<Float> &b)
+    {
+        return (a.size() == b.size()) && (memcmp(a.data(), b.data(), a.size() * sizeof(Float)) == 0);
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(NoiseBench, MyAppSettings)
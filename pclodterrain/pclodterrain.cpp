@@ -44,10 +44,23 @@
 #include <o3d/core/main.h>
 #include <o3d/core/dir.h>
 #include <o3d/core/file.h>
+#include <o3d/core/filemanager.h>
+#include <o3d/core/fileoutstream.h>
+#include <o3d/core/virtualfilelisting.h>
 
+#include <o3dsamples/contenthash.h>
+#include <o3dsamples/skylut.h>
+#include <o3dsamples/terrainheightquery.h>
+
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
 
 using namespace o3d;
+using namespace o3dsamples;
 
 Light *lpLight1 = nullptr;
 Light *lpLight2 = nullptr;
@@ -62,6 +75,262 @@ TrueTypeFont * lpFont = nullptr;
 #pragma comment(lib, "opengl32.lib")
 #endif
 
+/**
+ * @brief Keyed on-disk cache for the colormaps synthesized by the COLORMAP_AUTO policy.
+ * The terrain writes and streams back the colormap of each zone from the colormap
+ * directory given to PCLODTerrain::load. This helper computes a key from every input
+ * of the synthesis (precision, material set, static noise and terrain header) and
+ * gives a directory per key, so later runs with the same inputs stream the zone
+ * colormaps instead of regenerating them, and a changed input never reuses stale ones.
+ * The key is validated by a manifest only once the directory holds the colormap of
+ * every zone, and when an input cannot be hashed the plain colormap directory is used,
+ * without cache.
+ * @date 2026-10-19
+ */
+class ColormapCache
+{
+public:
+
+    ColormapCache() :
+        m_cached(False)
+    {
+    }
+
+    /**
+     * @brief Compute the key and prepare the directory of the colormaps.
+     * @param terrainDir Directory containing the terrain data.
+     * @param colormapRoot Name of the parent directory of the keyed colormap directories.
+     * @param headerFile Terrain header (.hclm), defines the zones.
+     * @param textureFile Terrain material list (.tclm).
+     * @param materialDir Directory containing the material files listed by the .tclm.
+     * @param precision Colormap precision given to the terrain configs.
+     * @param noiseFile Static noise image, or empty string if not used.
+     * @param noiseFactor Static noise factor given to the terrain configs.
+     * @return The directory to give to PCLODTerrain::load, colormapRoot if the inputs
+     * cannot be hashed.
+     */
+    String prepare(
+            const Dir &terrainDir,
+            const String &colormapRoot,
+            const String &headerFile,
+            const String &textureFile,
+            const String &materialDir,
+            UInt32 precision,
+            const String &noiseFile,
+            Float noiseFactor)
+    {
+        ContentHash hash;
+
+        hash.updateValue(precision);
+        hash.updateValue(noiseFactor);
+
+        Bool ok = hash.updateFile(headerFile.toUtf8().getData());
+
+        if (ok && !noiseFile.isEmpty()) {
+            ok = hash.updateFile(noiseFile.toUtf8().getData());
+        }
+
+        // material set, in the order of the terrain material list
+        ok = ok && hashMaterials(hash, textureFile, materialDir);
+
+        Dir root(terrainDir.makeFullPathName(colormapRoot));
+        if (!root.exists()) {
+            terrainDir.makeDir(colormapRoot);
+        }
+
+        m_key.destroy();
+        m_cached = False;
+
+        if (!ok) {
+            System::print("Unable to hash the colormap inputs, colormaps are not cached", "ColormapCache");
+
+            m_dirName = terrainDir.makeFullPathName(colormapRoot);
+            return m_dirName;
+        }
+
+        m_key = String(hash.getHex().c_str());
+
+        const String keyName = String::print("p%u_", precision) + m_key;
+
+        m_dirName = root.makeFullPathName(keyName);
+        m_manifest = Dir(m_dirName).makeFullFileName(MANIFEST);
+
+        if (Dir(m_dirName).exists()) {
+            m_cached = readManifest() == m_key;
+        } else {
+            root.makeDir(keyName);
+            m_cached = False;
+        }
+
+        if (m_cached) {
+            System::print(String("Stream cached colormaps from ") + m_dirName, "ColormapCache");
+        } else {
+            System::print(String("Generate colormaps into ") + m_dirName, "ColormapCache");
+        }
+
+        return m_dirName;
+    }
+
+    /**
+     * @brief Validate the cache entry once the colormaps are written (at terrain destruction).
+     * Nothing is validated until the directory holds a colormap per zone, a partial bake
+     * is completed by the next runs.
+     * @param numZones Number of zones of the terrain, 0 when its layout could not be read,
+     * nothing being validated then.
+     */
+    void commit(UInt32 numZones)
+    {
+        if (m_cached || m_key.isEmpty()) {
+            return;
+        }
+
+        if (numZones == 0) {
+            System::print("Unknown number of zones, the cache is not validated", "ColormapCache");
+            return;
+        }
+
+        const UInt32 numColormaps = countColormaps(numZones);
+        if (numColormaps < numZones) {
+            System::print(String::print("%u of %u zone colormaps baked, the cache is not validated yet",
+                                        numColormaps, numZones), "ColormapCache");
+            return;
+        }
+
+        try {
+            AutoPtr<FileOutStream> os(FileManager::instance()->openOutStream(m_manifest, FileOutStream::CREATE));
+            os->writeLine(m_key);
+
+            m_cached = True;
+        } catch (O3D_E_BaseException &) {
+            System::print(String("Unable to write ") + m_manifest, "ColormapCache");
+        }
+    }
+
+    //! True if the colormaps of the current key were found on disk.
+    Bool isCached() const { return m_cached; }
+
+    //! Key of the current inputs.
+    const String& getKey() const { return m_key; }
+
+private:
+
+    static const char *MANIFEST;
+    static const char *COLORMAP_EXT;
+
+    String m_key;
+    String m_dirName;
+    String m_manifest;
+    Bool m_cached;
+
+    //! Read the key stored into the manifest, or an empty string.
+    String readManifest() const
+    {
+        try {
+            AutoPtr<InStream> is(FileManager::instance()->openInStream(m_manifest));
+
+            String key;
+            is->readLine(key);
+
+            return key.length() == 16 ? key : String();
+        } catch (O3D_E_BaseException &) {
+            return String();
+        }
+    }
+
+    /**
+     * @brief Number of zones having their colormap into the keyed directory.
+     * Only the files named after a zone, <name>_<zone index> with the colormap extension,
+     * are counted, and each zone once, so that a stray file or the leftover of another
+     * bake cannot complete the count.
+     */
+    UInt32 countColormaps(UInt32 numZones) const
+    {
+        VirtualFileListing fileListing;
+        fileListing.setPath(m_dirName);
+        fileListing.setType(FILE_FILE);
+        fileListing.searchFirstFile();
+
+        std::vector<Bool> found(numZones, False);
+        UInt32 count = 0;
+        FLItem *item;
+
+        while ((item = fileListing.searchNextFile()) != nullptr) {
+            const std::string name(item->FileName.toUtf8().getData());
+
+            const size_t ext = name.rfind('.');
+            const size_t sep = name.rfind('_', ext);
+
+            if ((ext == std::string::npos) || (sep == std::string::npos) || (ext == sep + 1) ||
+                (name.compare(ext + 1, std::string::npos, COLORMAP_EXT) != 0)) {
+                continue;
+            }
+
+            UInt32 zone = 0;
+            Bool digits = True;
+
+            for (size_t i = sep + 1; i < ext; ++i) {
+                if ((name[i] < '0') || (name[i] > '9') || (zone >= numZones)) {
+                    digits = False;
+                    break;
+                }
+                zone = zone * 10 + UInt32(name[i] - '0');
+            }
+
+            if (digits && (zone < numZones) && !found[zone]) {
+                found[zone] = True;
+                ++count;
+            }
+        }
+
+        return count;
+    }
+
+    /**
+     * @brief Hash the material files referenced by the terrain material list.
+     * The .tclm contains a 16 bytes tag, the number of materials, then for each
+     * material its identifier and its file name (length including the terminal zero).
+     */
+    static Bool hashMaterials(ContentHash &hash, const String &textureFile, const String &materialDir)
+    {
+        FILE *file = fopen(textureFile.toUtf8().getData(), "rb");
+        if (!file) {
+            return False;
+        }
+
+        char tag[16];
+        UInt32 count = 0;
+        Bool ok = (fread(tag, 1, 16, file) == 16) &&
+                  (memcmp(tag, "O3DCLM TEXFILE  ", 16) == 0) &&
+                  (fread(&count, sizeof(UInt32), 1, file) == 1);
+
+        Dir dir(materialDir);
+
+        for (UInt32 i = 0; ok && (i < count); ++i) {
+            UInt32 id = 0, len = 0;
+            char name[256];
+
+            ok = (fread(&id, sizeof(UInt32), 1, file) == 1) &&
+                 (fread(&len, sizeof(UInt32), 1, file) == 1) &&
+                 (len > 0) && (len <= sizeof(name)) &&
+                 (fread(name, 1, len, file) == len);
+
+            if (ok) {
+                name[len-1] = 0;
+
+                hash.updateValue(id);
+                hash.updateString(name);
+                ok = hash.updateFile(dir.makeFullFileName(name).toUtf8().getData());
+            }
+        }
+
+        fclose(file);
+        return ok;
+    }
+};
+
+const char *ColormapCache::MANIFEST = "colormaps.key";
+const char *ColormapCache::COLORMAP_EXT = "cclm";
+
 /**
  * @brief The TerrainSample class
  * @date 2008-01-01
@@ -80,9 +349,33 @@ private:
 
 	Float m_time;
 
+    ColormapCache m_colormapCache;
+
+    ClmTerrain m_terrainLayout;
+    TerrainHeightQuery m_ground;
+
+    //! Sky clock, scaled and scrubbed by the arrow keys.
+    Double m_skyTime;
+    Double m_skyOrigin;
+    Float m_timeScale;
+
+    //! Sky tables by sun elevation, the background follows them in sky table mode.
+    SkyLut m_skyLut;
+    SkyLight m_skySun;
+    Bool m_skyLutMode;
+    Float m_dayTime;
+
+    static constexpr Float DAY_LENGTH = 240.0f;     //!< Sky clock seconds per day of the sun path.
+    static constexpr Float SKY_EXPOSURE = 0.01f;    //!< Tone mapping of the sky colors.
+
 public:
 
-    TerrainSample(Dir &basePath)
+    TerrainSample(Dir &basePath) :
+        m_skyTime(0.0),
+        m_skyOrigin(0.0),
+        m_timeScale(1.0f),
+        m_skyLutMode(False),
+        m_dayTime(12.5f)
 	{
         m_appWindow = new AppWindow;
 
@@ -115,6 +408,7 @@ public:
         m_appWindow->onDestroy.connect(this, &TerrainSample::onDestroy);
 
 		m_time = 0.001f*System::getMsTime();
+		m_skyTime = m_skyOrigin = m_time;
 
 		//getWindow()->grabMouse();
 
@@ -147,13 +441,29 @@ public:
         String headerFile = basePath.makeFullFileName("terrain/TerrainTerragen_64.hclm");
         //String headerFile = basePath.makeFileName("terrain/TerrainTerragen_LightmapTest.hclm");
         String dataDir = basePath.makeFullPathName("terrain");
+        String textureFile = basePath.makeFullFileName("terrain/TerrainTerragen_64.tclm");
         String materialDir = basePath.makeFullPathName("terrain/Materials");
-        String colormapDir = basePath.makeFullPathName("terrain/Colormaps");
+        String noiseFile = basePath.makeFullFileName("terrain/noise.jpg");
+
+        const UInt32 colormapPrecision = 2;
+        const Float colormapNoiseFactor = 0.1f;
 
-        Image noise(basePath.makeFullFileName("terrain/noise.jpg"));
+        Image noise(noiseFile);
+
+        // the colormaps synthesized at runtime are cached per zone into a directory keyed
+        // by their inputs, then streamed back on the next runs
+        String colormapDir = m_colormapCache.prepare(
+                                 Dir(dataDir),
+                                 "Colormaps",
+                                 headerFile,
+                                 textureFile,
+                                 materialDir,
+                                 colormapPrecision,
+                                 noise.isValid() ? noiseFile : String(),
+                                 colormapNoiseFactor);
 
         pTerrain->getCurrentConfigs().setColormapPolicy(PCLODConfigs::COLORMAP_AUTO);
-        pTerrain->getCurrentConfigs().setColormapPrecision(2);
+        pTerrain->getCurrentConfigs().setColormapPrecision(colormapPrecision);
         pTerrain->getCurrentConfigs().setDistanceOnlyMaterial(10.0f);
         pTerrain->getCurrentConfigs().setDistanceOnlyColormap(25.0f);
         pTerrain->getCurrentConfigs().setViewDistance(40);
@@ -161,7 +471,7 @@ public:
         pTerrain->getCurrentConfigs().setRefreshFrequency(10);
         pTerrain->getCurrentConfigs().setColormapStaticNoise(noise);
         pTerrain->getCurrentConfigs().enableColormapStaticNoise(noise.isValid());
-        pTerrain->getCurrentConfigs().setColormapStaticNoiseFactor(0.1f);
+        pTerrain->getCurrentConfigs().setColormapStaticNoiseFactor(colormapNoiseFactor);
         pTerrain->getCurrentConfigs().enableFrustumCulling(True);
         pTerrain->getCurrentConfigs().enableFrontToBack(True);
         pTerrain->getCurrentConfigs().setFrontToBackMinViewMove(10.0f);
@@ -170,12 +480,19 @@ public:
         pTerrain->getCurrentConfigs().setText2D(getGui()->getFontManager()->addTrueTypeFont(basePath.makeFullFileName("gui/arial.ttf")));
         pTerrain->getCurrentConfigs().enableDebugLabel(True);
 
-        pTerrain->getCurrentConfigs().enableLightmapLod(False);
+        // the lightmap mip levels of each zone follow the camera distance, terrainbench
+        // replays these points under a memory cap
+        pTerrain->getCurrentConfigs().enableLightmapLod(True);
         pTerrain->getCurrentConfigs().setLightmapPoint(0.0f, 0);
         pTerrain->getCurrentConfigs().setLightmapPoint(50.0f, -1);
         pTerrain->getCurrentConfigs().setLightmapPoint(100.0f, -2);
         pTerrain->getCurrentConfigs().setLightmapPoint(200.0f, -3);
 
+        // the zone heights are kept for the ground queries (camera ground follow)
+        if (m_terrainLayout.load(headerFile.toUtf8().getData(), std::string(dataDir.toUtf8().getData()) + "/")) {
+            m_ground.build(m_terrainLayout);
+        }
+
         pTerrain->getCurrentConfigs().enableWireFrame(False);
         pTerrain->getCurrentConfigs().enableLightning(True);
         pTerrain->getCurrentConfigs().enableSelfShadowing(True);
@@ -420,6 +737,32 @@ public:
         lpFont->setColor(Color(0.0f, 0.0f, 0.0f));
 
         lpSky->init();
+
+        //
+        // sky tables, same atmosphere, dome and sun as the sky object, the L key toggles them
+        //
+
+        SkyScatterParams lSkyParams;
+        lSkyParams.planetRadius = 6400.0f;
+        lSkyParams.atmosphereThickness = 100.0f;
+        lSkyParams.moleculePhase[0] = 1.75f;
+        lSkyParams.moleculePhase[1] = 0.25f;
+        lSkyParams.stepFactor = 1.1f;
+        lSkyParams.stepIndex = 5;
+
+        const SkyLight lSun = { { 0.0f, 0.7f, 1.0f }, { 200.0f, 220.0f, 250.0f }, { 650.0e-9f, 610.0e-9f, 475.0e-9f } };
+        m_skySun = lSun;
+
+        {
+            WorkerPool lPool;
+            m_skyLut.loadOrBuild(basePath.makeFullFileName("terrain/sky.lut").toUtf8().getData(),
+                                 lSkyParams, 4, m_skySun.wavelength, SkyLut::DEFAULT_NUM_ANGLES, &lPool);
+        }
+
+        System::print(String::print("Sky tables %s in %.2f ms, %.1f KB",
+                                    m_skyLut.isLoaded() ? "loaded" : "built and saved",
+                                    m_skyLut.getStartupTime(),
+                                    m_skyLut.getBytes() / 1024.f), "SkyLut");
 	}
 
     virtual ~TerrainSample()
@@ -442,6 +785,9 @@ public:
         deletePtr(m_scene);
         deletePtr(m_glRenderer);
 
+        // colormaps of any visited zone are now written
+        m_colormapCache.commit(m_terrainLayout.getNumZones());
+
         this->getWindow()->logFps();
 
         // it is deleted by the application
@@ -470,6 +816,17 @@ public:
 		SceneObject *lpCamera = getScene()->getSceneObjectManager()->searchName("CameraFPS");
 		lpCamera->getNode()->getTransform()->translate(Vector3(cam_t_x,cam_t_y,cam_t_z));
 
+		// keep the camera over the ground
+		Vector3 lCameraPos = lpCamera->getNode()->getTransform()->getPosition();
+
+        if (m_ground.isValid()) {
+			const Float lGround = m_ground.getHeight(lCameraPos[X], lCameraPos[Z]) + 1.0f;
+            if (lCameraPos[Y] < lGround) {
+				lCameraPos[Y] = lGround;
+				lpCamera->getNode()->getTransform()->setPosition(lCameraPos);
+			}
+		}
+
 		static int lCounter = 0;
 
         if ((++lCounter % 5) == 0) {
@@ -483,13 +840,64 @@ public:
 			lpLight2->getNode()->getTransform()->setDirectionZ(lDirection2);
 		}
 
-		m_time = 0.001f*System::getMsTime();
+		const Float lNow = 0.001f*System::getMsTime();
+		m_skyTime += (lNow - m_time) * m_timeScale;
+		m_time = lNow;
 
         if (lpSky != nullptr) {
-			lpSky->setTime(m_time);
+			lpSky->setTime(m_skyTime);
+        }
+
+        if (m_skyLutMode) {
+            updateSkyLut(lpCamera);
         }
 	}
 
+    //! Hour of the day of a sky clock time, the clock starting at 12h30.
+    static Float getDayTime(Double skyTime, Double skyOrigin)
+    {
+        const Double lHours = std::fmod(12.5 + (skyTime - skyOrigin) * 24.0 / DAY_LENGTH, 24.0);
+        return Float(lHours < 0.0 ? lHours + 24.0 : lHours);
+    }
+
+    /**
+     * @brief The sun turns around the east-west axis, and is at the position given to
+     * the sky object at noon.
+     */
+    static void computeSunDirection(Float hour, Float *dir)
+    {
+        const Float lAngle = (hour - 6.0f) * o3d::PI / 12.0f;
+        const Float lNoon = 1.0f / std::sqrt(0.7f*0.7f + 1.0f);
+
+        dir[0] = std::cos(lAngle);
+        dir[1] = std::sin(lAngle) * 0.7f * lNoon;
+        dir[2] = std::sin(lAngle) * lNoon;
+    }
+
+    /**
+     * @brief Time of day from the sky tables. The background takes the color of the sky
+     * in the view direction, a table fetch at any time of the day. The sky object is
+     * disabled meanwhile, so the L key compares both skies at the same hour.
+     */
+    void updateSkyLut(SceneObject *camera)
+    {
+        m_dayTime = getDayTime(m_skyTime, m_skyOrigin);
+        computeSunDirection(m_dayTime, m_skySun.direction);
+
+        // the camera looks toward -Z
+        const Vector3 lView = -camera->getAbsoluteMatrix().getZ();
+        const Float lViewDir[3] = { lView[X], lView[Y], lView[Z] };
+
+        Float lColor[3];
+        m_skyLut.sample(m_skySun, lViewDir, lColor);
+
+        getScene()->getContext()->setBackgroundColor(
+                    1.0f - std::exp(-lColor[0] * SKY_EXPOSURE),
+                    1.0f - std::exp(-lColor[1] * SKY_EXPOSURE),
+                    1.0f - std::exp(-lColor[2] * SKY_EXPOSURE),
+                    0.0f);
+    }
+
 	void onSceneDraw()
     {
 		Int32 lViewPort[4];
@@ -570,6 +978,22 @@ public:
 			lpFont->write(Vector2i(lViewPort[2] - 110 - lpFont->sizeOf(lText), 52), lText);
 		}
 
+        if (m_skyLutMode) {
+            Float lLight[3];
+            m_skyLut.getLightColor(m_skySun, lLight);
+
+            lText = String::print("Sky tables: Hour = %.2f    Sun = %.0f %.0f %.0f    Startup = %.2f ms (%s)    Memory = %.1f KB",
+                                  m_dayTime, lLight[0], lLight[1], lLight[2],
+                                  m_skyLut.getStartupTime(), m_skyLut.isLoaded() ? "loaded" : "built",
+                                  m_skyLut.getBytes() / 1024.f);
+            lpFont->write(Vector2i((lViewPort[2]-lpFont->sizeOf(lText))/2, 102), lText);
+        }
+
+		lText = String::print("Clock x%g    Hour = %.2f",
+							  m_timeScale,
+							  getDayTime(m_skyTime, m_skyOrigin));
+		lpFont->write(Vector2i((lViewPort[2]-lpFont->sizeOf(lText))/2, 122), lText);
+
 		getScene()->getContext()->setDefaultDepthFunc();
 		getScene()->getContext()->setDefaultCullingMode();
 
@@ -607,6 +1031,42 @@ public:
                 System::print("Grab mouse", "Change");
             }
         }
+
+        // scrub the sky clock by an hour of the sun path, and change its speed
+        if (event.isPressed() && (event.key() == KEY_RIGHT)) {
+            m_skyTime += DAY_LENGTH / 24.0;
+        }
+
+        if (event.isPressed() && (event.key() == KEY_LEFT)) {
+            m_skyTime -= DAY_LENGTH / 24.0;
+        }
+
+        if (event.isPressed() && (event.key() == KEY_UP)) {
+            m_timeScale = std::min(m_timeScale * 2.0f, 64.0f);
+        }
+
+        if (event.isPressed() && (event.key() == KEY_DOWN)) {
+            m_timeScale = std::max(m_timeScale * 0.5f, 1.0f / 16.0f);
+        }
+
+        if (event.isPressed() && (event.key() == KEY_L) && m_skyLut.isValid()) {
+            m_skyLutMode = !m_skyLutMode;
+
+            // the sky object dome would be drawn over the background of the sky tables
+            if (m_skyLutMode) {
+                if (lpSky != nullptr) {
+                    lpSky->disable();
+                }
+            } else {
+                if (lpSky != nullptr) {
+                    lpSky->enable();
+                }
+
+                getScene()->getContext()->setBackgroundColor(0.633f,0.792f,.914f,0.0f);
+            }
+
+            System::print(m_skyLutMode ? "Sky tables on" : "Sky tables off", "Change");
+        }
 	}
 
     void onTouchScreenMotion(TouchScreen* touch)
@@ -0,0 +1,289 @@
+/**
+ * @file primitivebench.cpp
+ * @brief Headless immediate mode primitive batching benchmark, a debug overlay per frame.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/string.h>
+
+#include <o3dsamples/primitivebatch.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Draw the debug overlay of a quadtree (a box per node, 7 levels) and of the
+ * skeletons of a crowd (a line strip per bone chain) for a number of frames, with a
+ * beginDraw/endDraw per primitive. Compare the primitives given one by one to an
+ * immediate mode target that copies them into a buffer per draw, as the primitive
+ * manager does, to the PrimitiveBatch whose runs are given again to the same target,
+ * as the terrain sample does: the vertices are copied once more, for fewer draws. The
+ * overlay is drawn grouped by state, then with the state changing at each object, the
+ * worst case of the merging. The target has no driver behind it, so only the CPU cost
+ * is timed, and the draw calls saved are counted, not measured.
+ * @date 2026-10-19
+ */
+class PrimitiveBench
+{
+public:
+
+    static Int32 main()
+    {
+        std::vector<Box> boxes;
+        buildQuadtree(boxes, 0.0f, 0.0f, 512.0f, 0);
+
+        Application::message(String::print("%u quadtree boxes, %u bone chains, %u frames",
+                                           UInt32(boxes.size()), NUM_CHAINS, NUM_FRAMES), "Bench");
+
+        // one draw per primitive
+        Float directTime[2] = { 0.0f, 0.0f };
+
+        for (UInt32 mode = 0; mode < 2; ++mode) {
+            PerPrimitive target;
+
+            for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+                target.numDraws = 0;
+                target.numVertices = 0;
+
+                const Int64 timer = System::getTime();
+                for (UInt32 f = 0; f < NUM_FRAMES; ++f) {
+                    drawOverlay(target, boxes, f, mode == 1);
+                }
+                directTime[mode] = best(r, directTime[mode], elapsed(timer));
+            }
+
+            report(mode == 1 ? "direct, state at each object" : "direct, grouped by state", directTime[mode],
+                   target.numDraws / NUM_FRAMES, target.numDraws / NUM_FRAMES, target.numVertices / NUM_FRAMES, 0);
+        }
+
+        for (UInt32 mode = 0; mode < 2; ++mode) {
+            const Bool interleaved = mode == 1;
+
+            Batched target;
+            PerPrimitive backend;
+            Float time = 0.0f;
+
+            for (UInt32 r = 0; r < NUM_RUNS; ++r) {
+                backend.numDraws = 0;
+                backend.numVertices = 0;
+
+                const Int64 timer = System::getTime();
+                for (UInt32 f = 0; f < NUM_FRAMES; ++f) {
+                    drawOverlay(target, boxes, f, interleaved);
+
+                    // each run given again to the immediate mode target, vertex by vertex
+                    target.batch.flush([&backend] (const PrimitiveSubmit &submit, const PrimitiveVertex *vertices) {
+                        backend.beginDraw(submit.mode);
+
+                        Float color[4];
+                        for (UInt32 i = submit.first; i < submit.first + submit.count; ++i) {
+                            vertices[i].getColor(color);
+                            backend.setColor(color[0], color[1], color[2]);
+                            backend.addVertex(vertices[i].x, vertices[i].y, vertices[i].z);
+                        }
+
+                        backend.endDraw();
+                    });
+
+                    target.batch.nextFrame();
+                }
+                time = best(r, time, elapsed(timer));
+            }
+
+            const PrimitiveBatch::Stats stats = target.batch.getStats();
+            report(interleaved ? "batched, state at each object" : "batched, grouped by state", time,
+                   stats.numDraws, backend.numDraws / NUM_FRAMES, backend.numVertices / NUM_FRAMES, stats.regionBytes);
+
+            Application::message(String::print("  x%.2f the direct time on the CPU, %u draws saved per frame, "
+                                               "region grown %u times",
+                                               time / directTime[mode], stats.numDraws - backend.numDraws / NUM_FRAMES,
+                                               stats.numGrows), "Bench");
+        }
+
+        return 0;
+    }
+
+private:
+
+    static const UInt32 NUM_LEVELS = 7;
+    static const UInt32 NUM_CHAINS = 2000;       //!< 40 characters of 50 bone chains.
+    static const UInt32 CHAIN_LENGTH = 5;
+    static const UInt32 NUM_FRAMES = 100;
+    static const UInt32 NUM_RUNS = 5;
+
+    enum State
+    {
+        STATE_DEPTH_TESTED = 0,
+        STATE_ON_TOP = 1
+    };
+
+    struct Box
+    {
+        Float x, z, size;
+    };
+
+    //! Immediate mode target, one buffer and one upload per beginDraw/endDraw.
+    struct PerPrimitive
+    {
+        std::vector<PrimitiveVertex> primitive;
+        std::vector<std::vector<PrimitiveVertex>> uploads;
+        UInt32 numDraws = 0;
+        UInt64 numVertices = 0;
+        Float r = 1.0f, g = 1.0f, b = 1.0f;
+
+        void setState(UInt32) {}
+        void setColor(Float red, Float green, Float blue) { r = red; g = green; b = blue; }
+        void beginDraw(PrimitiveMode) { primitive.clear(); }
+
+        void addVertex(Float x, Float y, Float z)
+        {
+            PrimitiveVertex v = { x, y, z, PrimitiveVertex::packColor(r, g, b, 1.0f) };
+            primitive.push_back(v);
+        }
+
+        void endDraw()
+        {
+            // a new buffer per draw, released once drawn
+            uploads.emplace_back(primitive.begin(), primitive.end());
+            numVertices += primitive.size();
+            ++numDraws;
+
+            if (uploads.size() > 64) {
+                uploads.clear();
+            }
+        }
+    };
+
+    struct Batched
+    {
+        PrimitiveBatch batch;
+
+        Batched() : batch(1, 1024) {}
+
+        void setState(UInt32 state) { batch.setState(state); }
+        void setColor(Float r, Float g, Float b) { batch.setColor(r, g, b); }
+        void beginDraw(PrimitiveMode mode) { batch.beginDraw(mode); }
+        void addVertex(Float x, Float y, Float z) { batch.addVertex(x, y, z); }
+        void endDraw() { batch.endDraw(); }
+    };
+
+    static void buildQuadtree(std::vector<Box> &boxes, Float x, Float z, Float size, UInt32 level)
+    {
+        Box box = { x, z, size };
+        boxes.push_back(box);
+
+        if (level + 1 < NUM_LEVELS) {
+            const Float half = size * 0.5f;
+            buildQuadtree(boxes, x, z, half, level + 1);
+            buildQuadtree(boxes, x + half, z, half, level + 1);
+            buildQuadtree(boxes, x, z + half, half, level + 1);
+            buildQuadtree(boxes, x + half, z + half, half, level + 1);
+        }
+    }
+
+    template <class Target>
+    static void drawBox(Target &target, const Box &box)
+    {
+        const Float x0 = box.x, x1 = box.x + box.size, z0 = box.z, z1 = box.z + box.size;
+        const Float y0 = 0.0f, y1 = box.size * 0.1f;
+
+        target.setState(STATE_DEPTH_TESTED);
+        target.setColor(0.0f, 1.0f, 0.0f);
+
+        target.beginDraw(PRIMITIVE_LINE_LOOP);
+        target.addVertex(x0, y0, z0); target.addVertex(x1, y0, z0); target.addVertex(x1, y0, z1); target.addVertex(x0, y0, z1);
+        target.endDraw();
+
+        target.beginDraw(PRIMITIVE_LINE_LOOP);
+        target.addVertex(x0, y1, z0); target.addVertex(x1, y1, z0); target.addVertex(x1, y1, z1); target.addVertex(x0, y1, z1);
+        target.endDraw();
+
+        target.beginDraw(PRIMITIVE_LINES);
+        target.addVertex(x0, y0, z0); target.addVertex(x0, y1, z0);
+        target.addVertex(x1, y0, z0); target.addVertex(x1, y1, z0);
+        target.addVertex(x1, y0, z1); target.addVertex(x1, y1, z1);
+        target.addVertex(x0, y0, z1); target.addVertex(x0, y1, z1);
+        target.endDraw();
+    }
+
+    template <class Target>
+    static void drawChain(Target &target, UInt32 chain, UInt32 frame)
+    {
+        const Float x = Float(chain % 50) * 10.0f;
+        const Float z = Float(chain / 50) * 10.0f;
+        const Float sway = Float((frame + chain) % 20) * 0.05f;
+
+        target.setState(STATE_ON_TOP);
+        target.setColor(1.0f, 1.0f, 0.0f);
+
+        target.beginDraw(PRIMITIVE_LINE_STRIP);
+        for (UInt32 i = 0; i < CHAIN_LENGTH; ++i) {
+            target.addVertex(x + sway * i, Float(i) * 0.4f, z);
+        }
+        target.endDraw();
+    }
+
+    //! The boxes then the chains, or a box and a chain in turn.
+    template <class Target>
+    static void drawOverlay(Target &target, const std::vector<Box> &boxes, UInt32 frame, Bool interleaved)
+    {
+        if (interleaved) {
+            const size_t count = std::max<size_t>(boxes.size(), NUM_CHAINS);
+            for (size_t i = 0; i < count; ++i) {
+                if (i < boxes.size()) {
+                    drawBox(target, boxes[i]);
+                }
+                if (i < NUM_CHAINS) {
+                    drawChain(target, UInt32(i), frame);
+                }
+            }
+        } else {
+            for (const Box &box : boxes) {
+                drawBox(target, box);
+            }
+            for (UInt32 c = 0; c < NUM_CHAINS; ++c) {
+                drawChain(target, c, frame);
+            }
+        }
+    }
+
+    static Float elapsed(Int64 timer)
+    {
+        return (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+    }
+
+    static Float best(UInt32 run, Float current, Float time)
+    {
+        return (run == 0) || (time < current) ? time : current;
+    }
+
+    static void report(const String &name, Float time, UInt32 numDraws, UInt32 numSubmits, UInt64 numVertices, size_t regionBytes)
+    {
+        Application::message(String::print("%s: %.3f ms/frame, %u begin/end, %u draw calls, %u vertices, region %.1f KB",
+                                           name.toUtf8().getData(), time / NUM_FRAMES, numDraws, numSubmits,
+                                           UInt32(numVertices), regionBytes / 1024.f), "Bench");
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(PrimitiveBench, MyAppSettings)
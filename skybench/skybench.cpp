@@ -0,0 +1,353 @@
+/**
+ * @file skybench.cpp
+ * @brief Headless sky scattering benchmark.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/string.h>
+
+#include <o3dsamples/cloudshading.h>
+#include <o3dsamples/perlinnoise.h>
+#include <o3dsamples/skyforecast.h>
+#include <o3dsamples/skylut.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Time a full dome recomputation at the precisions 3 to 6, with the scalar, SSE2
+ * and AVX paths and on a pool of workers, using the atmosphere, sun and moon of the
+ * pclodterrain sample. Then compare with the lookup tables: startup cost when built
+ * and when loaded from the disk, memory, cost of a dome fetch and error. Finally
+ * measure the latency of the background sky under time scrubbing, with and without
+ * the cancellation of the stale computations, and the cost left on the frame thread by
+ * the background cloud shading.
+ * @date 2026-10-19
+ */
+class SkyBench
+{
+public:
+
+    static Int32 main()
+    {
+        SkyScatterParams params;
+        params.planetRadius = 6400.0f;
+        params.atmosphereThickness = 100.0f;
+        params.moleculePhase[0] = 1.75f;
+        params.moleculePhase[1] = 0.25f;
+        params.stepFactor = 1.1f;
+        params.stepIndex = 5;
+
+        SkyScatter sky;
+        sky.setParams(params);
+
+        SkyLight sun = { { 0.0f, 0.7f, 1.0f }, { 200.0f, 220.0f, 250.0f }, { 650.0e-9f, 610.0e-9f, 475.0e-9f } };
+        SkyLight moon = { { 1.0f, 0.7f, 0.0f }, { 400E-6f, 440E-6f, 500E-6f }, { 650.0e-9f, 610.0e-9f, 475.0e-9f } };
+
+        sky.addLight(sun);
+        sky.addLight(moon);
+
+        Application::message(String::print("Optical depth tables %.1fKB", sky.getTableBytes() / 1024.f), "Bench");
+
+        static const char *paths[3] = { "scalar", "SSE2", "AVX" };
+
+        WorkerPool pool;
+
+        for (UInt32 precision = 3; precision <= 6; ++precision) {
+            sky.setDomePrecision(precision);
+
+            std::vector<Float> reference;
+
+            for (UInt32 path = SkyScatter::PATH_SCALAR; path <= SkyScatter::PATH_AVX; ++path) {
+                if (!SkyScatter::hasPath(SkyScatter::Path(path))) {
+                    Application::message(String::print("precision %u %s: not compiled in", precision, paths[path]), "Bench");
+                    continue;
+                }
+
+                sky.setPath(SkyScatter::Path(path));
+
+                const Float time = timeDome(sky, nullptr);
+
+                if (path == SkyScatter::PATH_SCALAR) {
+                    reference = sky.getColors();
+                }
+
+                Application::message(String::print("precision %u (%u vertices) %s: %.3fms // max diff %g",
+                                                   precision, sky.getNumVertices(), paths[path],
+                                                   time, maxDiff(reference, sky.getColors())), "Bench");
+            }
+
+            sky.setPath(SkyScatter::PATH_BEST);
+
+            const Float time = timeDome(sky, &pool);
+            Application::message(String::print("precision %u (%u vertices) best on %u workers: %.3fms // max diff %g",
+                                               precision, sky.getNumVertices(), pool.getNumWorkers() + 1,
+                                               time, maxDiff(reference, sky.getColors())), "Bench");
+        }
+
+        for (UInt32 precision = 4; precision <= 6; precision += 2) {
+            benchLut(params, precision, sun, moon, pool);
+        }
+
+        benchForecast(params, pool, True);
+        benchForecast(params, pool, False);
+
+        if (!benchClouds(pool)) {
+            return -1;
+        }
+
+        return 0;
+    }
+
+private:
+
+    static const UInt32 NUM_RUNS = 20;
+
+    //! Highest average cost left on the frame thread by the background clouds, as a
+    //! share of the same update made on the frame thread.
+    static constexpr Float MAX_CLOUD_FRAME_SHARE = 0.01f;
+
+    //! Average time of a full dome in milliseconds.
+    static Float timeDome(SkyScatter &sky, WorkerPool *pool)
+    {
+        // a first run out of the timing, for the caches
+        sky.compute(pool);
+
+        Int64 timer = System::getTime();
+
+        for (UInt32 i = 0; i < NUM_RUNS; ++i) {
+            sky.compute(pool);
+        }
+
+        return (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency() / NUM_RUNS;
+    }
+
+    static void benchLut(
+            const SkyScatterParams &params,
+            UInt32 precision,
+            const SkyLight &sun,
+            const SkyLight &moon,
+            WorkerPool &pool)
+    {
+        const char *filename = "skybench.lut";
+        remove(filename);
+
+        SkyLut built;
+        built.loadOrBuild(filename, params, precision, sun.wavelength, SkyLut::DEFAULT_NUM_ANGLES, &pool);
+
+        SkyLut loaded;
+        if (!loaded.loadOrBuild(filename, params, precision, sun.wavelength, SkyLut::DEFAULT_NUM_ANGLES, &pool)) {
+            Application::message("Unable to reload the sky lookup tables", "Bench");
+        }
+
+        remove(filename);
+
+        Application::message(String::print("LUT precision %u, %u angles: %.1fKB, built in %.2fms, loaded in %.2fms",
+                                           precision, loaded.getNumAngles(), loaded.getBytes() / 1024.f,
+                                           built.getStartupTime(), loaded.getStartupTime()), "Bench");
+
+        // reference integration on the pool
+        SkyScatter sky;
+        sky.setParams(params);
+        sky.setDomePrecision(precision);
+        sky.addLight(sun);
+        sky.addLight(moon);
+
+        const Float integrate = timeDome(sky, &pool);
+
+        std::vector<Float> colors(loaded.getNumVertices() * 3);
+
+        Int64 timer = System::getTime();
+
+        for (UInt32 i = 0; i < NUM_RUNS; ++i) {
+            std::fill(colors.begin(), colors.end(), 0.0f);
+            loaded.accumulate(sun, colors.data());
+            loaded.accumulate(moon, colors.data());
+        }
+
+        const Float fetch = (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency() / NUM_RUNS;
+
+        Float maxColor = 0.0f;
+        for (Float c : sky.getColors()) {
+            maxColor = std::max(maxColor, c);
+        }
+
+        Application::message(String::print("LUT precision %u: fetch %.3fms, integration on the pool %.3fms // max diff %.2f%% of the max",
+                                           precision, fetch, integrate,
+                                           100.f * maxDiff(sky.getColors(), colors) / maxColor), "Bench");
+    }
+
+    /**
+     * @brief Ten seconds at 250 frames per second of a clock running at one minute per
+     * second, scrubbed by half an hour per frame during 8 frames every second.
+     */
+    static void benchForecast(const SkyScatterParams &params, WorkerPool &pool, Bool cancellable)
+    {
+        SkyForecast forecast(pool);
+
+        forecast.setup(params, 6, [] (Double time, SkyScatter &sky) {
+            // hours, the sun of pclodterrain at noon
+            const Float angle = Float((time - 6.0) * 3.14159265358979 / 12.0);
+            const Float noon = 1.0f / std::sqrt(0.7f*0.7f + 1.0f);
+
+            SkyLight sun = { { std::cos(angle), std::sin(angle) * 0.7f * noon, std::sin(angle) * noon },
+                             { 200.0f, 220.0f, 250.0f }, { 650.0e-9f, 610.0e-9f, 475.0e-9f } };
+
+            sky.clearLights();
+            sky.addLight(sun);
+        });
+
+        forecast.setTolerance(1.0 / 60.0);
+        forecast.setCancellable(cancellable);
+
+        Double time = 12.0;
+
+        for (UInt32 frame = 0; frame < 2500; ++frame) {
+            time += 1.0 / (60.0 * 250.0);
+            if ((frame % 250) < 8) {
+                time += 0.5;
+            }
+
+            forecast.setTime(time);
+            forecast.update();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+        }
+
+        forecast.wait();
+        forecast.update();
+
+        const SkyForecast::Stats stats = forecast.getStats();
+        Application::message(String::print("Forecast %s: %u requests, %u started, %u cancelled, %u completed, latency avg %.2fms max %.2fms",
+                                           cancellable ? "cancellable" : "not cancellable",
+                                           stats.numRequests, stats.numStarted, stats.numCancelled, stats.numCompleted,
+                                           stats.averageLatency, stats.maxLatency), "Bench");
+    }
+
+    /**
+     * @brief Clouds of 512x512 texels updated at 20 Hz in the background, while a frame
+     * loop at 250 Hz sets the light, acquires the frames and samples the shadow.
+     * The background thread is judged against its period: the ticks it skipped because
+     * an update overran, and its longest update relative to the 50 ms period.
+     * @return False if the average cost on the frame thread is not negligible, over 1%
+     * of a synchronous update.
+     */
+    static Bool benchClouds(WorkerPool &pool)
+    {
+        PerlinNoise noise;
+        noise.setAmplitudes(PerlinNoise::geometricSequence(5, 0.5f, 1.0f));
+        noise.setFrequencies(PerlinNoise::geometricSequence(5, 2, 4));
+        noise.setPositive(True);
+        noise.setSize(512);
+        noise.setRandomSeed(15);
+
+        std::vector<Float> values(512 * 512);
+        noise.generate(values.data(), &pool);
+
+        CloudShading clouds;
+        clouds.setNoise(values, 512);
+
+        const Float light[3] = { 0.0f, 0.7f, 1.0f };
+        clouds.setLightDirection(light);
+
+        // the same frame on the frame thread, for comparison
+        Int64 timer = System::getTime();
+        clouds.update(0.0);
+        const Float syncTime = (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+
+        const Float rate = 20.0f;
+        const Float period = 1000.0f / rate;
+
+        const Int64 runTimer = System::getTime();
+        clouds.start(rate, &pool);
+
+        const UInt32 numFrames = 1000;
+        UInt32 numAcquired = 0;
+        Int64 frameTicks = 0, maxFrameTicks = 0;
+        Float shadow = 0.0f;
+
+        for (UInt32 frame = 0; frame < numFrames; ++frame) {
+            timer = System::getTime();
+
+            clouds.setLightDirection(light);
+            if (clouds.acquire()) {
+                ++numAcquired;
+            }
+            shadow += clouds.sampleShadow(frame * 0.001f, 0.5f);
+
+            const Int64 ticks = System::getTime() - timer;
+            frameTicks += ticks;
+            maxFrameTicks = std::max(maxFrameTicks, ticks);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+        }
+
+        clouds.stop();
+
+        const Float runTime = (Float)(System::getTime() - runTimer) * 1000.f / (Float)System::getTimeFrequency();
+        const UInt32 numTicks = UInt32(runTime / period) + 1;
+
+        const CloudShading::Stats stats = clouds.getStats();
+        const Float frameCost = (Float)frameTicks * 1.0e6f / (Float)System::getTimeFrequency() / numFrames;
+        const Float maxFrameCost = (Float)maxFrameTicks * 1.0e6f / (Float)System::getTimeFrequency();
+
+        Application::message(String::print("Clouds 512: %.2fms per update on the frame thread, background %u updates "
+                                           "(%u late, avg %.2fms, max %.2fms), %u acquired",
+                                           syncTime, stats.numUpdates, stats.numLate, stats.averageCompute,
+                                           stats.maxCompute, numAcquired), "Bench");
+
+        Application::message(String::print("Clouds at %.0f Hz over %.0fms: %u of %u ticks late (%.1f%%), "
+                                           "longest update %.1f%% of the %.0fms period",
+                                           rate, runTime, stats.numLate, numTicks,
+                                           100.f * Float(stats.numLate) / Float(numTicks),
+                                           100.f * stats.maxCompute / period, period), "Bench");
+
+        Application::message(String::print("Clouds frame thread cost: avg %.2fus max %.2fus per frame (mean shadow %.2f)",
+                                           frameCost, maxFrameCost, shadow / numFrames), "Bench");
+
+        if (frameCost > syncTime * 1000.f * MAX_CLOUD_FRAME_SHARE) {
+            Application::message(String::print("Clouds cost %.2fus per frame on the frame thread, over %.0f%% of "
+                                               "the %.2fms synchronous update",
+                                               frameCost, 100.f * MAX_CLOUD_FRAME_SHARE, syncTime), "Error");
+            return False;
+        }
+
+        return True;
+    }
+
+    static Float maxDiff(const std::vector<Float> &a, const std::vector<Float> &b)
+    {
+        Float diff = 0.0f;
+        for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+            diff = std::max(diff, std::fabs(a[i] - b[i]));
+        }
+
+        return diff;
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(SkyBench, MyAppSettings)
@@ -0,0 +1,406 @@
+/**
+ * @file terrainbench.cpp
+ * @brief Headless PCLOD terrain LOD selection and refresh benchmark.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/dir.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/string.h>
+
+#include <o3dsamples/terrainlod.h>
+#include <o3dsamples/terrainheightquery.h>
+#include <o3dsamples/lightmapstreamer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Replay a scripted camera path over TerrainTerragen_64 through the LOD model,
+ * without window nor renderer. Per frame values are written to terrainbench.csv and
+ * a summary per path segment is given as Bench messages, so two runs with different
+ * parameters can be compared. The path is run with the periodic front to back sort
+ * and with the incremental order, then through the lightmap residency model with the
+ * lightmap points of the sample under a memory cap.
+ * @date 2026-10-19
+ */
+class TerrainBench
+{
+public:
+
+    //! Accumulated values of a path segment.
+    struct Summary
+    {
+        UInt32 numFrames;
+        UInt64 triangles;
+        UInt32 maxTriangles;
+        UInt32 refreshed;
+        UInt32 numSorts;
+        Float refreshTime;
+        Float maxRefreshTime;
+        UInt64 maxMemory;
+        Float sortTime;
+        Float maxSortTime;
+        UInt32 misordered;
+        UInt32 unordered;
+    };
+
+    static Int32 main()
+    {
+        Dir basePath("media");
+        if (!basePath.exists()) {
+            basePath = Dir("../media");
+            if (!basePath.exists()) {
+                Application::message("Missing media content", "Error");
+                return -1;
+            }
+        }
+
+        String headerFile = basePath.makeFullFileName("terrain/TerrainTerragen_64.hclm");
+        String dataDir = basePath.makeFullPathName("terrain");
+
+        Int64 timer = System::getTime();
+
+        ClmTerrain terrain;
+        if (!terrain.load(headerFile.toUtf8().getData(), std::string(dataDir.toUtf8().getData()) + "/")) {
+            Application::message(String("Unable to load ") + headerFile, "Error");
+            return -1;
+        }
+
+        // same values as the pclodterrain sample, change them here to compare
+        TerrainLodParams params;
+        params.viewDistance = 40.0f;
+        params.distanceOnlyMaterial = 10.0f;
+        params.distanceOnlyColormap = 25.0f;
+        params.frontToBackMinViewMove = 10.0f;
+        params.frontToBackPeriodicity = 100;
+        params.refreshFrequency = 10.0f;
+        params.colormapPrecision = 2;
+
+        FILE *csv = fopen("terrainbench.csv", "wt");
+        if (csv) {
+            fprintf(csv, "order,frame,segment,visible,triangles,refreshed,sorted,update_us,sort_us,"
+                         "misordered,unordered,geometry_bytes,colormap_bytes\n");
+        }
+
+        // the periodic sort of the engine against the incremental front to back order
+        static const char *orders[2] = { "periodic sort", "incremental" };
+
+        for (UInt32 o = 0; o < 2; ++o) {
+            params.incrementalOrder = o == 1;
+
+            TerrainLod lod;
+            if (!lod.build(terrain, params)) {
+                Application::message("Unsupported terrain zone size", "Error");
+                return -1;
+            }
+
+            if (o == 0) {
+                Float time = (Float)(System::getTime() - timer) / (Float)System::getTimeFrequency();
+                Application::message(String::print("%u zones, %u patches of %u levels, loaded in %f",
+                                                   terrain.getNumZones(), lod.getNumPatches(), lod.getNumLevels(), time), "Bench");
+            }
+
+            Summary summaries[NUM_SEGMENTS] = {};
+            runPath(terrain, lod, o, summaries, csv);
+
+            for (UInt32 s = 0; s < NUM_SEGMENTS; ++s) {
+                const Summary &summary = summaries[s];
+
+                Application::message(String::print(
+                                         "%s, %s: triangles avg %u max %u // refreshed patches %u // "
+                                         "update avg %.2fus max %.2fus // memory max %.1fKB",
+                                         orders[o],
+                                         SEGMENTS[s],
+                                         UInt32(summary.triangles / summary.numFrames),
+                                         summary.maxTriangles,
+                                         summary.refreshed,
+                                         summary.refreshTime / summary.numFrames,
+                                         summary.maxRefreshTime,
+                                         summary.maxMemory / 1024.f),
+                                     "Bench");
+
+                Application::message(String::print(
+                                         "%s, %s: sorts %u in %.2fus (max %.2fus) // misordered %u // unordered %u",
+                                         orders[o],
+                                         SEGMENTS[s],
+                                         summary.numSorts,
+                                         summary.sortTime,
+                                         summary.maxSortTime,
+                                         summary.misordered,
+                                         summary.unordered),
+                                     "Bench");
+            }
+        }
+
+        if (csv) {
+            fclose(csv);
+        }
+
+        if (!benchLightmaps(terrain)) {
+            return -1;
+        }
+
+        benchHeightQueries(terrain);
+
+        return 0;
+    }
+
+private:
+
+    static const UInt32 NUM_SEGMENTS = 3;
+    static const UInt32 SEGMENT_FRAMES = 600;
+    static constexpr Float FRAME_RATE = 60.0f;
+
+    static const char *SEGMENTS[NUM_SEGMENTS];
+
+    static const UInt32 NUM_QUERIES = 1 << 22;
+
+    //! Lightmap residency cap, RGBA texels.
+    static const UInt64 LIGHTMAP_CAP = 4 * 1024 * 1024;
+
+    //! Bounds of the terrain, the camera path stays inside.
+    struct Extent
+    {
+        Float minX, minZ, maxX, maxZ, maxY;
+    };
+
+    static Extent getExtent(const ClmTerrain &terrain)
+    {
+        Extent extent = {};
+
+        for (UInt32 i = 0; i < terrain.getNumZones(); ++i) {
+            const ClmZone &zone = terrain.getZone(i);
+            const Float x0 = zone.originX * terrain.getUnit(), z0 = zone.originZ * terrain.getUnit();
+            const Float x1 = x0 + (zone.sizeX - 1) * terrain.getUnit(), z1 = z0 + (zone.sizeZ - 1) * terrain.getUnit();
+
+            extent.minX = i ? std::min(extent.minX, x0) : x0;
+            extent.minZ = i ? std::min(extent.minZ, z0) : z0;
+            extent.maxX = i ? std::max(extent.maxX, x1) : x1;
+            extent.maxZ = i ? std::max(extent.maxZ, z1) : z1;
+            extent.maxY = i ? std::max(extent.maxY, zone.maxHeight) : zone.maxHeight;
+        }
+
+        return extent;
+    }
+
+    //! Camera of a segment at a time: fly across, orbit around the center, then turn on place.
+    static void getCamera(const Extent &extent, UInt32 segment, Float t, Float &x, Float &z, Float &yaw)
+    {
+        const Float centerX = (extent.minX + extent.maxX) * 0.5f, centerZ = (extent.minZ + extent.maxZ) * 0.5f;
+
+        if (segment == 0) {
+            // straight across the terrain at the sample camera speed (10 units/s)
+            const Float len = std::min(10.0f * t, (extent.maxX - extent.minX) * 0.9f);
+            x = extent.minX + 8.0f + len * 0.8f;
+            z = extent.minZ + 8.0f + len * 0.6f;
+            yaw = std::atan2(-0.8f, -0.6f);
+        } else if (segment == 1) {
+            // orbit around the center, looking along the path
+            const Float radius = (extent.maxX - extent.minX) * 0.25f;
+            const Float a = t * 10.0f / radius;
+            x = centerX + radius * std::cos(a);
+            z = centerZ + radius * std::sin(a);
+            yaw = std::atan2(std::sin(a), -std::cos(a));
+        } else {
+            // stationary, turning on itself (only the culling changes)
+            x = centerX;
+            z = centerZ;
+            yaw = t;
+        }
+    }
+
+    /**
+     * @brief Replay the camera path through the lightmap residency of the zones, with the
+     * lightmap points of the pclodterrain sample, RGBA texels and a 4 MB cap.
+     * @return False if the resident bytes went past the cap.
+     */
+    static Bool benchLightmaps(const ClmTerrain &terrain)
+    {
+        LightmapStreamer lightmaps(4);
+        lightmaps.setPoint(0.0f, 0);
+        lightmaps.setPoint(50.0f, -1);
+        lightmaps.setPoint(100.0f, -2);
+        lightmaps.setPoint(200.0f, -3);
+        lightmaps.setZones(terrain);
+        lightmaps.setMemoryCap(LIGHTMAP_CAP);
+        lightmaps.setHysteresis(5.0f);
+
+        const UInt64 base = lightmaps.getNumZones() * lightmaps.chainBytes(lightmaps.getMinLevel());
+        const UInt64 cap = std::max(LIGHTMAP_CAP, base);
+
+        const Extent extent = getExtent(terrain);
+        const Float dt = 1.0f / FRAME_RATE;
+        UInt32 frame = 0;
+
+        for (UInt32 s = 0; s < NUM_SEGMENTS; ++s) {
+            const UInt32 numTransitions = lightmaps.getStats().numTransitions;
+            UInt64 maxResident = 0;
+            UInt32 maxCapped = 0;
+            Float updateTime = 0.0f, maxUpdateTime = 0.0f;
+
+            for (UInt32 f = 0; f < SEGMENT_FRAMES; ++f, ++frame) {
+                Float x, z, yaw;
+                getCamera(extent, s, f * dt, x, z, yaw);
+
+                const Int64 timer = System::getTime();
+                lightmaps.update(x, z, frame * dt);
+                const Float time = (Float)(System::getTime() - timer) * 1000000.f / (Float)System::getTimeFrequency();
+
+                const LightmapStreamer::Stats &stats = lightmaps.getStats();
+                maxResident = std::max(maxResident, stats.residentBytes);
+                maxCapped = std::max(maxCapped, stats.numCapped);
+                updateTime += time;
+                maxUpdateTime = std::max(maxUpdateTime, time);
+            }
+
+            const UInt32 segmentTransitions = lightmaps.getStats().numTransitions - numTransitions;
+
+            Application::message(String::print(
+                                     "lightmaps %u texels, %s: resident max %.2fMB of %.2fMB // transitions %u "
+                                     "(%.1f/s) // capped max %u // update avg %.2fus max %.2fus",
+                                     lightmaps.getLightmapSize(),
+                                     SEGMENTS[s],
+                                     maxResident / (1024.f*1024.f),
+                                     cap / (1024.f*1024.f),
+                                     segmentTransitions,
+                                     segmentTransitions / (SEGMENT_FRAMES * dt),
+                                     maxCapped,
+                                     updateTime / SEGMENT_FRAMES,
+                                     maxUpdateTime),
+                                 "Bench");
+
+            if (maxResident > cap) {
+                Application::message("Lightmaps resident past the cap", "Error");
+                return False;
+            }
+        }
+
+        return True;
+    }
+
+    //! Ground height and normal queries at random positions, scalar, SSE2 and on a pool.
+    static void benchHeightQueries(const ClmTerrain &terrain)
+    {
+        TerrainHeightQuery query;
+        if (!query.build(terrain)) {
+            return;
+        }
+
+        std::vector<Float> xz(NUM_QUERIES * 2);
+        std::vector<Float> reference(NUM_QUERIES), heights(NUM_QUERIES), normals(NUM_QUERIES * 3);
+
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<Float> distX(0.0f, Float(query.getGridWidth()));
+        std::uniform_real_distribution<Float> distZ(0.0f, Float(query.getGridHeight()));
+
+        for (UInt32 i = 0; i < NUM_QUERIES; ++i) {
+            xz[i*2] = distX(rng);
+            xz[i*2+1] = distZ(rng);
+        }
+
+        WorkerPool pool;
+        Int64 timer;
+        Float time;
+
+        query.setSimd(False);
+        timer = System::getTime();
+        query.getHeights(xz.data(), reference.data(), NUM_QUERIES);
+        time = (Float)(System::getTime() - timer) / (Float)System::getTimeFrequency();
+        Application::message(String::print("Heights scalar %.1f Mq/s", NUM_QUERIES / time / 1000000.f), "Bench");
+
+        query.setSimd(True);
+        timer = System::getTime();
+        query.getHeights(xz.data(), heights.data(), NUM_QUERIES);
+        time = (Float)(System::getTime() - timer) / (Float)System::getTimeFrequency();
+        Application::message(String::print("Heights SIMD %.1f Mq/s // identical %s", NUM_QUERIES / time / 1000000.f,
+                                           memcmp(reference.data(), heights.data(), NUM_QUERIES * sizeof(Float)) ? "no" : "yes"), "Bench");
+
+        timer = System::getTime();
+        query.getHeights(pool, xz.data(), heights.data(), NUM_QUERIES);
+        time = (Float)(System::getTime() - timer) / (Float)System::getTimeFrequency();
+        Application::message(String::print("Heights %u workers %.1f Mq/s // identical %s", pool.getNumWorkers() + 1,
+                                           NUM_QUERIES / time / 1000000.f,
+                                           memcmp(reference.data(), heights.data(), NUM_QUERIES * sizeof(Float)) ? "no" : "yes"), "Bench");
+
+        timer = System::getTime();
+        query.getNormals(pool, xz.data(), normals.data(), NUM_QUERIES);
+        time = (Float)(System::getTime() - timer) / (Float)System::getTimeFrequency();
+        Application::message(String::print("Normals %u workers %.1f Mq/s", pool.getNumWorkers() + 1,
+                                           NUM_QUERIES / time / 1000000.f), "Bench");
+    }
+
+    //! Replay the camera path through the LOD model.
+    static void runPath(const ClmTerrain &terrain, TerrainLod &lod, UInt32 order, Summary *summaries, FILE *csv)
+    {
+        const Extent extent = getExtent(terrain);
+        const Float altitude = extent.maxY + 4.0f;
+
+        const Float dt = 1.0f / FRAME_RATE;
+        UInt32 frame = 0;
+
+        for (UInt32 s = 0; s < NUM_SEGMENTS; ++s) {
+            Summary &summary = summaries[s];
+
+            for (UInt32 f = 0; f < SEGMENT_FRAMES; ++f, ++frame) {
+                Float x, z, yaw;
+                getCamera(extent, s, f * dt, x, z, yaw);
+
+                Int64 timer = System::getTime();
+                lod.update(x, altitude, z, yaw, frame * dt);
+                const Float updateTime = (Float)(System::getTime() - timer) * 1000000.f / (Float)System::getTimeFrequency();
+
+                const TerrainLod::FrameStats &stats = lod.getStats();
+                const UInt64 memory = stats.geometryBytes + stats.colormapBytes;
+
+                ++summary.numFrames;
+                summary.triangles += stats.numTriangles;
+                summary.maxTriangles = std::max(summary.maxTriangles, stats.numTriangles);
+                summary.refreshed += stats.numRefreshed;
+                summary.refreshTime += updateTime;
+                summary.maxRefreshTime = std::max(summary.maxRefreshTime, updateTime);
+                summary.maxMemory = std::max(summary.maxMemory, memory);
+                summary.numSorts += stats.sorted ? 1 : 0;
+                summary.sortTime += stats.sortTime;
+                summary.maxSortTime = std::max(summary.maxSortTime, stats.sortTime);
+                summary.misordered += stats.numMisordered;
+                summary.unordered += stats.numUnordered;
+
+                if (csv) {
+                    fprintf(csv, "%u,%u,%u,%u,%u,%u,%u,%.2f,%.2f,%u,%u,%llu,%llu\n",
+                            order, frame, s, stats.numVisible, stats.numTriangles, stats.numRefreshed,
+                            stats.sorted ? 1 : 0, updateTime, stats.sortTime,
+                            stats.numMisordered, stats.numUnordered,
+                            (unsigned long long)stats.geometryBytes, (unsigned long long)stats.colormapBytes);
+                }
+            }
+        }
+    }
+};
+
+const char *TerrainBench::SEGMENTS[TerrainBench::NUM_SEGMENTS] = { "fly", "orbit", "look around" };
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(TerrainBench, MyAppSettings)
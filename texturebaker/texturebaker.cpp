@@ -0,0 +1,230 @@
+/**
+ * @file texturebaker.cpp
+ * @brief Baking of the textures of the samples into mip chain files, BC1 when asked.
+ * @author Frederic SCHERMA (frederic.scherma@dreamoverflow.org)
+ * @date 2026-10-19
+ * @copyright Copyright (c) 2001-2017 Dream Overflow. All rights reserved.
+ * @details
+ */
+
+#include <o3d/core/architecture.h>
+#include <o3d/core/application.h>
+#include <o3d/core/main.h>
+#include <o3d/core/debug.h>
+#include <o3d/core/dir.h>
+#include <o3d/core/file.h>
+#include <o3d/core/string.h>
+
+#include <o3d/image/image.h>
+
+#include <o3dsamples/bakedtexture.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace o3d;
+using namespace o3dsamples;
+
+/**
+ * @brief Bake the textures of media/textures into .baked files next to them, with their
+ * whole mip chain and the key of their source. The photos (sky box, models) and the
+ * shine streaks are BC1 compressed, the flares keep their texels, the block artifacts
+ * being visible on their smooth gradients. The ms3d sample streams the flares raw and
+ * its Shine7 glow in BC1.
+ * For each texture, the time to decode the source and build its mip chain, as a load
+ * with mipmaps does, is compared to the time to read the baked file, and the bytes of
+ * the RGBA8 mip chain to the bytes of the baked levels.
+ * @date 2026-10-19
+ */
+class TextureBaker
+{
+public:
+
+    static Int32 main()
+    {
+        Dir basePath("media");
+        if (!basePath.exists()) {
+            basePath = Dir("../media");
+            if (!basePath.exists()) {
+                Application::message("Missing media content", "Error");
+                return -1;
+            }
+        }
+
+        struct Entry
+        {
+            const char *name;
+            Bool compress;
+        };
+
+        static const Entry entries[] = {
+            { "sky01_xp.jpg", True }, { "sky01_xn.jpg", True }, { "sky01_yp.jpg", True },
+            { "sky01_zp.jpg", True }, { "sky01_zn.jpg", True },
+            { "earth.jpg", True }, { "axe.jpg", True }, { "dwarf.jpg", True }, { "dwarf2.jpg", True },
+            { "monster.jpg", True },
+            { "Flare1.bmp", False }, { "Flare2.bmp", False }, { "Flare3.bmp", False },
+            { "Flare4.bmp", False }, { "Flare5.bmp", False }, { "Flare6.bmp", False },
+            { "Shine0.bmp", True }, { "Shine1.bmp", True }, { "Shine2.bmp", True }, { "Shine3.bmp", True },
+            { "Shine4.bmp", True }, { "Shine5.bmp", True }, { "Shine6.bmp", True }, { "Shine7.bmp", True },
+            { "Shine8.bmp", True }, { "Shine9.bmp", True }
+        };
+
+        WorkerPool pool;
+        Totals totals;
+
+        for (const Entry &entry : entries) {
+            const String source = basePath.makeFullFileName(String("textures/") + entry.name);
+
+            if (!bake(source, String(BakedTexture::getFileName(source.toUtf8().getData()).c_str()), entry.compress, pool, totals)) {
+                Application::message(String("Unable to bake ") + source, "Error");
+                return -1;
+            }
+        }
+
+        Application::message(String::print("total: source %.2f ms, %.1f KB // baked %.2f ms (x%.1f), %.1f KB (x%.1f)",
+                                           totals.sourceTime, totals.sourceBytes / 1024.f,
+                                           totals.bakedTime, totals.sourceTime / totals.bakedTime,
+                                           totals.bakedBytes / 1024.f, Float(totals.sourceBytes) / Float(totals.bakedBytes)), "Baker");
+
+        return 0;
+    }
+
+private:
+
+    struct Totals
+    {
+        Float sourceTime;
+        Float bakedTime;
+        UInt64 sourceBytes;
+        UInt64 bakedBytes;
+
+        Totals() : sourceTime(0.0f), bakedTime(0.0f), sourceBytes(0), bakedBytes(0) {}
+    };
+
+    static Float elapsed(Int64 timer)
+    {
+        return (Float)(System::getTime() - timer) * 1000.f / (Float)System::getTimeFrequency();
+    }
+
+    //! Bake a source image, and time its load against the load of the baked file.
+    static Bool bake(const String &source, const String &target, Bool compress, WorkerPool &pool, Totals &totals)
+    {
+        // the key of the source, a baked file of another content is not used
+        UInt64 sourceHash = 0, sourceSize = 0;
+        if (!BakedTexture::hashSource(source.toUtf8().getData(), sourceHash, sourceSize)) {
+            return False;
+        }
+
+        // load of the source with its mip chain, the mip chain of the baked texture being
+        // built like the one of a texture loaded with mipmaps
+        Int64 timer = System::getTime();
+
+        Image image(source);
+        if (!image.isValid()) {
+            return False;
+        }
+
+        const UInt32 texelSize = image.getBpp() / 8;
+        if ((texelSize != 3) && (texelSize != 4)) {
+            Application::message(String::print("%s: %u bits per texel, skipped", source.toUtf8().getData(), image.getBpp()), "Baker");
+            return True;
+        }
+
+        const Bool bgr = (image.getPixelFormat() == PF_BGR_8) || (image.getPixelFormat() == PF_BGRA_8);
+
+        BakedTexture raw;
+        if (!raw.build(image.getData(), image.getWidth(), image.getHeight(), texelSize,
+                       UInt32(image.getPixelFormat()), False)) {
+            return False;
+        }
+
+        const Float sourceTime = elapsed(timer);
+
+        timer = System::getTime();
+
+        BakedTexture baked;
+        baked.build(image.getData(), image.getWidth(), image.getHeight(), texelSize,
+                    UInt32(image.getPixelFormat()), compress, &pool, bgr);
+        baked.setSource(sourceHash, sourceSize);
+
+        const Float encodeTime = elapsed(timer);
+
+        if (!baked.save(target.toUtf8().getData())) {
+            return False;
+        }
+
+        // load of the baked file
+        timer = System::getTime();
+
+        BakedTexture loaded;
+        if (!loaded.load(target.toUtf8().getData())) {
+            return False;
+        }
+
+        const Float bakedTime = elapsed(timer);
+
+        // RGBA8, as the textures are stored by the GPU, with a third more for the mips
+        const UInt64 sourceBytes = UInt64(image.getWidth()) * image.getHeight() * 4 * 4 / 3;
+        const UInt64 bakedBytes = loaded.getLevelsBytes();
+
+        static const char *formats[3] = { "RGB8", "RGBA8", "BC1" };
+
+        String quality;
+        if (loaded.getHeader().format == BakedTextureHeader::FORMAT_BC1) {
+            quality = String::print(", PSNR %.1f dB", computePsnr(image.getData(), texelSize, bgr, loaded));
+        }
+
+        Application::message(String::print("%s: %ux%u %s, %u levels, encoded in %.2f ms%s",
+                                           target.toUtf8().getData(), image.getWidth(), image.getHeight(),
+                                           formats[loaded.getHeader().format], loaded.getHeader().numLevels,
+                                           encodeTime, quality.toUtf8().getData()), "Baker");
+
+        Application::message(String::print("  source %.2f ms, %.1f KB // baked %.2f ms (x%.1f), %.1f KB (x%.1f)",
+                                           sourceTime, sourceBytes / 1024.f,
+                                           bakedTime, sourceTime / bakedTime,
+                                           bakedBytes / 1024.f, Float(sourceBytes) / Float(bakedBytes)), "Baker");
+
+        totals.sourceTime += sourceTime;
+        totals.bakedTime += bakedTime;
+        totals.sourceBytes += sourceBytes;
+        totals.bakedBytes += bakedBytes;
+
+        return True;
+    }
+
+    //! PSNR of the first level of a baked texture against its source texels.
+    static Float computePsnr(const UInt8 *texels, UInt32 texelSize, Bool bgr, const BakedTexture &baked)
+    {
+        // decoded red first
+        std::vector<UInt8> decoded;
+        baked.decodeLevel(0, decoded);
+
+        const size_t count = decoded.size() / 4;
+        Double error = 0.0;
+
+        for (size_t i = 0; i < count; ++i) {
+            for (UInt32 c = 0; c < 3; ++c) {
+                const UInt32 source = bgr ? 2 - c : c;
+                const Double d = Double(decoded[i * 4 + c]) - Double(texels[i * texelSize + source]);
+                error += d * d;
+            }
+        }
+
+        error /= Double(count * 3);
+
+        return error > 0.0 ? Float(10.0 * std::log10(255.0 * 255.0 / error)) : 99.0f;
+    }
+};
+
+class MyAppSettings : public AppSettings
+{
+public:
+
+    MyAppSettings() : AppSettings()
+    {
+        useDisplay = False;
+        clearLog = True;
+    }
+};
+
+O3D_CONSOLE_MAIN(TextureBaker, MyAppSettings)